@@ -3799,7 +3799,7 @@ DECLARE_PROBERIG_BACKEND(adat)
                           ADAT_CMD_DEF_STRING_GET_ID_CODE,
                           strlen( ADAT_CMD_DEF_STRING_GET_ID_CODE ) );
 		nRead = read_string(port, acBuf, ADAT_RESPSZ, ADAT_EOM, 1);
-        close( port->fd );
+        ser_close(port);
 
 		if(( nRC != RIG_OK || nRead < 0 ))
         {
@@ -985,7 +985,7 @@ DECLARE_PROBERIG_BACKEND(drake)
 	retval = write_block(port, "ID" EOM, 3);
 	id_len = read_string(port, idbuf, BUFSZ, LF, 1);
 
-	close(port->fd);
+	ser_close(port);
 
 	if (retval != RIG_OK || id_len <= 0 || id_len >= BUFSZ)
 		return RIG_MODEL_NONE;
@@ -35,6 +35,7 @@
 #include "iofunc.h"
 #include "misc.h"
 #include "num_stdio.h"
+#include "netbin.h"
 
 #include "dummy.h"
 
@@ -43,18 +44,422 @@
 
 #define CHKSCN1ARG(a) if ((a) != 1) return -RIG_EPROTO; else do {} while(0)
 
+#define NETRIGCTL_MAX_BATCH 16	/* queries sent at once by get_state_batch */
+#define NETRIGCTL_MAX_PIPELINE 64
+#define NETRIGCTL_MAX_ARGS 128	/* arguments of a request frame */
+
+#define TOK_CFG_PIPELINE TOKEN_BACKEND(1)
+#define TOK_CFG_BINARY TOKEN_BACKEND(2)
+
+/* cfgparams are configuration item generally used by the backend's open() method */
+static const struct confparams netrigctl_cfg_params[] = {
+	{ TOK_CFG_PIPELINE, "pipeline", "Pipelined set commands",
+		"Number of set commands sent without waiting for their reply, "
+		"whose errors are then only logged",
+		"0", RIG_CONF_NUMERIC, { .n = { 0, NETRIGCTL_MAX_PIPELINE, 1 } }
+	},
+	{ TOK_CFG_BINARY, "binary", "Binary frames",
+		"Switch the connection to binary frames, falling back to text "
+		"if rigctld does not know them",
+		"0", RIG_CONF_CHECKBUTTON, { }
+	},
+	{ RIG_CONF_END, NULL, }
+};
+
 /*
- * Helper function with protocol return code parsing
+ * What \dump_state told about the rig, so that opening again the
+ * same rigctld skips the parsing when nothing changed.
  */
-static int netrigctl_transaction(RIG *rig, char *cmd, int len, char *buf)
+struct netrigctl_state_snap {
+  char key[FILPATHLEN + 2*BUF_MAX];	/* port, protocol version and model */
+  char *raw;			/* rest of the \dump_state reply, or binary one */
+  size_t raw_len;
+
+  int itu_region;
+  freq_range_t rx_range_list[FRQRANGESIZ];
+  freq_range_t tx_range_list[FRQRANGESIZ];
+  struct tuning_step_list tuning_steps[TSLSTSIZ];
+  struct filter_list filters[FLTLSTSIZ];
+  shortfreq_t max_rit;
+  shortfreq_t max_xit;
+  shortfreq_t max_ifshift;
+  ann_t announces;
+  int preamp[MAXDBLSTSIZ];
+  int attenuator[MAXDBLSTSIZ];
+  setting_t has_get_func;
+  setting_t has_set_func;
+  setting_t has_get_level;
+  setting_t has_set_level;
+  setting_t has_get_parm;
+  setting_t has_set_parm;
+  vfo_t vfo_list;
+};
+
+struct netrigctl_priv_data {
+  int pipeline;		/* max set commands waiting for their reply */
+  int pending;		/* replies not read yet */
+  int binary;		/* binary frames wanted */
+  int bin_on;		/* connection switched to binary frames */
+  unsigned int tx_id;	/* id of the next request frame */
+  unsigned int rx_id;	/* id of the next reply frame */
+  unsigned char *frame;	/* last reply frame, NETBIN_MAX_FRAME+1 long */
+  char *text;		/* lines of a TEXT reply not read yet */
+  size_t text_len;
+  struct netrigctl_state_snap snap;
+};
+
+#define NETRIGCTL_BIN_ON(rig) (((struct netrigctl_priv_data *)(rig)->state.priv)->bin_on)
+
+/*
+ * Lines of the \dump_state reply, read from the port once,
+ * and kept in raw to be parsed again or compared.
+ */
+struct netrigctl_reader {
+  RIG *rig;
+  char *raw;
+  size_t len;
+  size_t size;
+  size_t pos;		/* next line to parse */
+};
+
+static int netrigctl_reader_line(struct netrigctl_reader *r, char *buf)
 {
+  char *nl, *newraw;
   int ret;
 
-  ret = write_block(&rig->state.rigport, cmd, len);
+  if (r->pos < r->len) {
+	nl = memchr(r->raw + r->pos, '\n', r->len - r->pos);
+	ret = nl ? nl - (r->raw + r->pos) + 1 : r->len - r->pos;
+	memcpy(buf, r->raw + r->pos, ret);
+	buf[ret] = '\0';
+	r->pos += ret;
+	return ret;
+  }
+
+  ret = read_string(&r->rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  if (ret <= 0)
+	return (ret < 0) ? ret : -RIG_EPROTO;
+
+  if (r->len + ret > r->size) {
+	r->size = r->size ? 2*r->size : 1024;
+	newraw = realloc(r->raw, r->size);
+	if (!newraw)
+		return -RIG_ENOMEM;
+	r->raw = newraw;
+  }
+  memcpy(r->raw + r->len, buf, ret);
+  r->len += ret;
+  r->pos = r->len;
+
+  return ret;
+}
+
+static void netrigctl_snap_save(struct netrigctl_state_snap *snap, const struct rig_state *rs)
+{
+  snap->itu_region = rs->itu_region;
+  memcpy(snap->rx_range_list, rs->rx_range_list, sizeof(snap->rx_range_list));
+  memcpy(snap->tx_range_list, rs->tx_range_list, sizeof(snap->tx_range_list));
+  memcpy(snap->tuning_steps, rs->tuning_steps, sizeof(snap->tuning_steps));
+  memcpy(snap->filters, rs->filters, sizeof(snap->filters));
+  snap->max_rit = rs->max_rit;
+  snap->max_xit = rs->max_xit;
+  snap->max_ifshift = rs->max_ifshift;
+  snap->announces = rs->announces;
+  memcpy(snap->preamp, rs->preamp, sizeof(snap->preamp));
+  memcpy(snap->attenuator, rs->attenuator, sizeof(snap->attenuator));
+  snap->has_get_func = rs->has_get_func;
+  snap->has_set_func = rs->has_set_func;
+  snap->has_get_level = rs->has_get_level;
+  snap->has_set_level = rs->has_set_level;
+  snap->has_get_parm = rs->has_get_parm;
+  snap->has_set_parm = rs->has_set_parm;
+  snap->vfo_list = rs->vfo_list;
+}
+
+static void netrigctl_snap_load(const struct netrigctl_state_snap *snap, struct rig_state *rs)
+{
+  rs->itu_region = snap->itu_region;
+  memcpy(rs->rx_range_list, snap->rx_range_list, sizeof(snap->rx_range_list));
+  memcpy(rs->tx_range_list, snap->tx_range_list, sizeof(snap->tx_range_list));
+  memcpy(rs->tuning_steps, snap->tuning_steps, sizeof(snap->tuning_steps));
+  memcpy(rs->filters, snap->filters, sizeof(snap->filters));
+  rs->max_rit = snap->max_rit;
+  rs->max_xit = snap->max_xit;
+  rs->max_ifshift = snap->max_ifshift;
+  rs->announces = snap->announces;
+  memcpy(rs->preamp, snap->preamp, sizeof(snap->preamp));
+  memcpy(rs->attenuator, snap->attenuator, sizeof(snap->attenuator));
+  rs->has_get_func = snap->has_get_func;
+  rs->has_set_func = snap->has_set_func;
+  rs->has_get_level = snap->has_get_level;
+  rs->has_set_level = snap->has_set_level;
+  rs->has_get_parm = snap->has_get_parm;
+  rs->has_set_parm = snap->has_set_parm;
+  rs->vfo_list = snap->vfo_list;
+}
+
+/*
+ * Build a request frame, see netbin.h, returning its length
+ */
+static int netrigctl_bin_frame(struct netrigctl_priv_data *priv, unsigned char *frame,
+		int op, vfo_t vfo, const unsigned char *args, int arglen)
+{
+  netbin_put16(frame, NETBIN_REQ_HDR - 2 + arglen);
+  netbin_put16(frame + 2, priv->tx_id++ & 0xffff);
+  frame[4] = op;
+  netbin_put32(frame + 5, vfo);
+  if (arglen > 0)
+	memcpy(frame + NETBIN_REQ_HDR, args, arglen);
+
+  return NETBIN_REQ_HDR + arglen;
+}
+
+static int netrigctl_bin_send(RIG *rig, int op, vfo_t vfo,
+		const unsigned char *args, int arglen)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  unsigned char frame[NETBIN_REQ_HDR + NETRIGCTL_MAX_ARGS];
+  int len;
+
+  if (arglen > NETRIGCTL_MAX_ARGS)
+	return -RIG_EINVAL;
+
+  len = netrigctl_bin_frame(priv, frame, op, vfo, args, arglen);
+
+  return write_block(&rig->state.rigport, (char *)frame, len);
+}
+
+/*
+ * Read the next reply frame, which must answer the oldest request.
+ * Returns the length of its results, pointed to by *res and followed
+ * by a '\0', and its status in *status.
+ */
+static int netrigctl_bin_recv(RIG *rig, int *status, unsigned char **res)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  unsigned char *frame = priv->frame;
+  int ret, len;
+
+  ret = read_block(&rig->state.rigport, (char *)frame, 2);
+  if (ret < 0)
+	return ret;
+
+  len = netbin_get16(frame);
+  if (len < NETBIN_REP_HDR - 2)
+	return -RIG_EPROTO;
+
+  ret = read_block(&rig->state.rigport, (char *)frame + 2, len);
+  if (ret < 0)
+	return ret;
+
+  if (netbin_get16(frame + 2) != (priv->rx_id++ & 0xffff)) {
+	rig_debug(RIG_DEBUG_ERR, "%s: reply out of sequence\n", __FUNCTION__);
+	return -RIG_EPROTO;
+  }
+
+  frame[2 + len] = '\0';
+  *status = (signed char)frame[5];
+  *res = frame + NETBIN_REP_HDR;
+
+  return len + 2 - NETBIN_REP_HDR;
+}
+
+/*
+ * Next line of the reply, from the port, or from the TEXT frame
+ * when binary
+ */
+static int netrigctl_read_line(RIG *rig, char *buf)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  char *nl;
+  int len;
+
+  if (!priv->bin_on)
+	return read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+
+  if (priv->text_len == 0)
+	return -RIG_EPROTO;
+
+  nl = memchr(priv->text, '\n', priv->text_len);
+  len = nl ? nl - priv->text + 1 : priv->text_len;
+  if (len > BUF_MAX - 1)
+	len = BUF_MAX - 1;
+
+  memcpy(buf, priv->text, len);
+  buf[len] = '\0';
+  priv->text += len;
+  priv->text_len -= len;
+
+  return len;
+}
+
+/*
+ * Ask rigctld for binary frames, an older one not answering
+ */
+static int netrigctl_bin_negotiate(RIG *rig)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  char buf[BUF_MAX];
+  int ret;
+
+  priv->bin_on = 0;
+
+  ret = write_block(&rig->state.rigport, "\\binary\n", 8);
   if (ret != RIG_OK)
 	return ret;
 
   ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  if (ret <= 0)
+	return (ret < 0) ? ret : -RIG_EPROTO;
+
+  if (memcmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET)))
+	return -RIG_EPROTO;
+  ret = atoi(buf+strlen(NETRIGCTL_RET));
+  if (ret != RIG_OK)
+	return ret;
+
+  priv->bin_on = 1;
+  priv->tx_id = priv->rx_id = 0;
+  priv->text_len = 0;
+
+  return RIG_OK;
+}
+
+/*
+ * Connect again to rigctld, which keeps no state about the client,
+ * so that nothing learnt by netrigctl_open() has to be read again.
+ *
+ * The pipelined set commands not answered yet are lost with the
+ * connection, whether they were executed or not: -RIG_EIO tells it
+ * once connected again.
+ */
+static int netrigctl_reconnect(RIG *rig)
+{
+  struct rig_state *rs = &rig->state;
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rs->priv;
+  int ret, lost;
+
+  rig_debug(RIG_DEBUG_WARN, "%s: connection to %s lost, reconnecting\n",
+		  __FUNCTION__, rs->rigport.pathname);
+
+  lost = priv->pending;
+  priv->pending = 0;
+
+  port_close(&rs->rigport, rs->rigport.type.rig);
+  rs->rigport.fd = -1;
+
+  ret = port_open(&rs->rigport);
+  if (ret == RIG_OK && priv->bin_on)
+	ret = netrigctl_bin_negotiate(rig);
+  if (ret != RIG_OK)
+	rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __FUNCTION__, rigerror(ret));
+
+  if (ret == RIG_OK && lost > 0) {
+	rig_debug(RIG_DEBUG_ERR, "%s: %d pipelined command(s) lost\n",
+			__FUNCTION__, lost);
+	ret = -RIG_EIO;
+  }
+
+  return ret;
+}
+
+/*
+ * Read the replies of the pipelined set commands, down to max left
+ */
+static int netrigctl_drain(RIG *rig, int max)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  char buf[BUF_MAX];
+  unsigned char *res;
+  int ret, status;
+
+  while (priv->pending > max) {
+	if (priv->bin_on) {
+		ret = netrigctl_bin_recv(rig, &status, &res);
+		if (ret < 0)
+			return ret;
+		priv->pending--;
+
+		/* a TEXT frame tells in its text */
+		if (status == RIG_OK && !memcmp(res, NETRIGCTL_RET, strlen(NETRIGCTL_RET)))
+			status = atoi((char *)res+strlen(NETRIGCTL_RET));
+		ret = status;
+	} else {
+		ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+		if (ret < 0)
+			return ret;
+		priv->pending--;
+
+		if (memcmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET)))
+			return -RIG_EPROTO;
+		ret = atoi(buf+strlen(NETRIGCTL_RET));
+	}
+	if (ret != RIG_OK)
+		rig_debug(RIG_DEBUG_WARN, "%s: pipelined command failed: %s\n",
+				__FUNCTION__, rigerror(ret));
+  }
+
+  return RIG_OK;
+}
+
+/*
+ * Send a text command line, wrapped in a TEXT frame when binary
+ */
+static int netrigctl_send(RIG *rig, char *cmd, int len)
+{
+  if (NETRIGCTL_BIN_ON(rig))
+	return netrigctl_bin_send(rig, NETBIN_OP_TEXT, RIG_VFO_CURR,
+			(unsigned char *)cmd, len);
+
+  return write_block(&rig->state.rigport, cmd, len);
+}
+
+/*
+ * First line of the reply to a text command line
+ */
+static int netrigctl_recv(RIG *rig, char *buf)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  unsigned char *res;
+  int ret, status;
+
+  if (priv->bin_on) {
+	ret = netrigctl_bin_recv(rig, &status, &res);
+	if (ret < 0)
+		return ret;
+	if (status != RIG_OK)
+		return status;
+	priv->text = (char *)res;
+	priv->text_len = ret;
+  }
+
+  return netrigctl_read_line(rig, buf);
+}
+
+/*
+ * Helper function with protocol return code parsing
+ *
+ * A connection lost, e.g. because rigctld was restarted, is opened
+ * again.  The command is sent once more only when it could not be
+ * sent: once sent, it may have been executed, only its reply lost.
+ */
+static int netrigctl_transaction(RIG *rig, char *cmd, int len, char *buf)
+{
+  int ret, retry, sent;
+
+  for (retry = 0; ; retry++) {
+	ret = netrigctl_drain(rig, 0);
+	if (ret == RIG_OK)
+		ret = netrigctl_send(rig, cmd, len);
+	sent = ret == RIG_OK;
+	if (sent)
+		ret = netrigctl_recv(rig, buf);
+
+	if (ret != -RIG_EIO || retry > 0)
+		break;
+	if (netrigctl_reconnect(rig) != RIG_OK || sent)
+		break;
+  }
   if (ret < 0)
 	return ret;
 
@@ -64,41 +469,111 @@ static int netrigctl_transaction(RIG *rig, char *cmd, int len, char *buf)
   return ret;
 }
 
+/*
+ * Same as netrigctl_transaction() for the commands only answering
+ * with a return code, but when pipelining, it does not wait for it.
+ */
+static int netrigctl_set_transaction(RIG *rig, char *cmd, int len, char *buf)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  int ret, retry;
 
-static int netrigctl_open(RIG *rig)
+  if (priv->pipeline == 0)
+	return netrigctl_transaction(rig, cmd, len, buf);
+
+  for (retry = 0; ; retry++) {
+	ret = netrigctl_drain(rig, priv->pipeline - 1);
+	if (ret == RIG_OK)
+		ret = netrigctl_send(rig, cmd, len);
+
+	if (ret != -RIG_EIO || retry > 0 || netrigctl_reconnect(rig) != RIG_OK)
+		break;
+  }
+  if (ret < 0)
+	return ret;
+
+  priv->pending++;
+
+  return RIG_OK;
+}
+
+/*
+ * Same as netrigctl_transaction() with a native request frame.
+ * Returns the length of the results, pointed to by *res,
+ * otherwise the error.
+ */
+static int netrigctl_bin_transaction(RIG *rig, int op, vfo_t vfo,
+		const unsigned char *args, int arglen, unsigned char **res)
 {
-  int ret, len, i;
-  struct rig_state *rs = &rig->state;
-  int prot_ver;
-  char cmd[CMD_MAX];
-  char buf[BUF_MAX];
+  int ret, retry, sent, status = RIG_OK;
 
-  rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
+  for (retry = 0; ; retry++) {
+	ret = netrigctl_drain(rig, 0);
+	if (ret == RIG_OK)
+		ret = netrigctl_bin_send(rig, op, vfo, args, arglen);
+	sent = ret == RIG_OK;
+	if (sent)
+		ret = netrigctl_bin_recv(rig, &status, res);
 
+	if (ret != -RIG_EIO || retry > 0)
+		break;
+	if (netrigctl_reconnect(rig) != RIG_OK || sent)
+		break;
+  }
+  if (ret < 0)
+	return ret;
 
-  len = sprintf(cmd, "\\dump_state\n");
+  return status != RIG_OK ? status : ret;
+}
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
-  if (ret <= 0)
-	return (ret < 0) ? ret : -RIG_EPROTO;
+/*
+ * Same as netrigctl_set_transaction() with a native request frame
+ */
+static int netrigctl_bin_set_transaction(RIG *rig, int op, vfo_t vfo,
+		const unsigned char *args, int arglen)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+  unsigned char *res;
+  int ret, retry;
 
-  prot_ver = atoi(buf);
-#define RIGCTLD_PROT_VER 0
-  if (prot_ver < RIGCTLD_PROT_VER)
-	  return -RIG_EPROTO;
+  if (priv->pipeline == 0) {
+	ret = netrigctl_bin_transaction(rig, op, vfo, args, arglen, &res);
+	return ret < 0 ? ret : RIG_OK;
+  }
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
-  if (ret <= 0)
-	return (ret < 0) ? ret : -RIG_EPROTO;
+  for (retry = 0; ; retry++) {
+	ret = netrigctl_drain(rig, priv->pipeline - 1);
+	if (ret == RIG_OK)
+		ret = netrigctl_bin_send(rig, op, vfo, args, arglen);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+	if (ret != -RIG_EIO || retry > 0 || netrigctl_reconnect(rig) != RIG_OK)
+		break;
+  }
+  if (ret < 0)
+	return ret;
+
+  priv->pending++;
+
+  return RIG_OK;
+}
+
+/*
+ * The capabilities part of the \dump_state reply
+ */
+static int netrigctl_parse_state(RIG *rig, struct netrigctl_reader *r)
+{
+  int ret, i;
+  struct rig_state *rs = &rig->state;
+  char buf[BUF_MAX];
+
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->itu_region = atoi(buf);
 
   for (i=0; i<FRQRANGESIZ; i++) {
-	ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+	ret = netrigctl_reader_line(r, buf);
 	if (ret <= 0)
 		return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -117,7 +592,7 @@ static int netrigctl_open(RIG *rig)
 		break;
   }
   for (i=0; i<FRQRANGESIZ; i++) {
-	ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+	ret = netrigctl_reader_line(r, buf);
 	if (ret <= 0)
 		return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -136,7 +611,7 @@ static int netrigctl_open(RIG *rig)
 		break;
   }
   for (i=0; i<TSLSTSIZ; i++) {
-	ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+	ret = netrigctl_reader_line(r, buf);
   	if (ret <= 0)
 		return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -150,7 +625,7 @@ static int netrigctl_open(RIG *rig)
   }
 
   for (i=0; i<FLTLSTSIZ; i++) {
-	ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+	ret = netrigctl_reader_line(r, buf);
   	if (ret <= 0)
 		return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -168,31 +643,31 @@ static int netrigctl_open(RIG *rig)
 chan_t chan_list[CHANLSTSIZ]; /*!< Channel list, zero ended */
 #endif
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->max_rit = atol(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->max_xit = atol(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->max_ifshift = atol(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->announces = atoi(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -205,7 +680,7 @@ chan_t chan_list[CHANLSTSIZ]; /*!< Channel list, zero ended */
 	  ret = 0;
   rs->preamp[ret] = RIG_DBLST_END;
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -218,37 +693,37 @@ chan_t chan_list[CHANLSTSIZ]; /*!< Channel list, zero ended */
 	  ret = 0;
   rs->attenuator[ret] = RIG_DBLST_END;
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->has_get_func = strtol(buf, NULL, 0);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->has_set_func = strtol(buf, NULL, 0);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->has_get_level = strtol(buf, NULL, 0);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->has_set_level = strtol(buf, NULL, 0);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
   rs->has_get_parm = strtol(buf, NULL, 0);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_reader_line(r, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -269,12 +744,368 @@ gran_t parm_gran[RIG_SETTING_MAX];    /*!< parm granularity */
   return RIG_OK;
 }
 
+/*
+ * Read the capabilities part of the \dump_state reply down to its last
+ * line without parsing it, i.e. up to the end entry of each list, as
+ * netrigctl_parse_state() does, then the fixed lines.
+ */
+#define NETRIGCTL_STATE_TAIL 12	/* max_rit to has_set_parm */
+
+static int netrigctl_read_state(struct netrigctl_reader *r)
+{
+  static const int list_size[] = { FRQRANGESIZ, FRQRANGESIZ, TSLSTSIZ, FLTLSTSIZ };
+  char buf[BUF_MAX];
+  freq_t start, end;
+  unsigned int modes;
+  long val;
+  int ret, i, l;
+
+  /* itu_region */
+  ret = netrigctl_reader_line(r, buf);
+  if (ret <= 0)
+	return (ret < 0) ? ret : -RIG_EPROTO;
+
+  for (l=0; l<4; l++) {
+	for (i=0; i<list_size[l]; i++) {
+		ret = netrigctl_reader_line(r, buf);
+		if (ret <= 0)
+			return (ret < 0) ? ret : -RIG_EPROTO;
+
+		if (l < 2) {
+			ret = num_sscanf(buf, "%"SCNfreq"%"SCNfreq, &start, &end);
+			if (ret != 2)
+				return -RIG_EPROTO;
+			if (start == 0 && end == 0)
+				break;
+		} else {
+			ret = sscanf(buf, "%x%ld", &modes, &val);
+			if (ret != 2)
+				return -RIG_EPROTO;
+			if (modes == RIG_MODE_NONE && (l == 3 || val == 0))
+				break;
+		}
+	}
+  }
+
+  for (i=0; i<NETRIGCTL_STATE_TAIL; i++) {
+	ret = netrigctl_reader_line(r, buf);
+	if (ret <= 0)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+  }
+
+  return RIG_OK;
+}
+
+static int netrigctl_init(RIG *rig)
+{
+  struct netrigctl_priv_data *priv;
+
+  priv = (struct netrigctl_priv_data *)calloc(1, sizeof(struct netrigctl_priv_data));
+  if (!priv)
+	return -RIG_ENOMEM;
+
+  rig->state.priv = (rig_ptr_t)priv;
+
+  return RIG_OK;
+}
+
+static int netrigctl_cleanup(RIG *rig)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+
+  if (priv) {
+	free(priv->snap.raw);
+	free(priv->frame);
+  }
+  free(priv);
+  rig->state.priv = NULL;
+
+  return RIG_OK;
+}
+
+static int netrigctl_set_conf(RIG *rig, token_t token, const char *val)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+
+  switch (token) {
+	case TOK_CFG_PIPELINE:
+		priv->pipeline = atoi(val);
+		if (priv->pipeline < 0 || priv->pipeline > NETRIGCTL_MAX_PIPELINE)
+			return -RIG_EINVAL;
+		break;
+	case TOK_CFG_BINARY:
+		priv->binary = atoi(val) ? 1 : 0;
+		break;
+	default:
+		return -RIG_EINVAL;
+  }
+  return RIG_OK;
+}
+
+static int netrigctl_get_conf(RIG *rig, token_t token, char *val)
+{
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rig->state.priv;
+
+  switch (token) {
+	case TOK_CFG_PIPELINE:
+		sprintf(val, "%d", priv->pipeline);
+		break;
+	case TOK_CFG_BINARY:
+		sprintf(val, "%d", priv->binary);
+		break;
+	default:
+		return -RIG_EINVAL;
+  }
+  return RIG_OK;
+}
+
+static const unsigned char *netrigctl_bin_ranges(const unsigned char *p,
+		const unsigned char *end, freq_range_t *list)
+{
+  int i, n;
+
+  if (p >= end)
+	return NULL;
+  n = *p++;
+  if (n > FRQRANGESIZ || end - p < n * NETBIN_RANGE_LEN)
+	return NULL;
+
+  memset(list, 0, FRQRANGESIZ * sizeof(freq_range_t));
+
+  for (i = 0; i < n; i++) {
+	list[i].start = netbin_get_double(p);
+	list[i].end = netbin_get_double(p + 8);
+	list[i].modes = netbin_get32(p + 16);
+	list[i].low_power = (int)netbin_get32(p + 20);
+	list[i].high_power = (int)netbin_get32(p + 24);
+	list[i].vfo = netbin_get32(p + 28);
+	list[i].ant = netbin_get32(p + 32);
+	p += NETBIN_RANGE_LEN;
+  }
+
+  return p;
+}
+
+/*
+ * Load into the rig state the DUMP_STATE results, see netbin.h, the
+ * model excepted.  vfo_list is rebuilt from the ranges.
+ *
+ * Returns RIG_OK, or -RIG_EPROTO if buf is not a valid state.
+ */
+static int netrigctl_bin_load_state(RIG *rig, const unsigned char *buf, size_t len)
+{
+  struct rig_state *rs = &rig->state;
+  const unsigned char *p = buf, *end = buf + len;
+  int i, n;
+
+  if (len < 12 || netbin_get32(p) != NETBIN_PROT_VER)
+	return -RIG_EPROTO;
+
+  rs->itu_region = (int)netbin_get32(p + 8);
+  p += 12;
+
+  p = netrigctl_bin_ranges(p, end, rs->rx_range_list);
+  if (p)
+	p = netrigctl_bin_ranges(p, end, rs->tx_range_list);
+  if (!p || p >= end)
+	return -RIG_EPROTO;
+
+  n = *p++;
+  if (n > TSLSTSIZ || end - p < n * 8 + 1)
+	return -RIG_EPROTO;
+  memset(rs->tuning_steps, 0, sizeof(rs->tuning_steps));
+  for (i = 0; i < n; i++, p += 8) {
+	rs->tuning_steps[i].modes = netbin_get32(p);
+	rs->tuning_steps[i].ts = (int)netbin_get32(p + 4);
+  }
+
+  n = *p++;
+  if (n > FLTLSTSIZ || end - p < n * 8 + 16 + 1)
+	return -RIG_EPROTO;
+  memset(rs->filters, 0, sizeof(rs->filters));
+  for (i = 0; i < n; i++, p += 8) {
+	rs->filters[i].modes = netbin_get32(p);
+	rs->filters[i].width = (int)netbin_get32(p + 4);
+  }
+
+  rs->max_rit = (int)netbin_get32(p);
+  rs->max_xit = (int)netbin_get32(p + 4);
+  rs->max_ifshift = (int)netbin_get32(p + 8);
+  rs->announces = netbin_get32(p + 12);
+  p += 16;
+
+  n = *p++;
+  if (n >= MAXDBLSTSIZ || end - p < n * 4 + 1)
+	return -RIG_EPROTO;
+  for (i = 0; i < n; i++, p += 4)
+	rs->preamp[i] = (int)netbin_get32(p);
+  rs->preamp[n] = RIG_DBLST_END;
+
+  n = *p++;
+  if (n >= MAXDBLSTSIZ || end - p < n * 4 + 48)
+	return -RIG_EPROTO;
+  for (i = 0; i < n; i++, p += 4)
+	rs->attenuator[i] = (int)netbin_get32(p);
+  rs->attenuator[n] = RIG_DBLST_END;
+
+  rs->has_get_func = netbin_get64(p);
+  rs->has_set_func = netbin_get64(p + 8);
+  rs->has_get_level = netbin_get64(p + 16);
+  rs->has_set_level = netbin_get64(p + 24);
+  rs->has_get_parm = netbin_get64(p + 32);
+  rs->has_set_parm = netbin_get64(p + 40);
+
+  for (i = 0; i < FRQRANGESIZ && !RIG_IS_FRNG_END(rs->rx_range_list[i]); i++)
+	rs->vfo_list |= rs->rx_range_list[i].vfo;
+  for (i = 0; i < FRQRANGESIZ && !RIG_IS_FRNG_END(rs->tx_range_list[i]); i++)
+	rs->vfo_list |= rs->tx_range_list[i].vfo;
+
+  return RIG_OK;
+}
+
+/*
+ * The binary DUMP_STATE reply, kept whole in the snapshot
+ */
+static int netrigctl_bin_open(RIG *rig)
+{
+  struct rig_state *rs = &rig->state;
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rs->priv;
+  struct netrigctl_state_snap *snap = &priv->snap;
+  unsigned char *res;
+  char key[sizeof(snap->key)];
+  int ret, len;
+
+  len = netrigctl_bin_transaction(rig, NETBIN_OP_DUMP_STATE, RIG_VFO_CURR,
+		  NULL, 0, &res);
+  if (len < 0)
+	return len;
+
+  snprintf(key, sizeof(key), "%s\nbinary", rs->rigport.pathname);
+
+  if (snap->raw && !strcmp(key, snap->key) &&
+		  snap->raw_len == len && !memcmp(snap->raw, res, len)) {
+	rig_debug(RIG_DEBUG_VERBOSE, "%s: capabilities unchanged\n", __FUNCTION__);
+	netrigctl_snap_load(snap, rs);
+	return RIG_OK;
+  }
+
+  ret = netrigctl_bin_load_state(rig, res, len);
+  if (ret != RIG_OK)
+	return ret;
+
+  free(snap->raw);
+  snap->raw = malloc(len);
+  if (snap->raw) {
+	memcpy(snap->raw, res, len);
+	strcpy(snap->key, key);
+	snap->raw_len = len;
+	netrigctl_snap_save(snap, rs);
+  }
+
+  return RIG_OK;
+}
+
+static int netrigctl_open(RIG *rig)
+{
+  int ret, len;
+  struct rig_state *rs = &rig->state;
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rs->priv;
+  struct netrigctl_state_snap *snap = &priv->snap;
+  struct netrigctl_reader reader;
+  int prot_ver;
+  char cmd[CMD_MAX];
+  char buf[BUF_MAX];
+  char key[sizeof(snap->key)];
+
+  rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
+
+  priv->pending = 0;
+  priv->bin_on = 0;
+
+  if (priv->binary) {
+	if (!priv->frame)
+		priv->frame = malloc(NETBIN_MAX_FRAME + 1);
+	if (!priv->frame)
+		return -RIG_ENOMEM;
+
+	ret = netrigctl_bin_negotiate(rig);
+	if (ret == RIG_OK)
+		return netrigctl_bin_open(rig);
+
+	/* nothing more is coming from an older rigctld */
+	rig_debug(RIG_DEBUG_WARN, "%s: no binary frames (%s), using text\n",
+			__FUNCTION__, rigerror(ret));
+  }
+
+  len = sprintf(cmd, "\\dump_state\n");
+
+  ret = netrigctl_transaction(rig, cmd, len, buf);
+  if (ret <= 0)
+	return (ret < 0) ? ret : -RIG_EPROTO;
+
+  prot_ver = atoi(buf);
+#define RIGCTLD_PROT_VER 0
+  if (prot_ver < RIGCTLD_PROT_VER)
+	  return -RIG_EPROTO;
+
+  snprintf(key, sizeof(key), "%s\n%s", rs->rigport.pathname, buf);
+
+  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  if (ret <= 0)
+	return (ret < 0) ? ret : -RIG_EPROTO;
+
+  len = strlen(key);
+  snprintf(key + len, sizeof(key) - len, "%s", buf);
+
+  memset(&reader, 0, sizeof(reader));
+  reader.rig = rig;
+
+  /*
+   * Same rigctld and model as last time: read the whole reply, and if
+   * it is the same, skip the parsing.
+   */
+  if (snap->raw && !strcmp(key, snap->key)) {
+	ret = netrigctl_read_state(&reader);
+	if (ret != RIG_OK) {
+		free(reader.raw);
+		return ret;
+	}
+	if (reader.len == snap->raw_len && !memcmp(reader.raw, snap->raw, reader.len)) {
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: capabilities unchanged\n", __FUNCTION__);
+		netrigctl_snap_load(snap, rs);
+		free(reader.raw);
+		return RIG_OK;
+	}
+	reader.pos = 0;
+  }
+
+  ret = netrigctl_parse_state(rig, &reader);
+  if (ret != RIG_OK) {
+	free(reader.raw);
+	return ret;
+  }
+
+  free(snap->raw);
+  strcpy(snap->key, key);
+  snap->raw = reader.raw;
+  snap->raw_len = reader.len;
+  netrigctl_snap_save(snap, rs);
+
+  return RIG_OK;
+}
+
 static int netrigctl_close(RIG *rig)
 {
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  /* errors of the last pipelined commands */
+  netrigctl_drain(rig, 0);
+
   /* clean signoff, no read back */
-  write_block(&rig->state.rigport, "q\n", 2);
+  if (NETRIGCTL_BIN_ON(rig))
+	netrigctl_bin_send(rig, NETBIN_OP_QUIT, RIG_VFO_CURR, NULL, 0);
+  else
+	write_block(&rig->state.rigport, "q\n", 2);
 
   return RIG_OK;
 }
@@ -284,12 +1115,18 @@ static int netrigctl_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char args[8];
 
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	netbin_put_double(args, freq);
+	return netrigctl_bin_set_transaction(rig, NETBIN_OP_SET_FREQ, RIG_VFO_CURR, args, 8);
+  }
+
   len = sprintf(cmd, "F %"FREQFMT"\n", freq);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -301,9 +1138,18 @@ static int netrigctl_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char *res;
 
   rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	ret = netrigctl_bin_transaction(rig, NETBIN_OP_GET_FREQ, RIG_VFO_CURR, NULL, 0, &res);
+	if (ret < 8)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	*freq = netbin_get_double(res);
+	return RIG_OK;
+  }
+
   len = sprintf(cmd, "f\n");
 
   ret = netrigctl_transaction(rig, cmd, len, buf);
@@ -321,13 +1167,20 @@ static int netrigctl_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char args[8];
 
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	netbin_put32(args, mode);
+	netbin_put32(args + 4, width);
+	return netrigctl_bin_set_transaction(rig, NETBIN_OP_SET_MODE, RIG_VFO_CURR, args, 8);
+  }
+
   len = sprintf(cmd, "M %s %li\n",
   		rig_strrmode(mode), width);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -340,9 +1193,19 @@ static int netrigctl_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *wid
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char *res;
 
   rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	ret = netrigctl_bin_transaction(rig, NETBIN_OP_GET_MODE, RIG_VFO_CURR, NULL, 0, &res);
+	if (ret < 8)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	*mode = netbin_get32(res);
+	*width = (int)netbin_get32(res + 4);
+	return RIG_OK;
+  }
+
   len = sprintf(cmd, "m\n");
 
   ret = netrigctl_transaction(rig, cmd, len, buf);
@@ -352,7 +1215,7 @@ static int netrigctl_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *wid
   if (ret > 0 && buf[ret-1]=='\n') buf[ret-1] = '\0';	/* chomp */
   *mode = rig_parse_mode(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_read_line(rig, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -370,9 +1233,12 @@ static int netrigctl_set_vfo(RIG *rig, vfo_t vfo)
 
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig))
+	return netrigctl_bin_set_transaction(rig, NETBIN_OP_SET_VFO, vfo, NULL, 0);
+
   len = sprintf(cmd, "V %s\n", rig_strvfo(vfo));
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -385,9 +1251,18 @@ static int netrigctl_get_vfo(RIG *rig, vfo_t *vfo)
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char *res;
 
   rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	ret = netrigctl_bin_transaction(rig, NETBIN_OP_GET_VFO, RIG_VFO_CURR, NULL, 0, &res);
+	if (ret < 4)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	*vfo = netbin_get32(res);
+	return RIG_OK;
+  }
+
   len = sprintf(cmd, "v\n");
 
   ret = netrigctl_transaction(rig, cmd, len, buf);
@@ -406,12 +1281,18 @@ static int netrigctl_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char args[4];
 
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	netbin_put32(args, ptt);
+	return netrigctl_bin_set_transaction(rig, NETBIN_OP_SET_PTT, RIG_VFO_CURR, args, 4);
+  }
+
   len = sprintf(cmd, "T %d\n", ptt);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -424,9 +1305,18 @@ static int netrigctl_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char *res;
 
   rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	ret = netrigctl_bin_transaction(rig, NETBIN_OP_GET_PTT, RIG_VFO_CURR, NULL, 0, &res);
+	if (ret < 4)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	*ptt = netbin_get32(res);
+	return RIG_OK;
+  }
+
   len = sprintf(cmd, "t\n");
 
   ret = netrigctl_transaction(rig, cmd, len, buf);
@@ -468,7 +1358,7 @@ static int netrigctl_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift
 
   len = sprintf(cmd, "R %s\n", rig_strptrshift(rptr_shift));
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -507,7 +1397,7 @@ static int netrigctl_set_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t rptr_offs)
 
   len = sprintf(cmd, "O %ld\n", rptr_offs);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -545,7 +1435,7 @@ static int netrigctl_set_ctcss_tone(RIG *rig, vfo_t vfo, tone_t tone)
 
   len = sprintf(cmd, "C %d\n", tone);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -583,7 +1473,7 @@ static int netrigctl_set_dcs_code(RIG *rig, vfo_t vfo, tone_t code)
 
   len = sprintf(cmd, "D %d\n", code);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -621,7 +1511,7 @@ static int netrigctl_set_ctcss_sql(RIG *rig, vfo_t vfo, tone_t tone)
 
   len = sprintf(cmd, "\\set_ctcss_sql %d\n", tone);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -659,7 +1549,7 @@ static int netrigctl_set_dcs_sql(RIG *rig, vfo_t vfo, unsigned int code)
 
   len = sprintf(cmd, "\\set_dcs_sql %d\n", code);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -697,7 +1587,7 @@ static int netrigctl_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 
   len = sprintf(cmd, "I %"FREQFMT"\n", tx_freq);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -735,7 +1625,7 @@ static int netrigctl_set_split_mode(RIG *rig, vfo_t vfo, rmode_t tx_mode, pbwidt
   len = sprintf(cmd, "X %s %li\n",
   		rig_strrmode(tx_mode), tx_width);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -759,7 +1649,7 @@ static int netrigctl_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode, pbwid
   if (ret > 0 && buf[ret-1]=='\n') buf[ret-1] = '\0';	/* chomp */
   *tx_mode = rig_parse_mode(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_read_line(rig, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -778,7 +1668,7 @@ static int netrigctl_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_
 
   len = sprintf(cmd, "S %d %s\n", split, rig_strvfo(tx_vfo));
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -802,7 +1692,7 @@ static int netrigctl_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split, vfo_t *t
 
   *split = atoi(buf);
 
-  ret = read_string(&rig->state.rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+  ret = netrigctl_read_line(rig, buf);
   if (ret <= 0)
 	return (ret < 0) ? ret : -RIG_EPROTO;
 
@@ -823,7 +1713,7 @@ static int netrigctl_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 
   len = sprintf(cmd, "J %ld\n", rit);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -861,7 +1751,7 @@ static int netrigctl_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
 
   len = sprintf(cmd, "Z %ld\n", xit);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -899,7 +1789,7 @@ static int netrigctl_set_ts(RIG *rig, vfo_t vfo, shortfreq_t ts)
 
   len = sprintf(cmd, "N %ld\n", ts);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -937,7 +1827,7 @@ static int netrigctl_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
 
   len = sprintf(cmd, "U %s %i\n", rig_strfunc(func), status);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -970,10 +1860,17 @@ static int netrigctl_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char args[5];
   char lstr[32];
 
   rig_debug(RIG_DEBUG_VERBOSE,"%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	args[0] = rig_setting2idx(level);
+	netbin_put_level(args + 1, level, val);
+	return netrigctl_bin_set_transaction(rig, NETBIN_OP_SET_LEVEL, RIG_VFO_CURR, args, 5);
+  }
+
   if (RIG_LEVEL_IS_FLOAT(level))
 	sprintf(lstr, "%f", val.f);
   else
@@ -981,7 +1878,7 @@ static int netrigctl_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val
 
   len = sprintf(cmd, "L %s %s\n", rig_strlevel(level), lstr);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -995,9 +1892,20 @@ static int netrigctl_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *va
   int ret, len;
   char cmd[CMD_MAX];
   char buf[BUF_MAX];
+  unsigned char args[1];
+  unsigned char *res;
 
   rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
 
+  if (NETRIGCTL_BIN_ON(rig)) {
+	args[0] = rig_setting2idx(level);
+	ret = netrigctl_bin_transaction(rig, NETBIN_OP_GET_LEVEL, RIG_VFO_CURR, args, 1, &res);
+	if (ret < 4)
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	netbin_get_level(res, level, val);
+	return RIG_OK;
+  }
+
   len = sprintf(cmd, "l %s\n", rig_strlevel(level));
 
   ret = netrigctl_transaction(rig, cmd, len, buf);
@@ -1023,7 +1931,7 @@ static int netrigctl_set_powerstat(RIG *rig, powerstat_t status)
 
   len = sprintf(cmd, "\\set_powerstat %d\n", status);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1066,7 +1974,7 @@ static int netrigctl_set_parm(RIG *rig, setting_t parm, value_t val)
 	sprintf(pstr, "%d", val.i);
   len = sprintf(cmd, "P %s %s\n", rig_strparm(parm), pstr);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1107,7 +2015,7 @@ static int netrigctl_set_ant(RIG *rig, vfo_t vfo, ant_t ant)
 
   len = sprintf(cmd, "Y %d\n", ant);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1145,7 +2053,7 @@ static int netrigctl_set_bank(RIG *rig, vfo_t vfo, int bank)
 
   len = sprintf(cmd, "B %d\n", bank);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1163,7 +2071,7 @@ static int netrigctl_set_mem(RIG *rig, vfo_t vfo, int ch)
 
   len = sprintf(cmd, "E %d\n", ch);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1200,7 +2108,7 @@ static int netrigctl_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch)
 
   len = sprintf(cmd, "g %s %d\n", rig_strscan(scan), ch);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1217,7 +2125,7 @@ static int netrigctl_vfo_op(RIG *rig, vfo_t vfo, vfo_op_t op)
 
   len = sprintf(cmd, "J %s\n", rig_strvfop(op));
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1267,7 +2175,7 @@ static int netrigctl_send_dtmf(RIG *rig, vfo_t vfo, const char *digits)
 
   len = sprintf(cmd, "\\send_dtmf %s\n", digits);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1307,7 +2215,7 @@ static int netrigctl_send_morse(RIG *rig, vfo_t vfo, const char *msg)
 
   len = sprintf(cmd, "\\send_morse %s\n", msg);
 
-  ret = netrigctl_transaction(rig, cmd, len, buf);
+  ret = netrigctl_set_transaction(rig, cmd, len, buf);
   if (ret > 0)
 	return -RIG_EPROTO;
   else
@@ -1315,6 +2223,241 @@ static int netrigctl_send_morse(RIG *rig, vfo_t vfo, const char *msg)
 }
 
 
+/*
+ * get_state_batch with request frames, the replies matched by id
+ */
+static int netrigctl_bin_state_batch(RIG *rig, rig_query_t *query, int count)
+{
+  struct rig_state *rs = &rig->state;
+  struct netrigctl_priv_data *priv = (struct netrigctl_priv_data *)rs->priv;
+  unsigned char frames[NETRIGCTL_MAX_BATCH*(NETBIN_REQ_HDR + 1)];
+  unsigned char *res;
+  int idx[NETRIGCTL_MAX_BATCH];
+  rig_query_t *q;
+  int i, j, n, len, op, status, ret = RIG_OK;
+
+  for (i = 0; i < count; ) {
+	for (n = 0, len = 0; i < count && n < NETRIGCTL_MAX_BATCH; i++) {
+		unsigned char level_idx;
+
+		q = &query[i];
+		if (q->retcode != -RIG_ENIMPL)
+			continue;
+		/* rigctld is not run in vfo mode */
+		if (q->vfo != RIG_VFO_CURR && q->vfo != rs->current_vfo)
+			continue;
+
+		switch (q->item) {
+		case RIG_QUERY_FREQ:
+			op = NETBIN_OP_GET_FREQ;
+			break;
+		case RIG_QUERY_MODE:
+			op = NETBIN_OP_GET_MODE;
+			break;
+		case RIG_QUERY_VFO:
+			op = NETBIN_OP_GET_VFO;
+			break;
+		case RIG_QUERY_PTT:
+			op = NETBIN_OP_GET_PTT;
+			break;
+		case RIG_QUERY_LEVEL:
+			op = NETBIN_OP_GET_LEVEL;
+			break;
+		default:
+			continue;
+		}
+		level_idx = rig_setting2idx(q->level);
+		len += netrigctl_bin_frame(priv, frames+len, op, RIG_VFO_CURR,
+				&level_idx, op == NETBIN_OP_GET_LEVEL ? 1 : 0);
+		idx[n++] = i;
+	}
+
+	if (n == 0)
+		continue;
+
+	ret = write_block(&rs->rigport, (char *)frames, len);
+	if (ret != RIG_OK)
+		break;
+
+	for (j = 0; j < n; j++) {
+		q = &query[idx[j]];
+
+		ret = netrigctl_bin_recv(rig, &status, &res);
+		if (ret < 0)
+			break;
+		if (status != RIG_OK) {
+			q->retcode = status;
+			continue;
+		}
+
+		q->retcode = RIG_OK;
+		switch (q->item) {
+		case RIG_QUERY_FREQ:
+			if (ret >= 8)
+				q->u.freq = netbin_get_double(res);
+			else
+				q->retcode = -RIG_EPROTO;
+			break;
+		case RIG_QUERY_MODE:
+			if (ret >= 8) {
+				q->u.mode.mode = netbin_get32(res);
+				q->u.mode.width = (int)netbin_get32(res + 4);
+			} else
+				q->retcode = -RIG_EPROTO;
+			break;
+		case RIG_QUERY_VFO:
+			if (ret >= 4)
+				q->u.vfo = netbin_get32(res);
+			else
+				q->retcode = -RIG_EPROTO;
+			break;
+		case RIG_QUERY_PTT:
+			if (ret >= 4)
+				q->u.ptt = netbin_get32(res);
+			else
+				q->retcode = -RIG_EPROTO;
+			break;
+		case RIG_QUERY_LEVEL:
+			if (ret >= 4)
+				netbin_get_level(res, q->level, &q->u.level);
+			else
+				q->retcode = -RIG_EPROTO;
+			break;
+		}
+	}
+
+	if (ret < 0) {
+		/* replies may still be on their way, start afresh */
+		netrigctl_reconnect(rig);
+		return ret;
+	}
+  }
+
+  return (ret < 0) ? ret : RIG_OK;
+}
+
+/*
+ * Send all the queries rigctld can answer at once,
+ * then match the replies in order.
+ */
+static int netrigctl_get_state_batch(RIG *rig, rig_query_t *query, int count)
+{
+  struct rig_state *rs = &rig->state;
+  char cmd[NETRIGCTL_MAX_BATCH*CMD_MAX];
+  char buf[BUF_MAX];
+  int idx[NETRIGCTL_MAX_BATCH];
+  rig_query_t *q;
+  int i, j, n, len, ret;
+
+  rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __FUNCTION__);
+
+  ret = netrigctl_drain(rig, 0);
+  if (ret != RIG_OK)
+	return ret;
+
+  if (NETRIGCTL_BIN_ON(rig))
+	return netrigctl_bin_state_batch(rig, query, count);
+
+  for (i = 0; i < count; ) {
+	for (n = 0, len = 0; i < count && n < NETRIGCTL_MAX_BATCH; i++) {
+		q = &query[i];
+		if (q->retcode != -RIG_ENIMPL)
+			continue;
+		/* rigctld is not run in vfo mode */
+		if (q->vfo != RIG_VFO_CURR && q->vfo != rs->current_vfo)
+			continue;
+
+		switch (q->item) {
+		case RIG_QUERY_FREQ:
+			len += sprintf(cmd+len, "f\n");
+			break;
+		case RIG_QUERY_MODE:
+			len += sprintf(cmd+len, "m\n");
+			break;
+		case RIG_QUERY_VFO:
+			len += sprintf(cmd+len, "v\n");
+			break;
+		case RIG_QUERY_PTT:
+			len += sprintf(cmd+len, "t\n");
+			break;
+		case RIG_QUERY_LEVEL:
+			len += sprintf(cmd+len, "l %s\n", rig_strlevel(q->level));
+			break;
+		default:
+			continue;
+		}
+		idx[n++] = i;
+	}
+
+	if (n == 0)
+		continue;
+
+	ret = write_block(&rs->rigport, cmd, len);
+	if (ret != RIG_OK)
+		break;
+
+	for (j = 0; j < n; j++) {
+		q = &query[idx[j]];
+
+		ret = read_string(&rs->rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+		if (ret <= 0)
+			break;
+		if (buf[ret-1] == '\n')
+			buf[ret-1] = '\0';	/* chomp */
+
+		/* an error is the whole reply */
+		if (!memcmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET))) {
+			q->retcode = atoi(buf+strlen(NETRIGCTL_RET));
+			if (q->retcode == RIG_OK)
+				q->retcode = -RIG_EPROTO;
+			continue;
+		}
+
+		switch (q->item) {
+		case RIG_QUERY_FREQ:
+			if (num_sscanf(buf, "%"SCNfreq, &q->u.freq) != 1)
+				q->retcode = -RIG_EPROTO;
+			else
+				q->retcode = RIG_OK;
+			break;
+		case RIG_QUERY_MODE:
+			q->u.mode.mode = rig_parse_mode(buf);
+			ret = read_string(&rs->rigport, buf, BUF_MAX, "\n", sizeof("\n"));
+			if (ret <= 0)
+				break;
+			q->u.mode.width = atoi(buf);
+			q->retcode = RIG_OK;
+			break;
+		case RIG_QUERY_VFO:
+			q->u.vfo = rig_parse_vfo(buf);
+			q->retcode = RIG_OK;
+			break;
+		case RIG_QUERY_PTT:
+			q->u.ptt = atoi(buf);
+			q->retcode = RIG_OK;
+			break;
+		case RIG_QUERY_LEVEL:
+			if (RIG_LEVEL_IS_FLOAT(q->level))
+				q->u.level.f = atof(buf);
+			else
+				q->u.level.i = atoi(buf);
+			q->retcode = RIG_OK;
+			break;
+		}
+		if (ret <= 0)
+			break;
+	}
+
+	if (ret <= 0) {
+		/* replies may still be on their way, start afresh */
+		netrigctl_reconnect(rig);
+		return (ret < 0) ? ret : -RIG_EPROTO;
+	}
+  }
+
+  return (ret < 0) ? ret : RIG_OK;
+}
+
 
 /*
  * Netrigctl rig capabilities.
@@ -1324,7 +2467,7 @@ const struct rig_caps netrigctl_caps = {
   .rig_model =      RIG_MODEL_NETRIGCTL,
   .model_name =     "NET rigctl",
   .mfg_name =       "Hamlib",
-  .version =        "0.3",
+  .version =        "0.4",
   .copyright =      "LGPL",
   .status =         RIG_STATUS_BETA,
   .rig_type =       RIG_TYPE_OTHER,
@@ -1359,8 +2502,10 @@ const struct rig_caps netrigctl_caps = {
   .max_ifshift = 0,
   .priv =  NULL,
 
-  .rig_init =     NULL,
-  .rig_cleanup =  NULL,
+  .cfgparams =    netrigctl_cfg_params,
+
+  .rig_init =     netrigctl_init,
+  .rig_cleanup =  netrigctl_cleanup,
   .rig_open =     netrigctl_open,
   .rig_close =    netrigctl_close,
 
@@ -1422,4 +2567,7 @@ const struct rig_caps netrigctl_caps = {
   .send_morse =  netrigctl_send_morse,
   .set_channel = 	netrigctl_set_channel,
   .get_channel = 	netrigctl_get_channel,
+  .set_conf =     netrigctl_set_conf,
+  .get_conf =     netrigctl_get_conf,
+  .get_state_batch = netrigctl_get_state_batch,
 };
@@ -26,14 +26,531 @@
 #include <stdlib.h>
 #include <string.h>  /* String function definitions */
 #include <unistd.h>  /* UNIX standard function definitions */
+#include <sys/time.h>
 
 #include "hamlib/rig.h"
 #include "serial.h"
 #include "misc.h"
+#include "cache.h"
+#include "event.h"
 #include "icom.h"
 #include "icom_defs.h"
 #include "frame.h"
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if !defined(WIN32) || defined(HAVE_TERMIOS_H)
+#define HAVE_ICOM_BUS 1
+#endif
+
+#ifdef HAVE_ICOM_BUS
+
+/*
+ * CI-V bus shared by the rigs of this process opened on the same
+ * serial port.  Their transactions take turns in arrival order, and
+ * the frames read by one rig but sent by another are queued, then
+ * decoded for the latter once the bus is released.  All the rigs
+ * read and write through the port of the bus, so that no byte read
+ * ahead by one is missed by the others, and the bus keeps it open
+ * until its last rig is gone.
+ */
+#define ICOM_BUS_MAX	16	/* rigs on a bus */
+#define ICOM_BUS_QUEUE	16	/* frames waiting for their rig */
+
+struct icom_bus {
+	char pathname[FILPATHLEN];
+	hamlib_port_t port;		/* own fd and receive buffer */
+	RIG *rigs[ICOM_BUS_MAX];
+	int nrigs;
+	unsigned long ticket;		/* next turn to hand out */
+	unsigned long serving;		/* turn owning the bus */
+	int busy;			/* turn taken, without threads */
+	unsigned char queue[ICOM_BUS_QUEUE][MAXFRAMELEN];
+	int queue_len[ICOM_BUS_QUEUE];
+	int queue_head, queue_count;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+#endif
+	struct icom_bus *next;
+};
+
+static struct icom_bus *icom_buses;
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t icom_buses_lock = PTHREAD_MUTEX_INITIALIZER;
+#define icom_buses_enter()	pthread_mutex_lock(&icom_buses_lock)
+#define icom_buses_leave()	pthread_mutex_unlock(&icom_buses_lock)
+#else
+#define icom_buses_enter()
+#define icom_buses_leave()
+#endif
+
+/*
+ * Bus of the rig, joined on first use.  Returns NULL if the port is
+ * not a serial one.
+ */
+static struct icom_bus *icom_bus_get(RIG *rig)
+{
+	struct rig_state *rs = &rig->state;
+	struct icom_priv_data *priv = (struct icom_priv_data*)rs->priv;
+	struct icom_bus *bus;
+
+	if (rs->rigport.type.rig != RIG_PORT_SERIAL || rs->rigport.fd < 0)
+		return NULL;
+
+	if (priv->bus)
+		return priv->bus;
+
+	icom_buses_enter();
+
+	/* joined meanwhile by the event thread */
+	if (priv->bus) {
+		icom_buses_leave();
+		return priv->bus;
+	}
+
+	for (bus = icom_buses; bus; bus = bus->next)
+			if (!strcmp(bus->pathname, rs->rigport.pathname))
+				break;
+
+	if (bus && bus->nrigs == ICOM_BUS_MAX) {
+		rig_debug(RIG_DEBUG_WARN, "%s: too many rigs on %s\n",
+				__func__, bus->pathname);
+		icom_buses_leave();
+		return NULL;
+	}
+
+	if (!bus) {
+		bus = calloc(1, sizeof(struct icom_bus));
+		if (!bus) {
+			icom_buses_leave();
+			return NULL;
+		}
+		bus->port = rs->rigport;
+		bus->port.fd = dup(rs->rigport.fd);
+		if (bus->port.fd < 0) {
+			free(bus);
+			icom_buses_leave();
+			return NULL;
+		}
+		/* what the rig read ahead is the bus' now */
+		rs->rigport.rxbuf = NULL;
+		snprintf(bus->pathname, sizeof(bus->pathname), "%s",
+				rs->rigport.pathname);
+#ifdef HAVE_PTHREAD
+		pthread_mutex_init(&bus->lock, NULL);
+		pthread_cond_init(&bus->turn, NULL);
+#endif
+		bus->next = icom_buses;
+		icom_buses = bus;
+	}
+
+	/* only read through the bus from now on */
+	port_rx_free(&rs->rigport);
+
+	bus->rigs[bus->nrigs++] = rig;
+	priv->bus = bus;
+	if (bus->nrigs > 1)
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: %d rigs on %s\n",
+				__func__, bus->nrigs, bus->pathname);
+
+	icom_buses_leave();
+
+	return bus;
+}
+
+/*
+ * Leave the bus, called on cleanup.  The bus goes with its last rig.
+ */
+void icom_bus_detach(RIG *rig)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	struct icom_bus *bus = priv->bus, **pbus;
+	int i;
+
+	if (!bus)
+		return;
+
+	icom_buses_enter();
+
+	for (i = 0; i < bus->nrigs && bus->rigs[i] != rig; i++)
+		;
+	if (i < bus->nrigs)
+		bus->rigs[i] = bus->rigs[--bus->nrigs];
+	priv->bus = NULL;
+
+	if (bus->nrigs == 0) {
+		for (pbus = &icom_buses; *pbus != bus; pbus = &(*pbus)->next)
+			;
+		*pbus = bus->next;
+		close(bus->port.fd);
+		port_rx_free(&bus->port);
+#ifdef HAVE_PTHREAD
+		pthread_mutex_destroy(&bus->lock);
+		pthread_cond_destroy(&bus->turn);
+#endif
+		free(bus);
+	}
+
+	icom_buses_leave();
+}
+
+/*
+ * Wait for the turn of the caller, in arrival order.
+ * With try set, returns 0 at once instead of waiting.
+ */
+static int icom_bus_acquire(struct icom_bus *bus, int try)
+{
+#ifdef HAVE_PTHREAD
+	unsigned long me;
+#endif
+
+	if (!bus)
+		return 1;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&bus->lock);
+	if (try && bus->ticket != bus->serving) {
+		pthread_mutex_unlock(&bus->lock);
+		return 0;
+	}
+	me = bus->ticket++;
+	while (bus->serving != me)
+		pthread_cond_wait(&bus->turn, &bus->lock);
+	pthread_mutex_unlock(&bus->lock);
+#else
+	/*
+	 * Only the SIGIO handler may come in the middle of a transaction,
+	 * it must not touch the port then, whichever rig it is for.
+	 */
+	if (try && bus->busy)
+		return 0;
+	bus->busy++;
+#endif
+	return 1;
+}
+
+static void icom_bus_release(struct icom_bus *bus)
+{
+	if (!bus)
+		return;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&bus->lock);
+	bus->serving++;
+	pthread_cond_broadcast(&bus->turn);
+	pthread_mutex_unlock(&bus->lock);
+#else
+	bus->busy--;
+#endif
+}
+
+/*
+ * Port of the transaction, the one of the bus with the timing of rig.
+ * Called with the turn.
+ */
+static hamlib_port_t *icom_bus_port(RIG *rig, struct icom_bus *bus)
+{
+	hamlib_port_t *rp = &rig->state.rigport;
+
+	if (!bus)
+		return rp;
+
+	bus->port.timeout = rp->timeout;
+	bus->port.write_delay = rp->write_delay;
+	bus->port.post_write_delay = rp->post_write_delay;
+
+	return &bus->port;
+}
+
+/*
+ * Frames read ahead on the port of the bus do not make the fd of any
+ * rig readable: have the event thread decode them.
+ */
+static void icom_bus_kick(struct icom_bus *bus)
+{
+	RIG *rigs[ICOM_BUS_MAX];
+	int i, n;
+
+	if (!bus || !port_rx_pending(&bus->port))
+		return;
+
+	icom_buses_enter();
+	n = bus->nrigs;
+	memcpy(rigs, bus->rigs, n * sizeof(RIG *));
+	icom_buses_leave();
+
+	for (i = 0; i < n; i++)
+		if (rig_event_defer(rigs[i], 0) == RIG_OK)
+			break;
+}
+
+static void icom_bus_queue(struct icom_bus *bus, const unsigned char *buf, int frm_len)
+{
+	int i;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&bus->lock);
+#endif
+	if (bus->queue_count == ICOM_BUS_QUEUE) {
+		rig_debug(RIG_DEBUG_WARN, "%s: queue full on %s, frame from %#x dropped\n",
+				__func__, bus->pathname, bus->queue[bus->queue_head][3]);
+		bus->queue_head = (bus->queue_head + 1) % ICOM_BUS_QUEUE;
+		bus->queue_count--;
+	}
+	i = (bus->queue_head + bus->queue_count) % ICOM_BUS_QUEUE;
+	memcpy(bus->queue[i], buf, frm_len);
+	bus->queue_len[i] = frm_len;
+	bus->queue_count++;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&bus->lock);
+#endif
+}
+
+/*
+ * Rig of the bus at the CI-V address addr, called with the buses lock.
+ */
+static RIG *icom_bus_rig(struct icom_bus *bus, int addr)
+{
+	int i;
+
+	/* alone, whatever its address */
+	if (bus->nrigs == 1)
+		return bus->rigs[0];
+
+	for (i = 0; i < bus->nrigs; i++)
+		if (((struct icom_priv_data*)bus->rigs[i]->state.priv)->re_civ_addr == addr)
+			return bus->rigs[i];
+
+	return NULL;
+}
+
+/*
+ * Take the next queued frame which can be decoded now, the one of a rig
+ * whose port lock could be taken, and not held back by an older frame
+ * of a rig in held[].  Returns its length, 0 if none, with *rigp locked.
+ * Called with the lock of the bus.
+ */
+static int icom_bus_unqueue(struct icom_bus *bus, unsigned char *buf,
+		RIG **rigp, RIG **held, int *nheld)
+{
+	int frm_len, i, j, k;
+	RIG *rig;
+
+	for (k = 0; k < bus->queue_count; k++) {
+		i = (bus->queue_head + k) % ICOM_BUS_QUEUE;
+
+		icom_buses_enter();
+		rig = icom_bus_rig(bus, bus->queue[i][3]);
+		icom_buses_leave();
+
+		if (rig) {
+			for (j = 0; j < *nheld && held[j] != rig; j++)
+				;
+			if (j < *nheld)
+				continue;
+			/* its backend or the event thread is on it */
+			if (!rig_port_trylock(rig)) {
+				held[(*nheld)++] = rig;
+				continue;
+			}
+		}
+
+		frm_len = bus->queue_len[i];
+		memcpy(buf, bus->queue[i], frm_len);
+		/* close the gap */
+		for (; k < bus->queue_count - 1; k++) {
+			j = (i + 1) % ICOM_BUS_QUEUE;
+			memcpy(bus->queue[i], bus->queue[j], bus->queue_len[j]);
+			bus->queue_len[i] = bus->queue_len[j];
+			i = j;
+		}
+		bus->queue_count--;
+		*rigp = rig;
+		return frm_len;
+	}
+
+	return 0;
+}
+
+/*
+ * Decode the queued frames for the rigs which sent them, called without
+ * the turn.  Each frame is decoded with the port lock of its rig, like
+ * by the event thread; the frames of a rig whose lock is held stay
+ * queued for the event thread, or the next dispatch.
+ */
+static void icom_bus_dispatch(struct icom_bus *bus)
+{
+	unsigned char buf[MAXFRAMELEN];
+	RIG *held[ICOM_BUS_QUEUE];
+	int frm_len, i, nheld = 0;
+	RIG *rig;
+
+	while (bus) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&bus->lock);
+#endif
+		frm_len = icom_bus_unqueue(bus, buf, &rig, held, &nheld);
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&bus->lock);
+#endif
+		if (frm_len == 0)
+			break;
+
+		if (!rig) {
+			rig_debug(RIG_DEBUG_VERBOSE, "%s: frame from %#x for no rig on %s\n",
+					__func__, buf[3], bus->pathname);
+			continue;
+		}
+
+		icom_decode_frame(rig, buf, frm_len);
+		rig_port_unlock(rig);
+	}
+
+	for (i = 0; i < nheld; i++)
+		rig_event_defer(held[i], 0);
+}
+
+/*
+ * Read the next frame from src, queueing the frames of the other rigs
+ * when the bus is shared, and the transceive frames, e.g. scope data
+ * streamed meanwhile.  Frames cut by a collision or a timeout are
+ * returned as is.
+ */
+static int icom_bus_read(struct icom_bus *bus, hamlib_port_t *port,
+		unsigned char *buf, int src)
+{
+	int frm_len, n;
+
+	for (n = 0; n < ICOM_BUS_QUEUE; n++) {
+		frm_len = read_icom_frame(port, buf);
+		if (!bus || frm_len < ACKFRMLEN || buf[frm_len-1] != FI)
+			return frm_len;
+		if (buf[2] != BCASTID && (bus->nrigs == 1 || buf[3] == src))
+			return frm_len;
+		icom_bus_queue(bus, buf, frm_len);
+	}
+
+	return -RIG_BUSBUSY;
+}
+
+/*
+ * Drop the stale input before a transaction, but the frames of the
+ * other rigs of the bus, and the transceive frames already received.
+ */
+static void icom_bus_flush(struct icom_bus *bus, hamlib_port_t *port)
+{
+	unsigned char buf[MAXFRAMELEN];
+	int frm_len, n;
+
+	if (bus && bus->nrigs > 1)
+		return;
+
+	for (n = 0; bus && n < ICOM_BUS_QUEUE; n++) {
+		/* stop between two frames */
+		if (!icom_frame_pending(port))
+			return;
+		frm_len = read_icom_frame(port, buf);
+		if (frm_len >= ACKFRMLEN && buf[frm_len-1] == FI && buf[2] == BCASTID)
+			icom_bus_queue(bus, buf, frm_len);
+	}
+
+	serial_flush(port);
+}
+
+/*
+ * Transceive data: queue the frame for the rig of the bus which sent
+ * it.  Skipped if a transaction is running, it will do the same.
+ */
+int icom_bus_decode_event(RIG *rig)
+{
+	struct icom_bus *bus = icom_bus_get(rig);
+	unsigned char buf[MAXFRAMELEN];
+	hamlib_port_t *port;
+	int frm_len, n = 0;
+
+	if (!bus)
+		return -RIG_ENAVAIL;
+
+	if (!icom_bus_acquire(bus, 1))
+		return RIG_OK;
+
+	port = icom_bus_port(rig, bus);
+
+	/* another rig of the bus may have read it already */
+	if (!icom_frame_pending(port)) {
+		icom_bus_release(bus);
+		/* and left some of them to us */
+		icom_bus_dispatch(bus);
+		return RIG_OK;
+	}
+
+	/* and the frames read ahead with it */
+	do {
+		frm_len = read_icom_frame(port, buf);
+		if (frm_len >= ACKFRMLEN && buf[frm_len-1] == FI)
+			icom_bus_queue(bus, buf, frm_len);
+	} while (frm_len > 0 && port_rx_pending(port) && ++n < ICOM_BUS_QUEUE);
+
+	icom_bus_release(bus);
+	icom_bus_kick(bus);
+	icom_bus_dispatch(bus);
+
+	if (frm_len <= 0)
+		return frm_len < 0 ? frm_len : -RIG_ETIMEOUT;
+
+	return buf[frm_len-1] == COL ? -RIG_BUSBUSY : RIG_OK;
+}
+
+#else	/* !HAVE_ICOM_BUS */
+
+struct icom_bus;
+
+#define icom_bus_get(rig)		NULL
+#define icom_bus_acquire(bus, try)	1
+#define icom_bus_release(bus)
+#define icom_bus_port(rig, bus)		(&(rig)->state.rigport)
+#define icom_bus_kick(bus)
+#define icom_bus_dispatch(bus)
+#define icom_bus_read(bus, port, buf, src)	read_icom_frame(port, buf)
+#define icom_bus_flush(bus, port)	serial_flush(port)
+
+void icom_bus_detach(RIG *rig)
+{
+}
+
+int icom_bus_decode_event(RIG *rig)
+{
+	return -RIG_ENAVAIL;
+}
+
+#endif	/* HAVE_ICOM_BUS */
+
+/*
+ * Whether some data waits to be read, buffered or not
+ */
+int icom_frame_pending(hamlib_port_t *port)
+{
+#ifdef HAVE_ICOM_BUS
+	fd_set rfds;
+	struct timeval tv;
+
+	if (port_rx_pending(port))
+		return 1;
+
+	FD_ZERO(&rfds);
+	FD_SET(port->fd, &rfds);
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+
+	return select(port->fd + 1, &rfds, NULL, NULL, &tv) > 0;
+#else
+	return 1;
+#endif
+}
+
 /*
  * Build a CI-V frame.
  * The whole frame is placed in frame[],
@@ -81,6 +598,9 @@ int make_cmd_frame(char frame[], char re_id, char ctrl_id, char cmd, int subcmd,
 	return i;
 }
 
+static int icom_bus_transaction(RIG *rig, struct icom_bus *bus, int ctrl_id,
+		const unsigned char *sendbuf, int frm_len, unsigned char *data, int *data_len);
+
 /*
  * icom_one_transaction
  *
@@ -98,10 +618,10 @@ int icom_one_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *pa
 	struct icom_priv_data *priv;
 	const struct icom_priv_caps *priv_caps;
 	struct rig_state *rs;
-	unsigned char buf[MAXFRAMELEN];
 	unsigned char sendbuf[MAXFRAMELEN];
 	int frm_len, retval;
 	int ctrl_id;
+	struct icom_bus *bus;
 
 	rs = &rig->state;
 	priv = (struct icom_priv_data*)rs->priv;
@@ -112,14 +632,45 @@ int icom_one_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *pa
 	frm_len = make_cmd_frame((char *) sendbuf, priv->re_civ_addr, ctrl_id, cmd,
 				subcmd, payload, payload_len);
 
+	/*
+	 * keep the event thread off the port, then wait for our turn
+	 * on the bus, other rigs may share it
+	 */
+	rig_port_lock(rig);
+	bus = icom_bus_get(rig);
+	icom_bus_acquire(bus, 0);
+
+	retval = icom_bus_transaction(rig, bus, ctrl_id, sendbuf, frm_len,
+			data, data_len);
+
+	icom_bus_release(bus);
+	rig_port_unlock(rig);
+	icom_bus_kick(bus);
+	icom_bus_dispatch(bus);
+
+	return retval;
+}
+
+/*
+ * Write the frame and read the reply, with the bus ours if shared.
+ */
+static int icom_bus_transaction(RIG *rig, struct icom_bus *bus, int ctrl_id,
+		const unsigned char *sendbuf, int frm_len, unsigned char *data, int *data_len)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	const struct icom_priv_caps *priv_caps = (struct icom_priv_caps*)rig->caps->priv;
+	hamlib_port_t *port = icom_bus_port(rig, bus);
+	unsigned char buf[MAXFRAMELEN];
+	int retval;
+
 	/*
 	 * should check return code and that write wrote cmd_len chars!
 	 */
 	Hold_Decode(rig);
 
-	serial_flush(&rs->rigport);
+	icom_bus_flush(bus, port);
 
-	retval = write_block(&rs->rigport, (char *) sendbuf, frm_len);
+	retval = write_block(port, (char *) sendbuf, frm_len);
 	if (retval != RIG_OK) {
 			Unhold_Decode(rig);
 			return retval;
@@ -136,7 +687,7 @@ int icom_one_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *pa
 		 * 			up to rs->retry times.
 		 */
 
-		retval = read_icom_frame(&rs->rigport, buf);
+		retval = icom_bus_read(bus, port, buf, ctrl_id);
 		if (retval == -RIG_ETIMEOUT || retval == 0)
 		  {
 		    /* Nothing recieved, CI-V interface is not echoing */
@@ -197,7 +748,7 @@ int icom_one_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *pa
 	 * FIXME: handle pading/collisions
 	 * ACKFRMLEN is the smallest frame we can expect from the rig
 	 */
-	frm_len = read_icom_frame(&rs->rigport, buf);
+	frm_len = icom_bus_read(bus, port, buf, priv->re_civ_addr);
 	Unhold_Decode(rig);
 
 	if (frm_len < 0)
@@ -245,12 +796,36 @@ int icom_one_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *pa
  * payload can be NULL if payload_len == 0
  * subcmd can be equal to -1 (no subcmd wanted)
  *
+ * Replies echoing the command are kept in the response cache, keyed
+ * by the command bytes (cmd, subcmd, payload), while an ACK means
+ * the rig state changed and drops the cache.
+ *
  * return RIG_OK if transaction completed,
  * or a negative value otherwise indicating the error.
  */
 int icom_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *payload, int payload_len, unsigned char *data, int *data_len)
 {
 	int retval, retry;
+	unsigned char key[RIG_RESP_CACHE_KEYLEN];
+	size_t key_len = 0;
+	size_t len = MAXFRAMELEN;
+
+	if (data_len == NULL) {
+		rig_resp_cache_invalidate(rig, NULL, 0);
+	} else if (payload_len + 2 <= RIG_RESP_CACHE_KEYLEN) {
+		key[key_len++] = cmd;
+		if (subcmd != -1)
+			key[key_len++] = subcmd;
+		if (payload_len > 0) {
+			memcpy(key + key_len, payload, payload_len);
+			key_len += payload_len;
+		}
+
+		if (rig_resp_cache_get(rig, key, key_len, data, &len)) {
+			*data_len = len;
+			return RIG_OK;
+		}
+	}
 
 	retry = rig->state.rigport.retry;
 
@@ -260,6 +835,14 @@ int icom_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *payloa
 			break;
 	} while (retry-- > 0);
 
+	if (retval != RIG_OK || data_len == NULL)
+		return retval;
+
+	if (data[0] == ACK)
+		rig_resp_cache_invalidate(rig, NULL, 0);
+	else if (data[0] == cmd && key_len > 0)
+		rig_resp_cache_put(rig, key, key_len, data, *data_len);
+
 	return retval;
 }
 
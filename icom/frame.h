@@ -22,7 +22,7 @@
 #ifndef _FRAME_H
 #define _FRAME_H 1
 
-#define MAXFRAMELEN 56
+#define MAXFRAMELEN 64	/* scope data frames are up to 61 bytes */
 
 /*
  * helper functions
@@ -31,6 +31,10 @@ int make_cmd_frame(char frame[], char re_id, char ctrl_id, char cmd, int subcmd,
 
 int icom_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *payload, int payload_len, unsigned char *data, int *data_len);
 int read_icom_frame(hamlib_port_t *p, unsigned char rxbuffer[]);
+int icom_frame_pending(hamlib_port_t *p);
+
+void icom_bus_detach(RIG *rig);
+int icom_bus_decode_event(RIG *rig);
 
 int rig2icom_mode(RIG *rig, rmode_t mode, pbwidth_t width, unsigned char *md, signed char *pd);
 void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode, pbwidth_t *width);
@@ -34,6 +34,8 @@
 #include <cal.h>
 #include <token.h>
 #include <register.h>
+#include <cache.h>
+#include <event.h>
 
 #include "icom.h"
 #include "icom_defs.h"
@@ -256,6 +258,8 @@ struct icom_addr {
 #define TOK_CIVADDR TOKEN_BACKEND(1)
 #define TOK_MODE731 TOKEN_BACKEND(2)
 #define TOK_NOXCHG TOKEN_BACKEND(3)
+#define TOK_TRNINTERVAL TOKEN_BACKEND(4)
+#define TOK_SCOPEDATA TOKEN_BACKEND(5)
 
 const struct confparams icom_cfg_params[] = {
 	{ TOK_CIVADDR, "civaddr", "CI-V address", "Transceiver's CI-V address",
@@ -268,6 +272,15 @@ const struct confparams icom_cfg_params[] = {
 	{ TOK_NOXCHG, "no_xchg", "No VFO XCHG", "Don't Use VFO XCHG to set other VFO mode and Frequency",
 			"0", RIG_CONF_CHECKBUTTON
 	},
+	{ TOK_TRNINTERVAL, "trn_interval", "Transceive interval",
+			"Minimum delay in ms between two deliveries of transceive "
+			"events, bursts are coalesced.  0 to report each frame",
+			"50", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+	},
+	{ TOK_SCOPEDATA, "scope_data", "Scope data", "Have the opened rig "
+			"send its spectrum scope sweeps, see rig_set_spectrum_callback()",
+			"0", RIG_CONF_CHECKBUTTON
+	},
 	{ RIG_CONF_END, NULL, }
 };
 
@@ -383,6 +396,13 @@ int icom_init(RIG *rig)
 	priv->re_civ_addr = priv_caps->re_civ_addr;
 	priv->civ_731_mode = priv_caps->civ_731_mode;
 	priv->no_xchg = priv_caps->no_xchg;
+	priv->bus = NULL;
+	memset(&priv->trn, 0, sizeof(priv->trn));
+	priv->trn.interval = 50;
+	priv->scope_data = 0;
+	memset(priv->scope, 0, sizeof(priv->scope));
+	/* see icom_decode_frame() */
+	rig->state.cache.trn_update = 1;
 
 	return RIG_OK;
 }
@@ -396,8 +416,10 @@ int icom_cleanup(RIG *rig)
 	if (!rig)
 		return -RIG_EINVAL;
 
-	if (rig->state.priv)
+	if (rig->state.priv) {
+		icom_bus_detach(rig);
 		free(rig->state.priv);
+	}
 	rig->state.priv = NULL;
 
 	return RIG_OK;
@@ -1369,6 +1391,14 @@ int icom_set_conf(RIG *rig, token_t token, const char *val)
 	case TOK_NOXCHG:
 		priv->no_xchg = atoi(val) ? 1:0;
 		break;
+	case TOK_TRNINTERVAL:
+		priv->trn.interval = atoi(val);
+		break;
+	case TOK_SCOPEDATA:
+		priv->scope_data = atoi(val) ? 1:0;
+		if (rs->comm_state)
+			return icom_scope_output(rig, priv->scope_data);
+		break;
 	default:
 		return -RIG_EINVAL;
 	}
@@ -1398,6 +1428,12 @@ int icom_get_conf(RIG *rig, token_t token, char *val)
 	case TOK_NOXCHG:
 		sprintf(val, "%d", priv->no_xchg);
 		break;
+	case TOK_TRNINTERVAL:
+		sprintf(val, "%d", priv->trn.interval);
+		break;
+	case TOK_SCOPEDATA:
+		sprintf(val, "%d", priv->scope_data);
+		break;
 	default:
 		return -RIG_EINVAL;
 	}
@@ -3046,24 +3082,267 @@ int icom_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch)
 	return RIG_OK;
 }
 
+#ifndef DOC_HIDDEN
+
+/* the VFO of index i of the transceive events, 0 selected, 1 unselected */
+static vfo_t icom_trn_vfo(RIG *rig, int i)
+{
+	if (i == 0)
+		return RIG_VFO_CURR;
+
+	switch (rig->state.current_vfo) {
+	case RIG_VFO_B: return RIG_VFO_A;
+	case RIG_VFO_MAIN: return RIG_VFO_SUB;
+	case RIG_VFO_SUB: return RIG_VFO_MAIN;
+	default: return RIG_VFO_B;
+	}
+}
+
+/*
+ * Deliver the pending transceive events, if their time has come.
+ * The changes of VFO, split and PTT come last, so that the
+ * frequency and mode events before them apply to the former VFO.
+ */
+static void icom_trn_deliver(RIG *rig)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	struct icom_trn *trn = &priv->trn;
+	struct rig_callbacks *cb = &rig->callbacks;
+	struct timeval now;
+	unsigned pending;
+	value_t val;
+	int i;
+
+	if (!trn->pending)
+		return;
+
+	gettimeofday(&now, NULL);
+	if (timercmp(&now, &trn->next, <))
+		return;
+
+	pending = trn->pending;
+	trn->pending = 0;
+	trn->deferred = 0;
+	trn->next.tv_sec = now.tv_sec + trn->interval / 1000;
+	trn->next.tv_usec = now.tv_usec + (trn->interval % 1000) * 1000;
+	if (trn->next.tv_usec >= 1000000) {
+		trn->next.tv_sec++;
+		trn->next.tv_usec -= 1000000;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if ((pending & (ICOM_TRN_FREQ << i)) && cb->freq_event)
+			cb->freq_event(rig, icom_trn_vfo(rig, i), trn->freq[i],
+					cb->freq_arg);
+		if ((pending & (ICOM_TRN_MODE << i)) && cb->mode_event)
+			cb->mode_event(rig, icom_trn_vfo(rig, i), trn->mode[i],
+					trn->width[i], cb->mode_arg);
+	}
+
+	if ((pending & ICOM_TRN_RAWSTR) && cb->level_event) {
+		val.i = trn->rawstr;
+		cb->level_event(rig, RIG_VFO_CURR, RIG_LEVEL_RAWSTR, val,
+				cb->level_arg);
+		if (rig->state.str_cal.size) {
+			val.i = (int)rig_raw2val(trn->rawstr, &rig->state.str_cal);
+			cb->level_event(rig, RIG_VFO_CURR, RIG_LEVEL_STRENGTH, val,
+					cb->level_arg);
+		}
+	}
+
+	if ((pending & ICOM_TRN_VFO) && cb->vfo_event)
+		cb->vfo_event(rig, trn->vfo, cb->vfo_arg);
+	if ((pending & ICOM_TRN_SPLIT) && cb->split_event)
+		cb->split_event(rig, RIG_VFO_CURR, trn->split, rig->state.tx_vfo,
+				cb->split_arg);
+	if ((pending & ICOM_TRN_PTT) && cb->ptt_event)
+		cb->ptt_event(rig, RIG_VFO_CURR, trn->ptt, cb->ptt_arg);
+}
+
+/*
+ * Queue the events of mask, now delivered at most every trn.interval
+ * ms.  Bursts, like a spinning tuning knob, are coalesced into their
+ * last value.  Changes of VFO, split and PTT are not held back: they
+ * are delivered at once, along with what is pending.
+ */
+static void icom_trn_post(RIG *rig, unsigned mask)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	struct icom_trn *trn = &priv->trn;
+	struct timeval now, delta;
+
+	trn->pending |= mask;
+
+	if (trn->interval <= 0 || (mask & (ICOM_TRN_VFO|ICOM_TRN_SPLIT|ICOM_TRN_PTT)))
+		timerclear(&trn->next);
+
+	gettimeofday(&now, NULL);
+	if (!timercmp(&now, &trn->next, <)) {
+		icom_trn_deliver(rig);
+		return;
+	}
+
+	if (trn->deferred)
+		return;
+
+	/* have the event thread call icom_decode_event() when due */
+	timersub(&trn->next, &now, &delta);
+	if (rig_event_defer(rig, delta.tv_sec * 1000 +
+				(delta.tv_usec + 999) / 1000) == RIG_OK) {
+		trn->deferred = 1;
+		return;
+	}
+
+	/* nobody would come back for them */
+	timerclear(&trn->next);
+	icom_trn_deliver(rig);
+}
+
+/*
+ * Store a division of a scope sweep, and call the spectrum callback
+ * once the sweep is complete:
+ *
+ * 0x27 0x00, scope (0 main, 1 sub), division, divisions (BCD)
+ * first division: mode (0 center, 1 fixed, 2 scroll-C, 3 scroll-F),
+ * 	center or lower edge freq (5 BCD), span or upper edge freq
+ * 	(5 BCD), out of range (1)
+ * then the amplitudes, one byte each, from 0 to 160
+ *
+ * The amplitudes are stored where they belong in the sweep buffer of
+ * the scope, which is passed as is to the callback.
+ */
+static int icom_scope_frame(RIG *rig, const unsigned char *buf, int frm_len)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	const unsigned char *p = buf + 9;
+	int len = frm_len - 10;
+	struct icom_scope *scope;
+	freq_t freq, span;
+	int seq, max;
+
+	if (len < 0 || buf[6] > 1)
+		return -RIG_EPROTO;
+
+	scope = &priv->scope[buf[6]];
+	seq = from_bcd(buf+7, 2);
+	max = from_bcd(buf+8, 2);
+
+	if (seq == 1) {
+		if (len < 12) {
+			scope->seq = 0;
+			return -RIG_EPROTO;
+		}
+		freq = from_bcd(p+1, 5*2);
+		span = from_bcd(p+6, 5*2);
+		scope->line.id = buf[6];
+		scope->line.centered = p[0] == 0 || p[0] == 2;
+		if (scope->line.centered) {
+			scope->line.low_edge_freq = freq - span;
+			scope->line.high_edge_freq = freq + span;
+		} else {
+			scope->line.low_edge_freq = freq;
+			scope->line.high_edge_freq = span;
+		}
+		scope->line.out_of_range = p[11];
+		scope->line.data_length = 0;
+		/* a sweep in one frame goes on with its amplitudes */
+		p += 12;
+		len -= 12;
+	} else if (seq != scope->seq + 1) {
+		if (scope->seq)
+			rig_debug(RIG_DEBUG_VERBOSE, "%s: division %d after %d, "
+					"sweep dropped\n", __func__, seq, scope->seq);
+		scope->seq = 0;
+		return -RIG_EPROTO;
+	}
+
+	if (len > ICOM_SCOPE_MAXLEN - scope->line.data_length) {
+		scope->seq = 0;
+		return -RIG_EPROTO;
+	}
+
+	memcpy(scope->data + scope->line.data_length, p, len);
+	scope->line.data_length += len;
+	scope->seq = seq;
+
+	if (seq < max)
+		return RIG_OK;
+
+	scope->seq = 0;
+
+	if (!rig->callbacks.spectrum_event)
+		return RIG_OK;
+
+	scope->line.data = scope->data;
+	scope->line.data_level_max = ICOM_SCOPE_LEVEL_MAX;
+
+	return rig->callbacks.spectrum_event(rig, &scope->line,
+			rig->callbacks.spectrum_arg);
+}
+
+#endif	/* !DOC_HIDDEN */
+
+/*
+ * icom_scope_output
+ * Have the scope on and its sweeps sent through CI-V, or stop them
+ */
+int icom_scope_output(RIG *rig, int on)
+{
+	unsigned char scpbuf[1], ackbuf[MAXFRAMELEN];
+	int ack_len, retval;
+
+	scpbuf[0] = on ? 1 : 0;
+
+	if (on) {
+		retval = icom_transaction(rig, C_CTL_SCP, S_SCP_STS, scpbuf, 1,
+				ackbuf, &ack_len);
+		if (retval != RIG_OK)
+			return retval;
+		if (ack_len != 1 || ackbuf[0] != ACK) {
+			rig_debug(RIG_DEBUG_ERR,"%s: ack NG (%#.2x), len=%d\n",
+					__func__, ackbuf[0], ack_len);
+			return -RIG_ERJCTED;
+		}
+	}
+
+	retval = icom_transaction(rig, C_CTL_SCP, S_SCP_DOP, scpbuf, 1,
+			ackbuf, &ack_len);
+	if (retval != RIG_OK)
+		return retval;
+	if (ack_len != 1 || ackbuf[0] != ACK) {
+		rig_debug(RIG_DEBUG_ERR,"%s: ack NG (%#.2x), len=%d\n",
+				__func__, ackbuf[0], ack_len);
+		return -RIG_ERJCTED;
+	}
+
+	return RIG_OK;
+}
+
 /*
  * icom_decode is called by sa_sigio, when some asynchronous
- * data has been received from the rig
+ * data has been received from the rig, or by the event thread
+ * when the events held back are due
  */
 int icom_decode_event(RIG *rig)
 {
-	struct icom_priv_data *priv;
 	struct rig_state *rs;
 	unsigned char buf[MAXFRAMELEN];
 	int frm_len;
-	freq_t freq;
-	rmode_t mode;
-	pbwidth_t width;
 
 	rig_debug(RIG_DEBUG_VERBOSE, "icom: icom_decode called\n");
 
 	rs = &rig->state;
-	priv = (struct icom_priv_data*)rs->priv;
+
+	icom_trn_deliver(rig);
+
+	/* the frame may be for another rig of the bus */
+	frm_len = icom_bus_decode_event(rig);
+	if (frm_len != -RIG_ENAVAIL)
+		return frm_len;
+
+	/* only called back for the events held back */
+	if (!icom_frame_pending(&rs->rigport))
+		return RIG_OK;
 
 	frm_len = read_icom_frame(&rs->rigport, buf);
 
@@ -3088,11 +3367,40 @@ int icom_decode_event(RIG *rig)
 	    return  -RIG_EPROTO;
 	  }
 
+	return icom_decode_frame(rig, buf, frm_len);
+}
+
+/*
+ * Decode a transceive frame sent by the rig, or a reply to another
+ * controller overheard on the bus
+ *
+ * The rig state and cache are refreshed at once, the callbacks are
+ * called through icom_trn_post().
+ */
+int icom_decode_frame(RIG *rig, const unsigned char *buf, int frm_len)
+{
+	struct icom_priv_data *priv = (struct icom_priv_data*)rig->state.priv;
+	struct rig_state *rs = &rig->state;
+	struct icom_trn *trn = &priv->trn;
+	int data_len = frm_len - 6;
+	int i;
+
+	/* the end of a frame cut by a flush */
+	if (frm_len < 6 || buf[0] != PR || buf[1] != PR)
+		return -RIG_EPROTO;
+
 	if (buf[3] != BCASTID && buf[3] != priv->re_civ_addr) {
 		rig_debug(RIG_DEBUG_WARN, "icom_decode: CI-V %#x called for %#x!\n",
 						priv->re_civ_addr, buf[3]);
 	}
 
+	/* the scope streams, the rig state is the same */
+	if (buf[4] == C_CTL_SCP && data_len > 0 && buf[5] == S_SCP_DAT)
+		return icom_scope_frame(rig, buf, frm_len);
+
+	/* any reply cached may be stale now */
+	rig_resp_cache_invalidate(rig, NULL, 0);
+
 	/*
 	 * the first 2 bytes must be 0xfe
 	 * the 3rd one the emitter
@@ -3103,48 +3411,303 @@ int icom_decode_event(RIG *rig)
 	 */
 	switch (buf[4]) {
 	case C_SND_FREQ:
-		/*
-		 * TODO: the freq length might be less than 4 or 5 bytes
-		 * 			on older rigs!
-		 */
-		if (rig->callbacks.freq_event) {
-			freq = from_bcd(buf+5, (priv->civ_731_mode ? 4:5)*2);
-			return rig->callbacks.freq_event(rig, RIG_VFO_CURR, freq,
-							rig->callbacks.freq_arg);
-		} else
-				return -RIG_ENAVAIL;
-		break;
+	case C_RD_FREQ:
+		/* 4 bytes on the older rigs */
+		if (data_len < 4 || data_len > 5)
+			break;
+		trn->freq[0] = from_bcd(buf+5, data_len*2);
+		rs->current_freq = trn->freq[0];
+		rig_cache_update_freq(rig);
+		icom_trn_post(rig, ICOM_TRN_FREQ);
+		return RIG_OK;
+
 	case C_SND_MODE:
-		if (rig->callbacks.mode_event) {
-			icom2rig_mode(rig, buf[5], buf[6], &mode, &width);
-			return rig->callbacks.mode_event(rig, RIG_VFO_CURR,
-							mode, width,
-							rig->callbacks.mode_arg);
-		} else
-				return -RIG_ENAVAIL;
-		break;
+	case C_RD_MODE:
+		if (data_len < 1)
+			break;
+		icom2rig_mode(rig, buf[5], data_len > 1 ? buf[6] : -1,
+				&trn->mode[0], &trn->width[0]);
+		rs->current_mode = trn->mode[0];
+		rs->current_width = trn->width[0];
+		rig_cache_update_mode(rig);
+		icom_trn_post(rig, ICOM_TRN_MODE);
+		return RIG_OK;
+
+	case C_SEND_SEL_FREQ:
+		/* selected (0) or unselected (1) VFO, then the frequency */
+		if (data_len != 6 || buf[5] > 1)
+			break;
+		i = buf[5];
+		trn->freq[i] = from_bcd(buf+6, 5*2);
+		if (i == 0) {
+			rs->current_freq = trn->freq[0];
+			rig_cache_update_freq(rig);
+		}
+		icom_trn_post(rig, ICOM_TRN_FREQ << i);
+		return RIG_OK;
+
+	case C_SEND_SEL_MODE:
+		/* VFO, mode, data mode, filter */
+		if (data_len != 4 || buf[5] > 1)
+			break;
+		i = buf[5];
+		icom2rig_mode(rig, buf[6], buf[8], &trn->mode[i], &trn->width[i]);
+		if (i == 0) {
+			rs->current_mode = trn->mode[0];
+			rs->current_width = trn->width[0];
+			rig_cache_update_mode(rig);
+		}
+		icom_trn_post(rig, ICOM_TRN_MODE << i);
+		return RIG_OK;
+
+	case C_SET_VFO:
+		if (data_len != 1)
+			break;
+		switch (buf[5]) {
+		case S_VFOA: trn->vfo = RIG_VFO_A; break;
+		case S_VFOB: trn->vfo = RIG_VFO_B; break;
+		case S_MAIN: trn->vfo = RIG_VFO_MAIN; break;
+		case S_SUB: trn->vfo = RIG_VFO_SUB; break;
+		default:
+			trn->vfo = RIG_VFO_NONE;
+		}
+		if (trn->vfo == RIG_VFO_NONE)
+			break;
+		/* what is pending applies to the former VFO */
+		timerclear(&trn->next);
+		icom_trn_deliver(rig);
+		rig_cache_invalidate(rig);
+		rs->current_vfo = trn->vfo;
+		rig_cache_update_vfo(rig);
+		icom_trn_post(rig, ICOM_TRN_VFO);
+		return RIG_OK;
+
+	case C_CTL_SPLT:
+		if (data_len != 1)
+			break;
+		if (buf[5] == S_SPLT_ON)
+			trn->split = RIG_SPLIT_ON;
+		else if (buf[5] == S_SPLT_OFF || buf[5] == S_DUP_OFF)
+			trn->split = RIG_SPLIT_OFF;
+		else
+			break;	/* duplex */
+		rs->tx_vfo = trn->split == RIG_SPLIT_ON ? icom_trn_vfo(rig, 1) :
+				rs->current_vfo;
+		icom_trn_post(rig, ICOM_TRN_SPLIT);
+		return RIG_OK;
+
+	case C_CTL_PTT:
+		if (data_len != 2 || buf[5] != S_PTT)
+			break;
+		trn->ptt = buf[6] == 1 ? RIG_PTT_ON : RIG_PTT_OFF;
+		icom_trn_post(rig, ICOM_TRN_PTT);
+		return RIG_OK;
+
+	case C_RD_SQSM:
+		/* 0000..0255 in big endian BCD, like icom_get_level() */
+		if (data_len != 3 || buf[5] != S_SML)
+			break;
+		trn->rawstr = from_bcd_be(buf+6, 2*2);
+		icom_trn_post(rig, ICOM_TRN_RAWSTR);
+		return RIG_OK;
+
 	default:
-		rig_debug(RIG_DEBUG_VERBOSE,"icom_decode: tranceive cmd "
-					"unsupported %#2.2x\n",buf[4]);
-		return -RIG_ENIMPL;
+		break;
+	}
+
+	rig_debug(RIG_DEBUG_VERBOSE,"icom_decode: tranceive cmd "
+				"unsupported %#2.2x\n",buf[4]);
+
+	/* something changed, but what? */
+	rig_cache_invalidate(rig);
+
+	return -RIG_ENIMPL;
+}
+
+#ifndef DOC_HIDDEN
+
+#define ICOM_PROBE_BATCH 8	/* probes outstanding on the bus at once */
+
+struct icom_probe {
+	hamlib_port_t *port;
+	rig_probe_func_t cfunc;
+	rig_ptr_t data;
+	rig_model_t model;		/* last model found */
+	int found;			/* devices which answered */
+	unsigned char seen[256];	/* by CI-V address */
+};
+
+/*
+ * Handle a frame read while probing with cmd: our own requests echoed
+ * by the bus, replies, and whatever else is said on the bus.
+ *
+ * Returns RIG_OK, or -RIG_BUSBUSY if the frame is garbled, e.g. by
+ * a collision.
+ */
+static int icom_probe_frame(struct icom_probe *pr, int cmd,
+		const unsigned char *buf, int frm_len)
+{
+	unsigned char civ_id;
+	rig_model_t model = RIG_MODEL_NONE;
+	int i;
+
+	if (frm_len < 6 || buf[0] != PR || buf[1] != PR || buf[frm_len-1] != FI)
+		return -RIG_BUSBUSY;
+
+	/* our echo, or not for us */
+	if (buf[3] == CTRLID || buf[2] != CTRLID || pr->seen[buf[3]])
+		return RIG_OK;
+
+	if (cmd == C_CTL_MISC) {
+		/* wrong protocol? */
+		if (frm_len < 10 || buf[4] != C_CTL_MISC || buf[5] != S_OPTO_RDID)
+			return RIG_OK;
+
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: found OptoScan%c%c%c at %#x\n",
+				__FUNCTION__, buf[6], buf[7], buf[8], buf[3]);
+
+		if (buf[6] == '5' && buf[7] == '3' && buf[8] == '5')
+			model = RIG_MODEL_OS535;
+		else if (buf[6] == '4' && buf[7] == '5' && buf[8] == '6')
+			model = RIG_MODEL_OS456;
+		else
+			return RIG_OK;
+	} else {
+		if (buf[4] == NAK && frm_len == 6) {
+			/*
+			 * this is an Icom, but it does not support transceiver ID
+			 * try to guess from the return address
+			 */
+			civ_id = buf[3];
+		} else if (buf[4] == C_RD_TRXID && frm_len == 8) {
+			civ_id = buf[6];
+		} else {
+			return RIG_OK;
+		}
+
+		for (i=0; icom_addr_list[i].model != RIG_MODEL_NONE; i++) {
+			if (icom_addr_list[i].re_civ_addr == civ_id) {
+				rig_debug(RIG_DEBUG_VERBOSE,"probe_icom: found %#x"
+							" at %#x\n", civ_id, buf[3]);
+				model = icom_addr_list[i].model;
+				break;
+			}
+		}
+		/*
+		 * not found in known table....
+		 * update icom_addr_list[]!
+		 */
+		if (model == RIG_MODEL_NONE)
+			rig_debug(RIG_DEBUG_WARN,"probe_icom: found unknown device "
+						"with CI-V ID %#x, please report to Hamlib "
+						"developers.\n", civ_id);
+	}
+
+	pr->seen[buf[3]] = 1;
+	pr->found++;
+
+	if (model != RIG_MODEL_NONE) {
+		pr->model = model;
+		if (pr->cfunc)
+			(*pr->cfunc)(pr->port, model, pr->data);
+	}
+
+	return RIG_OK;
+}
+
+/*
+ * Send cmd/subcmd to the count addresses from first which did not
+ * answer yet, without waiting for the replies, then collect the replies
+ * until the bus stays quiet for a timeout.
+ *
+ * Returns RIG_OK, or -RIG_BUSBUSY if a frame was garbled.
+ */
+static int icom_probe_send(struct icom_probe *pr, int cmd, int subcmd,
+		int first, int count)
+{
+	unsigned char buf[MAXFRAMELEN];
+	int frm_len, addr, frames, sent = 0, retval = RIG_OK;
+
+	serial_flush(pr->port);
+
+	for (addr = first; addr < first + count; addr++) {
+		if (pr->seen[addr])
+			continue;
+		frm_len = make_cmd_frame((char *) buf, addr, CTRLID,
+				cmd, subcmd, NULL, 0);
+		write_block(pr->port, (char *) buf, frm_len);
+		sent++;
+	}
+
+	/* all found already, no need to wait */
+	if (!sent)
+		return RIG_OK;
+
+	/* bounded, in case of a chatty bus */
+	for (frames = 0; frames < 4 * count + 8; frames++) {
+		frm_len = read_icom_frame(pr->port, buf);
+
+		/* timeout, everybody had their say */
+		if (frm_len <= 0)
+			break;
+
+		if (icom_probe_frame(pr, cmd, buf, frm_len) != RIG_OK) {
+			rig_debug(RIG_DEBUG_VERBOSE, "%s: garbled frame, "
+					"collision?\n", __FUNCTION__);
+			retval = -RIG_BUSBUSY;
+		}
+	}
+
+	return retval;
+}
+
+/*
+ * Probe the addresses from first to last, ICOM_PROBE_BATCH at once.
+ * A batch with a collision is probed again an address at a time.
+ *
+ * Returns RIG_OK, or -RIG_EPROTO if a lone probe got a garbled reply,
+ * i.e. this is not a CI-V bus.
+ */
+static int icom_probe_sweep(struct icom_probe *pr, int cmd, int subcmd,
+		int first, int last)
+{
+	int addr, i, count;
+
+	for (addr = first; addr <= last; addr += ICOM_PROBE_BATCH) {
+		count = last - addr + 1 < ICOM_PROBE_BATCH ?
+			last - addr + 1 : ICOM_PROBE_BATCH;
+
+		if (icom_probe_send(pr, cmd, subcmd, addr, count) == RIG_OK)
+			continue;
+
+		for (i = addr; i < addr + count; i++) {
+			if (pr->seen[i])
+				continue;
+			if (icom_probe_send(pr, cmd, subcmd, i, 1) != RIG_OK)
+				return -RIG_EPROTO;
+		}
 	}
 
 	return RIG_OK;
 }
 
+#endif	/* !DOC_HIDDEN */
+
 /*
  * init_icom is called by rig_probe_all (register.c)
  *
  * probe_icom reports all the devices on the CI-V bus.
  *
+ * The rigs are first asked at once with a broadcast.  Then the addresses
+ * which did not answer are swept, several probes outstanding at once,
+ * since not every rig answers a broadcast and the replies may collide.
+ *
  * rig_model_t probeallrigs_icom(port_t *port, rig_probe_func_t cfunc, rig_ptr_t data)
  */
 DECLARE_PROBERIG_BACKEND(icom)
 {
-	unsigned char buf[MAXFRAMELEN], civ_addr, civ_id;
-	int frm_len, i;
+	struct icom_probe pr;
 	int retval;
-	rig_model_t model = RIG_MODEL_NONE;
 	int rates[] = { 19200, 9600, 300, 0 };
 	int rates_idx;
 
@@ -3168,127 +3731,42 @@ DECLARE_PROBERIG_BACKEND(icom)
 	if (retval != RIG_OK)
 		return RIG_MODEL_NONE;
 
+	memset(&pr, 0, sizeof(pr));
+	pr.port = port;
+	pr.cfunc = cfunc;
+	pr.data = data;
+
 	/*
-	 * try all possible addresses on the CI-V bus
+	 * all the rigs at once, unless they collide
 	 * FIXME: actualy, old rigs do not support C_RD_TRXID cmd!
 	 * 		Try to be smart, and deduce model depending
 	 * 		on freq range, return address, and
 	 * 		available commands.
 	 */
-	for (civ_addr=0x01; civ_addr<=0x7f; civ_addr++) {
-
-		frm_len = make_cmd_frame((char *) buf, civ_addr, CTRLID,
-				C_RD_TRXID, S_RD_TRXID, NULL, 0);
-
-		serial_flush(port);
-		write_block(port, (char *) buf, frm_len);
-
-		/* read out the bytes we just sent
-	 	* TODO: check this is what we expect
-	 	*/
-		frm_len = read_icom_frame(port, buf);
-
-		/* this is the reply */
-		frm_len = read_icom_frame(port, buf);
-
-		/* timeout.. nobody's there */
-		if (frm_len <= 0)
-			continue;
-
-		if (buf[7] != FI && buf[5] != FI) {
-			/* protocol error, unexpected reply.
-			 * is this a CI-V device?
-			 */
-			close(port->fd);
-			return RIG_MODEL_NONE;
-		} else if (buf[4] == NAK) {
-			/*
-		 	* this is an Icom, but it does not support transceiver ID
-		 	* try to guess from the return address
-		 	*/
-			civ_id = buf[3];
-		} else {
-			civ_id = buf[6];
-		}
-
-		for (i=0; icom_addr_list[i].model != RIG_MODEL_NONE; i++) {
-			if (icom_addr_list[i].re_civ_addr == civ_id) {
-				rig_debug(RIG_DEBUG_VERBOSE,"probe_icom: found %#x"
-							" at %#x\n", civ_id, buf[3]);
-				model = icom_addr_list[i].model;
-				if (cfunc)
-					(*cfunc)(port, model, data);
-				break;
-			}
-		}
-		/*
-		 * not found in known table....
-		 * update icom_addr_list[]!
-		 */
-		if (icom_addr_list[i].model == RIG_MODEL_NONE)
-			rig_debug(RIG_DEBUG_WARN,"probe_icom: found unknown device "
-						"with CI-V ID %#x, please report to Hamlib "
-						"developers.\n", civ_id);
-	}
+	icom_probe_send(&pr, C_RD_TRXID, S_RD_TRXID, BCASTID, 1);
+	retval = icom_probe_sweep(&pr, C_RD_TRXID, S_RD_TRXID, 0x01, 0x7f);
 
 	/*
 	 * Try to identify OptoScan
 	 */
-	for (civ_addr=0x80; civ_addr<=0x8f; civ_addr++) {
-
-		frm_len = make_cmd_frame((char *) buf, civ_addr, CTRLID,
-				C_CTL_MISC, S_OPTO_RDID, NULL, 0);
-
-		serial_flush(port);
-		write_block(port, (char *) buf, frm_len);
-
-		/* read out the bytes we just sent
-	 	* TODO: check this is what we expect
-	 	*/
-		frm_len = read_icom_frame(port, buf);
+	if (retval == RIG_OK)
+		retval = icom_probe_sweep(&pr, C_CTL_MISC, S_OPTO_RDID, 0x80, 0x8f);
 
-		/* this is the reply */
-		frm_len = read_icom_frame(port, buf);
+	ser_close(port);
 
-		/* timeout.. nobody's there */
-		if (frm_len <= 0)
-			continue;
-
-		/* wrong protocol? */
-		if (frm_len != 7 || buf[4] != C_CTL_MISC || buf[5] != S_OPTO_RDID)
-			continue;
-
-		rig_debug(RIG_DEBUG_VERBOSE, "%s, found OptoScan%c%c%c, software version %d.%d, "
-				"interface version %d.%d, at %#x\n",
-				__FUNCTION__,
-				buf[2], buf[3], buf[4],
-				buf[5] >> 4, buf[5] & 0xf,
-				buf[6] >> 4, buf[6] & 0xf,
-				civ_addr);
-
-		if (buf[6] == '5' && buf[7] == '3' && buf[8] == '5')
-			model = RIG_MODEL_OS535;
-		else if (buf[6] == '4' && buf[7] == '5' && buf[8] == '6')
-			model = RIG_MODEL_OS456;
-		else
-			continue;
-
-		if (cfunc)
-			(*cfunc)(port, model, data);
-		break;
-	}
-
-	close(port->fd);
+	/* protocol error, unexpected reply. is this a CI-V device? */
+	if (retval == -RIG_EPROTO)
+		return pr.model;
 
 	/*
 	 * Assumes all the rigs on the bus are running at same speed.
 	 * So if one at least has been found, none will be at lower speed.
 	 */
-	if (model != RIG_MODEL_NONE)
-		return model;
+	if (pr.model != RIG_MODEL_NONE)
+		return pr.model;
 	}
 
-	return model;
+	return RIG_MODEL_NONE;
 }
 
 /*
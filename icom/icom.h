@@ -114,11 +114,54 @@ struct icom_priv_caps {
 };
 
 
+/*
+ * Transceive events decoded but not delivered yet, see icom_decode_frame().
+ * Index 0 of the VFO arrays is the selected VFO, 1 the unselected one.
+ */
+#define ICOM_TRN_FREQ	0x01	/* bit shifted by the VFO index */
+#define ICOM_TRN_MODE	0x04	/* same */
+#define ICOM_TRN_RAWSTR	0x10
+#define ICOM_TRN_VFO	0x20
+#define ICOM_TRN_SPLIT	0x40
+#define ICOM_TRN_PTT	0x80
+
+struct icom_trn {
+	int interval;		/* ms between two deliveries, 0 for each frame */
+	unsigned pending;	/* ICOM_TRN_* to deliver */
+	int deferred;		/* the event thread will call back */
+	struct timeval next;	/* no delivery before */
+	freq_t freq[2];
+	rmode_t mode[2];
+	pbwidth_t width[2];
+	int rawstr;
+	vfo_t vfo;
+	split_t split;
+	ptt_t ptt;
+};
+
+/*
+ * Spectrum scope sweep being received, see icom_scope_frame().
+ * The rigs send a sweep in divisions, the first one telling the
+ * edges, the others up to 50 amplitudes each.
+ */
+#define ICOM_SCOPE_MAXLEN 1024	/* points of a sweep, 689 on the IC-7610 */
+#define ICOM_SCOPE_LEVEL_MAX 160	/* amplitude of a full scale point */
+
+struct icom_scope {
+	int seq;		/* last division stored, 0 for none */
+	rig_spectrum_line_t line;	/* sweep being assembled */
+	unsigned char data[ICOM_SCOPE_MAXLEN];
+};
+
 struct icom_priv_data {
 	unsigned char re_civ_addr;	/* the remote equipment's CI-V address*/
 	int civ_731_mode; /* Off: freqs on 10 digits, On: freqs on 8 digits */
 	int no_xchg; /* Off: use VFO XCHG to set other VFO, On: use set VFO to set other VFO */
 	pltstate_t *pltstate;	/* only on optoscan */
+	struct icom_bus *bus;	/* CI-V bus shared with other rigs, see frame.c */
+	struct icom_trn trn;	/* transceive events held back */
+	int scope_data;		/* rig asked to send its scope sweeps */
+	struct icom_scope scope[2];	/* main and sub scope */
 };
 
 extern const struct ts_sc_list r8500_ts_sc_list[];
@@ -141,6 +184,8 @@ extern const pbwidth_t rtty_fil[];	/* rtty filter passband width; available on 7
 pbwidth_t icom_get_dsp_flt(RIG *rig, rmode_t mode);
 
 int icom_init(RIG *rig);
+int icom_decode_frame(RIG *rig, const unsigned char *buf, int frm_len);
+int icom_scope_output(RIG *rig, int on);
 int icom_cleanup(RIG *rig);
 int icom_set_freq(RIG *rig, vfo_t vfo, freq_t freq);
 int icom_get_freq(RIG *rig, vfo_t vfo, freq_t *freq);
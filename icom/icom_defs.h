@@ -92,6 +92,9 @@
 #define C_CTL_MEM	0x1a		/* Misc memory/bank/rig control functions, Sc */
 #define C_SET_TONE	0x1b		/* Set tone frequency */
 #define C_CTL_PTT	0x1c		/* Control Transmit On/Off, Sc */
+#define C_SEND_SEL_FREQ	0x25		/* Send/Read selected/unselected VFO frequency, Sc */
+#define C_SEND_SEL_MODE	0x26		/* Send/Read selected/unselected VFO mode, Sc */
+#define C_CTL_SCP	0x27		/* Spectrum scope data and control, Sc */
 #define C_CTL_MISC	0x7f		/* Miscellaneous control, Sc */
 
 /*
@@ -328,6 +331,13 @@
 #define S_MEM_SATMODE       0x07    /* Satellite mode (on/off) */
 #define S_MEM_BANDSCOPE     0x08    /* Simple bandscope (on/off) */
 
+/*
+ * Spectrum scope (C_CTL_SCP) sub commands
+ */
+#define S_SCP_DAT	0x00	/* Scope waveform data */
+#define S_SCP_STS	0x10	/* Scope ON/OFF */
+#define S_SCP_DOP	0x11	/* Scope data output to CI-V ON/OFF */
+
 
 /*
  * Tone control (C_SET_TONE) subcommands
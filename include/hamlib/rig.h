@@ -1104,8 +1104,59 @@ typedef struct cal_table cal_table_t;
 
 
 typedef int (*chan_cb_t) (RIG *, channel_t**, int, const chan_t*, rig_ptr_t);
+
+/**
+ * \brief Memory channel difference, see rig_set_chan_diff()
+ */
+typedef enum {
+	RIG_CHAN_SAME = 0,	/*!< Memory already holds the channel data */
+	RIG_CHAN_CHANGED,	/*!< Memory holds different data */
+	RIG_CHAN_NEW,		/*!< Memory is empty */
+	RIG_CHAN_DELETED	/*!< Memory is to be emptied */
+} chan_diff_t;
+
+#define RIG_CHAN_DIFF_DRYRUN	(1<<0)	/*!< Report the differences, write nothing */
+#define RIG_CHAN_DIFF_DELETE	(1<<1)	/*!< Delete the memories not listed */
+#define RIG_CHAN_DIFF_REREAD	(1<<2)	/*!< Read back every memory, ignoring the known hashes */
+
+typedef int (*chan_diff_cb_t) (RIG *, const channel_t *, chan_diff_t, rig_ptr_t);
 typedef int (*confval_cb_t) (RIG *, const struct confparams *, value_t *, rig_ptr_t);
 
+/**
+ * \brief Items which can be read by rig_get_state_batch()
+ */
+enum rig_query_e {
+	RIG_QUERY_FREQ = 0,	/*!< Frequency, as rig_get_freq() */
+	RIG_QUERY_MODE,		/*!< Mode and passband, as rig_get_mode() */
+	RIG_QUERY_VFO,		/*!< Current VFO, as rig_get_vfo() */
+	RIG_QUERY_PTT,		/*!< PTT status, as rig_get_ptt() */
+	RIG_QUERY_LEVEL		/*!< Level, as rig_get_level() */
+};
+
+/**
+ * \brief One query of rig_get_state_batch()
+ *
+ * \a vfo, \a item and, for RIG_QUERY_LEVEL, \a level are set by the
+ * caller.  The result is stored in the member of \a u matching
+ * \a item, and the status of the query in \a retcode.
+ */
+typedef struct rig_query {
+	vfo_t vfo;		/*!< VFO to query */
+	enum rig_query_e item;	/*!< Item to query */
+	setting_t level;	/*!< Level to read, for RIG_QUERY_LEVEL */
+	int retcode;		/*!< RIG_OK, or error code of this query */
+	union {
+		freq_t freq;	/*!< RIG_QUERY_FREQ result */
+		struct {
+			rmode_t mode;
+			pbwidth_t width;
+		} mode;		/*!< RIG_QUERY_MODE result */
+		vfo_t vfo;	/*!< RIG_QUERY_VFO result */
+		ptt_t ptt;	/*!< RIG_QUERY_PTT result */
+		value_t level;	/*!< RIG_QUERY_LEVEL result */
+	} u;
+} rig_query_t;
+
 /**
  * \brief Rig data structure.
  *
@@ -1327,6 +1378,13 @@ struct rig_caps {
 
   const char *clone_combo_set;	/*!< String describing key combination to enter load cloning mode */
   const char *clone_combo_get;	/*!< String describing key combination to enter save cloning mode */
+
+  /* answer the queries it can with their retcode still -RIG_ENIMPL */
+  int (*get_state_batch) (RIG * rig, rig_query_t * query, int count);
+
+  /* read count memory channels from start, status[i] is RIG_OK,
+   * -RIG_ENAVAIL for an empty channel, or another error */
+  int (*get_chan_range) (RIG * rig, int start, int count, channel_t chans[], int status[]);
 };
 
 /**
@@ -1376,6 +1434,7 @@ typedef struct hamlib_port {
         char *product;     /*!< Product (opt.) */
 	} usb;			/*!< USB attributes */
   } parm;			/*!< Port parameter union */
+  void *rxbuf;			/*!< Receive buffer, hamlib internal use */
 } hamlib_port_t;
 
 #if !defined(__APPLE__) || !defined(__cplusplus)
@@ -1383,6 +1442,32 @@ typedef hamlib_port_t port_t;
 #endif
 
 
+/**
+ * \brief Frontend cache of the rig state
+ *
+ * Opt-in read-through cache of the current_freq, current_mode/current_width
+ * and current_vfo fields of struct rig_state, enabled per field by setting
+ * the "cache_freq_timeout", "cache_mode_timeout" and "cache_vfo_timeout"
+ * configuration tokens to a non-zero validity duration.
+ * Backends supporting it may also reuse raw command replies for
+ * "cache_resp_timeout" ms.  The cache is dropped on each transceive
+ * event, unless the backend refreshes it from the data received.
+ */
+struct rig_cache {
+  int timeout_freq;	/*!< Validity of current_freq in ms, 0 to disable */
+  int timeout_mode;	/*!< Validity of current_mode/width in ms, 0 to disable */
+  int timeout_vfo;	/*!< Validity of current_vfo in ms, 0 to disable */
+  struct { int tv_sec,tv_usec; } time_freq;	/*!< hamlib internal use */
+  struct { int tv_sec,tv_usec; } time_mode;	/*!< hamlib internal use */
+  struct { int tv_sec,tv_usec; } time_vfo;	/*!< hamlib internal use */
+  unsigned long hits;	/*!< Number of reads answered from the cache */
+  unsigned long misses;	/*!< Number of reads forwarded to the backend */
+  int timeout_resp;	/*!< Validity of cached command replies in ms, 0 to disable */
+  rig_ptr_t resp;	/*!< hamlib internal use */
+  int trn_update;	/*!< Set by backends refreshing the cache from transceive data */
+};
+
+
 /**
  * \brief Rig state containing live data and customized fields.
  *
@@ -1452,6 +1537,12 @@ struct rig_state {
   pbwidth_t current_width;	/*!< Passband width currently set */
   vfo_t tx_vfo;		/*!< Tx VFO currently set */
   int mode_list;		/*!< Complete list of modes for this rig */
+  struct rig_cache cache;	/*!< State cache, see struct rig_cache */
+  rig_ptr_t event_queue;	/*!< Asynchronous event queue, see rig_event_queue() */
+  rig_ptr_t chan_hash;	/*!< Memory channel content hashes, hamlib internal use */
+  rig_ptr_t telemetry;	/*!< Level telemetry, see rig_telemetry_setup() */
+  rig_ptr_t port_lock;	/*!< Serializes the port I/O with the event thread, hamlib internal use */
+  rig_ptr_t conf_saved;	/*!< Backend conf applied again at open, hamlib internal use */
 
 };
 
@@ -1464,6 +1555,25 @@ typedef int (*vfo_cb_t) (RIG *, vfo_t, rig_ptr_t);
 typedef int (*ptt_cb_t) (RIG *, vfo_t, ptt_t, rig_ptr_t);
 typedef int (*dcd_cb_t) (RIG *, vfo_t, dcd_t, rig_ptr_t);
 typedef int (*pltune_cb_t) (RIG *, vfo_t, freq_t *, rmode_t *, pbwidth_t *, rig_ptr_t);
+typedef int (*chan_progress_cb_t) (RIG *, int, int, int, rig_ptr_t);
+typedef int (*split_cb_t) (RIG *, vfo_t, split_t, vfo_t, rig_ptr_t);
+typedef int (*level_cb_t) (RIG *, vfo_t, setting_t, value_t, rig_ptr_t);
+
+/**
+ * \brief Spectrum scope sweep, see rig_set_spectrum_callback()
+ */
+typedef struct rig_spectrum_line {
+	int id;			/*!< Scope number, 0 for the main one */
+	int centered;		/*!< Centered on the frequency, otherwise fixed edges */
+	freq_t low_edge_freq;	/*!< Frequency of the first point */
+	freq_t high_edge_freq;	/*!< Frequency of the last point */
+	int out_of_range;	/*!< The edges are out of the rig range */
+	int data_level_max;	/*!< Amplitude of a full scale point */
+	int data_length;	/*!< Number of points */
+	const unsigned char *data;	/*!< Amplitudes, from 0 to data_level_max */
+} rig_spectrum_line_t;
+
+typedef int (*spectrum_cb_t) (RIG *, const rig_spectrum_line_t *, rig_ptr_t);
 
 /**
  * \brief Callback functions and args for rig event.
@@ -1480,7 +1590,8 @@ typedef int (*pltune_cb_t) (RIG *, vfo_t, freq_t *, rmode_t *, pbwidth_t *, rig_
  * really appropriate in a GUI.
  *
  * \sa rig_set_freq_callback, rig_set_mode_callback, rig_set_vfo_callback,
- *	 rig_set_ptt_callback, rig_set_dcd_callback
+ *	 rig_set_ptt_callback, rig_set_dcd_callback, rig_set_split_callback,
+ *	 rig_set_level_callback, rig_set_spectrum_callback
  */
 struct rig_callbacks {
   freq_cb_t freq_event;	/*!< Frequency change event */
@@ -1495,9 +1606,100 @@ struct rig_callbacks {
   rig_ptr_t dcd_arg;	/*!< DCD change argument */
   pltune_cb_t pltune;   /*!< Pipeline tuning module freq/mode/width callback */
   rig_ptr_t pltune_arg; /*!< Pipeline tuning argument */
+  chan_progress_cb_t chan_progress;	/*!< Bulk channel transfer progress */
+  rig_ptr_t chan_progress_arg;	/*!< Bulk channel transfer progress argument */
+  split_cb_t split_event;	/*!< Split change event */
+  rig_ptr_t split_arg;	/*!< Split change argument */
+  level_cb_t level_event;	/*!< Level change event, e.g. S-meter */
+  rig_ptr_t level_arg;	/*!< Level change argument */
+  spectrum_cb_t spectrum_event;	/*!< Spectrum scope sweep */
+  rig_ptr_t spectrum_arg;	/*!< Spectrum scope sweep argument */
   /* etc.. */
 };
 
+/**
+ * \brief Type of an event read with rig_event_poll()
+ */
+enum rig_event_e {
+	RIG_EVENT_FREQ = 0,	/*!< Frequency change */
+	RIG_EVENT_MODE,		/*!< Mode change */
+	RIG_EVENT_VFO,		/*!< VFO change */
+	RIG_EVENT_PTT,		/*!< PTT change */
+	RIG_EVENT_DCD,		/*!< DCD change */
+	RIG_EVENT_SPLIT,	/*!< Split change */
+	RIG_EVENT_LEVEL		/*!< Level change */
+};
+
+/**
+ * \brief Event read with rig_event_poll()
+ *
+ * Carries the arguments the matching callback would have received.
+ */
+typedef struct rig_event {
+	enum rig_event_e type;	/*!< Type of the event */
+	vfo_t vfo;		/*!< VFO the event applies to */
+	union {
+		freq_t freq;	/*!< RIG_EVENT_FREQ */
+		struct {
+			rmode_t mode;
+			pbwidth_t width;
+		} mode;		/*!< RIG_EVENT_MODE */
+		ptt_t ptt;	/*!< RIG_EVENT_PTT */
+		dcd_t dcd;	/*!< RIG_EVENT_DCD */
+		struct {
+			split_t split;
+			vfo_t tx_vfo;
+		} split;	/*!< RIG_EVENT_SPLIT */
+		struct {
+			setting_t level;
+			value_t val;
+		} level;	/*!< RIG_EVENT_LEVEL */
+	} u;
+} rig_event_t;
+
+/**
+ * \brief Level sample read with rig_telemetry_read()
+ */
+typedef struct rig_telemetry {
+	unsigned long seq;	/*!< Sample number, gaps tell about lost samples */
+	long ts_sec;		/*!< Monotonic time of the sample, seconds */
+	long ts_nsec;		/*!< Monotonic time of the sample, nanoseconds */
+	setting_t level;	/*!< Level sampled, RIG_LEVEL_* */
+	value_t val;		/*!< Level value */
+} rig_telemetry_t;
+
+/**
+ * \brief Frequency sweep description, see rig_sweep()
+ */
+typedef struct rig_sweep {
+	freq_t start;		/*!< First frequency */
+	freq_t stop;		/*!< Last frequency, included when on a step */
+	freq_t step;		/*!< Frequency step */
+	setting_t level;	/*!< Level read at each point, e.g. RIG_LEVEL_SWR */
+	int flags;		/*!< RIG_SWEEP_* */
+	int dwell_min;		/*!< Shortest wait before the reading, ms */
+	int dwell_max;		/*!< Longest wait for the level to settle, ms */
+	float settle;		/*!< Largest change between two settled readings */
+} rig_sweep_t;
+
+#define RIG_SWEEP_PTT		(1<<0)	/*!< Transmit during the readings, e.g. for SWR */
+#define RIG_SWEEP_KEEP_TX	(1<<1)	/*!< With RIG_SWEEP_PTT, keep transmitting across the steps */
+
+/**
+ * \brief One point of a sweep, filled by rig_sweep()
+ */
+typedef struct rig_sweep_point {
+	freq_t freq;		/*!< Frequency of the point */
+	value_t val;		/*!< Level read */
+	int dwell;		/*!< Time waited for the level to settle, ms */
+	int status;		/*!< RIG_OK, or the error reading the level */
+} rig_sweep_point_t;
+
+/**
+ * \brief Callback of rig_sweep(), return 0 to stop the sweep
+ */
+typedef int (*sweep_cb_t) (RIG *, const rig_sweep_point_t *, rig_ptr_t);
+
 /**
  * \brief The Rig structure
  *
@@ -1648,6 +1850,7 @@ extern HAMLIB_EXPORT(int) rig_set_chan_all HAMLIB_PARAMS((RIG *rig, const channe
 extern HAMLIB_EXPORT(int) rig_get_chan_all HAMLIB_PARAMS((RIG *rig, channel_t chans[]));
 extern HAMLIB_EXPORT(int) rig_set_chan_all_cb HAMLIB_PARAMS((RIG *rig, chan_cb_t chan_cb, rig_ptr_t));
 extern HAMLIB_EXPORT(int) rig_get_chan_all_cb HAMLIB_PARAMS((RIG *rig, chan_cb_t chan_cb, rig_ptr_t));
+extern HAMLIB_EXPORT(int) rig_set_chan_diff HAMLIB_PARAMS((RIG *rig, const channel_t chans[], int count, int flags, chan_diff_cb_t diff_cb, rig_ptr_t));
 
 extern HAMLIB_EXPORT(int) rig_set_mem_all_cb HAMLIB_PARAMS((RIG *rig, chan_cb_t chan_cb, confval_cb_t parm_cb, rig_ptr_t));
 extern HAMLIB_EXPORT(int) rig_get_mem_all_cb HAMLIB_PARAMS((RIG *rig, chan_cb_t chan_cb, confval_cb_t parm_cb, rig_ptr_t));
@@ -1665,8 +1868,25 @@ extern HAMLIB_EXPORT(int) rig_set_vfo_callback HAMLIB_PARAMS((RIG *, vfo_cb_t, r
 extern HAMLIB_EXPORT(int) rig_set_ptt_callback HAMLIB_PARAMS((RIG *, ptt_cb_t, rig_ptr_t));
 extern HAMLIB_EXPORT(int) rig_set_dcd_callback HAMLIB_PARAMS((RIG *, dcd_cb_t, rig_ptr_t));
 extern HAMLIB_EXPORT(int) rig_set_pltune_callback HAMLIB_PARAMS((RIG *, pltune_cb_t, rig_ptr_t));
+extern HAMLIB_EXPORT(int) rig_set_chan_progress_callback HAMLIB_PARAMS((RIG *, chan_progress_cb_t, rig_ptr_t));
+extern HAMLIB_EXPORT(int) rig_set_split_callback HAMLIB_PARAMS((RIG *, split_cb_t, rig_ptr_t));
+extern HAMLIB_EXPORT(int) rig_set_level_callback HAMLIB_PARAMS((RIG *, level_cb_t, rig_ptr_t));
+extern HAMLIB_EXPORT(int) rig_set_spectrum_callback HAMLIB_PARAMS((RIG *, spectrum_cb_t, rig_ptr_t));
+
+extern HAMLIB_EXPORT(int) rig_event_queue HAMLIB_PARAMS((RIG *rig, int size));
+extern HAMLIB_EXPORT(int) rig_event_poll HAMLIB_PARAMS((RIG *rig, rig_event_t *event));
+extern HAMLIB_EXPORT(int) rig_event_fd HAMLIB_PARAMS((RIG *rig));
+extern HAMLIB_EXPORT(int) rig_event_stats HAMLIB_PARAMS((RIG *rig, unsigned long *dropped, unsigned long *overruns));
+
+extern HAMLIB_EXPORT(int) rig_telemetry_setup HAMLIB_PARAMS((RIG *rig, setting_t levels, int size));
+extern HAMLIB_EXPORT(int) rig_telemetry_sample HAMLIB_PARAMS((RIG *rig));
+extern HAMLIB_EXPORT(int) rig_telemetry_read HAMLIB_PARAMS((RIG *rig, unsigned long *cursor, rig_telemetry_t samples[], int max));
+
+extern HAMLIB_EXPORT(int) rig_sweep_count HAMLIB_PARAMS((const rig_sweep_t *sweep));
+extern HAMLIB_EXPORT(int) rig_sweep HAMLIB_PARAMS((RIG *rig, vfo_t vfo, const rig_sweep_t *sweep, rig_sweep_point_t points[], int max, sweep_cb_t cb, rig_ptr_t arg));
 
 extern HAMLIB_EXPORT(const char *) rig_get_info HAMLIB_PARAMS((RIG *rig));
+extern HAMLIB_EXPORT(int) rig_get_state_batch HAMLIB_PARAMS((RIG *rig, rig_query_t *query, int count));
 
 extern HAMLIB_EXPORT(const struct rig_caps *) rig_get_caps HAMLIB_PARAMS((rig_model_t rig_model));
 extern HAMLIB_EXPORT(const freq_range_t *) rig_get_range HAMLIB_PARAMS((const freq_range_t range_list[], freq_t freq, rmode_t mode));
@@ -1694,6 +1914,7 @@ extern HAMLIB_EXPORT(FILE*) rig_set_debug_file HAMLIB_PARAMS((FILE *stream));
 extern HAMLIB_EXPORT(int) rig_register HAMLIB_PARAMS((const struct rig_caps *caps));
 extern HAMLIB_EXPORT(int) rig_unregister HAMLIB_PARAMS((rig_model_t rig_model));
 extern HAMLIB_EXPORT(int) rig_list_foreach HAMLIB_PARAMS((int (*cfunc)(const struct rig_caps*, rig_ptr_t), rig_ptr_t data));
+extern HAMLIB_EXPORT(rig_model_t) rig_lookup_model HAMLIB_PARAMS((const char *mfg_name, const char *model_name));
 extern HAMLIB_EXPORT(int) rig_load_backend HAMLIB_PARAMS((const char *be_name));
 extern HAMLIB_EXPORT(int) rig_check_backend HAMLIB_PARAMS((rig_model_t rig_model));
 extern HAMLIB_EXPORT(int) rig_load_all_backends HAMLIB_PARAMS((void));
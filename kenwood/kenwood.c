@@ -37,6 +37,8 @@
 #include "misc.h"
 #include "register.h"
 #include "cal.h"
+#include "cache.h"
+#include "event.h"
 
 #include "kenwood.h"
 
@@ -165,6 +167,146 @@ const struct confparams kenwood_cfg_params[] = {
 };
 
 
+/*
+ * kenwood_check_reply
+ * Validate a reply of len bytes, as returned by read_string(), in a
+ * single pass and strip its terminator.  *retry is set when resending
+ * the command may help.
+ */
+static int kenwood_check_reply(RIG *rig, const char *cmdstr, char *data,
+				int len, int *retry)
+{
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+
+	*retry = 0;
+
+	/* Check that command termination is correct */
+	if (len <= 0 || data[len - 1] != caps->cmdtrm) {
+		rig_debug(RIG_DEBUG_ERR, "%s: Command is not correctly terminated '%s'\n",
+				__func__, data);
+		*retry = 1;
+		return -RIG_EPROTO;
+	}
+
+	if (len == 2) {
+	switch (data[0]) {
+	case 'N':
+		/* Command recognised by rig but invalid data entered. */
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: NegAck for '%s'\n", __func__, cmdstr);
+		return -RIG_ENAVAIL;
+	case 'O':
+		/* Too many characters sent without a carriage return */
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: Overflow for '%s'\n", __func__, cmdstr);
+		*retry = 1;
+		return -RIG_EPROTO;
+	case 'E':
+		/* Communication error */
+		rig_debug(RIG_DEBUG_VERBOSE, "%s: Communication error for '%s'\n", __func__, cmdstr);
+		*retry = 1;
+		return -RIG_EIO;
+	case '?':
+		/* Command not understood by rig */
+		rig_debug(RIG_DEBUG_ERR, "%s: Unknown command '%s'\n", __func__, cmdstr);
+		*retry = 1;
+		return -RIG_ERJCTED;
+	}
+	}
+
+	/* always give back a null terminated string without
+	 * the command terminator.
+	 */
+	data[len - 1] = '\0';
+
+	/*
+	 * Check that we received the correct reply. The first two characters
+	 * should be the same as command.
+	 */
+	if (cmdstr && (data[0] != cmdstr[0] || data[1] != cmdstr[1])) {
+		/*
+		 * TODO: When RIG_TRN is enabled, we can pass the string
+		 * to the decoder for callback. That way we don't ignore
+		 * any commands.
+		 */
+		rig_debug(RIG_DEBUG_ERR, "%s: wrong reply %c%c for command %c%c\n",
+			__func__, data[0], data[1], cmdstr[0], cmdstr[1]);
+		*retry = 1;
+		return -RIG_EPROTO;
+	}
+
+	/*
+	 * Memory reads echo their parameters, e.g. "MR0 17" or "MR0017".
+	 * Check them all, a late reply for another channel may be left
+	 * over by a failed batch.
+	 */
+	if (cmdstr && cmdstr[0] == 'M' && cmdstr[1] == 'R' && isdigit((int)cmdstr[2])) {
+		size_t cmd_len = strcspn(cmdstr, ";\r");
+
+		if (len - 1 < cmd_len || memcmp(data, cmdstr, cmd_len)) {
+			rig_debug(RIG_DEBUG_ERR, "%s: wrong reply %.*s for command %.*s\n",
+				__func__, (int)cmd_len, data, (int)cmd_len, cmdstr);
+			*retry = 1;
+			return -RIG_EPROTO;
+		}
+	}
+
+	return RIG_OK;
+}
+
+
+/*
+ * kenwood_flush
+ * Drop stale input before a new command.  The tcflush() is only needed
+ * when unsolicited or late data may be pending: transceive mode, a
+ * previous failed transaction, or bytes already read ahead.
+ */
+static void kenwood_flush(RIG *rig, int force)
+{
+	struct kenwood_priv_data *priv = rig->state.priv;
+	hamlib_port_t *port = &rig->state.rigport;
+
+	if (force || priv->flush_pending
+			|| rig->state.transceive != RIG_TRN_OFF
+			|| port_rx_pending(port))
+		serial_flush(port);
+
+	priv->flush_pending = 0;
+}
+
+
+/*
+ * kenwood_write_cmd
+ * Send cmdstr, appending the command terminator if missing.  The
+ * terminated command is assembled in the per rig scratch buffer.
+ */
+static int kenwood_write_cmd(RIG *rig, const char *cmdstr)
+{
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	struct kenwood_priv_data *priv = rig->state.priv;
+	hamlib_port_t *port = &rig->state.rigport;
+	int len = strlen(cmdstr);
+	int retval;
+
+	if (len == 0)
+		return -RIG_EINVAL;
+
+	/* XXX the if is temporary, until all invocations are fixed */
+	if (cmdstr[len - 1] == ';' || cmdstr[len - 1] == '\r')
+		return write_block(port, cmdstr, len);
+
+	if (len < sizeof(priv->cmd_buf)) {
+		memcpy(priv->cmd_buf, cmdstr, len);
+		priv->cmd_buf[len++] = caps->cmdtrm;
+		return write_block(port, priv->cmd_buf, len);
+	}
+
+	/* oversized command, send the terminator on its own */
+	retval = write_block(port, cmdstr, len);
+	if (retval != RIG_OK)
+		return retval;
+	return write_block(port, &caps->cmdtrm, 1);
+}
+
+
 /**
  * kenwood_transaction
  * Assumes rig!=NULL rig->state!=NULL rig->caps!=NULL
@@ -195,141 +337,178 @@ int kenwood_transaction(RIG *rig, const char *cmdstr, int cmd_len,
 		return -RIG_EINVAL;
 
 	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	struct kenwood_priv_data *priv = rig->state.priv;
 	struct rig_state *rs;
-	int retval;
-	char cmdtrm[2];  /* Default Command/Reply termination char */
+	int retval, len;
 	int retry_read = 0;
+	int retry;
 
 	rs = &rig->state;
+	rig_port_lock(rig);
 	rs->hold_decode = 1;
 
 	rig_debug(RIG_DEBUG_TRACE, "%s: cmdstr = %s\n", __func__, cmdstr);
 
-	cmdtrm[0] = caps->cmdtrm;
-	cmdtrm[1] = '\0';
+	if (cmdstr && (data == NULL || *datasize <= 0)) {
+		/* a set command, what the rig would answer may have changed */
+		rig_resp_cache_invalidate(rig, NULL, 0);
+	} else if (cmdstr && rig_resp_cache_get(rig, cmdstr, strlen(cmdstr), data, datasize)) {
+		rs->hold_decode = 0;
+		rig_port_unlock(rig);
+		return RIG_OK;
+	}
 
 transaction_write:
 
-	serial_flush(&rs->rigport);
+	kenwood_flush(rig, retry_read);
 
 	if (cmdstr) {
-
-	char *cmd;
-	int len = strlen(cmdstr);
-
-	cmd = malloc(len + 2);
-	if (cmd == NULL) {
-		retval = -RIG_ENOMEM;
-		goto transaction_quit;
-	}
-
-	memcpy(cmd, cmdstr, len);
-
-	/* XXX the if is temporary, until all invocations are fixed */
-	if (cmdstr[len - 1] != ';' && cmdstr[len - 1] != '\r') {
-		cmd[len] = caps->cmdtrm;
-		len++;
-	}
-
-	retval = write_block(&rs->rigport, cmd, len);
-
-	free(cmd);
-
-	if (retval != RIG_OK)
-		goto transaction_quit;
+		retval = kenwood_write_cmd(rig, cmdstr);
+		if (retval != RIG_OK)
+			goto transaction_quit;
 	}
 
 	if (data == NULL || *datasize <= 0) {
 		rig->state.hold_decode = 0;
+		rig_port_unlock(rig);
 		return RIG_OK;  /* don't want a reply */
 	}
 
-	memset(data,0,*datasize);
-	retval = read_string(&rs->rigport, data, *datasize, cmdtrm, strlen(cmdtrm));
+	retval = read_string(&rs->rigport, data, *datasize, &caps->cmdtrm, 1);
 	if (retval < 0) {
 		if (retry_read++ < rig->state.rigport.retry)
 			goto transaction_write;
 		goto transaction_quit;
 	}
 
-	/* Check that command termination is correct */
-	if (strchr(cmdtrm, data[strlen(data)-1])==NULL) {
-		rig_debug(RIG_DEBUG_ERR, "%s: Command is not correctly terminated '%s'\n", __func__, data);
-		if (retry_read++ < rig->state.rigport.retry)
-			goto transaction_write;
-		retval = -RIG_EPROTO;
-		goto transaction_quit;
-	}
+	len = retval;
 
-	if (strlen(data) == 2) {
-	switch (data[0]) {
-	case 'N':
-		/* Command recognised by rig but invalid data entered. */
-		rig_debug(RIG_DEBUG_VERBOSE, "%s: NegAck for '%s'\n", __func__, cmdstr);
-		retval = -RIG_ENAVAIL;
-		goto transaction_quit;
-	case 'O':
-		/* Too many characters sent without a carriage return */
-		rig_debug(RIG_DEBUG_VERBOSE, "%s: Overflow for '%s'\n", __func__, cmdstr);
-		if (retry_read++ < rig->state.rigport.retry)
-			goto transaction_write;
-		retval = -RIG_EPROTO;
-		goto transaction_quit;
-	case 'E':
-		/* Communication error */
-		rig_debug(RIG_DEBUG_VERBOSE, "%s: Communication error for '%s'\n", __func__, cmdstr);
-		if (retry_read++ < rig->state.rigport.retry)
-			goto transaction_write;
-		retval = -RIG_EIO;
-		goto transaction_quit;
-	case '?':
-			/* Command not understood by rig */
-		rig_debug(RIG_DEBUG_ERR, "%s: Unknown command '%s'\n", __func__, cmdstr);
-		if (retry_read++ < rig->state.rigport.retry)
+	retval = kenwood_check_reply(rig, cmdstr, data, len, &retry);
+	if (retval != RIG_OK) {
+		if (retry && retry_read++ < rig->state.rigport.retry)
 			goto transaction_write;
-		retval = -RIG_ERJCTED;
 		goto transaction_quit;
 	}
-	}
 
-	*datasize = retval;	/* this is retval from successful
+	*datasize = len;	/* this is retval from successful
 				   read_string above, don't assign
 				   until here because IN value is
 				   needed for retries */
 
-	/* always give back a null terminated string without
-	 * the command terminator.
-	 */
-	if (strlen(data) > 0)
-		data[strlen(data) - 1] = '\0';  /* not elegant, but works */
-	else
-		data[0] = '\0';
+	if (cmdstr)
+		rig_resp_cache_put(rig, cmdstr, strlen(cmdstr), data, len);
 
-	/*
-	 * Check that we received the correct reply. The first two characters
-	 * should be the same as command.
-	 */
-	if (cmdstr && (data[0] != cmdstr[0] || data[1] != cmdstr[1])) {
-		/*
-		 * TODO: When RIG_TRN is enabled, we can pass the string
-		 * to the decoder for callback. That way we don't ignore
-		 * any commands.
-		 */
-		rig_debug(RIG_DEBUG_ERR, "%s: wrong reply %c%c for command %c%c\n",
-			__func__, data[0], data[1], cmdstr[0], cmdstr[1]);
+transaction_quit:
 
-		if (retry_read++ < rig->state.rigport.retry)
-			goto transaction_write;
+	if (retval != RIG_OK)
+		priv->flush_pending = 1;
+	rs->hold_decode = 0;
+	rig_port_unlock(rig);
+	return retval;
+}
 
-		retval =  -RIG_EPROTO;
+
+/**
+ * kenwood_transaction_batch
+ * Send several commands in a single write and demultiplex the replies,
+ * saving one round-trip per command on rigs polled in a loop.
+ * Assumes rig!=NULL rig->state!=NULL rig->caps!=NULL
+ *
+ * Parameters:
+ * cmdstr:		Commands to be sent, each one terminated by the rig
+ * 				command terminator, e.g. "FA;FB;MD;".
+ * data:		Array of count reply buffers.  data[i] can be NULL
+ * 				when command i has no reply (a set command).
+ * datasize:	Array of count buffer sizes, in and out as for
+ * 				kenwood_transaction().
+ * count:		Number of commands in cmdstr.
+ *
+ * returns:
+ *   RIG_OK, or the first error found, as for kenwood_transaction().
+ */
+int kenwood_transaction_batch(RIG *rig, const char *cmdstr, char *data[],
+				size_t datasize[], int count)
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+	if (!rig || !cmdstr || !data || !datasize
+			|| count <= 0 || count > KENWOOD_MAX_BATCH)
+		return -RIG_EINVAL;
+
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	struct kenwood_priv_data *priv = rig->state.priv;
+	struct rig_state *rs = &rig->state;
+	const char *cmd[KENWOOD_MAX_BATCH];
+	size_t insize[KENWOOD_MAX_BATCH];
+	const char *p;
+	int i, n, len, retval, retry;
+	int retry_read = 0;
+
+	/* locate each command, for reply checking */
+	len = strlen(cmdstr);
+	for (n = 0, p = cmdstr; p < cmdstr + len && n < KENWOOD_MAX_BATCH; n++) {
+		cmd[n] = p;
+		p = memchr(p, caps->cmdtrm, cmdstr + len - p);
+		if (!p)
+			break;
+		p++;
+	}
+	if (n != count || p != cmdstr + len) {
+		rig_debug(RIG_DEBUG_ERR, "%s: expected %d terminated commands in '%s'\n",
+				__func__, count, cmdstr);
+		return -RIG_EINVAL;
+	}
+
+	for (i = 0; i < count; i++) {
+		insize[i] = datasize[i];
+		if (data[i] == NULL || insize[i] <= 0)
+			rig_resp_cache_invalidate(rig, NULL, 0);
+	}
+
+	rig_port_lock(rig);
+	rs->hold_decode = 1;
+
+	rig_debug(RIG_DEBUG_TRACE, "%s: cmdstr = %s\n", __func__, cmdstr);
+
+transaction_write:
+
+	kenwood_flush(rig, retry_read);
+
+	retval = write_block(&rs->rigport, cmdstr, len);
+	if (retval != RIG_OK)
 		goto transaction_quit;
+
+	for (i = 0; i < count; i++) {
+		if (data[i] == NULL || insize[i] <= 0)
+			continue;
+
+		retval = read_string(&rs->rigport, data[i], insize[i], &caps->cmdtrm, 1);
+		if (retval < 0) {
+			if (retry_read++ < rs->rigport.retry)
+				goto transaction_write;
+			goto transaction_quit;
+		}
+		datasize[i] = retval;
+
+		retval = kenwood_check_reply(rig, cmd[i], data[i], retval, &retry);
+		if (retval != RIG_OK) {
+			if (retry && retry_read++ < rs->rigport.retry)
+				goto transaction_write;
+			goto transaction_quit;
+		}
+
+		rig_resp_cache_put(rig, cmd[i], strchr(cmd[i], caps->cmdtrm) - cmd[i],
+				data[i], datasize[i]);
 	}
 
 	retval = RIG_OK;
 
 transaction_quit:
 
+	if (retval != RIG_OK)
+		priv->flush_pending = 1;
 	rs->hold_decode = 0;
+	rig_port_unlock(rig);
 	return retval;
 }
 
@@ -417,6 +596,7 @@ int kenwood_init(RIG *rig)
 	memset(priv, 0x00, sizeof(struct kenwood_priv_data));
 
 	priv->split = RIG_SPLIT_OFF;
+	priv->flush_pending = 1;
 
 	rig->state.priv = priv;
 
@@ -2028,6 +2208,126 @@ int kenwood_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 	return RIG_OK;
 }
 
+/*
+ * kenwood_get_state_batch
+ * Pipeline the plain FA/FB/FC, MD and IF queries in one
+ * kenwood_transaction_batch() per KENWOOD_MAX_BATCH queries.  Queries
+ * which cannot be answered that way for this rig keep their -RIG_ENIMPL
+ * retcode and are read one by one by the frontend.
+ */
+int kenwood_get_state_batch(RIG *rig, rig_query_t *query, int count)
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+	if (!rig || !query)
+		return -RIG_EINVAL;
+
+	const struct rig_caps *rc = rig->caps;
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	struct kenwood_priv_data *priv = rig->state.priv;
+	char cmdstr[KENWOOD_MAX_BATCH * 4 + 1];
+	char buf[KENWOOD_MAX_BATCH][KENWOOD_MAX_BUF_LEN];
+	char *data[KENWOOD_MAX_BATCH];
+	size_t size[KENWOOD_MAX_BATCH];
+	int idx[KENWOOD_MAX_BATCH];
+	rig_query_t *q;
+	vfo_t tvfo;
+	int i, j, n, len, retval = RIG_OK;
+
+	for (i = 0; i < count; ) {
+		for (n = 0, len = 0; i < count && n < KENWOOD_MAX_BATCH; i++) {
+			q = &query[i];
+			if (q->retcode != -RIG_ENIMPL)
+				continue;
+
+			tvfo = (q->vfo == RIG_VFO_CURR || q->vfo == RIG_VFO_VFO) ?
+					rig->state.current_vfo : q->vfo;
+
+			switch (q->item) {
+			case RIG_QUERY_FREQ:
+				if (rc->get_freq != kenwood_get_freq)
+					continue;
+				if (tvfo == RIG_VFO_A)
+					len += sprintf(cmdstr + len, "FA;");
+				else if (tvfo == RIG_VFO_B)
+					len += sprintf(cmdstr + len, "FB;");
+				else if (tvfo == RIG_VFO_C)
+					len += sprintf(cmdstr + len, "FC;");
+				else
+					continue;
+				break;
+			case RIG_QUERY_MODE:
+				/* MD only reads the current VFO, TS-590 needs DA too */
+				if (rc->get_mode != kenwood_get_mode
+						|| RIG_MODEL_TS590S == rc->rig_model
+						|| tvfo != rig->state.current_vfo)
+					continue;
+				len += sprintf(cmdstr + len, "MD;");
+				break;
+			case RIG_QUERY_PTT:
+				/* IF; tells the CAT PTT, not the one of a RTS/DTR/parallel line */
+				if (rc->get_ptt != kenwood_get_ptt
+						|| (rig->state.pttport.type.ptt != RIG_PTT_RIG
+						&& rig->state.pttport.type.ptt != RIG_PTT_RIG_MICDATA))
+					continue;
+				len += sprintf(cmdstr + len, "IF;");
+				break;
+			default:
+				continue;
+			}
+
+			idx[n] = i;
+			data[n] = buf[n];
+			size[n] = KENWOOD_MAX_BUF_LEN;
+			n++;
+		}
+
+		if (n == 0)
+			continue;
+
+		retval = kenwood_transaction_batch(rig, cmdstr, data, size, n);
+		if (retval != RIG_OK)
+			continue;	/* left to the one by one path */
+
+		for (j = 0; j < n; j++) {
+			q = &query[idx[j]];
+
+			switch (q->item) {
+			case RIG_QUERY_FREQ:
+				if (size[j] != 14)
+					break;
+				sscanf(buf[j] + 2, "%"SCNfreq, &q->u.freq);
+				q->retcode = RIG_OK;
+				break;
+			case RIG_QUERY_MODE:
+				if (size[j] != 4)
+					break;
+				q->u.mode.mode = kenwood2rmode(buf[j][2] - '0', caps->mode_table);
+				q->u.mode.width = rig_passband_normal(rig, q->u.mode.mode);
+				q->retcode = RIG_OK;
+				break;
+			case RIG_QUERY_PTT:
+				if (size[j] != caps->if_len)
+					break;
+				memcpy(priv->info, buf[j], KENWOOD_MAX_BUF_LEN);
+				q->u.ptt = priv->info[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+				q->retcode = RIG_OK;
+				break;
+			default:
+				break;
+			}
+
+			if (q->retcode != RIG_OK) {
+				rig_debug(RIG_DEBUG_ERR, "%s: wrong answer len %d for '%s'\n",
+						__func__, (int)size[j], buf[j]);
+				q->retcode = -RIG_EPROTO;
+			}
+		}
+	}
+
+	return retval;
+}
+
 int kenwood_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 {
 	const char *ptt_cmd;
@@ -2343,24 +2643,17 @@ int kenwood_get_mem_if(RIG *rig, vfo_t vfo, int *ch)
 	return RIG_OK;
 }
 
-int kenwood_get_channel(RIG *rig, channel_t *chan)
+/*
+ * kenwood_parse_mr
+ * Fill chan from the reply to "MR0 cc", see kenwood_get_channel().
+ * Returns -RIG_ENAVAIL for an empty channel.
+ */
+static int kenwood_parse_mr(RIG *rig, channel_t *chan, char *buf, size_t len)
 {
-	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-	if (!rig || !chan)
-		return -RIG_EINVAL;
-
-	int err;
-	char buf[26];
-	char cmd[8];
 	struct kenwood_priv_caps *caps = kenwood_caps(rig);
 
-	/* put channel num in the command string */
-	sprintf(cmd, "MR0 %02d", chan->channel_num);
-
-	err = kenwood_safe_transaction(rig, cmd, buf, 26, 24);
-	if (err != RIG_OK)
-		return err;
+	if (len != 24)
+		return -RIG_EPROTO;
 
 	memset(chan, 0x00, sizeof(channel_t));
 
@@ -2400,12 +2693,17 @@ int kenwood_get_channel(RIG *rig, channel_t *chan)
 	buf[6] = '\0';
 	chan->channel_num = atoi(&buf[4]);
 
+	return RIG_OK;
+}
 
-	/* split freq */
-	cmd[2] = '1';
-	err = kenwood_safe_transaction(rig, cmd, buf, 26, 24);
-	if (err != RIG_OK)
-		return err;
+/*
+ * kenwood_parse_mr_split
+ * Complete chan with the reply to "MR1 cc", the TX side of the channel.
+ * Also used for the TS-2000, whose replies share this layout.
+ */
+int kenwood_parse_mr_split(RIG *rig, channel_t *chan, char *buf)
+{
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
 
 	chan->tx_mode = kenwood2rmode(buf[17] - '0', caps->mode_table);
 
@@ -2422,6 +2720,165 @@ int kenwood_get_channel(RIG *rig, channel_t *chan)
 	return RIG_OK;
 }
 
+int kenwood_get_channel(RIG *rig, channel_t *chan)
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+	if (!rig || !chan)
+		return -RIG_EINVAL;
+
+	int err;
+	char buf[26];
+	char cmd[8];
+
+	/* put channel num in the command string */
+	sprintf(cmd, "MR0 %02d", chan->channel_num);
+
+	err = kenwood_safe_transaction(rig, cmd, buf, 26, 24);
+	if (err != RIG_OK)
+		return err;
+
+	err = kenwood_parse_mr(rig, chan, buf, 24);
+	if (err != RIG_OK)
+		return err;
+
+	/* split freq */
+	cmd[2] = '1';
+	err = kenwood_safe_transaction(rig, cmd, buf, 26, 24);
+	if (err != RIG_OK)
+		return err;
+
+	return kenwood_parse_mr_split(rig, chan, buf);
+}
+
+/*
+ * kenwood_drain
+ * Wait for the late replies to a failed batch, and drop them, until
+ * the rig keeps quiet for KENWOOD_DRAIN_TIMEOUT ms.  Stragglers are
+ * still caught by the channel check of kenwood_check_reply().
+ */
+#define KENWOOD_DRAIN_TIMEOUT	200
+
+static void kenwood_drain(RIG *rig)
+{
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	hamlib_port_t *port = &rig->state.rigport;
+	char buf[KENWOOD_MAX_BUF_LEN];
+	int i, timeout;
+
+	rig_port_lock(rig);
+	timeout = port->timeout;
+	if (port->timeout > KENWOOD_DRAIN_TIMEOUT)
+		port->timeout = KENWOOD_DRAIN_TIMEOUT;
+
+	for (i = 0; i < 2 * KENWOOD_MAX_BATCH; i++)
+		if (read_string(port, buf, sizeof(buf), &caps->cmdtrm, 1) <= 0)
+			break;
+
+	port->timeout = timeout;
+	rig_port_unlock(rig);
+}
+
+/*
+ * kenwood_get_chan_block
+ * Read up to KENWOOD_MAX_BATCH memory channels with two pipelined
+ * command sequences: the MR0 (RX) queries of all the channels, then
+ * the MR1 (TX) queries of the channels found in use.
+ * fmt formats a channel number into the MR0 command, parse decodes
+ * its reply.  Should the rig reject a query of the batch, the block
+ * is read again one channel at a time with the get_channel of the caps.
+ */
+int kenwood_get_chan_block(RIG *rig, int start, int count, channel_t chans[],
+		int status[], const char *fmt,
+		int (*parse)(RIG *, channel_t *, char *, size_t))
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+	if (!rig || !chans || !status || count <= 0)
+		return -RIG_EINVAL;
+
+	struct kenwood_priv_caps *caps = kenwood_caps(rig);
+	char cmd[KENWOOD_MAX_BATCH * 10 + 1];
+	char reply[KENWOOD_MAX_BATCH][64];
+	char *data[KENWOOD_MAX_BATCH];
+	size_t datasize[KENWOOD_MAX_BATCH];
+	int idx[KENWOOD_MAX_BATCH];
+	int i, n, len, err;
+
+	if (count > KENWOOD_MAX_BATCH)
+		count = KENWOOD_MAX_BATCH;
+
+	/* RX side of every channel */
+	for (i = 0, len = 0; i < count; i++) {
+		len += sprintf(cmd + len, fmt, start + i);
+		cmd[len++] = caps->cmdtrm;
+		data[i] = reply[i];
+		datasize[i] = sizeof(reply[i]);
+	}
+	cmd[len] = '\0';
+
+	err = kenwood_transaction_batch(rig, cmd, data, datasize, count);
+	if (err != RIG_OK)
+		goto fallback;
+
+	for (i = 0, n = 0, len = 0; i < count; i++) {
+		status[i] = parse(rig, &chans[i], reply[i], datasize[i]);
+		chans[i].vfo = RIG_VFO_MEM;
+		chans[i].channel_num = start + i;
+		if (status[i] != RIG_OK)
+			continue;
+
+		/* TX side of the channels in use, MR1 instead of MR0 */
+		sprintf(cmd + len, fmt, start + i);
+		cmd[len + 2] = '1';
+		len += strlen(cmd + len);
+		cmd[len++] = caps->cmdtrm;
+		idx[n] = i;
+		data[n] = reply[n];
+		datasize[n] = sizeof(reply[n]);
+		n++;
+	}
+	cmd[len] = '\0';
+
+	if (n == 0)
+		return RIG_OK;
+
+	err = kenwood_transaction_batch(rig, cmd, data, datasize, n);
+	if (err != RIG_OK)
+		goto fallback;
+
+	for (i = 0; i < n; i++)
+		kenwood_parse_mr_split(rig, &chans[idx[i]], reply[i]);
+
+	return RIG_OK;
+
+fallback:
+	rig_debug(RIG_DEBUG_VERBOSE, "%s: batch failed (%s), reading channels one by one\n",
+			__func__, rigerror(err));
+
+	kenwood_drain(rig);
+
+	if (!rig->caps->get_channel)
+		return err;
+
+	for (i = 0; i < count; i++) {
+		chans[i].vfo = RIG_VFO_MEM;
+		chans[i].channel_num = start + i;
+		status[i] = rig->caps->get_channel(rig, &chans[i]);
+		chans[i].vfo = RIG_VFO_MEM;
+		chans[i].channel_num = start + i;
+	}
+
+	return RIG_OK;
+}
+
+int kenwood_get_chan_range(RIG *rig, int start, int count, channel_t chans[],
+		int status[])
+{
+	return kenwood_get_chan_block(rig, start, count, chans, status,
+			"MR0 %02d", kenwood_parse_mr);
+}
+
 int kenwood_set_channel(RIG *rig, const channel_t *chan)
 {
 	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -2620,7 +3077,7 @@ DECLARE_PROBERIG_BACKEND(kenwood)
 
 		retval = write_block(port, "ID;", 3);
 		id_len = read_string(port, idbuf, IDBUFSZ, ";\r", 2);
-		close(port->fd);
+		ser_close(port);
 
 		if (retval != RIG_OK || id_len < 0)
 			continue;
@@ -2665,7 +3122,7 @@ DECLARE_PROBERIG_BACKEND(kenwood)
 			return RIG_MODEL_NONE;
 		retval = write_block(port, "K2;", 3);
 			id_len = read_string(port, idbuf, IDBUFSZ, ";\r", 2);
-		close(port->fd);
+		ser_close(port);
 		if (retval != RIG_OK)
 			return RIG_MODEL_NONE;
 		/*
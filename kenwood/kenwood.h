@@ -34,6 +34,8 @@
 
 #define KENWOOD_MODE_TABLE_MAX	10
 #define KENWOOD_MAX_BUF_LEN		50 /* max answer len, arbitrary */
+#define KENWOOD_MAX_CMD_LEN		128 /* scratch command buffer len */
+#define KENWOOD_MAX_BATCH		8 /* max commands per batch transaction */
 
 
 /* Tokens for Parameters common to multiple rigs.
@@ -76,6 +78,8 @@ struct kenwood_priv_data {
     int k2_md_rtty;		/* K2 RTTY mode available flag, 1 = RTTY, 0 = N/A */
     char *fw_rev;		/* firmware revision level */
     unsigned fw_rev_uint;	/* firmware revison as a number 1.07 -> 107 */
+    int flush_pending;		/* stale input may be pending, flush before next command */
+    char cmd_buf[KENWOOD_MAX_CMD_LEN];	/* terminated command scratch buffer */
 };
 
 
@@ -91,6 +95,8 @@ int kenwood_transaction(RIG *rig, const char *cmd, int cmd_len, char *data,
 				size_t *data_len);
 int kenwood_safe_transaction(RIG *rig, const char *cmd, char *buf,
 				size_t buf_size, size_t expected);
+int kenwood_transaction_batch(RIG *rig, const char *cmd, char *data[],
+				size_t data_len[], int count);
 
 rmode_t kenwood2rmode(unsigned char mode, const rmode_t mode_table[]);
 char rmode2kenwood(rmode_t mode, const rmode_t mode_table[]);
@@ -134,6 +140,7 @@ int kenwood_set_ant (RIG * rig, vfo_t vfo, ant_t ant);
 int kenwood_set_ant_no_ack(RIG * rig, vfo_t vfo, ant_t ant);
 int kenwood_get_ant (RIG * rig, vfo_t vfo, ant_t * ant);
 int kenwood_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt);
+int kenwood_get_state_batch(RIG *rig, rig_query_t *query, int count);
 int kenwood_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 int kenwood_set_ptt_safe(RIG *rig, vfo_t vfo, ptt_t ptt);
 int kenwood_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd);
@@ -143,6 +150,11 @@ int kenwood_get_mem(RIG *rig, vfo_t vfo, int *ch);
 int kenwood_get_mem_if(RIG *rig, vfo_t vfo, int *ch);
 int kenwood_get_channel(RIG *rig, channel_t *chan);
 int kenwood_set_channel(RIG *rig, const channel_t *chan);
+int kenwood_get_chan_range(RIG *rig, int start, int count, channel_t chans[], int status[]);
+int kenwood_get_chan_block(RIG *rig, int start, int count, channel_t chans[],
+		int status[], const char *fmt,
+		int (*parse)(RIG *, channel_t *, char *, size_t));
+int kenwood_parse_mr_split(RIG *rig, channel_t *chan, char *buf);
 int kenwood_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch);
 const char * kenwood_get_info(RIG *rig);
 int kenwood_get_id(RIG *rig, char *buf);
@@ -180,6 +180,7 @@ const struct rig_caps ts140_caps = {
 .set_mem =  kenwood_set_mem,
 .get_mem = kenwood_get_mem_if,
 .reset =  kenwood_reset,
+.get_state_batch = kenwood_get_state_batch,
 
 };
 
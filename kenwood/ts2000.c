@@ -59,6 +59,7 @@
 /* prototypes */
 static int ts2000_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
 static int ts2000_get_channel(RIG *rig, channel_t *chan);
+static int ts2000_get_chan_range(RIG *rig, int start, int count, channel_t chans[], int status[]);
 static int ts2000_set_channel(RIG *rig, const channel_t *chan);
 
 /*
@@ -309,6 +310,7 @@ const struct rig_caps ts2000_caps = {
 .set_mem =  kenwood_set_mem,
 .get_mem =  kenwood_get_mem,
 .get_channel = ts2000_get_channel,
+.get_chan_range = ts2000_get_chan_range,
 .set_channel = ts2000_set_channel,
 .set_trn =  kenwood_set_trn,
 .get_trn =  kenwood_get_trn,
@@ -316,6 +318,7 @@ const struct rig_caps ts2000_caps = {
 .get_powerstat =  kenwood_get_powerstat,
 .get_info =  kenwood_get_info,
 .reset =  kenwood_reset,
+.get_state_batch = kenwood_get_state_batch,
 
 };
 
@@ -362,25 +365,15 @@ const struct rig_caps ts2000_caps = {
 
  */
 
-int ts2000_get_channel(RIG *rig, channel_t *chan)
+/*
+ * ts2000_parse_mr
+ * Fill chan from the reply to "MR0ccc", of buf_size bytes.
+ * Returns -RIG_ENAVAIL for an empty channel.
+ */
+static int ts2000_parse_mr(RIG *rig, channel_t *chan, char *buf, size_t buf_size)
 {
-	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-	if (!rig || !chan || chan->vfo != RIG_VFO_MEM)
-		return -RIG_EINVAL;
-
-	int err;
-	char buf[52];
-	size_t buf_size = 52;
-	char cmd[8];
 	struct kenwood_priv_caps *caps = kenwood_caps(rig);
 
-	/* put channel num in the command string */
-	sprintf(cmd, "MR0%03d;", chan->channel_num);
-
-	err = kenwood_transaction(rig, cmd, strlen(cmd), buf, &buf_size );
-	if (err != RIG_OK)
-		return err;
 	memset(chan, 0x00, sizeof(channel_t));
 
 	chan->vfo = RIG_VFO_MEM;
@@ -504,6 +497,31 @@ int ts2000_get_channel(RIG *rig, channel_t *chan)
 	buf[6] = '\0';
 	chan->channel_num = atoi(&buf[3]);
 
+	return RIG_OK;
+}
+
+int ts2000_get_channel(RIG *rig, channel_t *chan)
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+	if (!rig || !chan || chan->vfo != RIG_VFO_MEM)
+		return -RIG_EINVAL;
+
+	int err;
+	char buf[52];
+	size_t buf_size = 52;
+	char cmd[8];
+
+	/* put channel num in the command string */
+	sprintf(cmd, "MR0%03d;", chan->channel_num);
+
+	err = kenwood_transaction(rig, cmd, strlen(cmd), buf, &buf_size );
+	if (err != RIG_OK)
+		return err;
+
+	err = ts2000_parse_mr(rig, chan, buf, buf_size);
+	if (err != RIG_OK)
+		return err;
 
 	/* Check split freq */
 	cmd[2] = '1';
@@ -512,19 +530,18 @@ int ts2000_get_channel(RIG *rig, channel_t *chan)
 	if (err != RIG_OK)
 		return err;
 
-	chan->tx_mode = kenwood2rmode(buf[17] - '0', caps->mode_table);
-
-	buf[17] = '\0';
-	chan->tx_freq = atoi(&buf[6]);
-
-	if (chan->freq == chan->tx_freq) {
-		chan->tx_freq = RIG_FREQ_NONE;
-		chan->tx_mode = RIG_MODE_NONE;
-		chan->split = RIG_SPLIT_OFF;
-	} else
-		chan->split = RIG_SPLIT_ON;
+	return kenwood_parse_mr_split(rig, chan, buf);
+}
 
-	return RIG_OK;
+/*
+ * ts2000_get_chan_range
+ * Pipelined memory readout, see kenwood_get_chan_block()
+ */
+int ts2000_get_chan_range(RIG *rig, int start, int count, channel_t chans[],
+		int status[])
+{
+	return kenwood_get_chan_block(rig, start, count, chans, status,
+			"MR0%03d", ts2000_parse_mr);
 }
 
 int ts2000_set_channel(RIG *rig, const channel_t *chan)
@@ -1811,7 +1811,7 @@ rig_model_t probe_ts2k(port_t * port)
 	retval = write_block(port, "ID;", 3);
 	id_len = read_string(port, idbuf, IDBUFSZ, EOM_KEN EOM_TH, 2);
 
-	close(port->fd);
+	ser_close(port);
 
 	if (retval != RIG_OK)
 		return RIG_MODEL_NONE;
@@ -246,5 +246,7 @@ const struct rig_caps ts450s_caps = {
 	.reset = kenwood_reset,
 	.scan = kenwood_scan,
 	.get_channel = kenwood_get_channel,
+	.get_chan_range = kenwood_get_chan_range,
 	.set_channel = kenwood_set_channel,
+	.get_state_batch = kenwood_get_state_batch,
 };
@@ -399,6 +399,7 @@ const struct rig_caps ts480_caps = {
   .has_set_func = TS480_FUNC_ALL,
   .set_func = kenwood_set_func,
   .get_func = kenwood_get_func,
+  .get_state_batch = kenwood_get_state_batch,
 };
 
 
@@ -204,6 +204,7 @@ const struct rig_caps ts50s_caps = {
 .set_powerstat =  kenwood_set_powerstat,
 .get_powerstat =  kenwood_get_powerstat,
 .reset =  kenwood_reset,
+.get_state_batch = kenwood_get_state_batch,
 
 };
 
@@ -852,6 +852,7 @@ const struct rig_caps ts570s_caps = {
 .set_mem =  kenwood_set_mem,
 .get_mem =  kenwood_get_mem,
 .get_channel = kenwood_get_channel,
+.get_chan_range = kenwood_get_chan_range,
 .set_channel = ts570_set_channel,
 .set_trn =  kenwood_set_trn,
 .get_trn =  kenwood_get_trn,
@@ -1036,6 +1037,7 @@ const struct rig_caps ts570d_caps = {
 .set_mem =  kenwood_set_mem,
 .get_mem =  kenwood_get_mem,
 .get_channel = kenwood_get_channel,
+.get_chan_range = kenwood_get_chan_range,
 .set_channel = ts570_set_channel,
 .set_trn =  kenwood_set_trn,
 .get_trn =  kenwood_get_trn,
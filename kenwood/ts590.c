@@ -228,8 +228,10 @@ const struct rig_caps ts590_caps = {
   .get_mem =  kenwood_get_mem,
   .set_channel =  kenwood_set_channel,
   .get_channel =  kenwood_get_channel,
+  .get_chan_range =  kenwood_get_chan_range,
   .vfo_ops = TS590_VFO_OPS,
   .vfo_op =  kenwood_vfo_op,
+  .get_state_batch = kenwood_get_state_batch,
 };
 
 
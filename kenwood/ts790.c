@@ -206,9 +206,11 @@ const struct rig_caps ts790_caps = {
 .get_mem =  kenwood_get_mem,
 .set_channel = kenwood_set_channel,
 .get_channel = kenwood_get_channel,
+.get_chan_range = kenwood_get_chan_range,
 .set_trn =  kenwood_set_trn,
 .get_trn =  kenwood_get_trn,
 .get_info =  kenwood_get_info,
+.get_state_batch = kenwood_get_state_batch,
 
 };
 
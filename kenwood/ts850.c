@@ -232,8 +232,10 @@ const struct rig_caps ts850_caps = {
 	.set_mem =  kenwood_set_mem,
 	.get_mem =  kenwood_get_mem_if,
 	.get_channel = kenwood_get_channel,
+	.get_chan_range = kenwood_get_chan_range,
 	.set_channel = ts850_set_channel,
-	.set_trn =  kenwood_set_trn
+	.set_trn =  kenwood_set_trn,
+	.get_state_batch = kenwood_get_state_batch,
 };
 
 /*
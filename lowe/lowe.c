@@ -284,7 +284,7 @@ DECLARE_PROBERIG_BACKEND(lowe)
 	retval = write_block(port, "TYP?" EOM, 4);
 	id_len = read_string(port, idbuf, BUFSZ, CR, 2);
 
-	close(port->fd);
+	ser_close(port);
 
 	if (retval != RIG_OK || id_len <= 0 || id_len >= BUFSZ)
 		return RIG_MODEL_NONE;
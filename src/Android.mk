@@ -24,7 +24,12 @@ LOCAL_SRC_FILES := \
         usb_port.c \
         debug.c \
         network.c \
-        cm108.c
+        cm108.c \
+        cache.c \
+        evqueue.c \
+        ring.c \
+        telemetry.c \
+        sweep.c
 
 
 LOCAL_MODULE := libhamlib
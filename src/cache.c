@@ -0,0 +1,329 @@
+/*
+ *  Hamlib Interface - rig state cache
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup rig_internal
+ * @{
+ */
+
+/**
+ * \file cache.c
+ * \brief Read-through cache of the rig state
+ *
+ * The frontend keeps track of the current frequency, mode and VFO in
+ * struct rig_state.  When enabled, rig_get_freq(), rig_get_mode() and
+ * rig_get_vfo() answer from those fields as long as they are younger
+ * than their configured validity, sparing a round trip to the rig.
+ * Any rig_set_* call and any transceive event invalidates the cache.
+ *
+ * Below the frontend, backends may keep raw command replies in a keyed
+ * response cache, see rig_resp_cache_get().  Its validity is set by the
+ * "cache_resp_timeout" configuration token and measured on a monotonic
+ * clock, so that a status dump like Kenwood/Yaesu "IF;" is read once and
+ * shared by get_freq, get_mode, get_vfo... within the same window.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <hamlib/rig.h>
+#include "cache.h"
+#include "misc.h"
+
+
+/* store the current date into a cache time stamp */
+#define CACHE_STAMP(t) do { \
+		struct timeval __tv; \
+		gettimeofday(&__tv, NULL); \
+		(t).tv_sec = __tv.tv_sec; \
+		(t).tv_usec = __tv.tv_usec; \
+	} while (0)
+
+#define CACHE_RESET(t) do { (t).tv_sec = 0; (t).tv_usec = 0; } while (0)
+
+/*
+ * Tell whether a cached field stamped at tv_sec/tv_usec may be used,
+ * and account for it in the hit/miss counters.
+ */
+static int cache_is_valid(struct rig_cache *cache, int tv_sec, int tv_usec,
+		int timeout)
+{
+	struct timeval tv;
+
+	if (timeout <= 0)
+		return 0;	/* disabled, don't count */
+
+	tv.tv_sec = tv_sec;
+	tv.tv_usec = tv_usec;
+
+	if (rig_check_cache_timeout(&tv, timeout)) {
+		cache->misses++;
+		return 0;
+	}
+
+	cache->hits++;
+	return 1;
+}
+
+/* the frontend only tracks the state of the current VFO */
+#define IS_CURR_VFO(rs, vfo) ((vfo) == RIG_VFO_CURR || (vfo) == (rs)->current_vfo)
+
+/*
+ * Returns 1 when *freq has been answered from the cache, 0 otherwise
+ */
+int rig_cache_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
+{
+	struct rig_state *rs = &rig->state;
+
+	if (!IS_CURR_VFO(rs, vfo) ||
+			!cache_is_valid(&rs->cache, rs->cache.time_freq.tv_sec,
+				rs->cache.time_freq.tv_usec, rs->cache.timeout_freq))
+		return 0;
+
+	*freq = rs->current_freq;
+	return 1;
+}
+
+/*
+ * Returns 1 when *mode and *width have been answered from the cache,
+ * 0 otherwise
+ */
+int rig_cache_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
+{
+	struct rig_state *rs = &rig->state;
+
+	if (!IS_CURR_VFO(rs, vfo) ||
+			!cache_is_valid(&rs->cache, rs->cache.time_mode.tv_sec,
+				rs->cache.time_mode.tv_usec, rs->cache.timeout_mode))
+		return 0;
+
+	*mode = rs->current_mode;
+	*width = rs->current_width;
+	return 1;
+}
+
+/*
+ * Returns 1 when *vfo has been answered from the cache, 0 otherwise
+ */
+int rig_cache_get_vfo(RIG *rig, vfo_t *vfo)
+{
+	struct rig_state *rs = &rig->state;
+
+	if (!cache_is_valid(&rs->cache, rs->cache.time_vfo.tv_sec,
+				rs->cache.time_vfo.tv_usec, rs->cache.timeout_vfo))
+		return 0;
+
+	*vfo = rs->current_vfo;
+	return 1;
+}
+
+/*
+ * To be called once current_freq has been refreshed
+ */
+void rig_cache_update_freq(RIG *rig)
+{
+	if (rig->state.cache.timeout_freq > 0)
+		CACHE_STAMP(rig->state.cache.time_freq);
+}
+
+/*
+ * To be called once current_mode and current_width have been refreshed
+ */
+void rig_cache_update_mode(RIG *rig)
+{
+	if (rig->state.cache.timeout_mode > 0)
+		CACHE_STAMP(rig->state.cache.time_mode);
+}
+
+/*
+ * To be called once current_vfo has been refreshed
+ */
+void rig_cache_update_vfo(RIG *rig)
+{
+	if (rig->state.cache.timeout_vfo > 0)
+		CACHE_STAMP(rig->state.cache.time_vfo);
+}
+
+/*
+ * Force the next reads to go to the rig
+ */
+void rig_cache_invalidate(RIG *rig)
+{
+	CACHE_RESET(rig->state.cache.time_freq);
+	CACHE_RESET(rig->state.cache.time_mode);
+	CACHE_RESET(rig->state.cache.time_vfo);
+	rig_resp_cache_invalidate(rig, NULL, 0);
+}
+
+
+/*
+ * Response cache entries. An entry is free when key_len is 0.
+ */
+struct resp_entry {
+	unsigned long stamp;	/* monotonic date of the reply, in ms */
+	size_t key_len;
+	size_t data_len;
+	unsigned char key[RIG_RESP_CACHE_KEYLEN];
+	unsigned char data[RIG_RESP_CACHE_DATALEN];
+};
+
+/* milliseconds from an arbitrary origin, immune to clock changes */
+static unsigned long cache_now_ms(void)
+{
+	struct timeval tv;
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+#endif
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+}
+
+static struct resp_entry *resp_cache_find(struct rig_cache *cache,
+		const void *key, size_t key_len)
+{
+	struct resp_entry *e = cache->resp;
+	int i;
+
+	if (!e)
+		return NULL;
+
+	for (i = 0; i < RIG_RESP_CACHE_ENTRIES; i++, e++) {
+		if (e->key_len == key_len && !memcmp(e->key, key, key_len))
+			return e;
+	}
+
+	return NULL;
+}
+
+/*
+ * Look up the cached reply to the command key.
+ * On entry *data_len is the size of data, on a hit it is set
+ * to the length of the reply copied there.
+ *
+ * Returns 1 on a hit, 0 when the command has to be sent to the rig.
+ */
+int rig_resp_cache_get(RIG *rig, const void *key, size_t key_len,
+		void *data, size_t *data_len)
+{
+	struct rig_cache *cache = &rig->state.cache;
+	struct resp_entry *e;
+
+	if (cache->timeout_resp <= 0 || key_len == 0)
+		return 0;	/* disabled, don't count */
+
+	e = resp_cache_find(cache, key, key_len);
+	if (!e || e->data_len > *data_len ||
+			cache_now_ms() - e->stamp >= (unsigned long)cache->timeout_resp) {
+		cache->misses++;
+		return 0;
+	}
+
+	memcpy(data, e->data, e->data_len);
+	*data_len = e->data_len;
+	cache->hits++;
+
+	rig_debug(RIG_DEBUG_TRACE, "%s: using cached reply (%d bytes)\n",
+			__func__, (int)e->data_len);
+	return 1;
+}
+
+/*
+ * Remember the reply to the command key, replacing the previous reply
+ * to the same command, or else the oldest entry.
+ * Keys and replies too big for an entry are not cached.
+ */
+void rig_resp_cache_put(RIG *rig, const void *key, size_t key_len,
+		const void *data, size_t data_len)
+{
+	struct rig_cache *cache = &rig->state.cache;
+	struct resp_entry *e, *oldest;
+	int i;
+
+	if (cache->timeout_resp <= 0 || key_len == 0 ||
+			key_len > RIG_RESP_CACHE_KEYLEN ||
+			data_len > RIG_RESP_CACHE_DATALEN)
+		return;
+
+	if (!cache->resp) {
+		cache->resp = calloc(RIG_RESP_CACHE_ENTRIES, sizeof(struct resp_entry));
+		if (!cache->resp)
+			return;
+	}
+
+	e = resp_cache_find(cache, key, key_len);
+	if (!e) {
+		e = oldest = cache->resp;
+		for (i = 0; i < RIG_RESP_CACHE_ENTRIES; i++, e++) {
+			if (e->key_len == 0)
+				break;
+			if (e->stamp < oldest->stamp)
+				oldest = e;
+		}
+		if (i == RIG_RESP_CACHE_ENTRIES)
+			e = oldest;
+	}
+
+	memcpy(e->key, key, key_len);
+	e->key_len = key_len;
+	memcpy(e->data, data, data_len);
+	e->data_len = data_len;
+	e->stamp = cache_now_ms();
+}
+
+/*
+ * Drop the cached replies of the commands starting with prefix,
+ * or all of them if prefix_len is 0.  To be called when a command
+ * may have changed what the rig would answer.
+ */
+void rig_resp_cache_invalidate(RIG *rig, const void *prefix, size_t prefix_len)
+{
+	struct resp_entry *e = rig->state.cache.resp;
+	int i;
+
+	if (!e)
+		return;
+
+	for (i = 0; i < RIG_RESP_CACHE_ENTRIES; i++, e++) {
+		if (e->key_len >= prefix_len && !memcmp(e->key, prefix, prefix_len))
+			e->key_len = 0;
+	}
+}
+
+/*
+ * Release the response cache, see rig_cleanup()
+ */
+void rig_resp_cache_free(RIG *rig)
+{
+	free(rig->state.cache.resp);
+	rig->state.cache.resp = NULL;
+}
+
+/** @} */
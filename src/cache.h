@@ -0,0 +1,53 @@
+/*
+ *  Hamlib Interface - rig state cache header
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CACHE_H
+#define _CACHE_H 1
+
+#include <hamlib/rig.h>
+
+
+int rig_cache_get_freq(RIG *rig, vfo_t vfo, freq_t *freq);
+int rig_cache_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width);
+int rig_cache_get_vfo(RIG *rig, vfo_t *vfo);
+
+void rig_cache_update_freq(RIG *rig);
+void rig_cache_update_mode(RIG *rig);
+void rig_cache_update_vfo(RIG *rig);
+
+void rig_cache_invalidate(RIG *rig);
+
+/* keyed response cache, for backend transaction layers */
+#define RIG_RESP_CACHE_ENTRIES	16
+#define RIG_RESP_CACHE_KEYLEN	16
+#define RIG_RESP_CACHE_DATALEN	128
+
+int rig_resp_cache_get(RIG *rig, const void *key, size_t key_len,
+		void *data, size_t *data_len);
+void rig_resp_cache_put(RIG *rig, const void *key, size_t key_len,
+		const void *data, size_t data_len);
+void rig_resp_cache_invalidate(RIG *rig, const void *prefix, size_t prefix_len);
+void rig_resp_cache_free(RIG *rig);
+
+/* memory channel content hashes, see mem.c */
+void rig_chan_hash_free(RIG *rig);
+
+#endif /* _CACHE_H */
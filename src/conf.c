@@ -42,6 +42,9 @@
 
 #include <hamlib/rig.h>
 #include "token.h"
+#include "cache.h"
+#include "event.h"
+#include "conf.h"
 
 /*
  * Configuration options available in the rig->state struct.
@@ -78,6 +81,22 @@ static const struct confparams frontend_cfg_params[] = {
 			"Polling interval in millisecond for transceive emulation",
 			"500", RIG_CONF_NUMERIC, { .n = { 0, 1000000, 1 } }
 	},
+	{ TOK_CACHE_FREQ_TIMEOUT, "cache_freq_timeout", "Frequency cache",
+			"Validity in millisecond of the cached frequency, 0 to disable",
+			"0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+	},
+	{ TOK_CACHE_MODE_TIMEOUT, "cache_mode_timeout", "Mode cache",
+			"Validity in millisecond of the cached mode, 0 to disable",
+			"0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+	},
+	{ TOK_CACHE_VFO_TIMEOUT, "cache_vfo_timeout", "VFO cache",
+			"Validity in millisecond of the cached current VFO, 0 to disable",
+			"0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+	},
+	{ TOK_CACHE_RESP_TIMEOUT, "cache_resp_timeout", "Response cache",
+			"Validity in millisecond of the command replies cached by the backend, 0 to disable",
+			"0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+	},
 	{ TOK_PTT_TYPE, "ptt_type", "PTT type",
 			"Push-To-Talk interface type override",
 			"RIG", RIG_CONF_COMBO, { .c = {{ "RIG", "DTR", "RTS", "Parallel", "CM108", "None", NULL }} }
@@ -344,6 +363,33 @@ static int frontend_set_conf(RIG *rig, token_t token, const char *val)
                 rs->poll_interval = atof(val);
                 break;
 
+        case TOK_CACHE_FREQ_TIMEOUT:
+                if (1 != sscanf(val, "%d", &val_i)){
+                        return -RIG_EINVAL;//value format error
+                }
+                rs->cache.timeout_freq = val_i;
+                break;
+        case TOK_CACHE_MODE_TIMEOUT:
+                if (1 != sscanf(val, "%d", &val_i)){
+                        return -RIG_EINVAL;//value format error
+                }
+                rs->cache.timeout_mode = val_i;
+                break;
+        case TOK_CACHE_VFO_TIMEOUT:
+                if (1 != sscanf(val, "%d", &val_i)){
+                        return -RIG_EINVAL;//value format error
+                }
+                rs->cache.timeout_vfo = val_i;
+                break;
+        case TOK_CACHE_RESP_TIMEOUT:
+                if (1 != sscanf(val, "%d", &val_i)){
+                        return -RIG_EINVAL;//value format error
+                }
+                rs->cache.timeout_resp = val_i;
+                if (val_i <= 0)
+                        rig_resp_cache_free(rig);
+                break;
+
 
         default:
                 return -RIG_EINVAL;
@@ -452,6 +498,18 @@ static int frontend_get_conf(RIG *rig, token_t token, char *val)
 	case TOK_POLL_INTERVAL:
 		sprintf(val, "%d", rs->poll_interval);
 		break;
+	case TOK_CACHE_FREQ_TIMEOUT:
+		sprintf(val, "%d", rs->cache.timeout_freq);
+		break;
+	case TOK_CACHE_MODE_TIMEOUT:
+		sprintf(val, "%d", rs->cache.timeout_mode);
+		break;
+	case TOK_CACHE_VFO_TIMEOUT:
+		sprintf(val, "%d", rs->cache.timeout_vfo);
+		break;
+	case TOK_CACHE_RESP_TIMEOUT:
+		sprintf(val, "%d", rs->cache.timeout_resp);
+		break;
 
 	default:
 		return -RIG_EINVAL;
@@ -460,6 +518,85 @@ static int frontend_get_conf(RIG *rig, token_t token, char *val)
 	return RIG_OK;
 }
 
+/*
+ * Backend conf applied again at open
+ *
+ * rig_set_conf() is usually called before rig_open(), while some
+ * backend confs act on the rig, e.g. switching an output on.  The
+ * backend confs set are kept, in order, and rig_open() hands them to
+ * the backend again once the rig is open.
+ */
+struct conf_saved {
+	token_t token;
+	char *val;
+	struct conf_saved *next;
+};
+
+static int conf_save(RIG *rig, token_t token, const char *val)
+{
+	struct conf_saved **csp, *cs;
+	char *v;
+
+	v = strdup(val);
+	if (!v)
+		return -RIG_ENOMEM;
+
+	for (csp = (struct conf_saved **)&rig->state.conf_saved; *csp;
+			csp = &(*csp)->next) {
+		if ((*csp)->token == token) {
+			free((*csp)->val);
+			(*csp)->val = v;
+			return RIG_OK;
+		}
+	}
+
+	cs = malloc(sizeof(struct conf_saved));
+	if (!cs) {
+		free(v);
+		return -RIG_ENOMEM;
+	}
+	cs->token = token;
+	cs->val = v;
+	cs->next = NULL;
+	*csp = cs;
+
+	return RIG_OK;
+}
+
+/*
+ * Hand the backend confs set so far to the backend again,
+ * called by rig_open() once the rig is open
+ */
+int rig_conf_apply_saved(RIG *rig)
+{
+	struct conf_saved *cs;
+	int retval;
+
+	for (cs = rig->state.conf_saved; cs; cs = cs->next) {
+		retval = rig->caps->set_conf(rig, cs->token, cs->val);
+		if (retval != RIG_OK) {
+			rig_debug(RIG_DEBUG_ERR, "%s: conf %ld='%s': %s\n",
+					__FUNCTION__, cs->token, cs->val,
+					rigerror(retval));
+			return retval;
+		}
+	}
+
+	return RIG_OK;
+}
+
+void rig_conf_saved_free(RIG *rig)
+{
+	struct conf_saved *cs, *next;
+
+	for (cs = rig->state.conf_saved; cs; cs = next) {
+		next = cs->next;
+		free(cs->val);
+		free(cs);
+	}
+	rig->state.conf_saved = NULL;
+}
+
 /**
  * \brief call a function against each configuration token of a rig
  * \param rig	The rig handle
@@ -562,7 +699,8 @@ token_t HAMLIB_API rig_token_lookup(RIG *rig, const char *name)
  * \param token	The parameter
  * \param val	The value to set the parameter to
  *
- *  Sets a configuration parameter.
+ *  Sets a configuration parameter.  The backend parameters set are
+ *  applied again by rig_open(), those which need the rig included.
  *
  * \return RIG_OK if the operation has been sucessful, otherwise
  * a negative value if an error occured (in which case, cause is
@@ -572,26 +710,34 @@ token_t HAMLIB_API rig_token_lookup(RIG *rig, const char *name)
  */
 int HAMLIB_API rig_set_conf(RIG *rig, token_t token, const char *val)
 {
+	int retval;
+
 	if (!rig || !rig->caps)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
     if (rig_need_debug(RIG_DEBUG_VERBOSE)) {
 	    const struct confparams *cfp;
         char tokenstr[12];
         sprintf(tokenstr, "%ld", token);
         cfp = rig_confparam_lookup(rig, tokenstr);
         if (!cfp)
-            return -RIG_EINVAL;
+            RIG_UNLOCK_RETURN(rig, -RIG_EINVAL);
         rig_debug(RIG_DEBUG_VERBOSE, "%s: %s='%s'\n", __func__, cfp->name, val);
     }
 
 	if (IS_TOKEN_FRONTEND(token))
-		return frontend_set_conf(rig, token, val);
+		RIG_UNLOCK_RETURN(rig, frontend_set_conf(rig, token, val));
 
 	if (rig->caps->set_conf == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
+
+	retval = rig->caps->set_conf(rig, token, val);
+	if (retval == RIG_OK)
+		retval = conf_save(rig, token, val);
 
-	return rig->caps->set_conf(rig, token, val);
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -614,13 +760,15 @@ int HAMLIB_API rig_get_conf(RIG *rig, token_t token, char *val)
 	if (!rig || !rig->caps || !val)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	if (IS_TOKEN_FRONTEND(token))
-		return frontend_get_conf(rig, token, val);
+		RIG_UNLOCK_RETURN(rig, frontend_get_conf(rig, token, val));
 
 	if (rig->caps->get_conf == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->get_conf(rig, token, val);
+	RIG_UNLOCK_RETURN(rig, rig->caps->get_conf(rig, token, val));
 }
 
 /*! @} */
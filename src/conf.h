@@ -0,0 +1,31 @@
+/*
+ *  Hamlib Interface - configuration header
+ *  Copyright (c) 2000,2001,2002 by Stephane Fillod and Frank Singleton
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CONF_H
+#define _CONF_H 1
+
+#include <hamlib/rig.h>
+
+int rig_conf_apply_saved(RIG *rig);
+void rig_conf_saved_free(RIG *rig);
+
+
+#endif /* _CONF_H */
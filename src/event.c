@@ -51,10 +51,25 @@
 #include <signal.h>
 #include <errno.h>
 
+/*
+ * With threads and poll() available, transceive and polling are run
+ * by a dedicated event thread.  Otherwise fall back to the SIGIO and
+ * SIGALRM handlers.
+ */
+#if defined(HAVE_PTHREAD) && defined(HAVE_POLL_H)
+#define HAVE_EVENT_THREAD 1
+#include <pthread.h>
+#include <poll.h>
+#elif defined(HAVE_SIGACTION)
+#define HAVE_EVENT_SIGNALS 1
+#endif
+
 
 #include <hamlib/rig.h>
 
 #include "event.h"
+#include "cache.h"
+#include "iofunc.h"
 
 #if defined(WIN32) && !defined(HAVE_TERMIOS_H)
 #include "win32termios.h"
@@ -66,7 +81,12 @@
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
 
-#ifdef HAVE_SIGACTION
+#ifdef HAVE_EVENT_THREAD
+static int evt_add(RIG *rig, int trn);
+static int evt_remove(RIG *rig);
+#endif
+
+#ifdef HAVE_EVENT_SIGNALS
 static struct sigaction hamlib_trn_oldact, hamlib_trn_poll_oldact;
 
 #ifdef HAVE_SIGINFO_T
@@ -88,7 +108,9 @@ extern int foreach_opened_rig(int (*cfunc)(RIG *, rig_ptr_t),rig_ptr_t data);
  */
 int add_trn_rig(RIG *rig)
 {
-#ifdef HAVE_SIGACTION
+#if defined(HAVE_EVENT_THREAD)
+	return evt_add(rig, RIG_TRN_RIG);
+#elif defined(HAVE_EVENT_SIGNALS)
 	struct sigaction act;
 	int status;
 
@@ -141,7 +163,7 @@ int add_trn_rig(RIG *rig)
 
 #else
 	return -RIG_ENIMPL;
-#endif	/* !HAVE_SIGACTION */
+#endif	/* !HAVE_EVENT_SIGNALS */
 }
 
 /*
@@ -151,7 +173,9 @@ int add_trn_rig(RIG *rig)
  */
 int remove_trn_rig(RIG *rig)
 {
-#ifdef HAVE_SIGACTION
+#if defined(HAVE_EVENT_THREAD)
+	return evt_remove(rig);
+#elif defined(HAVE_EVENT_SIGNALS)
 	int status;
 
     /* assert(rig->caps->transceive == RIG_TRN_RIG); */
@@ -171,11 +195,583 @@ int remove_trn_rig(RIG *rig)
 	return RIG_OK;
 #else
 	return -RIG_ENIMPL;
-#endif	/* !HAVE_SIGACTION */
+#endif	/* !HAVE_EVENT_SIGNALS */
 }
 
 
-#ifdef HAVE_SIGACTION
+/*
+ * This is used by the SIGALRM handler and the event thread
+ * to poll each RIG in RIG_TRN_POLL mode.
+ *
+ * Changes are queued while the rig is held, and the callbacks
+ * dispatched once it has been released, so that they may talk
+ * to the rig themselves.
+ *
+ * assumes rig!=NULL
+ */
+static int search_rig_and_poll(RIG *rig, rig_ptr_t data)
+{
+	struct rig_state *rs = &rig->state;
+	int retval;
+	int vfo_changed = 0, freq_changed = 0, mode_changed = 0;
+
+	if (rig->state.transceive != RIG_TRN_POLL)
+		return -1;
+	/*
+	 * Do not disturb, the backend is currently receiving data
+	 */
+	if (!rig_port_trylock(rig))
+		return -1;
+
+	rig->state.hold_decode = 2;
+
+	if (rig->caps->get_vfo && rig->callbacks.vfo_event) {
+		vfo_t vfo = RIG_VFO_CURR;
+
+		retval = rig->caps->get_vfo(rig, &vfo);
+		if (retval == RIG_OK) {
+			vfo_changed = vfo != rs->current_vfo;
+			rs->current_vfo = vfo;
+		}
+	}
+	if (rig->caps->get_freq && rig->callbacks.freq_event) {
+		freq_t freq;
+
+		retval = rig->caps->get_freq(rig, RIG_VFO_CURR, &freq);
+		if (retval == RIG_OK) {
+			freq_changed = freq != rs->current_freq;
+			rs->current_freq = freq;
+		}
+	}
+	if (rig->caps->get_mode && rig->callbacks.mode_event) {
+		rmode_t rmode;
+		pbwidth_t width;
+
+		retval = rig->caps->get_mode(rig, RIG_VFO_CURR, &rmode, &width);
+		if (retval == RIG_OK) {
+			mode_changed = rmode != rs->current_mode ||
+					width != rs->current_width;
+			rs->current_mode = rmode;
+			rs->current_width = width;
+		}
+	}
+
+	rig->state.hold_decode = 0;
+	rig_port_unlock(rig);
+
+	if (vfo_changed && rig->callbacks.vfo_event)
+		rig->callbacks.vfo_event(rig, rs->current_vfo,
+				rig->callbacks.vfo_arg);
+	if (freq_changed && rig->callbacks.freq_event)
+		rig->callbacks.freq_event(rig, RIG_VFO_CURR,
+				rs->current_freq, rig->callbacks.freq_arg);
+	if (mode_changed && rig->callbacks.mode_event)
+		rig->callbacks.mode_event(rig, RIG_VFO_CURR,
+				rs->current_mode, rs->current_width,
+				rig->callbacks.mode_arg);
+
+	return 1;	/* process each opened rig */
+}
+
+
+#ifdef HAVE_EVENT_THREAD
+
+/*
+ * The event thread multiplexes the ports of the rigs in RIG_TRN_RIG
+ * mode with poll(), and polls the rigs in RIG_TRN_POLL mode, each one
+ * on its own poll_interval schedule.  It is started along with the
+ * first registered rig, and stopped with the last one.
+ *
+ * It keeps off a rig while another thread holds its port lock, see
+ * rig_port_lock(), and looks at it again EVT_HOLD_RETRY ms later.
+ */
+
+#define EVT_MAX_FDS	32	/* max rigs in RIG_TRN_RIG mode */
+#define EVT_HOLD_RETRY	20	/* ms before looking again at a held rig */
+
+struct evt_rig {
+	RIG *rig;
+	int trn;			/* RIG_TRN_RIG or RIG_TRN_POLL */
+	int failed;			/* port reported an error, stop watching it */
+	struct timeval next_poll;	/* RIG_TRN_POLL schedule, or deferred decode */
+	int deferred;			/* RIG_TRN_RIG: decode at next_poll, see rig_event_defer() */
+	int busy;			/* RIG_TRN_RIG: port was locked, retry at next_poll */
+	unsigned pass;			/* last loop pass it has been serviced */
+	struct evt_rig *next;
+};
+
+static pthread_mutex_t evt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t evt_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t evt_thread;
+static int evt_running;
+static int evt_pipe[2] = { -1, -1 };	/* wakes the thread up */
+static struct evt_rig *evt_rigs;
+static RIG *evt_current;		/* rig being serviced, if any */
+
+/* kick the event thread out of poll(), called with evt_lock held */
+static void evt_wakeup(void)
+{
+	char c = 0;
+
+	if (write(evt_pipe[1], &c, 1) < 0 && errno != EAGAIN)
+		rig_debug(RIG_DEBUG_ERR, "%s: write: %s\n",
+				__func__, strerror(errno));
+}
+
+/* milliseconds from now until tv, 0 if already passed */
+static int evt_ms_until(const struct timeval *tv)
+{
+	struct timeval now, delta;
+
+	gettimeofday(&now, NULL);
+	if (!timercmp(tv, &now, >))
+		return 0;
+
+	timersub(tv, &now, &delta);
+	return delta.tv_sec * 1000 + (delta.tv_usec + 999) / 1000;
+}
+
+/* schedule the next poll ms from now */
+static void evt_schedule(struct evt_rig *er, int ms)
+{
+	struct timeval now, delta;
+
+	gettimeofday(&now, NULL);
+	delta.tv_sec = ms / 1000;
+	delta.tv_usec = (ms % 1000) * 1000;
+	timeradd(&now, &delta, &er->next_poll);
+}
+
+/*
+ * Service one rig, called without evt_lock held.
+ * Returns the delay in ms until the next poll (RIG_TRN_POLL),
+ * or -1 if the port of a RIG_TRN_RIG rig was locked.
+ */
+static int evt_service(RIG *rig, int trn)
+{
+	if (trn == RIG_TRN_POLL) {
+		if (search_rig_and_poll(rig, NULL) < 0)
+			return EVT_HOLD_RETRY;
+		return rig->state.poll_interval;
+	}
+
+	/*
+	 * Do not disturb, the backend is currently receiving data
+	 */
+	if (!rig_port_trylock(rig))
+		return -1;
+
+	if (rig->caps->decode_event) {
+		rig->caps->decode_event(rig);
+		/* the rig told something changed */
+		if (!rig->state.cache.trn_update)
+			rig_cache_invalidate(rig);
+	}
+
+	rig_port_unlock(rig);
+
+	return 0;
+}
+
+static void *evt_loop(void *arg)
+{
+	struct pollfd fds[EVT_MAX_FDS + 1];
+	RIG *fd_rig[EVT_MAX_FDS + 1];
+	struct evt_rig *er;
+	unsigned pass = 0;
+	int i, n, ms, timeout, trn, deferred;
+	char buf[16];
+	RIG *rig;
+
+	pthread_mutex_lock(&evt_lock);
+
+	while (evt_running) {
+		fds[0].fd = evt_pipe[0];
+		fds[0].events = POLLIN;
+		n = 1;
+		timeout = -1;
+
+		for (er = evt_rigs; er; er = er->next) {
+			if (er->trn == RIG_TRN_POLL) {
+				ms = evt_ms_until(&er->next_poll);
+			} else if (er->failed || er->rig->state.rigport.fd < 0) {
+				continue;
+			} else if (er->busy) {
+				ms = evt_ms_until(&er->next_poll);
+			} else if (n <= EVT_MAX_FDS) {
+				fds[n].fd = er->rig->state.rigport.fd;
+				fds[n].events = POLLIN;
+				fd_rig[n] = er->rig;
+				n++;
+				/* read ahead already, the fd won't tell */
+				if (port_rx_pending(&er->rig->state.rigport))
+					ms = 0;
+				else if (!er->deferred)
+					continue;
+				else
+					ms = evt_ms_until(&er->next_poll);
+			} else {
+				rig_debug(RIG_DEBUG_WARN, "%s: too many rigs in transceive mode\n",
+						__func__);
+				continue;
+			}
+			if (timeout < 0 || ms < timeout)
+				timeout = ms;
+		}
+
+		pthread_mutex_unlock(&evt_lock);
+
+		i = poll(fds, n, timeout);
+
+		pthread_mutex_lock(&evt_lock);
+
+		if (i < 0) {
+			if (errno != EINTR)
+				rig_debug(RIG_DEBUG_ERR, "%s: poll: %s\n",
+						__func__, strerror(errno));
+			continue;
+		}
+
+		if (fds[0].revents & POLLIN)
+			while (read(evt_pipe[0], buf, sizeof(buf)) > 0)
+				;
+
+		/*
+		 * The list may change while a rig is being serviced,
+		 * so walk it again from the start after each one.
+		 */
+		pass++;
+restart:
+		for (er = evt_rigs; er; er = er->next) {
+			if (er->pass == pass)
+				continue;
+
+			rig = er->rig;
+			trn = er->trn;
+
+			if (trn == RIG_TRN_POLL || er->busy) {
+				if (evt_ms_until(&er->next_poll) > 0)
+					continue;
+			} else {
+				for (i = 1; i < n && fd_rig[i] != rig; i++)
+					;
+				if (i == n)
+					continue;
+				if (!fds[i].revents &&
+						!port_rx_pending(&rig->state.rigport) &&
+						(!er->deferred ||
+						evt_ms_until(&er->next_poll) > 0))
+					continue;
+				if (fds[i].revents & (POLLERR|POLLHUP|POLLNVAL)) {
+					rig_debug(RIG_DEBUG_ERR, "%s: error on rig port %s\n",
+							__func__, rig->state.rigport.pathname);
+					er->failed = 1;
+					continue;
+				}
+			}
+
+			/*
+			 * A deferred decode due now is consumed by this service,
+			 * one deferred again meanwhile is kept.
+			 */
+			deferred = er->deferred && evt_ms_until(&er->next_poll) <= 0;
+			if (deferred)
+				er->deferred = 0;
+			er->pass = pass;
+			evt_current = rig;
+			pthread_mutex_unlock(&evt_lock);
+
+			ms = evt_service(rig, trn);
+
+			pthread_mutex_lock(&evt_lock);
+			evt_current = NULL;
+			pthread_cond_broadcast(&evt_cond);
+
+			/* it may have been removed meanwhile */
+			for (er = evt_rigs; er && er->rig != rig; er = er->next)
+				;
+			if (er && er->trn == RIG_TRN_POLL && trn == RIG_TRN_POLL)
+				evt_schedule(er, ms);
+			else if (er && er->trn == RIG_TRN_RIG && trn == RIG_TRN_RIG) {
+				er->busy = ms < 0;
+				/* decode_event() did not run, still to be done */
+				if (er->busy) {
+					er->deferred |= deferred;
+					evt_schedule(er, EVT_HOLD_RETRY);
+				}
+			}
+
+			goto restart;
+		}
+	}
+
+	pthread_mutex_unlock(&evt_lock);
+
+	return NULL;
+}
+
+/* start the event thread, called with evt_lock held */
+static int evt_start(void)
+{
+	int err;
+
+	if (pipe(evt_pipe) < 0) {
+		rig_debug(RIG_DEBUG_ERR, "%s: pipe: %s\n", __func__, strerror(errno));
+		return -RIG_EINTERNAL;
+	}
+	fcntl(evt_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(evt_pipe[1], F_SETFL, O_NONBLOCK);
+
+	evt_running = 1;
+
+	err = pthread_create(&evt_thread, NULL, evt_loop, NULL);
+	if (err) {
+		rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n",
+				__func__, strerror(err));
+		evt_running = 0;
+		close(evt_pipe[0]);
+		close(evt_pipe[1]);
+		return -RIG_EINTERNAL;
+	}
+
+	return RIG_OK;
+}
+
+/*
+ * evt_add
+ * Register rig to the event thread in trn mode, starting the
+ * thread if needed.
+ */
+static int evt_add(RIG *rig, int trn)
+{
+	struct evt_rig *er;
+	int retval = RIG_OK;
+
+	pthread_mutex_lock(&evt_lock);
+
+	for (er = evt_rigs; er && er->rig != rig; er = er->next)
+		;
+	if (!er) {
+		er = calloc(1, sizeof(struct evt_rig));
+		if (!er) {
+			pthread_mutex_unlock(&evt_lock);
+			return -RIG_ENOMEM;
+		}
+		er->rig = rig;
+		er->next = evt_rigs;
+		evt_rigs = er;
+	}
+
+	er->trn = trn;
+	er->failed = 0;
+	er->deferred = 0;
+	er->busy = 0;
+	evt_schedule(er, rig->state.poll_interval);
+
+	if (evt_running) {
+		evt_wakeup();
+	} else {
+		retval = evt_start();
+		if (retval != RIG_OK) {
+			evt_rigs = er->next;
+			free(er);
+		}
+	}
+
+	pthread_mutex_unlock(&evt_lock);
+
+	return retval;
+}
+
+/*
+ * evt_remove
+ * Unregister rig from the event thread, waiting for the thread to be
+ * done with it.  The thread is stopped with the last rig, unless
+ * that happens from a callback, in which case it idles until the next
+ * registration.
+ */
+static int evt_remove(RIG *rig)
+{
+	struct evt_rig *er, **prev;
+	int self;
+
+	pthread_mutex_lock(&evt_lock);
+
+	self = evt_running && pthread_equal(pthread_self(), evt_thread);
+
+	while (!self && evt_current == rig)
+		pthread_cond_wait(&evt_cond, &evt_lock);
+
+	for (prev = &evt_rigs; *prev && (*prev)->rig != rig; prev = &(*prev)->next)
+		;
+	if (*prev) {
+		er = *prev;
+		*prev = er->next;
+		free(er);
+	}
+
+	if (!evt_running || evt_rigs || self) {
+		if (evt_running)
+			evt_wakeup();
+		pthread_mutex_unlock(&evt_lock);
+		return RIG_OK;
+	}
+
+	evt_running = 0;
+	evt_wakeup();
+	pthread_mutex_unlock(&evt_lock);
+
+	pthread_join(evt_thread, NULL);
+
+	close(evt_pipe[0]);
+	close(evt_pipe[1]);
+	evt_pipe[0] = evt_pipe[1] = -1;
+
+	return RIG_OK;
+}
+
+/*
+ * rig_event_defer
+ * Have the event thread call decode_event of rig in ms, even though
+ * no data came, e.g. to deliver the events a backend held back.
+ * Returns -RIG_ENAVAIL if rig is not in RIG_TRN_RIG mode.
+ */
+int rig_event_defer(RIG *rig, int ms)
+{
+	struct evt_rig *er;
+	struct timeval when;
+	int retval = -RIG_ENAVAIL;
+
+	pthread_mutex_lock(&evt_lock);
+
+	for (er = evt_rigs; er && er->rig != rig; er = er->next)
+		;
+	if (er && er->trn == RIG_TRN_RIG && !er->failed) {
+		when = er->next_poll;
+		evt_schedule(er, ms);
+		/* keep the earliest */
+		if (er->deferred && timercmp(&when, &er->next_poll, <))
+			er->next_poll = when;
+		er->deferred = 1;
+		evt_wakeup();
+		retval = RIG_OK;
+	}
+
+	pthread_mutex_unlock(&evt_lock);
+
+	return retval;
+}
+
+/*
+ * rig_port_lock_init
+ * Create the port lock of rig, called by rig_init().
+ *
+ * The frontend holds the port lock around its calls into the backend,
+ * and some backends around their transactions, so that the event
+ * thread does not read the port meanwhile: it only tries the lock, and
+ * leaves the rig for later if taken.  The lock is recursive, the
+ * callbacks run by decode_event may talk to the rig.
+ */
+int rig_port_lock_init(RIG *rig)
+{
+	pthread_mutex_t *lock;
+	pthread_mutexattr_t attr;
+
+	lock = malloc(sizeof(pthread_mutex_t));
+	if (!lock)
+		return -RIG_ENOMEM;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	rig->state.port_lock = lock;
+
+	return RIG_OK;
+}
+
+void rig_port_lock_free(RIG *rig)
+{
+	pthread_mutex_t *lock = rig->state.port_lock;
+
+	if (!lock)
+		return;
+
+	pthread_mutex_destroy(lock);
+	free(lock);
+	rig->state.port_lock = NULL;
+}
+
+void rig_port_lock(RIG *rig)
+{
+	if (rig->state.port_lock)
+		pthread_mutex_lock(rig->state.port_lock);
+}
+
+/*
+ * returns 1 if the lock has been taken, 0 if busy, as well while
+ * a backend holds the decoder, see Hold_Decode()
+ */
+int rig_port_trylock(RIG *rig)
+{
+	if (!rig->state.port_lock)
+		return rig->state.hold_decode != 1;
+
+	if (pthread_mutex_trylock(rig->state.port_lock) != 0)
+		return 0;
+
+	if (rig->state.hold_decode == 1) {
+		pthread_mutex_unlock(rig->state.port_lock);
+		return 0;
+	}
+
+	return 1;
+}
+
+void rig_port_unlock(RIG *rig)
+{
+	if (rig->state.port_lock)
+		pthread_mutex_unlock(rig->state.port_lock);
+}
+
+#else	/* !HAVE_EVENT_THREAD */
+
+int rig_event_defer(RIG *rig, int ms)
+{
+	return -RIG_ENAVAIL;
+}
+
+/*
+ * Without the event thread, only the signal handlers may interrupt
+ * a transaction, and hold_decode tells them to keep off.
+ */
+int rig_port_lock_init(RIG *rig)
+{
+	return RIG_OK;
+}
+
+void rig_port_lock_free(RIG *rig)
+{
+}
+
+void rig_port_lock(RIG *rig)
+{
+}
+
+int rig_port_trylock(RIG *rig)
+{
+	return !rig->state.hold_decode;
+}
+
+void rig_port_unlock(RIG *rig)
+{
+}
+
+#endif	/* HAVE_EVENT_THREAD */
+
+
+#ifdef HAVE_EVENT_SIGNALS
 
 /*
  * add_trn_poll_rig
@@ -249,6 +845,7 @@ static int search_rig_and_decode(RIG *rig, rig_ptr_t data)
 	fd_set rfds;
 	struct timeval tv;
 	int retval;
+	int left, before = -1;
 
 	/*
 	 * so far, only file oriented ports have event reporting support
@@ -264,6 +861,10 @@ static int search_rig_and_decode(RIG *rig, rig_ptr_t data)
 	if (rig->state.rigport.fd != si->si_fd)
 			return -1;
 #else
+	/* no SIGIO for what has been read ahead already */
+	if (port_rx_pending(&rig->state.rigport))
+		goto readable;
+
 	FD_ZERO(&rfds);
 	FD_SET(rig->state.rigport.fd, &rfds);
 	/* Read status immediately. */
@@ -280,85 +881,34 @@ static int search_rig_and_decode(RIG *rig, rig_ptr_t data)
 								strerror(errno));
 		return -1;
 	}
+readable:
 #endif
 
 	/*
 	 * Do not disturb, the backend is currently receiving data
 	 */
-	if (rig->state.hold_decode)
+	if (!rig_port_trylock(rig))
 			return -1;
 
-	if (rig->caps->decode_event)
-		rig->caps->decode_event(rig);
-
-	return 1;	/* process each opened rig */
-}
-
-/*
- * This is used by sa_sigio, the SIGALRM handler
- * to poll each RIG in RIG_TRN_POLL mode.
- *
- * assumes rig!=NULL
- */
-static int search_rig_and_poll(RIG *rig, rig_ptr_t data)
-{
-	struct rig_state *rs = &rig->state;
-	int retval;
-
-	if (rig->state.transceive != RIG_TRN_POLL)
-		return -1;
-	/*
-	 * Do not disturb, the backend is currently receiving data
-	 */
-	if (rig->state.hold_decode)
-		return -1;
-
-	rig->state.hold_decode = 2;
-
-	if (rig->caps->get_vfo && rig->callbacks.vfo_event) {
-		vfo_t vfo = RIG_VFO_CURR;
-
-		retval = rig->caps->get_vfo(rig, &vfo);
-		if (retval == RIG_OK) {
- 			if (vfo != rs->current_vfo) {
-				rig->callbacks.vfo_event(rig, vfo, rig->callbacks.vfo_arg);
-			}
-	 		rs->current_vfo = vfo;
-		}
+	if (rig->caps->decode_event) {
+		/* until the data read ahead is consumed */
+		do {
+			rig->caps->decode_event(rig);
+			/* the rig told something changed */
+			if (!rig->state.cache.trn_update)
+				rig_cache_invalidate(rig);
+			left = port_rx_pending(&rig->state.rigport);
+			if (left == before)
+				break;
+			before = left;
+		} while (left > 0);
 	}
-	if (rig->caps->get_freq && rig->callbacks.freq_event) {
-		freq_t freq;
 
-		retval = rig->caps->get_freq(rig, RIG_VFO_CURR, &freq);
-		if (retval == RIG_OK) {
- 			if (freq != rs->current_freq) {
-				rig->callbacks.freq_event(rig, RIG_VFO_CURR,
-						freq, rig->callbacks.freq_arg);
-			}
-	 		rs->current_freq = freq;
-		}
-	}
-	if (rig->caps->get_mode && rig->callbacks.mode_event) {
-		rmode_t rmode;
-		pbwidth_t width;
-
-		retval = rig->caps->get_mode(rig, RIG_VFO_CURR, &rmode, &width);
-		if (retval == RIG_OK) {
- 			if (rmode != rs->current_mode || width != rs->current_width) {
-				rig->callbacks.mode_event(rig, RIG_VFO_CURR,
-						rmode, width, rig->callbacks.mode_arg);
-			}
-	 		rs->current_mode = rmode;
-	 		rs->current_width = width;
-		}
-	}
-
-	rig->state.hold_decode = 0;
+	rig_port_unlock(rig);
 
 	return 1;	/* process each opened rig */
 }
 
-
 /*
  * This is the SIGIO handler
  *
@@ -412,7 +962,7 @@ static void sa_sigalrmhandler(int signum)
 
 #endif /* !HAVE_SIGINFO_T */
 
-#endif /* HAVE_SIGINFO */
+#endif /* HAVE_EVENT_SIGNALS */
 
 #endif	/* !DOC_HIDDEN */
 
@@ -546,6 +1096,90 @@ int HAMLIB_API rig_set_dcd_callback(RIG *rig, dcd_cb_t cb, rig_ptr_t arg)
 	return RIG_OK;
 }
 
+/**
+ * \brief set the callback for split events
+ * \param rig	The rig handle
+ * \param cb	The callback to install
+ * \param arg	A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for split events, to be called when in transceive mode.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_trn()
+ */
+
+int HAMLIB_API rig_set_split_callback(RIG *rig, split_cb_t cb, rig_ptr_t arg)
+{
+	if (CHECK_RIG_ARG(rig))
+		return -RIG_EINVAL;
+
+	rig->callbacks.split_event = cb;
+	rig->callbacks.split_arg = arg;
+
+	return RIG_OK;
+}
+
+/**
+ * \brief set the callback for level events
+ * \param rig	The rig handle
+ * \param cb	The callback to install
+ * \param arg	A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for level events, to be called when in transceive
+ *  mode.  Only the levels the rig reports by itself are notified,
+ *  typically the S-meter, as RIG_LEVEL_RAWSTR and RIG_LEVEL_STRENGTH.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_trn()
+ */
+
+int HAMLIB_API rig_set_level_callback(RIG *rig, level_cb_t cb, rig_ptr_t arg)
+{
+	if (CHECK_RIG_ARG(rig))
+		return -RIG_EINVAL;
+
+	rig->callbacks.level_event = cb;
+	rig->callbacks.level_arg = arg;
+
+	return RIG_OK;
+}
+
+/**
+ * \brief set the callback for spectrum scope sweeps
+ * \param rig	The rig handle
+ * \param cb	The callback to install
+ * \param arg	A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for the sweeps of the spectrum scope, to be
+ *  called when in transceive mode, once per sweep received, at the
+ *  rate the rig sends them.  The sweep is passed in place: it must
+ *  be used or copied before the callback returns.
+ *  It is not replaced by the queue of rig_event_queue().
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_trn()
+ */
+
+int HAMLIB_API rig_set_spectrum_callback(RIG *rig, spectrum_cb_t cb, rig_ptr_t arg)
+{
+	if (CHECK_RIG_ARG(rig))
+		return -RIG_EINVAL;
+
+	rig->callbacks.spectrum_event = cb;
+	rig->callbacks.spectrum_arg = arg;
+
+	return RIG_OK;
+}
+
 /**
  * \brief set the callback for pipelined tuning module
  * \param rig	The rig handle
@@ -580,6 +1214,8 @@ int HAMLIB_API rig_set_pltune_callback(RIG *rig, pltune_cb_t cb, rig_ptr_t arg)
  * \param trn	The transceive status to set to
  *
  *  Enable/disable the transceive handling of a rig and kick off async mode.
+ *  Where threads are available, the events of all the rigs are handled
+ *  by a single library thread, and the callbacks are called from it.
  *
  * \return RIG_OK if the operation has been sucessful, otherwise
  * a negative value if an error occured (in which case, cause is
@@ -592,31 +1228,35 @@ int HAMLIB_API rig_set_trn(RIG *rig, int trn)
 {
 	const struct rig_caps *caps;
 	int retcode = RIG_OK;
-#ifdef HAVE_SETITIMER
+#if defined(HAVE_EVENT_SIGNALS) && defined(HAVE_SETITIMER)
 	struct itimerval value;
 #endif
 
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	/* detect whether tranceive is active already */
 	if (trn != RIG_TRN_OFF && rig->state.transceive != RIG_TRN_OFF) {
 		if (trn == rig->state.transceive) {
-			return RIG_OK;
+			RIG_UNLOCK_RETURN(rig, RIG_OK);
 		} else {
 			/* when going POLL<->RIG, transtition to OFF */
 			retcode = rig_set_trn(rig, RIG_TRN_OFF);
 			if (retcode != RIG_OK)
-				return retcode;
+				RIG_UNLOCK_RETURN(rig, retcode);
 		}
 	}
 
 	switch (trn) {
 	case RIG_TRN_RIG:
 		if (caps->transceive != RIG_TRN_RIG)
-			return -RIG_ENAVAIL;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 		retcode = add_trn_rig(rig);
 		/* some protocols (e.g. CI-V's) offer no way
@@ -627,7 +1267,9 @@ int HAMLIB_API rig_set_trn(RIG *rig, int trn)
 		break;
 
 	case RIG_TRN_POLL:
-#ifdef HAVE_SETITIMER
+#if defined(HAVE_EVENT_THREAD)
+		retcode = evt_add(rig, RIG_TRN_POLL);
+#elif defined(HAVE_SETITIMER)
 
 		add_trn_poll_rig(rig);
 
@@ -642,16 +1284,18 @@ int HAMLIB_API rig_set_trn(RIG *rig, int trn)
 					__func__,
 					strerror(errno));
 			remove_trn_poll_rig(rig);
-			return -RIG_EINTERNAL;
+			RIG_UNLOCK_RETURN(rig, -RIG_EINTERNAL);
 		}
 #else
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 #endif
 		break;
 
 	case RIG_TRN_OFF:
 		if (rig->state.transceive == RIG_TRN_POLL) {
-#ifdef HAVE_SETITIMER
+#if defined(HAVE_EVENT_THREAD)
+			retcode = evt_remove(rig);
+#elif defined(HAVE_SETITIMER)
 
 			retcode = remove_trn_poll_rig(rig);
 
@@ -665,10 +1309,10 @@ int HAMLIB_API rig_set_trn(RIG *rig, int trn)
 				rig_debug(RIG_DEBUG_ERR, "%s: setitimer: %s\n",
 					__func__,
 					strerror(errno));
-				return -RIG_EINTERNAL;
+				RIG_UNLOCK_RETURN(rig, -RIG_EINTERNAL);
 			}
 #else
-			return -RIG_ENAVAIL;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 #endif
 		} else if (rig->state.transceive == RIG_TRN_RIG) {
 			retcode = remove_trn_rig(rig);
@@ -679,13 +1323,13 @@ int HAMLIB_API rig_set_trn(RIG *rig, int trn)
 		break;
 
 	default:
-		return -RIG_EINVAL;
+		RIG_UNLOCK_RETURN(rig, -RIG_EINVAL);
 	}
 
 	if (retcode == RIG_OK)
 		rig->state.transceive = trn;
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -707,11 +1351,13 @@ int HAMLIB_API rig_get_trn(RIG *rig, int *trn)
 	if (CHECK_RIG_ARG(rig) || !trn)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	if (rig->caps->get_trn != NULL)
-		return rig->caps->get_trn(rig, trn);
+		RIG_UNLOCK_RETURN(rig, rig->caps->get_trn(rig, trn));
 
 	*trn = rig->state.transceive;
-	return RIG_OK;
+	RIG_UNLOCK_RETURN(rig, RIG_OK);
 }
 
 /** @} */
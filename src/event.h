@@ -28,5 +28,20 @@
 int add_trn_rig(RIG *rig);
 int remove_trn_rig(RIG *rig);
 
+int rig_event_defer(RIG *rig, int ms);
+
+int rig_port_lock_init(RIG *rig);
+void rig_port_lock_free(RIG *rig);
+void rig_port_lock(RIG *rig);
+int rig_port_trylock(RIG *rig);
+void rig_port_unlock(RIG *rig);
+
+/*
+ * The frontend calls into the backend under the port lock of the rig,
+ * which keeps the event thread off, and return through this.
+ */
+#define RIG_UNLOCK_RETURN(rig, ret) \
+	do { int _ret = (ret); rig_port_unlock(rig); return _ret; } while (0)
+
 #endif /* _EVENT_H */
 
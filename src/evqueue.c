@@ -0,0 +1,428 @@
+/*
+ *  Hamlib Interface - asynchronous event queue
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file evqueue.c
+ * \brief Asynchronous event queue
+ *
+ * Instead of having the transceive events delivered through callbacks,
+ * from the thread or signal handler decoding them, an application may
+ * have them queued and drain the queue from its own loop.  A slow
+ * consumer then no longer holds back the decoding, the events it cannot
+ * keep up with are dropped and accounted for.
+ *
+ * The queue is a bounded ring buffer with a single producer, the event
+ * decoder, and any number of consumers calling rig_event_poll().  It
+ * is lock free, see ring.h.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
+#include <hamlib/rig.h>
+
+#include "ring.h"
+
+
+#ifndef DOC_HIDDEN
+
+struct rig_evq {
+	struct rig_ring ring;		/* of rig_event_t, never overwritten */
+	int full;			/* the last push found the queue full */
+	unsigned long dropped;		/* events lost because the queue was full */
+	unsigned long overruns;		/* times the queue became full */
+	int fd[2];			/* notification, read/write ends */
+};
+
+/* make the notification fd readable */
+static void evq_notify(struct rig_evq *q)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	uint64_t one = 1;
+
+	if (write(q->fd[1], &one, sizeof(one)) < 0 && errno != EAGAIN)
+		rig_debug(RIG_DEBUG_ERR, "%s: write: %s\n", __func__, strerror(errno));
+#elif !defined(_WIN32)
+	char c = 0;
+
+	if (write(q->fd[1], &c, 1) < 0 && errno != EAGAIN)
+		rig_debug(RIG_DEBUG_ERR, "%s: write: %s\n", __func__, strerror(errno));
+#endif
+}
+
+/* drain the notification fd */
+static void evq_clear(struct rig_evq *q)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	uint64_t count;
+
+	if (read(q->fd[0], &count, sizeof(count)) < 0 && errno != EAGAIN)
+		rig_debug(RIG_DEBUG_ERR, "%s: read: %s\n", __func__, strerror(errno));
+#elif !defined(_WIN32)
+	char buf[64];
+
+	while (read(q->fd[0], buf, sizeof(buf)) > 0)
+		;
+#endif
+}
+
+static int evq_open_fd(struct rig_evq *q)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	q->fd[0] = q->fd[1] = eventfd(0, EFD_NONBLOCK);
+	if (q->fd[0] < 0)
+		return -RIG_EINTERNAL;
+#elif !defined(_WIN32)
+	if (pipe(q->fd) < 0)
+		return -RIG_EINTERNAL;
+	fcntl(q->fd[0], F_SETFL, O_NONBLOCK);
+	fcntl(q->fd[1], F_SETFL, O_NONBLOCK);
+#else
+	q->fd[0] = q->fd[1] = -1;
+#endif
+	return RIG_OK;
+}
+
+static void evq_close_fd(struct rig_evq *q)
+{
+	if (q->fd[0] >= 0)
+		close(q->fd[0]);
+	if (q->fd[1] >= 0 && q->fd[1] != q->fd[0])
+		close(q->fd[1]);
+}
+
+/*
+ * Producer side, called from the event decoder
+ */
+static void evq_push(RIG *rig, const rig_event_t *ev)
+{
+	struct rig_evq *q = rig->state.event_queue;
+
+	if (!q)
+		return;
+
+	if (!ring_push(&q->ring, ev, 0)) {
+		/* not consumed yet, the application lags behind */
+		q->dropped++;
+		if (!q->full) {
+			q->full = 1;
+			q->overruns++;
+		}
+		return;
+	}
+	q->full = 0;
+
+	evq_notify(q);
+}
+
+static int evq_freq_cb(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_FREQ;
+	ev.vfo = vfo;
+	ev.u.freq = freq;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_mode_cb(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
+		rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_MODE;
+	ev.vfo = vfo;
+	ev.u.mode.mode = mode;
+	ev.u.mode.width = width;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_vfo_cb(RIG *rig, vfo_t vfo, rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_VFO;
+	ev.vfo = vfo;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_ptt_cb(RIG *rig, vfo_t vfo, ptt_t ptt, rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_PTT;
+	ev.vfo = vfo;
+	ev.u.ptt = ptt;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_dcd_cb(RIG *rig, vfo_t vfo, dcd_t dcd, rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_DCD;
+	ev.vfo = vfo;
+	ev.u.dcd = dcd;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_split_cb(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo,
+		rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_SPLIT;
+	ev.vfo = vfo;
+	ev.u.split.split = split;
+	ev.u.split.tx_vfo = tx_vfo;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+static int evq_level_cb(RIG *rig, vfo_t vfo, setting_t level, value_t val,
+		rig_ptr_t arg)
+{
+	rig_event_t ev;
+
+	ev.type = RIG_EVENT_LEVEL;
+	ev.vfo = vfo;
+	ev.u.level.level = level;
+	ev.u.level.val = val;
+	evq_push(rig, &ev);
+
+	return RIG_OK;
+}
+
+#endif	/* !DOC_HIDDEN */
+
+/**
+ * \brief queue the events instead of calling back
+ * \param rig	The rig handle
+ * \param size	The number of events the queue can hold, 0 to remove it
+ *
+ *  Installs a queue of \a size events, rounded up to a power of two,
+ *  in place of the freq, mode, vfo, ptt, dcd, split and level
+ *  callbacks.  The events are then read with rig_event_poll(), e.g.
+ *  when the descriptor returned by rig_event_fd() becomes readable.
+ *  When the queue is full, new events are dropped, see
+ *  rig_event_stats().
+ *
+ *  The queue must be installed or removed while transceive is off.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_event_poll(), rig_event_fd(), rig_set_trn()
+ */
+int HAMLIB_API rig_event_queue(RIG *rig, int size)
+{
+	struct rig_callbacks *cb;
+	struct rig_evq *q;
+
+	if (!rig || !rig->caps || size < 0)
+		return -RIG_EINVAL;
+
+	cb = &rig->callbacks;
+	q = rig->state.event_queue;
+
+	if (q) {
+		rig->state.event_queue = NULL;
+		evq_close_fd(q);
+		ring_free(&q->ring);
+		free(q);
+
+		if (cb->freq_event == evq_freq_cb)
+			cb->freq_event = NULL;
+		if (cb->mode_event == evq_mode_cb)
+			cb->mode_event = NULL;
+		if (cb->vfo_event == evq_vfo_cb)
+			cb->vfo_event = NULL;
+		if (cb->ptt_event == evq_ptt_cb)
+			cb->ptt_event = NULL;
+		if (cb->dcd_event == evq_dcd_cb)
+			cb->dcd_event = NULL;
+		if (cb->split_event == evq_split_cb)
+			cb->split_event = NULL;
+		if (cb->level_event == evq_level_cb)
+			cb->level_event = NULL;
+	}
+
+	if (size == 0)
+		return RIG_OK;
+
+	q = calloc(1, sizeof(struct rig_evq));
+	if (!q)
+		return -RIG_ENOMEM;
+
+	if (ring_init(&q->ring, size, sizeof(rig_event_t)) != RIG_OK) {
+		free(q);
+		return -RIG_ENOMEM;
+	}
+
+	if (evq_open_fd(q) != RIG_OK) {
+		rig_debug(RIG_DEBUG_ERR, "%s: cannot create event fd: %s\n",
+				__func__, strerror(errno));
+		ring_free(&q->ring);
+		free(q);
+		return -RIG_EINTERNAL;
+	}
+
+	rig->state.event_queue = q;
+
+	cb->freq_event = evq_freq_cb;
+	cb->mode_event = evq_mode_cb;
+	cb->vfo_event = evq_vfo_cb;
+	cb->ptt_event = evq_ptt_cb;
+	cb->dcd_event = evq_dcd_cb;
+	cb->split_event = evq_split_cb;
+	cb->level_event = evq_level_cb;
+
+	return RIG_OK;
+}
+
+/**
+ * \brief read the next queued event
+ * \param rig	The rig handle
+ * \param event	The location where to store the event
+ *
+ *  Reads the oldest event of the queue installed by rig_event_queue(),
+ *  without blocking.  It may be called from several threads at once.
+ *  Call it until it returns 0 once rig_event_fd() is readable.
+ *
+ * \return 1 if an event has been stored in \a event, 0 if the queue
+ * is empty, otherwise a negative value if an error occured.
+ *
+ * \sa rig_event_queue(), rig_event_fd()
+ */
+int HAMLIB_API rig_event_poll(RIG *rig, rig_event_t *event)
+{
+	struct rig_evq *q;
+
+	if (!rig || !event)
+		return -RIG_EINVAL;
+
+	q = rig->state.event_queue;
+	if (!q)
+		return -RIG_EINVAL;
+
+	if (ring_pop(&q->ring, event))
+		return 1;
+
+	/*
+	 * Clear the notification before looking again, so that an
+	 * event pushed in between is either seen now or notified anew.
+	 */
+	evq_clear(q);
+
+	return ring_pop(&q->ring, event);
+}
+
+/**
+ * \brief get a descriptor to wait for events
+ * \param rig	The rig handle
+ *
+ *  Returns a file descriptor which becomes readable when events are
+ *  queued, suitable for select()/poll() in the application main loop.
+ *  It must not be read nor closed by the application.
+ *
+ * \return the file descriptor, otherwise a negative value if an error
+ * occured.
+ *
+ * \sa rig_event_queue(), rig_event_poll()
+ */
+int HAMLIB_API rig_event_fd(RIG *rig)
+{
+	struct rig_evq *q;
+
+	if (!rig)
+		return -RIG_EINVAL;
+
+	q = rig->state.event_queue;
+	if (!q)
+		return -RIG_EINVAL;
+
+	if (q->fd[0] < 0)
+		return -RIG_ENAVAIL;
+
+	return q->fd[0];
+}
+
+/**
+ * \brief get the event queue statistics
+ * \param rig	The rig handle
+ * \param dropped	The location where to store the number of events
+ * 		dropped because the queue was full, or NULL
+ * \param overruns	The location where to store the number of times
+ * 		the queue became full, or NULL
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured.
+ *
+ * \sa rig_event_queue()
+ */
+int HAMLIB_API rig_event_stats(RIG *rig, unsigned long *dropped,
+		unsigned long *overruns)
+{
+	struct rig_evq *q;
+
+	if (!rig)
+		return -RIG_EINVAL;
+
+	q = rig->state.event_queue;
+	if (!q)
+		return -RIG_EINVAL;
+
+	if (dropped)
+		*dropped = q->dropped;
+	if (overruns)
+		*overruns = q->overruns;
+
+	return RIG_OK;
+}
+
+/** @} */
@@ -54,6 +54,17 @@
 #include "network.h"
 #include "cm108.h"
 
+#define PORTRXBUFSZ 512		/* port receive buffer size, in bytes */
+
+/*
+ * Port receive buffer, allocated on first read
+ */
+struct port_rxbuf {
+	int head;		/* index of the next unread byte */
+	int tail;		/* index past the last received byte */
+	unsigned char buf[PORTRXBUFSZ];	/* received bytes not consumed yet */
+};
+
 /**
  * \brief Open a hamlib_port based on its rig port type
  * \param p rig port descriptor
@@ -65,6 +76,8 @@ int HAMLIB_API port_open(hamlib_port_t *p)
 	int want_state_delay = 0;
 
 	p->fd = -1;
+	/* not zeroed by all the callers, e.g. a port on the stack to probe */
+	p->rxbuf = NULL;
 
 	switch(p->type.rig) {
 	case RIG_PORT_SERIAL:
@@ -178,6 +191,7 @@ int HAMLIB_API port_close(hamlib_port_t *p, rig_port_t port_type)
 			ret = close(p->fd);
 		}
 		p->fd = -1;
+		port_rx_free(p);
 	}
 
 	return ret;
@@ -364,6 +378,125 @@ int HAMLIB_API write_block(hamlib_port_t *p, const char *txbuffer, size_t count)
 }
 
 
+/*
+ * Wait up to tv_timeout for the port to become readable, then grab
+ * as many bytes as available into the port receive buffer, so that
+ * read_block() and read_string() don't pay a select()/read() pair
+ * for each received character.
+ *
+ * Only to be called once the receive buffer has been drained.
+ * Returns the number of bytes buffered, -RIG_ETIMEOUT or -RIG_EIO.
+ */
+static int port_fill_rxbuf(hamlib_port_t *p, const struct timeval *tv_timeout)
+{
+  struct port_rxbuf *rb = p->rxbuf;
+  fd_set rfds, efds;
+  struct timeval tv;
+  int rd_count;
+  int retval;
+
+  if (!rb) {
+	rb = p->rxbuf = malloc(sizeof(struct port_rxbuf));
+	if (!rb)
+		return -RIG_ENOMEM;
+  }
+  rb->head = rb->tail = 0;
+
+  tv = *tv_timeout;	/* select may update it */
+
+  FD_ZERO(&rfds);
+  FD_SET(p->fd, &rfds);
+  efds = rfds;
+
+  retval = port_select(p, p->fd+1, &rfds, NULL, &efds, &tv);
+  if (retval == 0)
+	return -RIG_ETIMEOUT;
+
+  if (retval < 0) {
+	rig_debug(RIG_DEBUG_ERR, "%s(): select() error: %s\n",
+		  __func__, strerror(errno));
+	return -RIG_EIO;
+  }
+  if (FD_ISSET(p->fd, &efds)) {
+	rig_debug(RIG_DEBUG_ERR, "%s(): fd error\n", __func__);
+	return -RIG_EIO;
+  }
+
+  /*
+   * grab all the pending bytes from the rig
+   * The file descriptor must have been set up non blocking.
+   */
+  rd_count = port_read(p, rb->buf, PORTRXBUFSZ);
+  if (rd_count < 0) {
+	rig_debug(RIG_DEBUG_ERR, "%s(): read() failed - %s\n",
+		  __func__, strerror(errno));
+	return -RIG_EIO;
+  }
+  if (rd_count == 0) {
+	/* readable but nothing to read: hangup or connection closed */
+	rig_debug(RIG_DEBUG_ERR, "%s(): read() returned no data\n", __func__);
+	return -RIG_EIO;
+  }
+
+  rb->tail = rd_count;
+
+  return rd_count;
+}
+
+/**
+ * \brief Number of bytes read ahead, not consumed yet
+ * \param p Hamlib port descriptor
+ * \return byte count
+ *
+ * A port with bytes read ahead is readable, whatever its file
+ * descriptor says.
+ */
+int HAMLIB_API port_rx_pending(const hamlib_port_t *p)
+{
+  const struct port_rxbuf *rb = p->rxbuf;
+
+  return rb ? rb->tail - rb->head : 0;
+}
+
+/*
+ * Drop the bytes read ahead, e.g. on flush or open
+ */
+void port_rx_discard(hamlib_port_t *p)
+{
+  struct port_rxbuf *rb = p->rxbuf;
+
+  if (rb)
+	rb->head = rb->tail = 0;
+}
+
+/*
+ * Release the receive buffer, on close
+ */
+void port_rx_free(hamlib_port_t *p)
+{
+  free(p->rxbuf);
+  p->rxbuf = NULL;
+}
+
+/*
+ * Find the first char of buf[0..len-1] belonging to the stopset
+ */
+static const unsigned char *find_stopset(const unsigned char *buf, int len,
+				const char *stopset, int stopset_len)
+{
+  int i;
+
+  /* single terminator, as in most ASCII protocols, let libc scan it */
+  if (stopset_len == 1)
+	return memchr(buf, stopset[0], len);
+
+  for (i=0; i < len; i++) {
+	if (memchr(stopset, buf[i], stopset_len))
+		return buf+i;
+  }
+  return NULL;
+}
+
 /**
  * \brief Read bytes from an fd
  * \param p rig port descriptor
@@ -378,14 +511,17 @@ int HAMLIB_API write_block(hamlib_port_t *p, const char *txbuffer, size_t count)
  *
  * It then reads "num" bytes into rxbuffer.
  *
+ * Bytes received beyond "num" are kept in the port receive buffer
+ * for the next read_block()/read_string() call.
+ *
  * Actually, this function has nothing specific to serial comm,
  * it could work very well also with any file handle, like a socket.
  */
 
 int HAMLIB_API read_block(hamlib_port_t *p, char *rxbuffer, size_t count)
 {
-  fd_set rfds, efds;
-  struct timeval tv, tv_timeout, start_time, end_time, elapsed_time;
+  struct port_rxbuf *rb;
+  struct timeval tv_timeout, start_time, end_time, elapsed_time;
   int rd_count, total_count = 0;
   int retval;
 
@@ -400,49 +536,37 @@ int HAMLIB_API read_block(hamlib_port_t *p, char *rxbuffer, size_t count)
   gettimeofday(&start_time, NULL);
 
   while (count > 0) {
-	tv = tv_timeout;	/* select may have updated it */
-
-	FD_ZERO(&rfds);
-	FD_SET(p->fd, &rfds);
-	efds = rfds;
+	rd_count = port_rx_pending(p);
 
-	retval = port_select(p, p->fd+1, &rfds, NULL, &efds, &tv);
-	if (retval == 0) {
-		/* Record timeout time and caculate elapsed time */
-		gettimeofday(&end_time, NULL);
-		timersub(&end_time, &start_time, &elapsed_time);
+	if (rd_count == 0) {
+		retval = port_fill_rxbuf(p, &tv_timeout);
+		if (retval == -RIG_ETIMEOUT) {
+			/* Record timeout time and caculate elapsed time */
+			gettimeofday(&end_time, NULL);
+			timersub(&end_time, &start_time, &elapsed_time);
 
-		dump_hex((unsigned char *) rxbuffer, total_count);
-		rig_debug(RIG_DEBUG_WARN, "%s(): Timed out %d.%d seconds after %d chars\n",
-			  __func__, elapsed_time.tv_sec, elapsed_time.tv_usec, total_count);
+			dump_hex((unsigned char *) rxbuffer, total_count);
+			rig_debug(RIG_DEBUG_WARN, "%s(): Timed out %d.%d seconds after %d chars\n",
+				  __func__, elapsed_time.tv_sec, elapsed_time.tv_usec, total_count);
 
-		return -RIG_ETIMEOUT;
-	}
-	if (retval < 0) {
-		dump_hex((unsigned char *) rxbuffer, total_count);
-		rig_debug(RIG_DEBUG_ERR,"%s(): select() error after %d chars: %s\n",
-			  __func__, total_count, strerror(errno));
-
-		return -RIG_EIO;
-	}
-	if (FD_ISSET(p->fd, &efds)) {
-		rig_debug(RIG_DEBUG_ERR, "%s(): fd error after %d chars\n",
-			  __func__, total_count);
+			return -RIG_ETIMEOUT;
+		}
+		if (retval < 0) {
+			dump_hex((unsigned char *) rxbuffer, total_count);
+			rig_debug(RIG_DEBUG_ERR, "%s(): I/O error after %d chars\n",
+				  __func__, total_count);
 
-		return -RIG_EIO;
+			return retval;
+		}
+		continue;
 	}
 
-	/*
-	 * grab bytes from the rig
-	 * The file descriptor must have been set up non blocking.
-	 */
-	rd_count = port_read(p, rxbuffer+total_count, count);
-	if (rd_count < 0) {
-		rig_debug(RIG_DEBUG_ERR, "%s(): read() failed - %s\n",
-			  __func__, strerror(errno));
+	if (rd_count > count)
+		rd_count = count;
 
-		return -RIG_EIO;
-	}
+	rb = p->rxbuf;
+	memcpy(rxbuffer+total_count, rb->buf+rb->head, rd_count);
+	rb->head += rd_count;
 	total_count += rd_count;
 	count -= rd_count;
   }
@@ -474,6 +598,9 @@ int HAMLIB_API read_block(hamlib_port_t *p, char *rxbuffer, size_t count)
  * "stopset" is found, or until "rxmax-1" characters was copied
  * into rxbuffer.  String termination character is added at the end.
  *
+ * Characters following the stop character are kept in the port
+ * receive buffer for the next read_block()/read_string() call.
+ *
  * Actually, this function has nothing specific to serial comm,
  * it could work very well also with any file handle, like a socket.
  *
@@ -482,8 +609,9 @@ int HAMLIB_API read_block(hamlib_port_t *p, char *rxbuffer, size_t count)
 int HAMLIB_API read_string(hamlib_port_t *p, char *rxbuffer, size_t rxmax, const char *stopset,
 				int stopset_len)
 {
-  fd_set rfds, efds;
-  struct timeval tv, tv_timeout, start_time, end_time, elapsed_time;
+  struct port_rxbuf *rb;
+  struct timeval tv_timeout, start_time, end_time, elapsed_time;
+  const unsigned char *rx_ptr, *stop_ptr = NULL;
   int rd_count, total_count = 0;
   int retval;
 
@@ -496,46 +624,40 @@ int HAMLIB_API read_string(hamlib_port_t *p, char *rxbuffer, size_t rxmax, const
   /* Store the time of the read loop start */
   gettimeofday(&start_time, NULL);
 
-  while (total_count < rxmax-1) {
-	tv = tv_timeout;	/* select may have updated it */
-
-	FD_ZERO(&rfds);
-	FD_SET(p->fd, &rfds);
-	efds = rfds;
-
-	retval = port_select(p, p->fd+1, &rfds, NULL, &efds, &tv);
-        if (retval == 0)    /* Timed out */
-            break;
+  while (total_count < rxmax-1 && !stop_ptr) {
+	rd_count = port_rx_pending(p);
 
-	if (retval < 0) {
-		dump_hex((unsigned char *) rxbuffer, total_count);
-		rig_debug(RIG_DEBUG_ERR, "%s(): select() error after %d chars: %s\n",
-			  __func__, total_count, strerror(errno));
+	if (rd_count == 0) {
+		retval = port_fill_rxbuf(p, &tv_timeout);
+		if (retval == -RIG_ETIMEOUT)    /* Timed out */
+			break;
+		if (retval < 0) {
+			dump_hex((unsigned char *) rxbuffer, total_count);
+			rig_debug(RIG_DEBUG_ERR, "%s(): I/O error after %d chars\n",
+				  __func__, total_count);
 
-		return -RIG_EIO;
+			return retval;
+		}
+		continue;
 	}
-	if (FD_ISSET(p->fd, &efds)) {
-		rig_debug(RIG_DEBUG_ERR, "%s(): fd error after %d chars\n",
-			  __func__, total_count);
 
-		return -RIG_EIO;
-	}
+	if (rd_count > rxmax-1-total_count)
+		rd_count = rxmax-1-total_count;
 
 	/*
-       	 * read 1 character from the rig, (check if in stop set)
-	 * The file descriptor must have been set up non blocking.
+	 * copy up to and including the first character in the stop set
 	 */
-        rd_count = port_read(p, &rxbuffer[total_count], 1);
-	if (rd_count < 0) {
-		dump_hex((unsigned char *) rxbuffer, total_count);
-		rig_debug(RIG_DEBUG_ERR, "%s(): read() failed - %s\n",
-			  __func__, strerror(errno));
-
-		return -RIG_EIO;
+	rb = p->rxbuf;
+	rx_ptr = rb->buf+rb->head;
+	if (stopset) {
+		stop_ptr = find_stopset(rx_ptr, rd_count, stopset, stopset_len);
+		if (stop_ptr)
+			rd_count = stop_ptr - rx_ptr + 1;
 	}
-        ++total_count;
-	if (stopset && memchr(stopset, rxbuffer[total_count-1], stopset_len))
-		break;
+
+	memcpy(&rxbuffer[total_count], rx_ptr, rd_count);
+	rb->head += rd_count;
+	total_count += rd_count;
   }
   /*
    * Doesn't hurt anyway. But be aware, some binary protocols may have
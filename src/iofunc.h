@@ -33,5 +33,12 @@ extern HAMLIB_EXPORT(int) read_block(hamlib_port_t *p, char *rxbuffer, size_t co
 extern HAMLIB_EXPORT(int) write_block(hamlib_port_t *p, const char *txbuffer, size_t count);
 extern HAMLIB_EXPORT(int) read_string(hamlib_port_t *p, char *rxbuffer, size_t rxmax, const char *stopset, int stopset_len);
 
+/*
+ * Bytes read ahead by read_block()/read_string(), not consumed yet
+ */
+extern HAMLIB_EXPORT(int) port_rx_pending(const hamlib_port_t *p);
+void port_rx_discard(hamlib_port_t *p);
+void port_rx_free(hamlib_port_t *p);
+
 #endif /* _IOFUNC_H */
 
@@ -45,11 +45,16 @@
 #include <fcntl.h>
 
 #include <hamlib/rig.h>
+#include "cache.h"
+#include "event.h"
 
 #ifndef DOC_HIDDEN
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
+static int set_channel(RIG *rig, const channel_t *chan);
+static int get_channel(RIG *rig, channel_t *chan);
+
 #endif /* !DOC_HIDDEN */
 
 
@@ -79,25 +84,29 @@ int HAMLIB_API rig_set_mem(RIG *rig, vfo_t vfo, int ch)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_mem == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_mem(rig, vfo, ch);
+		RIG_UNLOCK_RETURN(rig, caps->set_mem(rig, vfo, ch));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_mem(rig, vfo, ch);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -125,25 +134,27 @@ int HAMLIB_API rig_get_mem(RIG *rig, vfo_t vfo, int *ch)
 	if (CHECK_RIG_ARG(rig) || !ch)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_mem == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_mem(rig, vfo, ch);
+		RIG_UNLOCK_RETURN(rig, caps->get_mem(rig, vfo, ch));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_mem(rig, vfo, ch);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -173,25 +184,29 @@ int HAMLIB_API rig_set_bank(RIG *rig, vfo_t vfo, int bank)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_bank == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_bank(rig, vfo, bank);
+		RIG_UNLOCK_RETURN(rig, caps->set_bank(rig, vfo, bank));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_bank(rig, vfo, bank);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 #ifndef DOC_HIDDEN
@@ -288,6 +303,215 @@ static int rig_mem_caps_empty(const channel_cap_t *mem_cap)
 		);
 }
 
+/*
+ * Channel content hashes
+ *
+ * The frontend remembers a hash of the content of every memory channel
+ * it has read or written, indexed by the position of the channel in
+ * chan_list.  This lets rig_set_chan_diff() skip the channels already
+ * holding the data to be written.
+ */
+#define CHAN_HASH_UNKNOWN	0
+#define CHAN_HASH_EMPTY		1
+
+#define FNV_OFFSET_BASIS	2166136261U
+#define FNV_PRIME		16777619U
+
+static unsigned fnv1a(unsigned h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len-- > 0) {
+		h ^= *p++;
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+#define HASH_FIELD(h, f)	((h) = fnv1a((h), &(f), sizeof(f)))
+
+/*
+ * Hash the fields of chan stored by the memory channel, as told by
+ * its mem_caps.  An empty channel always hashes to CHAN_HASH_EMPTY.
+ */
+static unsigned chan_hash(RIG *rig, const channel_t *chan)
+{
+	const channel_cap_t *mem_cap = NULL;
+	const chan_t *chan_cap;
+	const struct confparams *cfp;
+	const struct ext_list *p;
+	setting_t setting, funcs;
+	unsigned h = FNV_OFFSET_BASIS;
+	int i;
+
+	chan_cap = rig_lookup_mem_caps(rig, chan->channel_num);
+	if (chan_cap)
+		mem_cap = &chan_cap->mem_caps;
+	if (mem_cap == NULL || rig_mem_caps_empty(mem_cap))
+		mem_cap = &mem_cap_all;
+
+	if (chan->freq == RIG_FREQ_NONE)
+		return CHAN_HASH_EMPTY;
+
+	if (mem_cap->bank_num)
+		HASH_FIELD(h, chan->bank_num);
+	if (mem_cap->ant)
+		HASH_FIELD(h, chan->ant);
+	if (mem_cap->freq)
+		HASH_FIELD(h, chan->freq);
+	if (mem_cap->mode)
+		HASH_FIELD(h, chan->mode);
+	if (mem_cap->width)
+		HASH_FIELD(h, chan->width);
+	if (mem_cap->tx_freq)
+		HASH_FIELD(h, chan->tx_freq);
+	if (mem_cap->tx_mode)
+		HASH_FIELD(h, chan->tx_mode);
+	if (mem_cap->tx_width)
+		HASH_FIELD(h, chan->tx_width);
+	if (mem_cap->split)
+		HASH_FIELD(h, chan->split);
+	if (mem_cap->tx_vfo)
+		HASH_FIELD(h, chan->tx_vfo);
+	if (mem_cap->rptr_shift)
+		HASH_FIELD(h, chan->rptr_shift);
+	if (mem_cap->rptr_offs)
+		HASH_FIELD(h, chan->rptr_offs);
+	if (mem_cap->tuning_step)
+		HASH_FIELD(h, chan->tuning_step);
+	if (mem_cap->rit)
+		HASH_FIELD(h, chan->rit);
+	if (mem_cap->xit)
+		HASH_FIELD(h, chan->xit);
+
+	funcs = chan->funcs & mem_cap->funcs;
+	HASH_FIELD(h, funcs);
+
+	for (i=0; i<RIG_SETTING_MAX; i++) {
+		setting = rig_idx2setting(i);
+		if (!(setting & mem_cap->levels))
+			continue;
+		if (RIG_LEVEL_IS_FLOAT(setting))
+			HASH_FIELD(h, chan->levels[i].f);
+		else
+			HASH_FIELD(h, chan->levels[i].i);
+	}
+
+	if (mem_cap->ctcss_tone)
+		HASH_FIELD(h, chan->ctcss_tone);
+	if (mem_cap->ctcss_sql)
+		HASH_FIELD(h, chan->ctcss_sql);
+	if (mem_cap->dcs_code)
+		HASH_FIELD(h, chan->dcs_code);
+	if (mem_cap->dcs_sql)
+		HASH_FIELD(h, chan->dcs_sql);
+	if (mem_cap->scan_group)
+		HASH_FIELD(h, chan->scan_group);
+	if (mem_cap->flags)
+		HASH_FIELD(h, chan->flags);
+	if (mem_cap->channel_desc) {
+		for (i=0; i<MAXCHANDESC && chan->channel_desc[i]; i++)
+			;
+		h = fnv1a(h, chan->channel_desc, i);
+	}
+
+	if (mem_cap->ext_levels && chan->ext_levels) {
+		for (p = chan->ext_levels; !RIG_IS_EXT_END(*p); p++) {
+			HASH_FIELD(h, p->token);
+			cfp = rig_ext_lookup_tok(rig, p->token);
+			if (cfp && cfp->type == RIG_CONF_STRING) {
+				if (p->val.cs)
+					h = fnv1a(h, p->val.cs, strlen(p->val.cs));
+			} else if (cfp && cfp->type == RIG_CONF_NUMERIC) {
+				HASH_FIELD(h, p->val.f);
+			} else {
+				HASH_FIELD(h, p->val.i);
+			}
+		}
+	}
+
+	/* keep clear of the reserved values */
+	if (h == CHAN_HASH_UNKNOWN || h == CHAN_HASH_EMPTY)
+		h += 2;
+
+	return h;
+}
+
+/*
+ * Position of channel_num in the hash table, -1 if not in chan_list
+ */
+static int chan_hash_index(RIG *rig, int channel_num)
+{
+	const chan_t *chan_list = rig->state.chan_list;
+	int i, idx = 0;
+
+	for (i=0; i<CHANLSTSIZ && !RIG_IS_CHAN_END(chan_list[i]); i++) {
+		if (channel_num >= chan_list[i].start && channel_num <= chan_list[i].end)
+			return idx + channel_num - chan_list[i].start;
+		idx += chan_list[i].end - chan_list[i].start + 1;
+	}
+
+	return -1;
+}
+
+static unsigned chan_hash_get(RIG *rig, int channel_num)
+{
+	const unsigned *tbl = rig->state.chan_hash;
+	int idx;
+
+	if (!tbl)
+		return CHAN_HASH_UNKNOWN;
+
+	idx = chan_hash_index(rig, channel_num);
+
+	return idx < 0 ? CHAN_HASH_UNKNOWN : tbl[idx];
+}
+
+static void chan_hash_set(RIG *rig, int channel_num, unsigned h)
+{
+	unsigned *tbl = rig->state.chan_hash;
+	int idx, count;
+
+	idx = chan_hash_index(rig, channel_num);
+	if (idx < 0)
+		return;
+
+	if (!tbl) {
+		if (h == CHAN_HASH_UNKNOWN)
+			return;
+		count = rig_mem_count(rig);
+		tbl = calloc(count, sizeof(unsigned));
+		if (!tbl)
+			return;
+		rig->state.chan_hash = tbl;
+	}
+
+	tbl[idx] = h;
+}
+
+/*
+ * Record the outcome of a memory channel read, retval being
+ * the status of the read
+ */
+static void chan_hash_update(RIG *rig, const channel_t *chan, int retval)
+{
+	if (chan->vfo != RIG_VFO_MEM)
+		return;
+
+	if (retval == RIG_OK)
+		chan_hash_set(rig, chan->channel_num, chan_hash(rig, chan));
+	else if (retval == -RIG_ENAVAIL)
+		chan_hash_set(rig, chan->channel_num, CHAN_HASH_EMPTY);
+	else
+		chan_hash_set(rig, chan->channel_num, CHAN_HASH_UNKNOWN);
+}
+
+void rig_chan_hash_free(RIG *rig)
+{
+	free(rig->state.chan_hash);
+	rig->state.chan_hash = NULL;
+}
+
 /*
  * stores current VFO state into chan by emulating rig_get_channel
  */
@@ -501,6 +725,24 @@ static int generic_restore_channel(RIG *rig, const channel_t *chan)
  */
 
 int HAMLIB_API rig_set_channel(RIG *rig, const channel_t *chan)
+{
+	int retcode;
+
+	if (CHECK_RIG_ARG(rig) || !chan)
+		return -RIG_EINVAL;
+
+	rig_port_lock(rig);
+
+	retcode = set_channel(rig, chan);
+
+	if (chan->vfo == RIG_VFO_MEM)
+		chan_hash_set(rig, chan->channel_num, retcode == RIG_OK ?
+				chan_hash(rig, chan) : CHAN_HASH_UNKNOWN);
+
+	RIG_UNLOCK_RETURN(rig, retcode);
+}
+
+static int set_channel(RIG *rig, const channel_t *chan)
 {
 	struct rig_caps *rc;
 	int curr_chan_num, get_mem_status = RIG_OK;
@@ -512,8 +754,7 @@ int HAMLIB_API rig_set_channel(RIG *rig, const channel_t *chan)
 	channel_t curr_chan;
 #endif
 
-	if (CHECK_RIG_ARG(rig) || !chan)
-		return -RIG_EINVAL;
+	rig_cache_invalidate(rig);
 
 	/*
 	 * TODO: check validity of chan->channel_num
@@ -624,6 +865,22 @@ int HAMLIB_API rig_set_channel(RIG *rig, const channel_t *chan)
  * \sa rig_set_channel()
  */
 int HAMLIB_API rig_get_channel(RIG *rig, channel_t *chan)
+{
+	int retcode;
+
+	if (CHECK_RIG_ARG(rig) || !chan)
+		return -RIG_EINVAL;
+
+	rig_port_lock(rig);
+
+	retcode = get_channel(rig, chan);
+
+	chan_hash_update(rig, chan, retcode);
+
+	RIG_UNLOCK_RETURN(rig, retcode);
+}
+
+static int get_channel(RIG *rig, channel_t *chan)
 {
 	struct rig_caps *rc;
 	int curr_chan_num, get_mem_status = RIG_OK;
@@ -635,9 +892,6 @@ int HAMLIB_API rig_get_channel(RIG *rig, channel_t *chan)
 	channel_t curr_chan;
 #endif
 
-	if (CHECK_RIG_ARG(rig) || !chan)
-		return -RIG_EINVAL;
-
 	/*
 	 * TODO: check validity of chan->channel_num
 	 */
@@ -710,11 +964,186 @@ int HAMLIB_API rig_get_channel(RIG *rig, channel_t *chan)
 
 
 #ifndef DOC_HIDDEN
+
+/* channels read per get_chan_range call */
+#define CHAN_BLOCK 8
+
+/*
+ * State of a bulk channel transfer
+ */
+struct chan_xfer {
+	chan_cb_t chan_cb;
+	rig_ptr_t arg;
+	int done;
+	int total;
+};
+
+static int chan_list_count(const chan_t *chan_list)
+{
+	int i, total = 0;
+
+ 	for (i=0; !RIG_IS_CHAN_END(chan_list[i]) && i < CHANLSTSIZ; i++)
+		total += chan_list[i].end - chan_list[i].start + 1;
+
+	return total;
+}
+
+static void chan_progress(RIG *rig, struct chan_xfer *x, int channel_num)
+{
+	x->done++;
+	if (rig->callbacks.chan_progress)
+		rig->callbacks.chan_progress(rig, channel_num, x->done, x->total,
+				rig->callbacks.chan_progress_arg);
+}
+
+/*
+ * Read the memories start..end through the backend bulk reader,
+ * CHAN_BLOCK channels at a time.
+ */
+static int get_chan_range_bulk(RIG *rig, const chan_t *chan_list, int start,
+		int end, channel_t **chan, struct chan_xfer *x)
+{
+	channel_t block[CHAN_BLOCK];
+	int status[CHAN_BLOCK];
+	struct ext_list *ext_levels;
+	int j, k, n, retval;
+
+	for (j = start; j <= end; j += n) {
+		n = end - j + 1;
+		if (n > CHAN_BLOCK)
+			n = CHAN_BLOCK;
+
+		memset(block, 0, sizeof(block));
+		for (k = 0; k < n; k++) {
+			block[k].vfo = RIG_VFO_MEM;
+			block[k].channel_num = j + k;
+			status[k] = -RIG_ENIMPL;
+		}
+
+		retval = rig->caps->get_chan_range(rig, j, n, block, status);
+		if (retval != RIG_OK)
+			return retval;
+
+		for (k = 0; k < n; k++) {
+			chan_hash_update(rig, &block[k], status[k]);
+			chan_progress(rig, x, j + k);
+
+			if (status[k] == -RIG_ENAVAIL)
+				continue;	/* empty channel */
+			if (status[k] != RIG_OK)
+				return status[k];
+
+			ext_levels = (*chan)->ext_levels;
+			memcpy(*chan, &block[k], sizeof(channel_t));
+			(*chan)->ext_levels = ext_levels;
+			(*chan)->vfo = RIG_VFO_MEM;
+			(*chan)->channel_num = j + k;
+
+			x->chan_cb(rig, chan, j + k < end ? j + k + 1 : j + k,
+					chan_list, x->arg);
+		}
+	}
+
+	return RIG_OK;
+}
+
+/*
+ * Read the memories start..end one at a time.  Without a backend
+ * get_channel, the VFO/memory emulation of rig_get_channel() is set
+ * up once for the whole range instead of once per channel.
+ */
+static int get_chan_range_generic(RIG *rig, const chan_t *chan_list, int start,
+		int end, channel_t **chan, struct chan_xfer *x)
+{
+	struct rig_caps *rc = rig->caps;
+	int j, retval, curr_chan_num, get_mem_status = RIG_OK;
+	vfo_t curr_vfo;
+	int emulate, can_emulate_by_vfo_mem, can_emulate_by_vfo_op;
+
+	can_emulate_by_vfo_mem = rc->set_vfo &&
+		((rig->state.vfo_list & RIG_VFO_MEM) == RIG_VFO_MEM);
+
+	can_emulate_by_vfo_op = rc->vfo_op &&
+		rig_has_vfo_op(rig, RIG_OP_TO_VFO);
+
+	emulate = !rc->get_channel && rc->set_mem &&
+		(can_emulate_by_vfo_mem || can_emulate_by_vfo_op);
+
+	curr_vfo = rig->state.current_vfo;
+
+	if (emulate) {
+		get_mem_status = rig_get_mem(rig, RIG_VFO_CURR, &curr_chan_num);
+
+		if (can_emulate_by_vfo_mem && curr_vfo != RIG_VFO_MEM) {
+			retval = rig_set_vfo(rig, RIG_VFO_MEM);
+			if (retval != RIG_OK)
+				return retval;
+		}
+	}
+
+	retval = RIG_OK;
+
+	for (j = start; j <= end; j++) {
+
+		(*chan)->vfo = RIG_VFO_MEM;
+		(*chan)->channel_num = j;
+
+		if (emulate) {
+			rig_set_mem(rig, RIG_VFO_CURR, j);
+
+			if (!can_emulate_by_vfo_mem) {
+				retval = rig_vfo_op(rig, RIG_VFO_CURR, RIG_OP_TO_VFO);
+				if (retval != RIG_OK)
+					break;
+			}
+
+			retval = generic_save_channel(rig, *chan);
+			chan_hash_update(rig, *chan, retval);
+		} else {
+			retval = rig_get_channel(rig, *chan);
+		}
+
+		chan_progress(rig, x, j);
+
+		if (retval == -RIG_ENAVAIL) {
+			/*
+			 * empty channel
+			 *
+			 * Should it continue or call chan_cb with special arg?
+			 */
+			retval = RIG_OK;
+			continue;
+		}
+
+		if (retval != RIG_OK)
+			break;
+
+		x->chan_cb(rig, chan, j < end ? j+1 : j, chan_list, x->arg);
+	}
+
+	if (emulate) {
+		/* restore current memory number */
+		if (get_mem_status == RIG_OK)
+			rig_set_mem(rig, RIG_VFO_CURR, curr_chan_num);
+
+		if (can_emulate_by_vfo_mem)
+			rig_set_vfo(rig, curr_vfo);
+	}
+
+	return retval;
+}
+
 int get_chan_all_cb_generic (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 {
-	int i,j,retval;
+	int i,retval;
 	chan_t *chan_list = rig->state.chan_list;
 	channel_t *chan;
+	struct chan_xfer x;
+
+	x.chan_cb = chan_cb;
+	x.arg = arg;
+	x.done = 0;
+	x.total = chan_list_count(chan_list);
 
  	for (i=0; !RIG_IS_CHAN_END(chan_list[i]) && i < CHANLSTSIZ; i++) {
 
@@ -730,33 +1159,15 @@ int get_chan_all_cb_generic (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 		if (chan == NULL)
 			return -RIG_ENOMEM;
 
-		for (j = chan_list[i].start; j <= chan_list[i].end; j++) {
-			int chan_next;
-
-			chan->vfo = RIG_VFO_MEM;
-			chan->channel_num = j;
-
-			/*
-			 * TODO: if doesn't have rc->get_channel, special generic
-			 */
-			retval = rig_get_channel(rig, chan);
-
-			if (retval == -RIG_ENAVAIL) {
-				/*
-				 * empty channel
-				 *
-				 * Should it continue or call chan_cb with special arg?
-				 */
-				continue;
-			}
-
-			if (retval != RIG_OK)
-				return retval;
-
-			chan_next = j < chan_list[i].end ? j+1 : j;
+		if (rig->caps->get_chan_range)
+			retval = get_chan_range_bulk(rig, chan_list, chan_list[i].start,
+					chan_list[i].end, &chan, &x);
+		else
+			retval = get_chan_range_generic(rig, chan_list, chan_list[i].start,
+					chan_list[i].end, &chan, &x);
 
-			chan_cb(rig, &chan, chan_next, chan_list, arg);
-		}
+		if (retval != RIG_OK)
+			return retval;
 	}
 
 	return RIG_OK;
@@ -767,6 +1178,12 @@ int set_chan_all_cb_generic (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 	int i,j,retval;
 	chan_t *chan_list = rig->state.chan_list;
 	channel_t *chan;
+	struct chan_xfer x;
+
+	x.chan_cb = chan_cb;
+	x.arg = arg;
+	x.done = 0;
+	x.total = chan_list_count(chan_list);
 
  	for (i=0; !RIG_IS_CHAN_END(chan_list[i]) && i < CHANLSTSIZ; i++) {
 
@@ -779,6 +1196,8 @@ int set_chan_all_cb_generic (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 
 			if (retval != RIG_OK)
 				return retval;
+
+			chan_progress(rig, &x, j);
 		}
 	}
 
@@ -830,16 +1249,20 @@ int HAMLIB_API rig_set_chan_all_cb (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 	if (CHECK_RIG_ARG(rig) || !chan_cb)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	rc = rig->caps;
 
 	if (rc->set_chan_all_cb)
-		return rc->set_chan_all_cb(rig, chan_cb, arg);
+		RIG_UNLOCK_RETURN(rig, rc->set_chan_all_cb(rig, chan_cb, arg));
 
 
 	/* if not available, emulate it */
 	retval = set_chan_all_cb_generic (rig, chan_cb, arg);
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -856,6 +1279,10 @@ int HAMLIB_API rig_set_chan_all_cb (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
  *  future data for channel channel_num. If channel_num == chan->channel_num,
  *  the application does not need to provide a new allocated structure.
  *
+ *  Empty channels are skipped. Backends providing get_chan_range read
+ *  several channels per command sequence, see
+ *  rig_set_chan_progress_callback() to follow the transfer.
+ *
  * \return RIG_OK if the operation has been sucessful, otherwise
  * a negative value if an error occured (in which case, cause is
  * set appropriately).
@@ -870,16 +1297,18 @@ int HAMLIB_API rig_get_chan_all_cb (RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
 	if (CHECK_RIG_ARG(rig) || !chan_cb)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	rc = rig->caps;
 
 	if (rc->get_chan_all_cb)
-		return rc->get_chan_all_cb(rig, chan_cb, arg);
+		RIG_UNLOCK_RETURN(rig, rc->get_chan_all_cb(rig, chan_cb, arg));
 
 
 	/* if not available, emulate it */
 	retval = get_chan_all_cb_generic (rig, chan_cb, arg);
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 
@@ -905,17 +1334,21 @@ int HAMLIB_API rig_set_chan_all (RIG *rig, const channel_t chans[])
 	if (CHECK_RIG_ARG(rig) || !chans)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	rc = rig->caps;
 	map_arg.chans = (channel_t *) chans;
 
 	if (rc->set_chan_all_cb)
-		return rc->set_chan_all_cb(rig, map_chan, (rig_ptr_t)&map_arg);
+		RIG_UNLOCK_RETURN(rig, rc->set_chan_all_cb(rig, map_chan, (rig_ptr_t)&map_arg));
 
 
 	/* if not available, emulate it */
 	retval = set_chan_all_cb_generic (rig, map_chan, (rig_ptr_t)&map_arg);
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 
@@ -941,11 +1374,13 @@ int HAMLIB_API rig_get_chan_all (RIG *rig, channel_t chans[])
 	if (CHECK_RIG_ARG(rig) || !chans)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	rc = rig->caps;
 	map_arg.chans = chans;
 
 	if (rc->get_chan_all_cb)
-		return rc->get_chan_all_cb(rig, map_chan, (rig_ptr_t)&map_arg);
+		RIG_UNLOCK_RETURN(rig, rc->get_chan_all_cb(rig, map_chan, (rig_ptr_t)&map_arg));
 
 	/*
 	 * if not available, emulate it
@@ -954,7 +1389,214 @@ int HAMLIB_API rig_get_chan_all (RIG *rig, channel_t chans[])
 	 */
 	retval = get_chan_all_cb_generic (rig, map_chan, (rig_ptr_t)&map_arg);
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
+}
+
+#ifndef DOC_HIDDEN
+/*
+ * Hash of the current content of memory channel_num, read from the rig
+ * unless known already
+ */
+static int chan_hash_read(RIG *rig, int channel_num, int reread, unsigned *h)
+{
+	channel_t chan;
+	int retval;
+
+	*h = reread ? CHAN_HASH_UNKNOWN : chan_hash_get(rig, channel_num);
+	if (*h != CHAN_HASH_UNKNOWN)
+		return RIG_OK;
+
+	memset(&chan, 0, sizeof(chan));
+	chan.vfo = RIG_VFO_MEM;
+	chan.channel_num = channel_num;
+
+	retval = rig_get_channel(rig, &chan);
+	free(chan.ext_levels);
+
+	if (retval != RIG_OK && retval != -RIG_ENAVAIL)
+		return retval;
+
+	*h = chan_hash_get(rig, channel_num);
+
+	return RIG_OK;
+}
+
+/*
+ * Report the difference found on chan, then write it unless dry run
+ */
+static int chan_diff_apply(RIG *rig, const channel_t *chan, chan_diff_t diff,
+		int flags, chan_diff_cb_t diff_cb, rig_ptr_t arg)
+{
+	channel_t mem_chan;
+	int retval;
+
+	if (diff_cb) {
+		retval = diff_cb(rig, chan, diff, arg);
+		if (retval != RIG_OK)
+			return retval;
+	}
+
+	if (diff == RIG_CHAN_SAME || (flags & RIG_CHAN_DIFF_DRYRUN))
+		return RIG_OK;
+
+	memcpy(&mem_chan, chan, sizeof(channel_t));
+	mem_chan.vfo = RIG_VFO_MEM;
+
+	return rig_set_channel(rig, &mem_chan);
+}
+#endif	/* DOC_HIDDEN */
+
+/**
+ * \brief write only the memory channels that differ
+ * \param rig	The rig handle
+ * \param chans	The channels to be written
+ * \param count	The number of entries in \a chans
+ * \param flags	Bitwise OR of RIG_CHAN_DIFF_DRYRUN, RIG_CHAN_DIFF_DELETE
+ *		and RIG_CHAN_DIFF_REREAD
+ * \param diff_cb	Callback reporting every channel compared, may be NULL
+ * \param arg	Arbitrary argument passed back to \a diff_cb
+ *
+ *  Compares the memory channels listed in \a chans, by channel_num,
+ *  with the content of the rig memory, and only writes the ones which
+ *  are changed or new.  A channel with a RIG_FREQ_NONE frequency deletes
+ *  the memory.  With RIG_CHAN_DIFF_DELETE, the memories not listed in
+ *  \a chans are deleted too.
+ *
+ *  The content of the rig memory is compared through a hash of the
+ *  fields listed in the mem_caps of the channel.  The hashes of the
+ *  channels read or written earlier through this rig handle are reused,
+ *  unless RIG_CHAN_DIFF_REREAD is set, e.g. because the memories may
+ *  have been edited from the front panel meanwhile.  The other channels
+ *  are read back once.
+ *
+ *  With RIG_CHAN_DIFF_DRYRUN, nothing is written, \a diff_cb only reports
+ *  what would be done.  Returning an error from \a diff_cb aborts.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_chan_all(), rig_set_channel()
+ */
+int HAMLIB_API rig_set_chan_diff(RIG *rig, const channel_t chans[], int count,
+		int flags, chan_diff_cb_t diff_cb, rig_ptr_t arg)
+{
+	const chan_t *chan_list;
+	channel_t empty_chan;
+	unsigned char *listed;
+	unsigned old_h, new_h;
+	chan_diff_t diff;
+	int i, j, idx, retval;
+	int reread = flags & RIG_CHAN_DIFF_REREAD;
+
+	if (CHECK_RIG_ARG(rig) || (!chans && count > 0) || count < 0)
+		return -RIG_EINVAL;
+
+	rig_port_lock(rig);
+
+	listed = calloc(rig_mem_count(rig) + 1, 1);
+	if (!listed)
+		RIG_UNLOCK_RETURN(rig, -RIG_ENOMEM);
+
+	retval = RIG_OK;
+
+	for (i = 0; i < count; i++) {
+		idx = chan_hash_index(rig, chans[i].channel_num);
+		if (idx < 0) {
+			rig_debug(RIG_DEBUG_WARN, "%s: channel %d not in chan_list\n",
+					__FUNCTION__, chans[i].channel_num);
+			retval = -RIG_EINVAL;
+			break;
+		}
+		listed[idx] = 1;
+
+		retval = chan_hash_read(rig, chans[i].channel_num, reread, &old_h);
+		if (retval != RIG_OK)
+			break;
+
+		new_h = chan_hash(rig, &chans[i]);
+
+		if (new_h == old_h)
+			diff = RIG_CHAN_SAME;
+		else if (new_h == CHAN_HASH_EMPTY)
+			diff = RIG_CHAN_DELETED;
+		else if (old_h == CHAN_HASH_EMPTY)
+			diff = RIG_CHAN_NEW;
+		else
+			diff = RIG_CHAN_CHANGED;
+
+		retval = chan_diff_apply(rig, &chans[i], diff, flags, diff_cb, arg);
+		if (retval != RIG_OK)
+			break;
+	}
+
+	if (retval != RIG_OK || !(flags & RIG_CHAN_DIFF_DELETE)) {
+		free(listed);
+		RIG_UNLOCK_RETURN(rig, retval);
+	}
+
+	memset(&empty_chan, 0, sizeof(empty_chan));
+	empty_chan.freq = RIG_FREQ_NONE;
+	empty_chan.tx_freq = RIG_FREQ_NONE;
+	empty_chan.mode = RIG_MODE_NONE;
+	empty_chan.tx_mode = RIG_MODE_NONE;
+	empty_chan.vfo = RIG_VFO_MEM;
+
+	chan_list = rig->state.chan_list;
+	idx = 0;
+
+	for (i = 0; i < CHANLSTSIZ && !RIG_IS_CHAN_END(chan_list[i]); i++) {
+		for (j = chan_list[i].start; j <= chan_list[i].end; j++, idx++) {
+			if (listed[idx])
+				continue;
+
+			retval = chan_hash_read(rig, j, reread, &old_h);
+			if (retval != RIG_OK)
+				goto out;
+
+			if (old_h == CHAN_HASH_EMPTY)
+				continue;
+
+			empty_chan.channel_num = j;
+			retval = chan_diff_apply(rig, &empty_chan, RIG_CHAN_DELETED,
+					flags, diff_cb, arg);
+			if (retval != RIG_OK)
+				goto out;
+		}
+	}
+
+out:
+	free(listed);
+	RIG_UNLOCK_RETURN(rig, retval);
+}
+
+/**
+ * \brief set the callback for bulk channel transfers
+ * \param rig	The rig handle
+ * \param cb	The callback to install, NULL to remove it
+ * \param arg	A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback to be called after each memory channel handled by
+ *  rig_get_chan_all(), rig_set_chan_all() and their _cb variants, when
+ *  done by the frontend.  The callback receives the channel number, the
+ *  number of channels handled so far, empty ones included, and the
+ *  total number of channels.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_get_chan_all_cb()
+ */
+int HAMLIB_API rig_set_chan_progress_callback(RIG *rig, chan_progress_cb_t cb, rig_ptr_t arg)
+{
+	if (CHECK_RIG_ARG(rig))
+		return -RIG_EINVAL;
+
+	rig->callbacks.chan_progress = cb;
+	rig->callbacks.chan_progress_arg = arg;
+
+	return RIG_OK;
 }
 
 int HAMLIB_API rig_copy_channel(RIG *rig, channel_t *dest, const channel_t *src)
@@ -1022,26 +1664,30 @@ int HAMLIB_API rig_set_mem_all_cb (RIG *rig, chan_cb_t chan_cb, confval_cb_t par
 	if (CHECK_RIG_ARG(rig) || !chan_cb)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	rc = rig->caps;
 
 	if (rc->set_mem_all_cb)
-		return rc->set_mem_all_cb(rig, chan_cb, parm_cb, arg);
+		RIG_UNLOCK_RETURN(rig, rc->set_mem_all_cb(rig, chan_cb, parm_cb, arg));
 
 
 	/* if not available, emulate it */
 	retval = rig_set_chan_all_cb (rig, chan_cb, arg);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 
 #if 0
 	retval = rig_set_parm_all_cb (rig, parm_cb, arg);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 #else
-	return -RIG_ENIMPL;
+	RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 #endif
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -1072,26 +1718,28 @@ int HAMLIB_API rig_get_mem_all_cb (RIG *rig, chan_cb_t chan_cb, confval_cb_t par
 	if (CHECK_RIG_ARG(rig) || !chan_cb)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	rc = rig->caps;
 
 	if (rc->get_mem_all_cb)
-		return rc->get_mem_all_cb(rig, chan_cb, parm_cb, arg);
+		RIG_UNLOCK_RETURN(rig, rc->get_mem_all_cb(rig, chan_cb, parm_cb, arg));
 
 
 	/* if not available, emulate it */
 	retval = rig_get_chan_all_cb (rig, chan_cb, arg);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 
 #if 0
 	retval = rig_get_parm_cb (rig, parm_cb, arg);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 #else
-	return -RIG_ENIMPL;
+	RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 #endif
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -1122,29 +1770,33 @@ int HAMLIB_API rig_set_mem_all (RIG *rig, const channel_t chans[], const struct
 	if (CHECK_RIG_ARG(rig) || !chans || !cfgps || !vals)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	rc = rig->caps;
 	mem_all_arg.chans = (channel_t *) chans;
 	mem_all_arg.cfgps = cfgps;
 	mem_all_arg.vals = (value_t *) vals;
 
 	if (rc->set_mem_all_cb)
-		return rc->set_mem_all_cb(rig, map_chan, map_parm,
-				(rig_ptr_t)&mem_all_arg);
+		RIG_UNLOCK_RETURN(rig, rc->set_mem_all_cb(rig, map_chan, map_parm,
+				(rig_ptr_t)&mem_all_arg));
 
 	/* if not available, emulate it */
 	retval = rig_set_chan_all (rig, chans);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 
 #if 0
 	retval = rig_set_parm_all (rig, parms);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 #else
-	return -RIG_ENIMPL;
+	RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 #endif
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -1174,14 +1826,16 @@ int HAMLIB_API rig_get_mem_all (RIG *rig, channel_t chans[], const struct confpa
 	if (CHECK_RIG_ARG(rig) || !chans || !cfgps || !vals)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	rc = rig->caps;
 	mem_all_arg.chans = chans;
 	mem_all_arg.cfgps = cfgps;
 	mem_all_arg.vals = vals;
 
 	if (rc->get_mem_all_cb)
-		return rc->get_mem_all_cb(rig, map_chan, map_parm,
-				(rig_ptr_t)&mem_all_arg);
+		RIG_UNLOCK_RETURN(rig, rc->get_mem_all_cb(rig, map_chan, map_parm,
+				(rig_ptr_t)&mem_all_arg));
 
 	/*
 	 * if not available, emulate it
@@ -1190,12 +1844,12 @@ int HAMLIB_API rig_get_mem_all (RIG *rig, channel_t chans[], const struct confpa
 	 */
 	retval = rig_get_chan_all (rig, chans);
 	if (retval != RIG_OK)
-		return retval;
+		RIG_UNLOCK_RETURN(rig, retval);
 
 	retval = get_parm_all_cb_generic (rig, map_parm, (rig_ptr_t)cfgps,
 			(rig_ptr_t)vals);
 
-	return retval;
+	RIG_UNLOCK_RETURN(rig, retval);
 }
 
 /**
@@ -51,6 +51,64 @@
 
 #include "misc.h"
 
+/*
+ * Two digits per octet through tables, rather than a division or a
+ * multiplication by 10 per digit.  bcd2bin keeps the arithmetic of
+ * the former digit loop on nibbles above 9.
+ */
+#define BCD_DEC(h)	(h)*10, (h)*10+1, (h)*10+2, (h)*10+3, (h)*10+4, \
+	(h)*10+5, (h)*10+6, (h)*10+7, (h)*10+8, (h)*10+9, (h)*10+10, \
+	(h)*10+11, (h)*10+12, (h)*10+13, (h)*10+14, (h)*10+15
+#define BCD_ENC(t)	(t)<<4, (t)<<4|1, (t)<<4|2, (t)<<4|3, (t)<<4|4, \
+	(t)<<4|5, (t)<<4|6, (t)<<4|7, (t)<<4|8, (t)<<4|9
+
+static const unsigned char bcd2bin[256] = {
+	BCD_DEC(0), BCD_DEC(1), BCD_DEC(2), BCD_DEC(3),
+	BCD_DEC(4), BCD_DEC(5), BCD_DEC(6), BCD_DEC(7),
+	BCD_DEC(8), BCD_DEC(9), BCD_DEC(10), BCD_DEC(11),
+	BCD_DEC(12), BCD_DEC(13), BCD_DEC(14), BCD_DEC(15)
+};
+
+static const unsigned char bin2bcd[100] = {
+	BCD_ENC(0), BCD_ENC(1), BCD_ENC(2), BCD_ENC(3), BCD_ENC(4),
+	BCD_ENC(5), BCD_ENC(6), BCD_ENC(7), BCD_ENC(8), BCD_ENC(9)
+};
+
+/*
+ * Store the n low pairs of digits of freq, one octet every step bytes
+ * from p.  Above 32 bits, one 64-bit division splits off 8 digits,
+ * the rest is done on 32 bits.
+ *
+ * Returns what is left of freq, at least its low digit.
+ */
+static unsigned int bcd_put(unsigned char *p, int step,
+		unsigned long long freq, unsigned n)
+{
+	unsigned int lo;
+	int k;
+
+	while (n >= 4 && (freq >> 32)) {
+		lo = freq % 100000000;
+		freq /= 100000000;
+		for (k = 0; k < 4; k++, p += step) {
+			*p = bin2bcd[lo % 100];
+			lo /= 100;
+		}
+		n -= 4;
+	}
+	/* no more than 7 digits wanted from here */
+	if (freq >> 32)
+		freq %= 100000000;
+
+	lo = freq;
+	for (; n > 0; n--, p += step) {
+		*p = bin2bcd[lo % 100];
+		lo /= 100;
+	}
+
+	return lo;
+}
+
 /**
  * \brief Convert from binary to 4-bit BCD digits, little-endian
  * \param bcd_data
@@ -65,30 +123,21 @@
  * bcd_len is the number of BCD digits, usually 10 or 8 in 1-Hz units,
  * and 6 digits in 100-Hz units for Tx offset data.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/the 64bit freq)
- *
  * Returns a pointer to (unsigned char *)bcd_data.
  *
  * \sa to_bcd_be
  */
 unsigned char * HAMLIB_API to_bcd(unsigned char bcd_data[], unsigned long long freq, unsigned bcd_len)
 {
-	int i;
-	unsigned char a;
+	unsigned int rest;
 
 	/* '450'/4-> 5,0;0,4 */
 	/* '450'/3-> 5,0;x,4 */
 
-	for (i=0; i < bcd_len/2; i++) {
-		a = freq%10;
-		freq /= 10;
-		a |= (freq%10)<<4;
-		freq /= 10;
-		bcd_data[i] = a;
-	}
+	rest = bcd_put(bcd_data, 1, freq, bcd_len/2);
 	if (bcd_len&1) {
-		bcd_data[i] &= 0xf0;
-		bcd_data[i] |= freq%10;	/* NB: high nibble is left uncleared */
+		bcd_data[bcd_len/2] &= 0xf0;
+		bcd_data[bcd_len/2] |= rest%10;	/* NB: high nibble is left uncleared */
 	}
 
 	return bcd_data;
@@ -105,26 +154,22 @@ unsigned char * HAMLIB_API to_bcd(unsigned char bcd_data[], unsigned long long f
  *
  * bcd_len is the number of BCD digits.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/ the 64bit freq)
- *
  * Returns frequency in Hz an unsigned long long integer.
  *
  * \sa from_bcd_be
  */
 unsigned long long HAMLIB_API from_bcd(const unsigned char bcd_data[], unsigned bcd_len)
 {
-	int i;
-	freq_t f = 0;
+	int i = bcd_len/2;
+	unsigned long long f = 0;
 
 	if (bcd_len&1)
-		f = bcd_data[bcd_len/2] & 0x0f;
+		f = bcd_data[i] & 0x0f;
 
-	for (i=(bcd_len/2)-1; i >= 0; i--) {
-		f *= 10;
-		f += bcd_data[i]>>4;
-		f *= 10;
-		f += bcd_data[i] & 0x0f;
-	}
+	for (; i >= 2; i -= 2)
+		f = f*10000 + bcd2bin[bcd_data[i-1]]*100 + bcd2bin[bcd_data[i-2]];
+	if (i)
+		f = f*100 + bcd2bin[bcd_data[0]];
 
 	return f;
 }
@@ -143,9 +188,6 @@ unsigned long long HAMLIB_API from_bcd(const unsigned char bcd_data[], unsigned
  */
 unsigned char * HAMLIB_API to_bcd_be(unsigned char bcd_data[], unsigned long long freq, unsigned bcd_len)
 {
-	int i;
-	unsigned char a;
-
 	/* '450'/4 -> 0,4;5,0 */
 	/* '450'/3 -> 4,5;0,x */
 
@@ -154,13 +196,8 @@ unsigned char * HAMLIB_API to_bcd_be(unsigned char bcd_data[], unsigned long lon
 		bcd_data[bcd_len/2] |= (freq%10)<<4;	/* NB: low nibble is left uncleared */
 		freq /= 10;
 	}
-	for (i=(bcd_len/2)-1; i >= 0; i--) {
-		a = freq%10;
-		freq /= 10;
-		a |= (freq%10)<<4;
-		freq /= 10;
-		bcd_data[i] = a;
-	}
+	if (bcd_len >= 2)
+		bcd_put(bcd_data + bcd_len/2 - 1, -1, freq, bcd_len/2);
 
 	return bcd_data;
 }
@@ -178,19 +215,15 @@ unsigned char * HAMLIB_API to_bcd_be(unsigned char bcd_data[], unsigned long lon
  */
 unsigned long long HAMLIB_API from_bcd_be(const unsigned char bcd_data[], unsigned bcd_len)
 {
-	int i;
-	freq_t f = 0;
+	int i, n = bcd_len/2;
+	unsigned long long f = 0;
 
-	for (i=0; i < bcd_len/2; i++) {
-		f *= 10;
-		f += bcd_data[i]>>4;
-		f *= 10;
-		f += bcd_data[i] & 0x0f;
-	}
-	if (bcd_len&1) {
-		f *= 10;
-		f += bcd_data[bcd_len/2]>>4;
-	}
+	for (i = 0; i + 1 < n; i += 2)
+		f = f*10000 + bcd2bin[bcd_data[i]]*100 + bcd2bin[bcd_data[i+1]];
+	if (i < n)
+		f = f*100 + bcd2bin[bcd_data[i]];
+	if (bcd_len&1)
+		f = f*10 + (bcd_data[n]>>4);
 
 	return f;
 }
@@ -254,10 +287,170 @@ const char * HAMLIB_API rig_strstatus(enum rig_status_e status)
 }
 
 
-static struct {
-		rmode_t mode;
-		const char *str;
-} mode_str[] = {
+#ifndef DOC_HIDDEN
+
+/*
+ * The name tables below stay the reference, ended by an empty name.
+ * On first use, each gets a perfect hash of its names, i.e. a seed for
+ * which no two names fall in the same slot, so that parsing is one hash,
+ * one probe and one strcmp.  Values made of a single bit, most of them,
+ * are found back by their bit number.
+ */
+#define STR_HASH_SIZE	256	/* power of 2, well above the table sizes */
+#define STR_SEED_MAX	4096	/* linear scans if no seed is found below */
+#define STR_BITS	(sizeof(unsigned long) * 8)
+
+enum { STR_INDEX_NONE, STR_INDEX_BUILDING, STR_INDEX_READY, STR_INDEX_LINEAR };
+
+struct str_entry {
+	unsigned long val;
+	const char *str;
+};
+
+struct str_index {
+	const struct str_entry *tab;
+	volatile int state;
+	unsigned int seed;
+	int multi;	/* some values are not a single bit */
+	signed char hash[STR_HASH_SIZE];
+	signed char bit[STR_BITS];
+};
+
+static int str_ctz(unsigned long v)
+{
+#ifdef __GNUC__
+	return __builtin_ctzl(v);
+#else
+	int n = 0;
+
+	while (!(v & 1)) {
+		v >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* FNV-1a, with the seed folded in the offset basis */
+static unsigned int str_hash(const char *s, unsigned int seed)
+{
+	unsigned int h = 2166136261U ^ seed;
+
+	while (*s) {
+		h ^= (unsigned char)*s++;
+		h *= 16777619U;
+	}
+	return (h ^ (h >> 16)) & (STR_HASH_SIZE - 1);
+}
+
+static int str_index_seed(struct str_index *idx, unsigned int seed)
+{
+	const struct str_entry *tab = idx->tab;
+	int i, slot;
+
+	memset(idx->hash, -1, sizeof(idx->hash));
+
+	for (i = 0; tab[i].str[0] != '\0'; i++) {
+		slot = str_hash(tab[i].str, seed);
+		if (idx->hash[slot] < 0)
+			idx->hash[slot] = i;
+		else if (strcmp(tab[i].str, tab[idx->hash[slot]].str))
+			return 0;
+		/* a duplicate name is found first by the scan too */
+	}
+	return 1;
+}
+
+static void str_index_build(struct str_index *idx)
+{
+	const struct str_entry *tab = idx->tab;
+	unsigned long v;
+	unsigned int seed;
+	int i;
+
+	for (seed = 0; seed < STR_SEED_MAX; seed++)
+		if (str_index_seed(idx, seed))
+			break;
+
+	if (seed == STR_SEED_MAX) {
+		rig_debug(RIG_DEBUG_WARN, "%s: no perfect hash for \"%s\"'s table\n",
+				__func__, tab[0].str);
+		__sync_synchronize();
+		idx->state = STR_INDEX_LINEAR;
+		return;
+	}
+	idx->seed = seed;
+
+	memset(idx->bit, -1, sizeof(idx->bit));
+	for (i = 0; tab[i].str[0] != '\0'; i++) {
+		v = tab[i].val;
+		if (!v || (v & (v - 1)))
+			idx->multi = 1;
+		else if (idx->bit[str_ctz(v)] < 0)
+			idx->bit[str_ctz(v)] = i;
+	}
+
+	__sync_synchronize();
+	idx->state = STR_INDEX_READY;
+}
+
+/*
+ * Whether the index may be used, building it on first call.  Callers
+ * racing the build scan the table meanwhile.
+ */
+static int str_index_ready(struct str_index *idx)
+{
+	int state = idx->state;
+
+	if (state == STR_INDEX_NONE &&
+			__sync_bool_compare_and_swap(&idx->state, STR_INDEX_NONE,
+				STR_INDEX_BUILDING)) {
+		str_index_build(idx);
+		state = idx->state;
+	}
+	__sync_synchronize();
+
+	return state == STR_INDEX_READY;
+}
+
+/* entry of name s, or -1 */
+static int str_index_find(struct str_index *idx, const char *s)
+{
+	int i;
+
+	if (str_index_ready(idx)) {
+		i = idx->hash[str_hash(s, idx->seed)];
+		return i >= 0 && !strcmp(s, idx->tab[i].str) ? i : -1;
+	}
+
+	for (i = 0; idx->tab[i].str[0] != '\0'; i++)
+		if (!strcmp(s, idx->tab[i].str))
+			return i;
+	return -1;
+}
+
+/* first entry of value val, or -1 */
+static int str_index_name(struct str_index *idx, unsigned long val)
+{
+	int i;
+
+	if (str_index_ready(idx)) {
+		if (val && !(val & (val - 1)))
+			return idx->bit[str_ctz(val)];
+		if (!idx->multi)
+			return -1;
+	}
+
+	for (i = 0; idx->tab[i].str[0] != '\0'; i++)
+		if (val == idx->tab[i].val)
+			return i;
+	return -1;
+}
+
+#endif	/* !DOC_HIDDEN */
+
+
+static const struct str_entry mode_str[] = {
 	{ RIG_MODE_AM, "AM" },
 	{ RIG_MODE_CW, "CW" },
 	{ RIG_MODE_USB, "USB" },
@@ -281,6 +474,8 @@ static struct {
 	{ RIG_MODE_NONE, "" },
 };
 
+static struct str_index mode_idx = { mode_str };
+
 /**
  * \brief Convert alpha string to enum RIG_MODE
  * \param s input alpha string
@@ -290,12 +485,9 @@ static struct {
  */
 rmode_t HAMLIB_API rig_parse_mode(const char *s)
 {
-	int i;
+	int i = str_index_find(&mode_idx, s);
 
-	for (i=0 ; mode_str[i].str[0] != '\0'; i++)
-			if (!strcmp(s, mode_str[i].str))
-					return mode_str[i].mode;
-	return RIG_MODE_NONE;
+	return i < 0 ? RIG_MODE_NONE : (rmode_t)mode_str[i].val;
 }
 
 /**
@@ -312,17 +504,12 @@ const char * HAMLIB_API rig_strrmode(rmode_t mode)
 	if (mode == RIG_MODE_NONE)
 		return "";
 
-	for (i=0 ; mode_str[i].str[0] != '\0'; i++)
-		if (mode == mode_str[i].mode)
-			return mode_str[i].str;
+	i = str_index_name(&mode_idx, mode);
 
-	return "";
+	return i < 0 ? "" : mode_str[i].str;
 }
 
-static struct {
-	vfo_t vfo;
-	const char *str;
-} vfo_str[] = {
+static const struct str_entry vfo_str[] = {
 	{ RIG_VFO_A, "VFOA" },
 	{ RIG_VFO_B, "VFOB" },
 	{ RIG_VFO_C, "VFOC" },
@@ -336,6 +523,8 @@ static struct {
 	{ RIG_VFO_NONE, "" },
 };
 
+static struct str_index vfo_idx = { vfo_str };
+
 /**
  * \brief Convert alpha string to enum RIG_VFO_...
  * \param s input alpha string
@@ -345,12 +534,9 @@ static struct {
  */
 vfo_t HAMLIB_API rig_parse_vfo(const char *s)
 {
-	int i;
+	int i = str_index_find(&vfo_idx, s);
 
-	for (i=0 ; vfo_str[i].str[0] != '\0'; i++)
-		if (!strcmp(s, vfo_str[i].str))
-			return vfo_str[i].vfo;
-	return RIG_VFO_NONE;
+	return i < 0 ? RIG_VFO_NONE : (vfo_t)vfo_str[i].val;
 }
 
 /**
@@ -367,17 +553,12 @@ const char * HAMLIB_API rig_strvfo(vfo_t vfo)
 	if (vfo == RIG_VFO_NONE)
 		return "";
 
-	for (i=0 ; vfo_str[i].str[0] != '\0'; i++)
-		if (vfo == vfo_str[i].vfo)
-			return vfo_str[i].str;
+	i = str_index_name(&vfo_idx, vfo);
 
-	return "";
+	return i < 0 ? "" : vfo_str[i].str;
 }
 
-static struct {
-	setting_t func;
-	const char *str;
-} func_str[] = {
+static const struct str_entry func_str[] = {
 	{ RIG_FUNC_FAGC, "FAGC" },
 	{ RIG_FUNC_NB, "NB" },
 	{ RIG_FUNC_COMP, "COMP" },
@@ -413,6 +594,8 @@ static struct {
 	{ RIG_FUNC_NONE, "" },
 };
 
+static struct str_index func_idx = { func_str };
+
 /**
  * \brief Convert alpha string to enum RIG_FUNC_...
  * \param s input alpha string
@@ -422,13 +605,9 @@ static struct {
  */
 setting_t HAMLIB_API rig_parse_func(const char *s)
 {
-	int i;
-
-	for (i=0 ; func_str[i].str[0] != '\0'; i++)
-		if (!strcmp(s, func_str[i].str))
-			return func_str[i].func;
+	int i = str_index_find(&func_idx, s);
 
-	return RIG_FUNC_NONE;
+	return i < 0 ? RIG_FUNC_NONE : (setting_t)func_str[i].val;
 }
 
 /**
@@ -445,17 +624,12 @@ const char * HAMLIB_API rig_strfunc(setting_t func)
 	if (func == RIG_FUNC_NONE)
 		return "";
 
-	for (i=0; func_str[i].str[0] != '\0'; i++)
-		if (func == func_str[i].func)
-			return func_str[i].str;
+	i = str_index_name(&func_idx, func);
 
-	return "";
+	return i < 0 ? "" : func_str[i].str;
 }
 
-static struct {
-	setting_t level;
-	const char *str;
-} level_str[] = {
+static const struct str_entry level_str[] = {
 	{ RIG_LEVEL_PREAMP, "PREAMP" },
 	{ RIG_LEVEL_ATT, "ATT" },
 	{ RIG_LEVEL_VOX, "VOX" },
@@ -490,6 +664,8 @@ static struct {
 	{ RIG_LEVEL_NONE, "" },
 };
 
+static struct str_index level_idx = { level_str };
+
 /**
  * \brief Convert alpha string to enum RIG_LEVEL_...
  * \param s input alpha string
@@ -499,13 +675,9 @@ static struct {
  */
 setting_t HAMLIB_API rig_parse_level(const char *s)
 {
-	int i;
+	int i = str_index_find(&level_idx, s);
 
-	for (i=0 ; level_str[i].str[0] != '\0'; i++)
-		if (!strcmp(s, level_str[i].str))
-			return level_str[i].level;
-
-	return RIG_LEVEL_NONE;
+	return i < 0 ? RIG_LEVEL_NONE : (setting_t)level_str[i].val;
 }
 
 /**
@@ -522,17 +694,12 @@ const char * HAMLIB_API rig_strlevel(setting_t level)
 	if (level == RIG_LEVEL_NONE)
 		return "";
 
-	for (i=0; level_str[i].str[0] != '\0'; i++)
-		if (level == level_str[i].level)
-			return level_str[i].str;
+	i = str_index_name(&level_idx, level);
 
-	return "";
+	return i < 0 ? "" : level_str[i].str;
 }
 
-static struct {
-	setting_t parm;
-	const char *str;
-} parm_str[] = {
+static const struct str_entry parm_str[] = {
 	{ RIG_PARM_ANN, "ANN" },
 	{ RIG_PARM_APO, "APO" },
 	{ RIG_PARM_BACKLIGHT, "BACKLIGHT" },
@@ -543,6 +710,8 @@ static struct {
 	{ RIG_PARM_NONE, "" },
 };
 
+static struct str_index parm_idx = { parm_str };
+
 /**
  * \brief Convert alpha string to RIG_PARM_...
  * \param s input alpha string
@@ -552,13 +721,9 @@ static struct {
  */
 setting_t HAMLIB_API rig_parse_parm(const char *s)
 {
-	int i;
-
-	for (i=0 ; parm_str[i].str[0] != '\0'; i++)
-		if (!strcmp(s, parm_str[i].str))
-			return parm_str[i].parm;
+	int i = str_index_find(&parm_idx, s);
 
-	return RIG_PARM_NONE;
+	return i < 0 ? RIG_PARM_NONE : (setting_t)parm_str[i].val;
 }
 
 /**
@@ -575,17 +740,12 @@ const char * HAMLIB_API rig_strparm(setting_t parm)
 	if (parm == RIG_PARM_NONE)
 		return "";
 
-	for (i=0; parm_str[i].str[0] != '\0'; i++)
-		if (parm == parm_str[i].parm)
-			return parm_str[i].str;
+	i = str_index_name(&parm_idx, parm);
 
-	return "";
+	return i < 0 ? "" : parm_str[i].str;
 }
 
-static struct {
-	vfo_op_t vfo_op;
-	const char *str;
-} vfo_op_str[] = {
+static const struct str_entry vfo_op_str[] = {
 	{ RIG_OP_CPY, "CPY" },
 	{ RIG_OP_XCHG, "XCHG" },
 	{ RIG_OP_FROM_VFO, "FROM_VFO" },
@@ -602,6 +762,8 @@ static struct {
 	{ RIG_OP_NONE, "" },
 };
 
+static struct str_index vfo_op_idx = { vfo_op_str };
+
 /**
  * \brief Convert alpha string to enum RIG_OP_...
  * \param s alpha string
@@ -611,13 +773,9 @@ static struct {
  */
 vfo_op_t HAMLIB_API rig_parse_vfo_op(const char *s)
 {
-	int i;
+	int i = str_index_find(&vfo_op_idx, s);
 
-	for (i=0 ; vfo_op_str[i].str[0] != '\0'; i++)
-		if (!strcmp(s, vfo_op_str[i].str))
-			return vfo_op_str[i].vfo_op;
-
-	return RIG_OP_NONE;
+	return i < 0 ? RIG_OP_NONE : (vfo_op_t)vfo_op_str[i].val;
 }
 
 /**
@@ -634,17 +792,12 @@ const char * HAMLIB_API rig_strvfop(vfo_op_t op)
 	if (op == RIG_OP_NONE)
 		return "";
 
-	for (i=0; vfo_op_str[i].str[0] != '\0'; i++)
-		if (op == vfo_op_str[i].vfo_op)
-			return vfo_op_str[i].str;
+	i = str_index_name(&vfo_op_idx, op);
 
-	return "";
+	return i < 0 ? "" : vfo_op_str[i].str;
 }
 
-static struct {
-	scan_t rscan;
-	const char *str;
-} scan_str[] = {
+static const struct str_entry scan_str[] = {
 	{ RIG_SCAN_STOP, "STOP" },
 	{ RIG_SCAN_MEM, "MEM" },
 	{ RIG_SCAN_SLCT, "SLCT" },
@@ -656,6 +809,8 @@ static struct {
 	{ RIG_SCAN_NONE, "" },
 };
 
+static struct str_index scan_idx = { scan_str };
+
 /**
  * \brief Convert alpha string to enum RIG_SCAN_...
  * \param s alpha string
@@ -665,14 +820,9 @@ static struct {
  */
 scan_t HAMLIB_API rig_parse_scan(const char *s)
 {
-	int i;
+	int i = str_index_find(&scan_idx, s);
 
-	for (i=0 ; scan_str[i].str[0] != '\0'; i++) {
-		if (strcmp(s, scan_str[i].str) == 0) {
-			return scan_str[i].rscan;
-		}
-	}
-	return RIG_SCAN_NONE;
+	return i < 0 ? RIG_SCAN_NONE : (scan_t)scan_str[i].val;
 }
 
 /**
@@ -689,10 +839,9 @@ const char * HAMLIB_API rig_strscan(scan_t rscan)
 	if (rscan == RIG_SCAN_NONE)
 		return "";
 
-	for (i=0; scan_str[i].str[0] != '\0'; i++)
-		if (rscan == scan_str[i].rscan)
-			return scan_str[i].str;
-	return "";
+	i = str_index_name(&scan_idx, rscan);
+
+	return i < 0 ? "" : scan_str[i].str;
 }
 
 /**
@@ -725,10 +874,7 @@ rptr_shift_t HAMLIB_API rig_parse_rptr_shift(const char *s)
 		return RIG_RPT_SHIFT_NONE;
 }
 
-static struct {
-	chan_type_t mtype;
-	const char *str;
-} mtype_str[] = {
+static const struct str_entry mtype_str[] = {
 	{ RIG_MTYPE_MEM, "MEM" },
 	{ RIG_MTYPE_EDGE, "EDGE" },
 	{ RIG_MTYPE_CALL, "CALL" },
@@ -739,6 +885,8 @@ static struct {
 	{ RIG_MTYPE_NONE, "" },
 };
 
+static struct str_index mtype_idx = { mtype_str };
+
 /**
  * \brief Convert alpha string to enum RIG_MTYPE_...
  * \param s alpha string
@@ -748,14 +896,9 @@ static struct {
  */
 chan_type_t HAMLIB_API rig_parse_mtype(const char *s)
 {
-	int i;
+	int i = str_index_find(&mtype_idx, s);
 
-	for (i=0 ; mtype_str[i].str[0] != '\0'; i++) {
-		if (strcmp(s, mtype_str[i].str) == 0) {
-			return mtype_str[i].mtype;
-		}
-	}
-	return RIG_MTYPE_NONE;
+	return i < 0 ? RIG_MTYPE_NONE : (chan_type_t)mtype_str[i].val;
 }
 
 /**
@@ -772,10 +915,9 @@ const char * HAMLIB_API rig_strmtype(chan_type_t mtype)
 	if (mtype == RIG_MTYPE_NONE)
 		return "";
 
-	for (i=0; mtype_str[i].str[0] != '\0'; i++)
-		if (mtype == mtype_str[i].mtype)
-			return mtype_str[i].str;
-	return "";
+	i = str_index_name(&mtype_idx, mtype);
+
+	return i < 0 ? "" : mtype_str[i].str;
 }
 
 
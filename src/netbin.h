@@ -0,0 +1,175 @@
+/*
+ *  Hamlib Interface - rigctld binary protocol header
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _NETBIN_H
+#define _NETBIN_H 1
+
+#include <string.h>
+
+#include <hamlib/rig.h>
+
+/*
+ * Binary framing of the rigctld protocol, entered with the "\binary"
+ * text command.  All the fields are little endian.
+ *
+ * request: len(16) id(16) op(8) vfo(32) arguments
+ * reply:   len(16) id(16) op(8) status(8, signed) results
+ *
+ * len counts the bytes after itself.  The reply carries the id of the
+ * request, so that several requests may be outstanding.  Requests are
+ * answered in order.
+ *
+ * op			arguments		results
+ * TEXT			text command line	text reply
+ * DUMP_STATE		-			see below
+ * SET_FREQ		freq(f64)		-
+ * GET_FREQ		-			freq(f64)
+ * SET_MODE		mode(32) width(32)	-
+ * GET_MODE		-			mode(32) width(32)
+ * SET_VFO		-			-
+ * GET_VFO		-			vfo(32)
+ * SET_PTT		ptt(32)			-
+ * GET_PTT		-			ptt(32)
+ * SET_LEVEL		level index(8) val(32)	-
+ * GET_LEVEL		level index(8)		val(32)
+ * QUIT			-			no reply, connection closed
+ *
+ * Level values are 32 bit integers, or IEEE 754 floats for the float
+ * levels.
+ *
+ * The DUMP_STATE results have the same content as the text \dump_state
+ * reply, with counted lists:
+ *
+ * protocol version(32) model(32) itu_region(32)
+ * rx ranges, tx ranges: count(8), then start(f64) end(f64) modes(32)
+ * 	low_power(32) high_power(32) vfo(32) ant(32) each
+ * tuning steps, filters: count(8), then modes(32) value(32) each
+ * max_rit(32) max_xit(32) max_ifshift(32) announces(32)
+ * preamp, attenuator: count(8), then dB(32) each
+ * has_get_func has_set_func has_get_level has_set_level
+ * 	has_get_parm has_set_parm, 64 bits each
+ *
+ * Like the text protocol, it is written by rigctl_parse.c and read by
+ * the netrigctl backend.  Only the field encoding below is shared, as
+ * static functions, so that none of it gets exported by the library.
+ */
+
+#define NETBIN_REQ_HDR	9	/* len, id, op and vfo */
+#define NETBIN_REP_HDR	6	/* len, id, op and status */
+#define NETBIN_MAX_FRAME 65537	/* len field included */
+#define NETBIN_PROT_VER 0	/* first field of the DUMP_STATE reply */
+#define NETBIN_RANGE_LEN 36	/* bytes per freq_range_t in DUMP_STATE */
+
+enum netbin_op {
+	NETBIN_OP_TEXT = 0,
+	NETBIN_OP_DUMP_STATE,
+	NETBIN_OP_SET_FREQ,
+	NETBIN_OP_GET_FREQ,
+	NETBIN_OP_SET_MODE,
+	NETBIN_OP_GET_MODE,
+	NETBIN_OP_SET_VFO,
+	NETBIN_OP_GET_VFO,
+	NETBIN_OP_SET_PTT,
+	NETBIN_OP_GET_PTT,
+	NETBIN_OP_SET_LEVEL,
+	NETBIN_OP_GET_LEVEL,
+	NETBIN_OP_QUIT
+};
+
+static inline void netbin_put16(unsigned char *p, unsigned int v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static inline void netbin_put32(unsigned char *p, unsigned long v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+static inline void netbin_put64(unsigned char *p, unsigned long long v)
+{
+	netbin_put32(p, v & 0xffffffffUL);
+	netbin_put32(p + 4, v >> 32);
+}
+
+static inline void netbin_put_double(unsigned char *p, double v)
+{
+	unsigned long long bits;
+
+	memcpy(&bits, &v, sizeof(bits));
+	netbin_put64(p, bits);
+}
+
+static inline unsigned int netbin_get16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline unsigned long netbin_get32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) |
+		((unsigned long)p[3] << 24);
+}
+
+static inline unsigned long long netbin_get64(const unsigned char *p)
+{
+	return netbin_get32(p) | ((unsigned long long)netbin_get32(p + 4) << 32);
+}
+
+static inline double netbin_get_double(const unsigned char *p)
+{
+	unsigned long long bits = netbin_get64(p);
+	double v;
+
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+/*
+ * Level value on 32 bits, the IEEE 754 bits of the float levels
+ */
+static inline void netbin_put_level(unsigned char *p, setting_t level, value_t val)
+{
+	unsigned int bits;
+
+	if (RIG_LEVEL_IS_FLOAT(level))
+		memcpy(&bits, &val.f, sizeof(bits));
+	else
+		bits = val.i;
+
+	netbin_put32(p, bits);
+}
+
+static inline void netbin_get_level(const unsigned char *p, setting_t level, value_t *val)
+{
+	unsigned int bits = netbin_get32(p);
+
+	if (RIG_LEVEL_IS_FLOAT(level))
+		memcpy(&val->f, &bits, sizeof(bits));
+	else
+		val->i = (int)bits;
+}
+
+#endif /* _NETBIN_H */
@@ -151,6 +151,8 @@ int network_open(hamlib_port_t *rp, int default_port)
 	}
 
 	rp->fd = fd;
+	/* a closed port owns no buffer, whatever the caller left in there */
+	rp->rxbuf = NULL;
 
 	return RIG_OK;
 }
@@ -158,6 +160,8 @@ int network_open(hamlib_port_t *rp, int default_port)
 int network_close(hamlib_port_t *rp)
 {
 	int ret;
+
+	port_rx_free(rp);
 #ifdef __MINGW32__
 	ret = closesocket(rp->fd);
 	if (--wsstarted)
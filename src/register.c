@@ -31,6 +31,7 @@
 #endif
 
 #include <errno.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -94,11 +95,13 @@ DEFINE_INITRIG_BACKEND(winradio);
 
 
 /*! \def rig_backend_list
- *  \brief Static list of rig models.
+ *  \brief Static map of backend numbers to rig backends.
  *
- *  This is a NULL terminated list of available rig backends. Each entry
- *  in the list consists of two fields: The branch number, which is an integer,
- *  and the branch name, which is a character string.
+ *  This table is indexed by backend number, ie. RIG_BACKEND_NUM(model),
+ *  so the backend declaring a model is found without initializing or
+ *  scanning the others. Each entry consists of the branch number, the
+ *  branch name, and the backend init and probe functions. Unused backend
+ *  numbers have a NULL be_name.
  */
 static struct {
 	int be_num;
@@ -107,63 +110,107 @@ static struct {
 	rig_model_t (* be_probe_all)(hamlib_port_t*, rig_probe_func_t, rig_ptr_t);
 } rig_backend_list[RIG_BACKEND_MAX] =
 {
-		{ RIG_DUMMY, RIG_BACKEND_DUMMY, RIG_FUNCNAMA(dummy) },
-		{ RIG_YAESU, RIG_BACKEND_YAESU, RIG_FUNCNAM(yaesu) },
-		{ RIG_KENWOOD, RIG_BACKEND_KENWOOD, RIG_FUNCNAM(kenwood) },
-		{ RIG_ICOM, RIG_BACKEND_ICOM, RIG_FUNCNAM(icom) },
-		{ RIG_PCR, RIG_BACKEND_PCR, RIG_FUNCNAMA(pcr) },
-		{ RIG_AOR, RIG_BACKEND_AOR, RIG_FUNCNAMA(aor) },
-		{ RIG_JRC, RIG_BACKEND_JRC, RIG_FUNCNAMA(jrc) },
-		{ RIG_UNIDEN, RIG_BACKEND_UNIDEN, RIG_FUNCNAM(uniden) },
-		{ RIG_DRAKE, RIG_BACKEND_DRAKE, RIG_FUNCNAM(drake) },
-		{ RIG_LOWE, RIG_BACKEND_LOWE, RIG_FUNCNAM(lowe) },
-		{ RIG_RACAL, RIG_BACKEND_RACAL, RIG_FUNCNAMA(racal) },
-		{ RIG_WJ, RIG_BACKEND_WJ, RIG_FUNCNAMA(wj) },
-		{ RIG_SKANTI, RIG_BACKEND_SKANTI, RIG_FUNCNAMA(skanti) },
+		[RIG_DUMMY] = { RIG_DUMMY, RIG_BACKEND_DUMMY, RIG_FUNCNAMA(dummy) },
+		[RIG_YAESU] = { RIG_YAESU, RIG_BACKEND_YAESU, RIG_FUNCNAM(yaesu) },
+		[RIG_KENWOOD] = { RIG_KENWOOD, RIG_BACKEND_KENWOOD, RIG_FUNCNAM(kenwood) },
+		[RIG_ICOM] = { RIG_ICOM, RIG_BACKEND_ICOM, RIG_FUNCNAM(icom) },
+		[RIG_PCR] = { RIG_PCR, RIG_BACKEND_PCR, RIG_FUNCNAMA(pcr) },
+		[RIG_AOR] = { RIG_AOR, RIG_BACKEND_AOR, RIG_FUNCNAMA(aor) },
+		[RIG_JRC] = { RIG_JRC, RIG_BACKEND_JRC, RIG_FUNCNAMA(jrc) },
+		[RIG_UNIDEN] = { RIG_UNIDEN, RIG_BACKEND_UNIDEN, RIG_FUNCNAM(uniden) },
+		[RIG_DRAKE] = { RIG_DRAKE, RIG_BACKEND_DRAKE, RIG_FUNCNAM(drake) },
+		[RIG_LOWE] = { RIG_LOWE, RIG_BACKEND_LOWE, RIG_FUNCNAM(lowe) },
+		[RIG_RACAL] = { RIG_RACAL, RIG_BACKEND_RACAL, RIG_FUNCNAMA(racal) },
+		[RIG_WJ] = { RIG_WJ, RIG_BACKEND_WJ, RIG_FUNCNAMA(wj) },
+		[RIG_SKANTI] = { RIG_SKANTI, RIG_BACKEND_SKANTI, RIG_FUNCNAMA(skanti) },
 #ifdef HAVE_WINRADIO
-		{ RIG_WINRADIO, RIG_BACKEND_WINRADIO, RIG_FUNCNAMA(winradio) },
+		[RIG_WINRADIO] = { RIG_WINRADIO, RIG_BACKEND_WINRADIO, RIG_FUNCNAMA(winradio) },
 #endif /* HAVE_WINRADIO */
-		{ RIG_TENTEC, RIG_BACKEND_TENTEC, RIG_FUNCNAMA(tentec) },
-		{ RIG_ALINCO, RIG_BACKEND_ALINCO, RIG_FUNCNAMA(alinco) },
-		{ RIG_KACHINA, RIG_BACKEND_KACHINA, RIG_FUNCNAMA(kachina) },
-		{ RIG_TAPR, RIG_BACKEND_TAPR, RIG_FUNCNAMA(tapr) },
-		{ RIG_FLEXRADIO, RIG_BACKEND_FLEXRADIO, RIG_FUNCNAMA(flexradio) },
-		{ RIG_RFT, RIG_BACKEND_RFT, RIG_FUNCNAMA(rft) },
-		{ RIG_KIT, RIG_BACKEND_KIT, RIG_FUNCNAMA(kit) },
-		{ RIG_TUNER, RIG_BACKEND_TUNER, RIG_FUNCNAMA(tuner) },
-		{ RIG_RS, RIG_BACKEND_RS, RIG_FUNCNAMA(rs) },
-		{ RIG_PRM80, RIG_BACKEND_PRM80, RIG_FUNCNAMA(prm80) },
-		{ RIG_ADAT, RIG_BACKEND_ADAT, RIG_FUNCNAM(adat) },
-		{ 0, NULL }, /* end */
+		[RIG_TENTEC] = { RIG_TENTEC, RIG_BACKEND_TENTEC, RIG_FUNCNAMA(tentec) },
+		[RIG_ALINCO] = { RIG_ALINCO, RIG_BACKEND_ALINCO, RIG_FUNCNAMA(alinco) },
+		[RIG_KACHINA] = { RIG_KACHINA, RIG_BACKEND_KACHINA, RIG_FUNCNAMA(kachina) },
+		[RIG_TAPR] = { RIG_TAPR, RIG_BACKEND_TAPR, RIG_FUNCNAMA(tapr) },
+		[RIG_FLEXRADIO] = { RIG_FLEXRADIO, RIG_BACKEND_FLEXRADIO, RIG_FUNCNAMA(flexradio) },
+		[RIG_RFT] = { RIG_RFT, RIG_BACKEND_RFT, RIG_FUNCNAMA(rft) },
+		[RIG_KIT] = { RIG_KIT, RIG_BACKEND_KIT, RIG_FUNCNAMA(kit) },
+		[RIG_TUNER] = { RIG_TUNER, RIG_BACKEND_TUNER, RIG_FUNCNAMA(tuner) },
+		[RIG_RS] = { RIG_RS, RIG_BACKEND_RS, RIG_FUNCNAMA(rs) },
+		[RIG_PRM80] = { RIG_PRM80, RIG_BACKEND_PRM80, RIG_FUNCNAMA(prm80) },
+		[RIG_ADAT] = { RIG_ADAT, RIG_BACKEND_ADAT, RIG_FUNCNAM(adat) },
 };
 
+/* set once a backend init function has registered its models */
+static int rig_backend_loaded[RIG_BACKEND_MAX] = { 0, };
+
 /*
- * This struct to keep track of known rig models.
- * It is chained, and used in a hash table, see below.
+ * Registered caps are indexed directly by model number: each backend
+ * number owns a row of RIG_MODELS_PER_BACKEND slots, allocated the
+ * first time one of its models registers, so registering and looking
+ * up a model are O(1) whatever the number of models.
+ * Model numbers outside the rows, if any, are kept in a plain list.
  */
+#define RIG_MODELS_PER_BACKEND RIG_MAKE_MODEL(1, 0)
+#define RIG_INDEX_ROWS RIG_BACKEND_MAX
+
 struct rig_list {
 	const struct rig_caps *caps;
 	struct rig_list *next;
 };
 
-#define RIGLSTHASHSZ 16
-#define HASH_FUNC(a) ((a)%RIGLSTHASHSZ)
+static const struct rig_caps **rig_index[RIG_INDEX_ROWS] = { NULL, };
+static struct rig_list *rig_overflow = NULL;
 
 /*
- * The rig_hash_table is a hash table pointing to a list of next==NULL
- * 	terminated caps.
+ * Secondary index sorted by model name then manufacturer name,
+ * built on first use by rig_lookup_model() and dropped whenever
+ * the set of registered models changes.
  */
-static struct rig_list *rig_hash_table[RIGLSTHASHSZ] = { NULL, };
+static const struct rig_caps **rig_name_index = NULL;
+static int rig_name_count = 0;
 
 
 static int rig_lookup_backend(rig_model_t rig_model);
 
 /*
- * Basically, this is a hash insert function that doesn't check for dup!
+ * Return the index slot of rig_model, allocating its row if asked to.
+ * NULL means the model lives in the overflow list.
+ */
+static const struct rig_caps **rig_index_slot(rig_model_t rig_model, int alloc)
+{
+	int row;
+
+	if (rig_model < 0)
+		return NULL;
+
+	row = RIG_BACKEND_NUM(rig_model);
+	if (row >= RIG_INDEX_ROWS)
+		return NULL;
+
+	if (!rig_index[row]) {
+		if (!alloc)
+			return NULL;
+		rig_index[row] = calloc(RIG_MODELS_PER_BACKEND,
+					sizeof(const struct rig_caps *));
+		if (!rig_index[row])
+			return NULL;
+	}
+
+	return &rig_index[row][rig_model - RIG_MAKE_MODEL(row, 0)];
+}
+
+static void rig_name_index_reset(void)
+{
+	free(rig_name_index);
+	rig_name_index = NULL;
+	rig_name_count = 0;
+}
+
+/*
+ * Insert caps in the model index, rejecting duplicates.
  */
 int HAMLIB_API rig_register(const struct rig_caps *caps)
 {
-	int hval;
+	const struct rig_caps **slot;
 	struct rig_list *p;
 
 	if (!caps)
@@ -176,29 +223,39 @@ int HAMLIB_API rig_register(const struct rig_caps *caps)
 		return -RIG_EINVAL;
 #endif
 
-	p = (struct rig_list*)malloc(sizeof(struct rig_list));
-	if (!p)
-		return -RIG_ENOMEM;
+	slot = rig_index_slot(caps->rig_model, 1);
+	if (slot) {
+		*slot = caps;
+	} else {
+		p = (struct rig_list*)malloc(sizeof(struct rig_list));
+		if (!p)
+			return -RIG_ENOMEM;
+
+		p->caps = caps;
+		p->next = rig_overflow;
+		rig_overflow = p;
+	}
 
-	hval = HASH_FUNC(caps->rig_model);
-	p->caps = caps;
-	// p->handle = NULL;
-	p->next = rig_hash_table[hval];
-	rig_hash_table[hval] = p;
+	rig_name_index_reset();
 
 	return RIG_OK;
 }
 
 /*
  * Get rig capabilities.
- * ie. rig_hash_table lookup
+ * ie. rig_index lookup
  */
 
 const struct rig_caps * HAMLIB_API rig_get_caps(rig_model_t rig_model)
 {
+	const struct rig_caps **slot;
 	struct rig_list *p;
 
-	for (p = rig_hash_table[HASH_FUNC(rig_model)]; p; p=p->next) {
+	slot = rig_index_slot(rig_model, 0);
+	if (slot && *slot)
+		return *slot;
+
+	for (p = rig_overflow; p; p=p->next) {
 		if (p->caps->rig_model == rig_model)
 			return p->caps;
 	}
@@ -213,15 +270,34 @@ const struct rig_caps * HAMLIB_API rig_get_caps(rig_model_t rig_model)
  */
 static int rig_lookup_backend(rig_model_t rig_model)
 {
-	int i;
+	int be_num = RIG_BACKEND_NUM(rig_model);
 
-	for (i=0; i<RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++) {
-		if (RIG_BACKEND_NUM(rig_model) ==
-					rig_backend_list[i].be_num)
-			return i;
-	}
+	if (rig_model < 0 || be_num >= RIG_BACKEND_MAX ||
+			!rig_backend_list[be_num].be_name)
+		return -1;
 
-	return -1;
+	return be_num;
+}
+
+/*
+ * initialize a backend from its rig_backend_list index,
+ * unless it has already registered its models
+ */
+static int rig_init_backend(int be_idx)
+{
+	int retval;
+
+	if (rig_backend_loaded[be_idx])
+		return RIG_OK;
+
+	if (!rig_backend_list[be_idx].be_init_all)
+		return -RIG_EINVAL;
+
+	retval = (*rig_backend_list[be_idx].be_init_all)(NULL);
+	if (retval == RIG_OK)
+		rig_backend_loaded[be_idx] = 1;
+
+	return retval;
 }
 
 /*
@@ -253,7 +329,13 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 		return -RIG_ENAVAIL;
 	}
 
-	retval = rig_load_backend(rig_backend_list[be_idx].be_name);
+	/*
+	 * Backend already there, but it doesn't know this model
+	 */
+	if (rig_backend_loaded[be_idx])
+		return -RIG_ENAVAIL;
+
+	retval = rig_init_backend(be_idx);
 
 	return retval;
 }
@@ -262,19 +344,26 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 
 int HAMLIB_API rig_unregister(rig_model_t rig_model)
 {
-	int hval;
+	const struct rig_caps **slot;
 	struct rig_list *p,*q;
 
-	hval = HASH_FUNC(rig_model);
+	slot = rig_index_slot(rig_model, 0);
+	if (slot && *slot) {
+		*slot = NULL;
+		rig_name_index_reset();
+		return RIG_OK;
+	}
+
 	q = NULL;
-	for (p = rig_hash_table[hval]; p; p=p->next) {
+	for (p = rig_overflow; p; p=p->next) {
 		if (p->caps->rig_model == rig_model) {
 			if (q == NULL)
-				rig_hash_table[hval] = p->next;
+				rig_overflow = p->next;
 			else
 				q->next = p->next;
 
 			free(p);
+			rig_name_index_reset();
 			return RIG_OK;
 		}
 		q = p;
@@ -285,25 +374,123 @@ int HAMLIB_API rig_unregister(rig_model_t rig_model)
 
 /*
  * rig_list_foreach
- * executes cfunc on all the elements stored in the rig hash list
+ * executes cfunc on all the registered caps, in model order
  */
 int HAMLIB_API rig_list_foreach(int (*cfunc)(const struct rig_caps*, rig_ptr_t),rig_ptr_t data)
 {
 	struct rig_list *p;
-	int i;
+	int i, j;
 
 	if (!cfunc)
 		return -RIG_EINVAL;
 
-	for (i=0; i<RIGLSTHASHSZ; i++) {
-		for (p=rig_hash_table[i]; p; p=p->next)
-			if ((*cfunc)(p->caps,data) == 0)
+	for (i=0; i<RIG_INDEX_ROWS; i++) {
+		if (!rig_index[i])
+			continue;
+		for (j=0; j<RIG_MODELS_PER_BACKEND; j++) {
+			if (rig_index[i][j] && (*cfunc)(rig_index[i][j],data) == 0)
 				return RIG_OK;
+		}
 	}
 
+	for (p=rig_overflow; p; p=p->next)
+		if ((*cfunc)(p->caps,data) == 0)
+			return RIG_OK;
+
 	return RIG_OK;
 }
 
+static int rig_name_cmp(const char *a, const char *b)
+{
+	int ca, cb;
+
+	if (!a || !b)
+		return a ? 1 : (b ? -1 : 0);
+
+	do {
+		ca = tolower((unsigned char)*a++);
+		cb = tolower((unsigned char)*b++);
+	} while (ca && ca == cb);
+
+	return ca - cb;
+}
+
+static int rig_caps_name_cmp(const void *a, const void *b)
+{
+	const struct rig_caps *ca = *(const struct rig_caps * const *)a;
+	const struct rig_caps *cb = *(const struct rig_caps * const *)b;
+	int ret;
+
+	ret = rig_name_cmp(ca->model_name, cb->model_name);
+	if (ret)
+		return ret;
+
+	return rig_name_cmp(ca->mfg_name, cb->mfg_name);
+}
+
+static int rig_name_index_add(const struct rig_caps *caps, rig_ptr_t data)
+{
+	if (data)
+		rig_name_index[rig_name_count] = caps;
+	rig_name_count++;
+	return 1;	/* continue */
+}
+
+/**
+ * \brief find a rig model by its names
+ * \param mfg_name	manufacturer name, may be NULL to match any
+ * \param model_name	model name
+ *
+ * Looks up a registered model by name, ignoring case. Only loaded
+ * backends are searched, see rig_load_all_backends().
+ *
+ * \return the model number, or RIG_MODEL_NONE if not found.
+ */
+rig_model_t HAMLIB_API rig_lookup_model(const char *mfg_name, const char *model_name)
+{
+	int lo, hi, mid;
+
+	if (!model_name)
+		return RIG_MODEL_NONE;
+
+	if (!rig_name_index) {
+		rig_name_count = 0;
+		rig_list_foreach(rig_name_index_add, NULL);
+		if (rig_name_count == 0)
+			return RIG_MODEL_NONE;
+
+		rig_name_index = calloc(rig_name_count, sizeof(const struct rig_caps *));
+		if (!rig_name_index) {
+			rig_name_count = 0;
+			return RIG_MODEL_NONE;
+		}
+		rig_name_count = 0;
+		rig_list_foreach(rig_name_index_add, (rig_ptr_t)rig_name_index);
+
+		qsort(rig_name_index, rig_name_count, sizeof(const struct rig_caps *),
+				rig_caps_name_cmp);
+	}
+
+	/* first entry whose model name is not below model_name */
+	lo = 0;
+	hi = rig_name_count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (rig_name_cmp(rig_name_index[mid]->model_name, model_name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < rig_name_count &&
+			!rig_name_cmp(rig_name_index[lo]->model_name, model_name); lo++) {
+		if (!mfg_name || !rig_name_cmp(rig_name_index[lo]->mfg_name, mfg_name))
+			return rig_name_index[lo]->rig_model;
+	}
+
+	return RIG_MODEL_NONE;
+}
+
 static int dummy_rig_probe(const hamlib_port_t *p, rig_model_t model, rig_ptr_t data)
 {
 	rig_debug(RIG_DEBUG_TRACE, "Found rig, model %d\n", model);
@@ -319,7 +506,7 @@ rig_model_t rig_probe_first(hamlib_port_t *p)
 	int i;
 	rig_model_t model;
 
-	for (i=0; i<RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++) {
+	for (i=0; i<RIG_BACKEND_MAX; i++) {
 		if (rig_backend_list[i].be_probe_all) {
 			model = (*rig_backend_list[i].be_probe_all)(p, dummy_rig_probe, (rig_ptr_t)NULL);
 			/* stop at first one found */
@@ -338,7 +525,7 @@ int rig_probe_all_backends(hamlib_port_t *p, rig_probe_func_t cfunc, rig_ptr_t d
 {
 	int i;
 
-	for (i=0; i<RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++) {
+	for (i=0; i<RIG_BACKEND_MAX; i++) {
 		if (rig_backend_list[i].be_probe_all) {
 			(*rig_backend_list[i].be_probe_all)(p, cfunc, data);
 		}
@@ -351,36 +538,26 @@ int rig_load_all_backends()
 {
 	int i;
 
-	for (i=0; i<RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++) {
-			rig_load_backend(rig_backend_list[i].be_name);
+	for (i=0; i<RIG_BACKEND_MAX; i++) {
+		if (rig_backend_list[i].be_name)
+			rig_init_backend(i);
 	}
 
 	return RIG_OK;
 }
 
 
-typedef int (*backend_init_t)(rig_ptr_t);
-
 /*
  * rig_load_backend
  */
 int HAMLIB_API rig_load_backend(const char *be_name)
 {
 	int i;
-	backend_init_t be_init;
-
-	for (i=0; i<RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++) {
-		if (!strcmp(be_name, rig_backend_list[i].be_name)) {
-			be_init = rig_backend_list[i].be_init_all ;
-			if(be_init)
-			{
-				return (*be_init)(NULL);
-			}
-			else
-			{
-				return -RIG_EINVAL;
-			}
-		}
+
+	for (i=0; i<RIG_BACKEND_MAX; i++) {
+		if (rig_backend_list[i].be_name &&
+				!strcmp(be_name, rig_backend_list[i].be_name))
+			return rig_init_backend(i);
 	}
 
 	return -RIG_EINVAL;
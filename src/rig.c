@@ -67,6 +67,8 @@
 #include "network.h"
 #include "event.h"
 #include "cm108.h"
+#include "cache.h"
+#include "conf.h"
 
 /**
  * \brief Hamlib release number
@@ -417,6 +419,11 @@ RIG * HAMLIB_API rig_init(rig_model_t rig_model)
 
 	rs->rigport.fd = rs->pttport.fd = rs->dcdport.fd = -1;
 
+	if (rig_port_lock_init(rig) != RIG_OK) {
+		free(rig);
+		return NULL;
+	}
+
 	/*
 	 * let the backend a chance to setup his private data
 	 * This must be done only once defaults are setup,
@@ -427,6 +434,7 @@ RIG * HAMLIB_API rig_init(rig_model_t rig_model)
 		if (retcode != RIG_OK) {
 			rig_debug(RIG_DEBUG_VERBOSE,"rig:backend_init failed!\n");
 			/* cleanup and exit */
+			rig_port_lock_free(rig);
 			free(rig);
 			return NULL;
 		}
@@ -619,6 +627,14 @@ int HAMLIB_API rig_open(RIG *rig)
 		}
 	}
 
+	/* the conf set while closed, e.g. scope_data, may need the rig */
+	if (caps->set_conf != NULL) {
+		status = rig_conf_apply_saved(rig);
+		if (status != RIG_OK) {
+			return status;
+		}
+	}
+
 	/*
 	 * trigger state->current_vfo first retrieval
 	 */
@@ -680,6 +696,10 @@ int HAMLIB_API rig_close(RIG *rig)
 	if (caps->rig_close)
 		caps->rig_close(rig);
 
+	rig_cache_invalidate(rig);
+	/* the memories may be edited while the rig is closed */
+	rig_chan_hash_free(rig);
+
 	/*
 	 * FIXME: what happens if PTT and rig ports are the same?
 	 * 			(eg. ptt_type = RIG_PTT_SERIAL)
@@ -777,6 +797,13 @@ int HAMLIB_API rig_cleanup(RIG *rig)
 	if (rig->caps->rig_cleanup)
 		rig->caps->rig_cleanup(rig);
 
+	rig_event_queue(rig, 0);
+	rig_telemetry_setup(rig, 0, 0);
+	rig_resp_cache_free(rig);
+	rig_chan_hash_free(rig);
+	rig_conf_saved_free(rig);
+	rig_port_lock_free(rig);
+
 	free(rig);
 
 	return RIG_OK;
@@ -807,24 +834,28 @@ int HAMLIB_API rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (rig->state.vfo_comp != 0.0)
 		freq += (freq_t)((double)rig->state.vfo_comp * freq);
 
 	if (caps->set_freq == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_FREQ) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo) {
 		retcode = caps->set_freq(rig, vfo, freq);
 	} else {
 		if (!caps->set_vfo)
-			return -RIG_ENTARGET;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->set_freq(rig, vfo, freq);
 		caps->set_vfo(rig, curr_vfo);
@@ -833,7 +864,7 @@ int HAMLIB_API rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 			(vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo))
 		rig->state.current_freq = freq;
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -862,21 +893,26 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 	if (CHECK_RIG_ARG(rig) || !freq)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_freq == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
+
+	if (rig_cache_get_freq(rig, vfo, freq))
+		RIG_UNLOCK_RETURN(rig, RIG_OK);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_FREQ) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo) {
 		retcode = caps->get_freq(rig, vfo, freq);
 	} else {
 		if (!caps->set_vfo)
-			return -RIG_ENAVAIL;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 		retcode = caps->get_freq(rig, vfo, freq);
 		caps->set_vfo(rig, curr_vfo);
 	}
@@ -885,10 +921,12 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 		*freq += (freq_t)(rig->state.vfo_comp * (*freq));
 
 	if (retcode == RIG_OK &&
-			(vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo))
+			(vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)) {
 		rig->state.current_freq = *freq;
+		rig_cache_update_freq(rig);
+	}
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -918,10 +956,14 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_mode == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_MODE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo) {
@@ -929,11 +971,11 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 	} else {
 
 		if (!caps->set_vfo)
-			return -RIG_ENTARGET;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->set_mode(rig, vfo, mode, width);
 		caps->set_vfo(rig, curr_vfo);
@@ -945,7 +987,7 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 		rig->state.current_width = width;
 	}
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -977,10 +1019,18 @@ int HAMLIB_API rig_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width
 	if (CHECK_RIG_ARG(rig) || !mode || !width)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_mode == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
+
+	if (rig_cache_get_mode(rig, vfo, mode, width)) {
+		if (*width == RIG_PASSBAND_NORMAL && *mode != RIG_MODE_NONE)
+			*width = rig_passband_normal (rig, *mode);
+		RIG_UNLOCK_RETURN(rig, RIG_OK);
+	}
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_MODE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo) {
@@ -988,11 +1038,11 @@ int HAMLIB_API rig_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width
 	} else {
 
 		if (!caps->set_vfo)
-			return -RIG_ENTARGET;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->get_mode(rig, vfo, mode, width);
 		caps->set_vfo(rig, curr_vfo);
@@ -1002,12 +1052,13 @@ int HAMLIB_API rig_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width
 			(vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)) {
 		rig->state.current_mode = *mode;
 		rig->state.current_width = *width;
+		rig_cache_update_mode(rig);
 	}
 
 	if (*width == RIG_PASSBAND_NORMAL && *mode != RIG_MODE_NONE)
 		*width = rig_passband_normal (rig, *mode);
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1150,15 +1201,19 @@ int HAMLIB_API rig_set_vfo(RIG *rig, vfo_t vfo)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_vfo == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	retcode= caps->set_vfo(rig, vfo);
 	if (retcode == RIG_OK)
 		rig->state.current_vfo = vfo;
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1185,15 +1240,22 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
 	if (CHECK_RIG_ARG(rig) || !vfo)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_vfo == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
+
+	if (rig_cache_get_vfo(rig, vfo))
+		RIG_UNLOCK_RETURN(rig, RIG_OK);
 
 	retcode= caps->get_vfo(rig, vfo);
-	if (retcode == RIG_OK)
+	if (retcode == RIG_OK) {
 		rig->state.current_vfo = *vfo;
-	return retcode;
+		rig_cache_update_vfo(rig);
+	}
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1219,6 +1281,10 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 	switch (rig->state.pttport.type.ptt) {
 	case RIG_PTT_RIG:
@@ -1227,44 +1293,44 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 		/* fall through */
 	case RIG_PTT_RIG_MICDATA:
 		if (caps->set_ptt == NULL)
-		    return -RIG_ENIMPL;
+		    RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 
 		if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		    return caps->set_ptt(rig, vfo, ptt);
+		    RIG_UNLOCK_RETURN(rig, caps->set_ptt(rig, vfo, ptt));
 
 		if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->set_ptt(rig, vfo, ptt);
 		caps->set_vfo(rig, curr_vfo);
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 		break;
 
 	case RIG_PTT_SERIAL_DTR:
-		return ser_set_dtr(&rig->state.pttport, ptt!=RIG_PTT_OFF);
+		RIG_UNLOCK_RETURN(rig, ser_set_dtr(&rig->state.pttport, ptt!=RIG_PTT_OFF));
 
 	case RIG_PTT_SERIAL_RTS:
-		return ser_set_rts(&rig->state.pttport, ptt!=RIG_PTT_OFF);
+		RIG_UNLOCK_RETURN(rig, ser_set_rts(&rig->state.pttport, ptt!=RIG_PTT_OFF));
 
 	case RIG_PTT_PARALLEL:
-		return par_ptt_set(&rig->state.pttport, ptt);
+		RIG_UNLOCK_RETURN(rig, par_ptt_set(&rig->state.pttport, ptt));
 
 	case RIG_PTT_CM108:
-		return cm108_ptt_set(&rig->state.pttport, ptt);
+		RIG_UNLOCK_RETURN(rig, cm108_ptt_set(&rig->state.pttport, ptt));
 
 	case RIG_PTT_NONE:
-		return -RIG_ENAVAIL;	/* not available */
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);	/* not available */
 	default:
-		return -RIG_EINVAL;
+		RIG_UNLOCK_RETURN(rig, -RIG_EINVAL);
 	}
 
-	return RIG_OK;
+	RIG_UNLOCK_RETURN(rig, RIG_OK);
 }
 
 /**
@@ -1290,67 +1356,69 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 	if (CHECK_RIG_ARG(rig) || !ptt)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	switch (rig->state.pttport.type.ptt) {
 	case RIG_PTT_RIG:
 	case RIG_PTT_RIG_MICDATA:
 		if (caps->get_ptt == NULL)
-			return -RIG_ENIMPL;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 
 		if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-			return caps->get_ptt(rig, vfo, ptt);
+			RIG_UNLOCK_RETURN(rig, caps->get_ptt(rig, vfo, ptt));
 
 		if (!caps->set_vfo)
-			return -RIG_ENTARGET;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->get_ptt(rig, vfo, ptt);
 		caps->set_vfo(rig, curr_vfo);
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 		break;
 
 	case RIG_PTT_SERIAL_RTS:
 		if (caps->get_ptt)
-			return caps->get_ptt(rig, vfo, ptt);
+			RIG_UNLOCK_RETURN(rig, caps->get_ptt(rig, vfo, ptt));
 
 		retcode = ser_get_rts(&rig->state.pttport, &status);
 		*ptt = status ? RIG_PTT_ON : RIG_PTT_OFF;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	case RIG_PTT_SERIAL_DTR:
 		if (caps->get_ptt)
-			return caps->get_ptt(rig, vfo, ptt);
+			RIG_UNLOCK_RETURN(rig, caps->get_ptt(rig, vfo, ptt));
 
 		retcode = ser_get_dtr(&rig->state.pttport, &status);
 		*ptt = status ? RIG_PTT_ON : RIG_PTT_OFF;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	case RIG_PTT_PARALLEL:
 		if (caps->get_ptt)
-			return caps->get_ptt(rig, vfo, ptt);
+			RIG_UNLOCK_RETURN(rig, caps->get_ptt(rig, vfo, ptt));
 
-		return par_ptt_get(&rig->state.pttport, ptt);
+		RIG_UNLOCK_RETURN(rig, par_ptt_get(&rig->state.pttport, ptt));
 
 	case RIG_PTT_CM108:
 		if (caps->get_ptt)
-			return caps->get_ptt(rig, vfo, ptt);
+			RIG_UNLOCK_RETURN(rig, caps->get_ptt(rig, vfo, ptt));
 
-		return cm108_ptt_get(&rig->state.pttport, ptt);
+		RIG_UNLOCK_RETURN(rig, cm108_ptt_get(&rig->state.pttport, ptt));
 
 	case RIG_PTT_NONE:
-		return -RIG_ENAVAIL;	/* not available */
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);	/* not available */
 
 	default:
-		return -RIG_EINVAL;
+		RIG_UNLOCK_RETURN(rig, -RIG_EINVAL);
 	}
 
-	return RIG_OK;
+	RIG_UNLOCK_RETURN(rig, RIG_OK);
 }
 
 /**
@@ -1375,57 +1443,59 @@ int HAMLIB_API rig_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd)
 	if (CHECK_RIG_ARG(rig) || !dcd)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	switch (rig->state.dcdport.type.dcd) {
 	case RIG_DCD_RIG:
 		if (caps->get_dcd == NULL)
-			return -RIG_ENIMPL;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENIMPL);
 
 		if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-			return caps->get_dcd(rig, vfo, dcd);
+			RIG_UNLOCK_RETURN(rig, caps->get_dcd(rig, vfo, dcd));
 
 		if (!caps->set_vfo)
-			return -RIG_ENTARGET;
+			RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 		curr_vfo = rig->state.current_vfo;
 		retcode = caps->set_vfo(rig, vfo);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 
 		retcode = caps->get_dcd(rig, vfo, dcd);
 		caps->set_vfo(rig, curr_vfo);
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 		break;
 
 	case RIG_DCD_SERIAL_CTS:
 		retcode = ser_get_cts(&rig->state.dcdport, &status);
 		*dcd = status ? RIG_DCD_ON : RIG_DCD_OFF;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	case RIG_DCD_SERIAL_DSR:
 		retcode = ser_get_dsr(&rig->state.dcdport, &status);
 		*dcd = status ? RIG_DCD_ON : RIG_DCD_OFF;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	case RIG_DCD_SERIAL_CAR:
 		retcode = ser_get_car(&rig->state.dcdport, &status);
 		*dcd = status ? RIG_DCD_ON : RIG_DCD_OFF;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 
 	case RIG_DCD_PARALLEL:
-		return par_dcd_get(&rig->state.dcdport, dcd);
+		RIG_UNLOCK_RETURN(rig, par_dcd_get(&rig->state.dcdport, dcd));
 
 	case RIG_DCD_NONE:
-		return -RIG_ENAVAIL;	/* not available */
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);	/* not available */
 
 	default:
-		return -RIG_EINVAL;
+		RIG_UNLOCK_RETURN(rig, -RIG_EINVAL);
 	}
 
-	return RIG_OK;
+	RIG_UNLOCK_RETURN(rig, RIG_OK);
 }
 
 
@@ -1452,25 +1522,29 @@ int HAMLIB_API rig_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_rptr_shift == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_rptr_shift(rig, vfo, rptr_shift);
+		RIG_UNLOCK_RETURN(rig, caps->set_rptr_shift(rig, vfo, rptr_shift));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_rptr_shift(rig, vfo, rptr_shift);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1496,25 +1570,27 @@ int HAMLIB_API rig_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
 	if (CHECK_RIG_ARG(rig) || !rptr_shift)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_rptr_shift == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_rptr_shift(rig, vfo, rptr_shift);
+		RIG_UNLOCK_RETURN(rig, caps->get_rptr_shift(rig, vfo, rptr_shift));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_rptr_shift(rig, vfo, rptr_shift);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1541,25 +1617,29 @@ int HAMLIB_API rig_set_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t rptr_offs)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_rptr_offs == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_rptr_offs(rig, vfo, rptr_offs);
+		RIG_UNLOCK_RETURN(rig, caps->set_rptr_offs(rig, vfo, rptr_offs));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_rptr_offs(rig, vfo, rptr_offs);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1586,25 +1666,27 @@ int HAMLIB_API rig_get_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t *rptr_offs)
 	if (CHECK_RIG_ARG(rig) || !rptr_offs)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_rptr_offs == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_rptr_offs(rig, vfo, rptr_offs);
+		RIG_UNLOCK_RETURN(rig, caps->get_rptr_offs(rig, vfo, rptr_offs));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_rptr_offs(rig, vfo, rptr_offs);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -1632,13 +1714,17 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_split_freq &&
 			((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			 vfo == RIG_VFO_CURR || vfo == RIG_VFO_TX ||
 			 vfo == rig->state.current_vfo))
-		return caps->set_split_freq(rig, vfo, tx_freq);
+		RIG_UNLOCK_RETURN(rig, caps->set_split_freq(rig, vfo, tx_freq));
 
 	/* Assisted mode */
 
@@ -1651,7 +1737,7 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 		tx_vfo = vfo;
 
 	if (caps->set_freq && (caps->targetable_vfo&RIG_TARGETABLE_FREQ))
-		return caps->set_freq(rig, tx_vfo, tx_freq);
+		RIG_UNLOCK_RETURN(rig, caps->set_freq(rig, tx_vfo, tx_freq));
 
 
 	if (caps->set_vfo) {
@@ -1659,10 +1745,10 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 	} else if (rig_has_vfo_op(rig, RIG_OP_TOGGLE) && caps->vfo_op) {
 		retcode = caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	} else {
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 	}
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	if (caps->set_split_freq)
 		retcode = caps->set_split_freq(rig, vfo, tx_freq);
@@ -1674,7 +1760,7 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 	} else {
 		caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	}
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1700,13 +1786,15 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
 	if (CHECK_RIG_ARG(rig) || !tx_freq)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_split_freq &&
 			((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			 vfo == RIG_VFO_CURR || vfo == RIG_VFO_TX ||
 			 vfo == rig->state.current_vfo))
-		return caps->get_split_freq(rig, vfo, tx_freq);
+		RIG_UNLOCK_RETURN(rig, caps->get_split_freq(rig, vfo, tx_freq));
 
 	/* Assisted mode */
 
@@ -1719,7 +1807,7 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
 		tx_vfo = vfo;
 
 	if (caps->get_freq && (caps->targetable_vfo&RIG_TARGETABLE_FREQ))
-		return caps->get_freq(rig, tx_vfo, tx_freq);
+		RIG_UNLOCK_RETURN(rig, caps->get_freq(rig, tx_vfo, tx_freq));
 
 
 	if (caps->set_vfo) {
@@ -1727,10 +1815,10 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
 	} else if (rig_has_vfo_op(rig, RIG_OP_TOGGLE) && caps->vfo_op) {
 		retcode = caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	} else {
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 	}
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	if (caps->get_split_freq)
 		retcode = caps->get_split_freq(rig, vfo, tx_freq);
@@ -1743,7 +1831,7 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
 		caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	}
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1771,13 +1859,17 @@ int HAMLIB_API rig_set_split_mode(RIG *rig, vfo_t vfo, rmode_t tx_mode, pbwidth_
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_split_mode &&
 			((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			 vfo == RIG_VFO_CURR || vfo == RIG_VFO_TX ||
 			 vfo == rig->state.current_vfo))
-		return caps->set_split_mode(rig, vfo, tx_mode, tx_width);
+		RIG_UNLOCK_RETURN(rig, caps->set_split_mode(rig, vfo, tx_mode, tx_width));
 
 	/* Assisted mode */
 
@@ -1790,7 +1882,7 @@ int HAMLIB_API rig_set_split_mode(RIG *rig, vfo_t vfo, rmode_t tx_mode, pbwidth_
 		tx_vfo = vfo;
 
 	if (caps->set_mode && (caps->targetable_vfo&RIG_TARGETABLE_MODE))
-		return caps->set_mode(rig, tx_vfo, tx_mode, tx_width);
+		RIG_UNLOCK_RETURN(rig, caps->set_mode(rig, tx_vfo, tx_mode, tx_width));
 
 
 	if (caps->set_vfo) {
@@ -1798,10 +1890,10 @@ int HAMLIB_API rig_set_split_mode(RIG *rig, vfo_t vfo, rmode_t tx_mode, pbwidth_
 	} else if (rig_has_vfo_op(rig, RIG_OP_TOGGLE) && caps->vfo_op) {
 		retcode = caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	} else {
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 	}
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	if (caps->set_split_mode)
 		retcode = caps->set_split_mode(rig, vfo, tx_mode, tx_width);
@@ -1814,7 +1906,7 @@ int HAMLIB_API rig_set_split_mode(RIG *rig, vfo_t vfo, rmode_t tx_mode, pbwidth_
 		caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	}
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1845,13 +1937,15 @@ int HAMLIB_API rig_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode, pbwidth
 	if (CHECK_RIG_ARG(rig) || !tx_mode || !tx_width)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_split_mode &&
 			((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			 vfo == RIG_VFO_CURR || vfo == RIG_VFO_TX ||
 			 vfo == rig->state.current_vfo))
-		return caps->get_split_mode(rig, vfo, tx_mode, tx_width);
+		RIG_UNLOCK_RETURN(rig, caps->get_split_mode(rig, vfo, tx_mode, tx_width));
 
 	/* Assisted mode */
 
@@ -1864,7 +1958,7 @@ int HAMLIB_API rig_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode, pbwidth
 		tx_vfo = vfo;
 
 	if (caps->get_mode && (caps->targetable_vfo&RIG_TARGETABLE_MODE))
-		return caps->get_mode(rig, tx_vfo, tx_mode, tx_width);
+		RIG_UNLOCK_RETURN(rig, caps->get_mode(rig, tx_vfo, tx_mode, tx_width));
 
 
 	if (caps->set_vfo) {
@@ -1872,10 +1966,10 @@ int HAMLIB_API rig_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode, pbwidth
 	} else if (rig_has_vfo_op(rig, RIG_OP_TOGGLE) && caps->vfo_op) {
 		retcode = caps->vfo_op(rig, vfo, RIG_OP_TOGGLE);
 	} else {
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 	}
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	if (caps->get_split_mode)
 		retcode = caps->get_split_mode(rig, vfo, tx_mode, tx_width);
@@ -1891,7 +1985,7 @@ int HAMLIB_API rig_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode, pbwidth
 	if (*tx_width == RIG_PASSBAND_NORMAL && *tx_mode != RIG_MODE_NONE)
 		*tx_width = rig_passband_normal (rig, *tx_mode);
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -1919,10 +2013,14 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vf
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_split_vfo == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
@@ -1930,15 +2028,15 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vf
 		retcode = caps->set_split_vfo(rig, vfo, split, tx_vfo);
 		if (retcode == RIG_OK)
 			rig->state.tx_vfo = tx_vfo;
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 	}
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_split_vfo(rig, vfo, split, tx_vfo);
 	caps->set_vfo(rig, curr_vfo);
@@ -1946,7 +2044,7 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vf
 	if (retcode == RIG_OK)
 		rig->state.tx_vfo = tx_vfo;
 
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -1973,28 +2071,30 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split, vfo_t *tx_
 	if (CHECK_RIG_ARG(rig) || !split || !tx_vfo)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_split_vfo == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	/* overidden by backend at will */
 	*tx_vfo = rig->state.tx_vfo;
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_split_vfo(rig, vfo, split, tx_vfo);
+		RIG_UNLOCK_RETURN(rig, caps->get_split_vfo(rig, vfo, split, tx_vfo));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_split_vfo(rig, vfo, split, tx_vfo);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2021,25 +2121,29 @@ int HAMLIB_API rig_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_rit == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_rit(rig, vfo, rit);
+		RIG_UNLOCK_RETURN(rig, caps->set_rit(rig, vfo, rit));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_rit(rig, vfo, rit);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2066,25 +2170,27 @@ int HAMLIB_API rig_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
 	if (CHECK_RIG_ARG(rig) || !rit)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_rit == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_rit(rig, vfo, rit);
+		RIG_UNLOCK_RETURN(rig, caps->get_rit(rig, vfo, rit));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_rit(rig, vfo, rit);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2111,25 +2217,29 @@ int HAMLIB_API rig_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_xit == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_xit(rig, vfo, xit);
+		RIG_UNLOCK_RETURN(rig, caps->set_xit(rig, vfo, xit));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_xit(rig, vfo, xit);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2156,25 +2266,27 @@ int HAMLIB_API rig_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
 	if (CHECK_RIG_ARG(rig) || !xit)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_xit == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_xit(rig, vfo, xit);
+		RIG_UNLOCK_RETURN(rig, caps->get_xit(rig, vfo, xit));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_xit(rig, vfo, xit);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -2203,25 +2315,29 @@ int HAMLIB_API rig_set_ts(RIG *rig, vfo_t vfo, shortfreq_t ts)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_ts == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_ts(rig, vfo, ts);
+		RIG_UNLOCK_RETURN(rig, caps->set_ts(rig, vfo, ts));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_ts(rig, vfo, ts);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2248,25 +2364,27 @@ int HAMLIB_API rig_get_ts(RIG *rig, vfo_t vfo, shortfreq_t *ts)
 	if (CHECK_RIG_ARG(rig) || !ts)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_ts == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_ts(rig, vfo, ts);
+		RIG_UNLOCK_RETURN(rig, caps->get_ts(rig, vfo, ts));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_ts(rig, vfo, ts);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2297,25 +2415,29 @@ int HAMLIB_API rig_set_ant(RIG *rig, vfo_t vfo, ant_t ant)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_ant == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_ant(rig, vfo, ant);
+		RIG_UNLOCK_RETURN(rig, caps->set_ant(rig, vfo, ant));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_ant(rig, vfo, ant);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2342,25 +2464,27 @@ int HAMLIB_API rig_get_ant(RIG *rig, vfo_t vfo, ant_t *ant)
 	if (CHECK_RIG_ARG(rig) || !ant)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_ant == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_ant(rig, vfo, ant);
+		RIG_UNLOCK_RETURN(rig, caps->get_ant(rig, vfo, ant));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_ant(rig, vfo, ant);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -2504,10 +2628,14 @@ int HAMLIB_API rig_set_powerstat(RIG *rig, powerstat_t status)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	if (rig->caps->set_powerstat == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->set_powerstat(rig, status);
+	RIG_UNLOCK_RETURN(rig, rig->caps->set_powerstat(rig, status));
 }
 
 /**
@@ -2530,10 +2658,12 @@ int HAMLIB_API rig_get_powerstat(RIG *rig, powerstat_t *status)
 	if (CHECK_RIG_ARG(rig) || !status)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	if (rig->caps->get_powerstat == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->get_powerstat(rig, status);
+	RIG_UNLOCK_RETURN(rig, rig->caps->get_powerstat(rig, status));
 }
 
 /**
@@ -2556,10 +2686,14 @@ int HAMLIB_API rig_reset(RIG *rig, reset_t reset)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	if (rig->caps->reset == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->reset(rig, reset);
+	RIG_UNLOCK_RETURN(rig, rig->caps->reset(rig, reset));
 }
 
 extern int rig_probe_first(hamlib_port_t *p);
@@ -2660,25 +2794,29 @@ int HAMLIB_API rig_vfo_op(RIG *rig, vfo_t vfo, vfo_op_t op)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->vfo_op == NULL || !rig_has_vfo_op(rig,op))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->vfo_op(rig, vfo, op);
+		RIG_UNLOCK_RETURN(rig, caps->vfo_op(rig, vfo, op));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->vfo_op(rig, vfo, op);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2731,26 +2869,30 @@ int HAMLIB_API rig_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->scan == NULL ||
 			(scan!=RIG_SCAN_STOP && !rig_has_scan(rig, scan)))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->scan(rig, vfo, scan, ch);
+		RIG_UNLOCK_RETURN(rig, caps->scan(rig, vfo, scan, ch));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->scan(rig, vfo, scan, ch);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2777,25 +2919,27 @@ int HAMLIB_API rig_send_dtmf(RIG *rig, vfo_t vfo, const char *digits)
 	if (CHECK_RIG_ARG(rig) || !digits)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->send_dtmf == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->send_dtmf(rig, vfo, digits);
+		RIG_UNLOCK_RETURN(rig, caps->send_dtmf(rig, vfo, digits));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->send_dtmf(rig, vfo, digits);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2823,25 +2967,27 @@ int HAMLIB_API rig_recv_dtmf(RIG *rig, vfo_t vfo, char *digits, int *length)
 	if (CHECK_RIG_ARG(rig) || !digits || !length)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->recv_dtmf == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->recv_dtmf(rig, vfo, digits, length);
+		RIG_UNLOCK_RETURN(rig, caps->recv_dtmf(rig, vfo, digits, length));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->recv_dtmf(rig, vfo, digits, length);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -2868,25 +3014,27 @@ int HAMLIB_API rig_send_morse(RIG *rig, vfo_t vfo, const char *msg)
 	if (CHECK_RIG_ARG(rig) || !msg)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->send_morse == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->send_morse(rig, vfo, msg);
+		RIG_UNLOCK_RETURN(rig, caps->send_morse(rig, vfo, msg));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->send_morse(rig, vfo, msg);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 
@@ -2934,13 +3082,154 @@ HAMLIB_API rig_get_range(const freq_range_t range_list[], freq_t freq, rmode_t m
  */
 const char* HAMLIB_API rig_get_info(RIG *rig)
 {
+	const char *info = NULL;
+
 	if (CHECK_RIG_ARG(rig))
 		return NULL;
 
-	if (rig->caps->get_info == NULL)
-		return NULL;
+	rig_port_lock(rig);
+	if (rig->caps->get_info != NULL)
+		info = rig->caps->get_info(rig);
+	rig_port_unlock(rig);
+
+	return info;
+}
+
+/**
+ * \brief read several items of the rig state at once
+ * \param rig	The rig handle
+ * \param query	The array of queries, results are stored in place
+ * \param count	The number of queries
+ *
+ *  Reads the items described by \a query, e.g. the frequency of VFO A,
+ *  the mode and the PTT status.  The backends able to do so send all
+ *  the queries before parsing the replies in order, saving a round trip
+ *  per item.  Items a backend cannot pipeline are read one after the
+ *  other with rig_get_freq(), rig_get_mode(), etc.
+ *
+ *  Each query gets its own \a retcode.
+ *
+ * \return RIG_OK if all the queries have been sucessful, otherwise the
+ * error code of the first failed query.
+ *
+ * \sa rig_get_freq(), rig_get_mode(), rig_get_vfo(), rig_get_ptt(),
+ * rig_get_level()
+ */
+#define BATCH_CACHED	1	/* query answered from the cache, not an error code */
+
+int HAMLIB_API rig_get_state_batch(RIG *rig, rig_query_t *query, int count)
+{
+	const struct rig_caps *caps;
+	struct rig_state *rs;
+	rig_query_t *q;
+	int i, retcode;
+
+	if (CHECK_RIG_ARG(rig) || !query || count < 0)
+		return -RIG_EINVAL;
+
+	rig_port_lock(rig);
+
+	caps = rig->caps;
+	rs = &rig->state;
+
+	/*
+	 * Cache hits are marked BATCH_CACHED until the backend is done,
+	 * so that only its answers get the post processing below.
+	 */
+	for (i = 0; i < count; i++) {
+		q = &query[i];
+		q->retcode = -RIG_ENIMPL;
+
+		switch (q->item) {
+		case RIG_QUERY_FREQ:
+			if (rig_cache_get_freq(rig, q->vfo, &q->u.freq))
+				q->retcode = BATCH_CACHED;
+			break;
+		case RIG_QUERY_MODE:
+			if (rig_cache_get_mode(rig, q->vfo, &q->u.mode.mode,
+						&q->u.mode.width))
+				q->retcode = BATCH_CACHED;
+			break;
+		case RIG_QUERY_VFO:
+			if (rig_cache_get_vfo(rig, &q->u.vfo))
+				q->retcode = BATCH_CACHED;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (caps->get_state_batch) {
+		retcode = caps->get_state_batch(rig, query, count);
+		if (retcode != RIG_OK)
+			rig_debug(RIG_DEBUG_WARN, "%s: batch failed: %s\n",
+					__func__, rigerror(retcode));
+
+		/* same post processing as rig_get_freq() and rig_get_mode() */
+		for (i = 0; i < count; i++) {
+			q = &query[i];
+			if (q->retcode != RIG_OK)
+				continue;
+			if (q->item == RIG_QUERY_FREQ) {
+				if (rs->vfo_comp != 0.0)
+					q->u.freq += (freq_t)(rs->vfo_comp * q->u.freq);
+				if (q->vfo == RIG_VFO_CURR || q->vfo == rs->current_vfo) {
+					rs->current_freq = q->u.freq;
+					rig_cache_update_freq(rig);
+				}
+			} else if (q->item == RIG_QUERY_MODE) {
+				if (q->vfo == RIG_VFO_CURR || q->vfo == rs->current_vfo) {
+					rs->current_mode = q->u.mode.mode;
+					rs->current_width = q->u.mode.width;
+					rig_cache_update_mode(rig);
+				}
+			}
+		}
+	}
+
+	retcode = RIG_OK;
+
+	for (i = 0; i < count; i++) {
+		q = &query[i];
+
+		if (q->retcode == BATCH_CACHED)
+			q->retcode = RIG_OK;
+
+		if (q->retcode == -RIG_ENIMPL) {
+			switch (q->item) {
+			case RIG_QUERY_FREQ:
+				q->retcode = rig_get_freq(rig, q->vfo, &q->u.freq);
+				break;
+			case RIG_QUERY_MODE:
+				q->retcode = rig_get_mode(rig, q->vfo, &q->u.mode.mode,
+						&q->u.mode.width);
+				break;
+			case RIG_QUERY_VFO:
+				q->retcode = rig_get_vfo(rig, &q->u.vfo);
+				break;
+			case RIG_QUERY_PTT:
+				q->retcode = rig_get_ptt(rig, q->vfo, &q->u.ptt);
+				break;
+			case RIG_QUERY_LEVEL:
+				q->retcode = rig_get_level(rig, q->vfo, q->level,
+						&q->u.level);
+				break;
+			default:
+				q->retcode = -RIG_EINVAL;
+				break;
+			}
+		}
+
+		if (q->item == RIG_QUERY_MODE && q->retcode == RIG_OK &&
+				q->u.mode.width == RIG_PASSBAND_NORMAL &&
+				q->u.mode.mode != RIG_MODE_NONE)
+			q->u.mode.width = rig_passband_normal(rig, q->u.mode.mode);
+
+		if (q->retcode != RIG_OK && retcode == RIG_OK)
+			retcode = q->retcode;
+	}
 
-	return rig->caps->get_info(rig);
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /*! @} */
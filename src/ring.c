@@ -0,0 +1,143 @@
+/*
+ *  Hamlib Interface - lock free ring buffer
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Ring buffer shared by the event queue and the level telemetry.
+ * See ring.h for the slot protocol.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+
+#include "ring.h"
+
+
+/*
+ * Set up a ring of at least count entries of size bytes each,
+ * the number of slots being rounded up to a power of 2.
+ */
+int ring_init(struct rig_ring *r, unsigned long count, size_t size)
+{
+	unsigned long n;
+
+	for (n = 2; n < count; n <<= 1)
+		;
+
+	memset(r, 0, sizeof(struct rig_ring));
+
+	r->seq = calloc(n, sizeof(unsigned long));
+	r->data = calloc(n, size);
+	if (!r->seq || !r->data) {
+		ring_free(r);
+		return -RIG_ENOMEM;
+	}
+
+	r->mask = n - 1;
+	r->size = size;
+
+	return RIG_OK;
+}
+
+void ring_free(struct rig_ring *r)
+{
+	free((void *)r->seq);
+	free(r->data);
+	r->seq = NULL;
+	r->data = NULL;
+}
+
+/*
+ * Producer side.  When the entries not popped yet fill the ring,
+ * either overwrite the oldest one, or drop the new one and return 0.
+ * Returns 1 when stored.
+ */
+int ring_push(struct rig_ring *r, const void *entry, int overwrite)
+{
+	unsigned long pos = r->tail;
+	unsigned long i = pos & r->mask;
+
+	if (!overwrite && pos - r->head > r->mask)
+		return 0;
+
+	r->seq[i] = 0;
+	__sync_synchronize();
+	memcpy(r->data + i * r->size, entry, r->size);
+	__sync_synchronize();
+	r->seq[i] = pos + 1;
+	r->tail = pos + 1;
+
+	return 1;
+}
+
+/*
+ * Reader side, copies the entry numbered pos.  Returns 0 when that
+ * entry is not stored, or has been overwritten before or meanwhile.
+ */
+int ring_read(struct rig_ring *r, unsigned long pos, void *entry)
+{
+	unsigned long i = pos & r->mask;
+	unsigned long seq;
+
+	seq = r->seq[i];
+	__sync_synchronize();
+	if (seq != pos + 1)
+		return 0;
+
+	memcpy(entry, r->data + i * r->size, r->size);
+	__sync_synchronize();
+
+	return r->seq[i] == seq;
+}
+
+/*
+ * Consumer side, takes the oldest entry through the shared head.
+ * The head only moves once the entry is copied, so that a producer
+ * not overwriting cannot reuse the slot under the consumer.
+ * Returns 1 when *entry has been filled, 0 when empty.
+ */
+int ring_pop(struct rig_ring *r, void *entry)
+{
+	unsigned long pos;
+
+	for (;;) {
+		pos = r->head;
+		__sync_synchronize();
+		if (pos == r->tail)
+			return 0;	/* empty */
+
+		if (!ring_read(r, pos, entry)) {
+			/* head moved meanwhile, or overwritten: skip the lost ones */
+			if (r->tail - pos > r->mask + 1)
+				__sync_bool_compare_and_swap(&r->head, pos,
+						r->tail - (r->mask + 1));
+			continue;
+		}
+
+		if (__sync_bool_compare_and_swap(&r->head, pos, pos + 1))
+			return 1;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ *  Hamlib Interface - lock free ring buffer header
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RING_H
+#define _RING_H 1
+
+#include <stddef.h>
+
+/*
+ * Bounded ring of fixed size entries, with a single producer.
+ *
+ * Each slot carries the number of the entry it holds plus one, or 0
+ * while being written, so that readers can tell a stable entry from
+ * one being overwritten without taking any lock.  The entries are
+ * either consumed once through the shared head (ring_pop), or read
+ * by any number of readers each keeping its own position (ring_read).
+ */
+struct rig_ring {
+	unsigned long mask;		/* number of slots - 1 */
+	size_t size;			/* size of an entry */
+	volatile unsigned long head;	/* next entry to pop, shared by consumers */
+	volatile unsigned long tail;	/* number of entries pushed so far */
+	volatile unsigned long *seq;	/* per slot entry number + 1, 0 while written */
+	unsigned char *data;
+};
+
+int ring_init(struct rig_ring *r, unsigned long count, size_t size);
+void ring_free(struct rig_ring *r);
+
+int ring_push(struct rig_ring *r, const void *entry, int overwrite);
+int ring_pop(struct rig_ring *r, void *entry);
+int ring_read(struct rig_ring *r, unsigned long pos, void *entry);
+
+#endif	/* _RING_H */
@@ -32,6 +32,7 @@
 #endif
 
 #include <errno.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -76,11 +77,13 @@ DEFINE_INITROT_BACKEND(celestron);
 DEFINE_INITROT_BACKEND(ether6);
 
 /*! \def ROT_BACKEND_LIST
- *  \brief Static list of rotator models.
+ *  \brief Static map of backend numbers to rotator backends.
  *
- *  This is a NULL terminated list of available rotator backends. Each entry
- *  in the list consists of two fields: The branch number, which is an integer,
- *  and the branch name, which is a character string.
+ *  This table is indexed by backend number, ie. ROT_BACKEND_NUM(model),
+ *  so the backend declaring a model is found without initializing or
+ *  scanning the others. Each entry consists of the branch number, the
+ *  branch name, and the backend init and probe functions. Unused backend
+ *  numbers have a NULL be_name.
  *  An external library, loaded dynamically, could add its own functions pointers
  *  in this array.
  */
@@ -91,24 +94,26 @@ static struct {
 	rot_model_t (*be_probe)(hamlib_port_t *);
 } rot_backend_list[ROT_BACKEND_MAX] =
 {
-        { ROT_DUMMY, ROT_BACKEND_DUMMY, ROT_FUNCNAMA(dummy) },
-        { ROT_EASYCOMM, ROT_BACKEND_EASYCOMM, ROT_FUNCNAMA(easycomm) },
-        { ROT_FODTRACK, ROT_BACKEND_FODTRACK, ROT_FUNCNAMA(fodtrack) },
-        { ROT_ROTOREZ, ROT_BACKEND_ROTOREZ, ROT_FUNCNAMA(rotorez) },
-        { ROT_SARTEK, ROT_BACKEND_SARTEK, ROT_FUNCNAMA(sartek) },
-        { ROT_GS232A, ROT_BACKEND_GS232A, ROT_FUNCNAMA(gs232a) },
-        { ROT_KIT, ROT_BACKEND_KIT, ROT_FUNCNAMA(kit) },
-        { ROT_HEATHKIT, ROT_BACKEND_HEATHKIT, ROT_FUNCNAMA(heathkit) },
-        { ROT_SPID, ROT_BACKEND_SPID, ROT_FUNCNAMA(spid) },
-        { ROT_M2, ROT_BACKEND_M2, ROT_FUNCNAMA(m2) },
-        { ROT_ARS, ROT_BACKEND_ARS, ROT_FUNCNAMA(ars) },
-        { ROT_AMSAT, ROT_BACKEND_AMSAT, ROT_FUNCNAMA(amsat) },
-        { ROT_TS7400, ROT_BACKEND_TS7400, ROT_FUNCNAMA(ts7400) },
-        { ROT_CELESTRON, ROT_BACKEND_CELESTRON, ROT_FUNCNAMA(celestron) },
-        { ROT_ETHER6, ROT_BACKEND_ETHER6, ROT_FUNCNAMA(ether6) },
-        { 0, NULL }, /* end */
+        [ROT_DUMMY] = { ROT_DUMMY, ROT_BACKEND_DUMMY, ROT_FUNCNAMA(dummy) },
+        [ROT_EASYCOMM] = { ROT_EASYCOMM, ROT_BACKEND_EASYCOMM, ROT_FUNCNAMA(easycomm) },
+        [ROT_FODTRACK] = { ROT_FODTRACK, ROT_BACKEND_FODTRACK, ROT_FUNCNAMA(fodtrack) },
+        [ROT_ROTOREZ] = { ROT_ROTOREZ, ROT_BACKEND_ROTOREZ, ROT_FUNCNAMA(rotorez) },
+        [ROT_SARTEK] = { ROT_SARTEK, ROT_BACKEND_SARTEK, ROT_FUNCNAMA(sartek) },
+        [ROT_GS232A] = { ROT_GS232A, ROT_BACKEND_GS232A, ROT_FUNCNAMA(gs232a) },
+        [ROT_KIT] = { ROT_KIT, ROT_BACKEND_KIT, ROT_FUNCNAMA(kit) },
+        [ROT_HEATHKIT] = { ROT_HEATHKIT, ROT_BACKEND_HEATHKIT, ROT_FUNCNAMA(heathkit) },
+        [ROT_SPID] = { ROT_SPID, ROT_BACKEND_SPID, ROT_FUNCNAMA(spid) },
+        [ROT_M2] = { ROT_M2, ROT_BACKEND_M2, ROT_FUNCNAMA(m2) },
+        [ROT_ARS] = { ROT_ARS, ROT_BACKEND_ARS, ROT_FUNCNAMA(ars) },
+        [ROT_AMSAT] = { ROT_AMSAT, ROT_BACKEND_AMSAT, ROT_FUNCNAMA(amsat) },
+        [ROT_TS7400] = { ROT_TS7400, ROT_BACKEND_TS7400, ROT_FUNCNAMA(ts7400) },
+        [ROT_CELESTRON] = { ROT_CELESTRON, ROT_BACKEND_CELESTRON, ROT_FUNCNAMA(celestron) },
+        [ROT_ETHER6] = { ROT_ETHER6, ROT_BACKEND_ETHER6, ROT_FUNCNAMA(ether6) },
 };
 
+/* set once a backend init function has registered its models */
+static int rot_backend_loaded[ROT_BACKEND_MAX] = { 0, };
+
 // Apparently, no rotator can be probed.
 
 /*
@@ -121,32 +126,74 @@ static struct {
 
 
 /*
- * This struct to keep track of known rot models.
- * It is chained, and used in a hash table, see below.
+ * Registered caps are indexed directly by model number: each backend
+ * number owns a row of ROT_MODELS_PER_BACKEND slots, allocated the
+ * first time one of its models registers, so registering and looking
+ * up a model are O(1) whatever the number of models.
+ * Model numbers outside the rows, if any, are kept in a plain list.
  */
+#define ROT_MODELS_PER_BACKEND ROT_MAKE_MODEL(1, 0)
+#define ROT_INDEX_ROWS ROT_BACKEND_MAX
+
 struct rot_list {
 	const struct rot_caps *caps;
 	struct rot_list *next;
 };
 
-#define ROTLSTHASHSZ 16
-#define HASH_FUNC(a) ((a)%ROTLSTHASHSZ)
+static const struct rot_caps **rot_index[ROT_INDEX_ROWS] = { NULL, };
+static struct rot_list *rot_overflow = NULL;
 
 /*
- * The rot_hash_table is a hash table pointing to a list of next==NULL
- * 	terminated caps.
+ * Secondary index sorted by model name then manufacturer name,
+ * built on first use by rot_lookup_model() and dropped whenever
+ * the set of registered models changes.
  */
-static struct rot_list *rot_hash_table[ROTLSTHASHSZ] = { NULL, };
+static const struct rot_caps **rot_name_index = NULL;
+static int rot_name_count = 0;
 
 
 static int rot_lookup_backend(rot_model_t rot_model);
 
 /*
- * Basically, this is a hash insert function that doesn't check for dup!
+ * Return the index slot of rot_model, allocating its row if asked to.
+ * NULL means the model lives in the overflow list.
+ */
+static const struct rot_caps **rot_index_slot(rot_model_t rot_model, int alloc)
+{
+	int row;
+
+	if (rot_model < 0)
+		return NULL;
+
+	row = ROT_BACKEND_NUM(rot_model);
+	if (row >= ROT_INDEX_ROWS)
+		return NULL;
+
+	if (!rot_index[row]) {
+		if (!alloc)
+			return NULL;
+		rot_index[row] = calloc(ROT_MODELS_PER_BACKEND,
+					sizeof(const struct rot_caps *));
+		if (!rot_index[row])
+			return NULL;
+	}
+
+	return &rot_index[row][rot_model - ROT_MAKE_MODEL(row, 0)];
+}
+
+static void rot_name_index_reset(void)
+{
+	free(rot_name_index);
+	rot_name_index = NULL;
+	rot_name_count = 0;
+}
+
+/*
+ * Insert caps in the model index, rejecting duplicates.
  */
 int HAMLIB_API rot_register(const struct rot_caps *caps)
 {
-	int hval;
+	const struct rot_caps **slot;
 	struct rot_list *p;
 
 	if (!caps)
@@ -159,32 +206,43 @@ int HAMLIB_API rot_register(const struct rot_caps *caps)
 		return -RIG_EINVAL;
 #endif
 
-	p = (struct rot_list*)malloc(sizeof(struct rot_list));
-	if (!p)
-		return -RIG_ENOMEM;
+	slot = rot_index_slot(caps->rot_model, 1);
+	if (slot) {
+		*slot = caps;
+	} else {
+		p = (struct rot_list*)malloc(sizeof(struct rot_list));
+		if (!p)
+			return -RIG_ENOMEM;
+
+		p->caps = caps;
+		p->next = rot_overflow;
+		rot_overflow = p;
+	}
 
-	hval = HASH_FUNC(caps->rot_model);
-	p->caps = caps;
-	// p->handle = NULL;
-	p->next = rot_hash_table[hval];
-	rot_hash_table[hval] = p;
+	rot_name_index_reset();
 
 	return RIG_OK;
 }
 
 /*
  * Get rot capabilities.
- * ie. rot_hash_table lookup
+ * ie. rot_index lookup
  */
 
 const struct rot_caps * HAMLIB_API rot_get_caps(rot_model_t rot_model)
 {
+	const struct rot_caps **slot;
 	struct rot_list *p;
 
-	for (p = rot_hash_table[HASH_FUNC(rot_model)]; p; p=p->next) {
+	slot = rot_index_slot(rot_model, 0);
+	if (slot)
+		return *slot;
+
+	for (p = rot_overflow; p; p=p->next) {
 		if (p->caps->rot_model == rot_model)
 			return p->caps;
 	}
+
 	return NULL;	/* sorry, caps not registered! */
 }
 
@@ -195,14 +253,34 @@ const struct rot_caps * HAMLIB_API rot_get_caps(rot_model_t rot_model)
  */
 static int rot_lookup_backend(rot_model_t rot_model)
 {
-	int i;
+	int be_num = ROT_BACKEND_NUM(rot_model);
 
-	for (i=0; i<ROT_BACKEND_MAX && rot_backend_list[i].be_name; i++) {
-		if (ROT_BACKEND_NUM(rot_model) ==
-				rot_backend_list[i].be_num)
-			return i;
-	}
-	return -1;
+	if (rot_model < 0 || be_num >= ROT_BACKEND_MAX ||
+			!rot_backend_list[be_num].be_name)
+		return -1;
+
+	return be_num;
+}
+
+/*
+ * initialize a backend from its rot_backend_list index,
+ * unless it has already registered its models
+ */
+static int rot_init_backend(int be_idx)
+{
+	int retval;
+
+	if (rot_backend_loaded[be_idx])
+		return RIG_OK;
+
+	if (!rot_backend_list[be_idx].be_init)
+		return -RIG_EINVAL;
+
+	retval = (*rot_backend_list[be_idx].be_init)(NULL);
+	if (retval == RIG_OK)
+		rot_backend_loaded[be_idx] = 1;
+
+	return retval;
 }
 
 /*
@@ -234,7 +312,13 @@ int HAMLIB_API rot_check_backend(rot_model_t rot_model)
 		return -RIG_ENAVAIL;
 	}
 
-	retval = rot_load_backend(rot_backend_list[be_idx].be_name);
+	/*
+	 * Backend already there, but it doesn't know this model
+	 */
+	if (rot_backend_loaded[be_idx])
+		return -RIG_ENAVAIL;
+
+	retval = rot_init_backend(be_idx);
 
 	return retval;
 }
@@ -243,45 +327,153 @@ int HAMLIB_API rot_check_backend(rot_model_t rot_model)
 
 int HAMLIB_API rot_unregister(rot_model_t rot_model)
 {
-	int hval;
+	const struct rot_caps **slot;
 	struct rot_list *p,*q;
 
-	hval = HASH_FUNC(rot_model);
+	slot = rot_index_slot(rot_model, 0);
+	if (slot && *slot) {
+		*slot = NULL;
+		rot_name_index_reset();
+		return RIG_OK;
+	}
+
 	q = NULL;
-	for (p = rot_hash_table[hval]; p; p=p->next) {
+	for (p = rot_overflow; p; p=p->next) {
 		if (p->caps->rot_model == rot_model) {
 			if (q == NULL)
-				rot_hash_table[hval] = p->next;
+				rot_overflow = p->next;
 			else
 				q->next = p->next;
+
 			free(p);
+			rot_name_index_reset();
 			return RIG_OK;
 		}
 		q = p;
 	}
+
 	return -RIG_EINVAL;	/* sorry, caps not registered! */
 }
 
 /*
  * rot_list_foreach
- * executes cfunc on all the elements stored in the rot hash list
+ * executes cfunc on all the registered caps, in model order
  */
 int HAMLIB_API rot_list_foreach(int (*cfunc)(const struct rot_caps*, rig_ptr_t),rig_ptr_t data)
 {
 	struct rot_list *p;
-	int i;
+	int i, j;
 
 	if (!cfunc)
 		return -RIG_EINVAL;
 
-	for (i=0; i<ROTLSTHASHSZ; i++) {
-		for (p=rot_hash_table[i]; p; p=p->next)
-			if ((*cfunc)(p->caps,data) == 0)
+	for (i=0; i<ROT_INDEX_ROWS; i++) {
+		if (!rot_index[i])
+			continue;
+		for (j=0; j<ROT_MODELS_PER_BACKEND; j++) {
+			if (rot_index[i][j] && (*cfunc)(rot_index[i][j],data) == 0)
 				return RIG_OK;
+		}
 	}
+
+	for (p=rot_overflow; p; p=p->next)
+		if ((*cfunc)(p->caps,data) == 0)
+			return RIG_OK;
+
 	return RIG_OK;
 }
 
+static int rot_name_cmp(const char *a, const char *b)
+{
+	int ca, cb;
+
+	if (!a || !b)
+		return a ? 1 : (b ? -1 : 0);
+
+	do {
+		ca = tolower((unsigned char)*a++);
+		cb = tolower((unsigned char)*b++);
+	} while (ca && ca == cb);
+
+	return ca - cb;
+}
+
+static int rot_caps_name_cmp(const void *a, const void *b)
+{
+	const struct rot_caps *ca = *(const struct rot_caps * const *)a;
+	const struct rot_caps *cb = *(const struct rot_caps * const *)b;
+	int ret;
+
+	ret = rot_name_cmp(ca->model_name, cb->model_name);
+	if (ret)
+		return ret;
+
+	return rot_name_cmp(ca->mfg_name, cb->mfg_name);
+}
+
+static int rot_name_index_add(const struct rot_caps *caps, rig_ptr_t data)
+{
+	if (data)
+		rot_name_index[rot_name_count] = caps;
+	rot_name_count++;
+	return 1;	/* continue */
+}
+
+/**
+ * \brief find a rotator model by its names
+ * \param mfg_name	manufacturer name, may be NULL to match any
+ * \param model_name	model name
+ *
+ * Looks up a registered model by name, ignoring case. Only loaded
+ * backends are searched, see rot_load_all_backends().
+ *
+ * \return the model number, or ROT_MODEL_NONE if not found.
+ */
+rot_model_t HAMLIB_API rot_lookup_model(const char *mfg_name, const char *model_name)
+{
+	int lo, hi, mid;
+
+	if (!model_name)
+		return ROT_MODEL_NONE;
+
+	if (!rot_name_index) {
+		rot_name_count = 0;
+		rot_list_foreach(rot_name_index_add, NULL);
+		if (rot_name_count == 0)
+			return ROT_MODEL_NONE;
+
+		rot_name_index = calloc(rot_name_count, sizeof(const struct rot_caps *));
+		if (!rot_name_index) {
+			rot_name_count = 0;
+			return ROT_MODEL_NONE;
+		}
+		rot_name_count = 0;
+		rot_list_foreach(rot_name_index_add, (rig_ptr_t)rot_name_index);
+
+		qsort(rot_name_index, rot_name_count, sizeof(const struct rot_caps *),
+				rot_caps_name_cmp);
+	}
+
+	/* first entry whose model name is not below model_name */
+	lo = 0;
+	hi = rot_name_count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (rot_name_cmp(rot_name_index[mid]->model_name, model_name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < rot_name_count &&
+			!rot_name_cmp(rot_name_index[lo]->model_name, model_name); lo++) {
+		if (!mfg_name || !rot_name_cmp(rot_name_index[lo]->mfg_name, mfg_name))
+			return rot_name_index[lo]->rot_model;
+	}
+
+	return ROT_MODEL_NONE;
+}
+
 /*
  * rot_probe_all
  * called straight by rot_probe
@@ -291,7 +483,7 @@ rot_model_t HAMLIB_API rot_probe_all(hamlib_port_t *p)
 	int i;
 	rot_model_t rot_model;
 
-	for (i=0; i<ROT_BACKEND_MAX && rot_backend_list[i].be_name; i++) {
+	for (i=0; i<ROT_BACKEND_MAX; i++) {
 		if (rot_backend_list[i].be_probe) {
 			rot_model = (*rot_backend_list[i].be_probe)(p);
 			if (rot_model != ROT_MODEL_NONE)
@@ -306,8 +498,9 @@ int rot_load_all_backends()
 {
 	int i;
 
-	for (i=0; i<ROT_BACKEND_MAX && rot_backend_list[i].be_name; i++) {
-		rot_load_backend(rot_backend_list[i].be_name);
+	for (i=0; i<ROT_BACKEND_MAX; i++) {
+		if (rot_backend_list[i].be_name)
+			rot_init_backend(i);
 	}
 	return RIG_OK;
 }
@@ -318,21 +511,12 @@ int rot_load_all_backends()
  */
 int HAMLIB_API rot_load_backend(const char *be_name)
 {
-	int status;
-	int (*be_init)(rig_ptr_t);
 	int i;
 
-	for (i=0; i<ROT_BACKEND_MAX && rot_backend_list[i].be_name; i++) {
-		if (!strcmp(be_name, rot_backend_list[i].be_name)) {
-			be_init = rot_backend_list[i].be_init;
-			if( be_init == NULL )
-			{
-				printf("Null\n");
-				return -EINVAL;
-			}
-			status = (*be_init)(NULL);
- 			return status;
-		}
+	for (i=0; i<ROT_BACKEND_MAX; i++) {
+		if (rot_backend_list[i].be_name &&
+				!strcmp(be_name, rot_backend_list[i].be_name))
+			return rot_init_backend(i);
 	}
 
 	return -EINVAL;
@@ -323,6 +323,7 @@ int HAMLIB_API rot_open(ROT *rot)
 		if (status < 0)
 			return -RIG_EIO;
 		rs->rotport.fd = status;
+		rs->rotport.rxbuf = NULL;
 		break;
 
 	case RIG_PORT_USB:
@@ -423,6 +424,7 @@ int HAMLIB_API rot_close(ROT *rot)
 			close(rs->rotport.fd);
 		}
 		rs->rotport.fd = -1;
+		port_rx_free(&rs->rotport);
 	}
 
 	remove_opened_rot(rot);
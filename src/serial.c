@@ -110,6 +110,8 @@ int HAMLIB_API serial_open(hamlib_port_t *rp) {
   }
 
   rp->fd = fd;
+  /* a closed port owns no buffer, whatever the caller left in there */
+  rp->rxbuf = NULL;
 
   err = serial_setup(rp);
   if (err != RIG_OK) {
@@ -396,6 +398,9 @@ int HAMLIB_API serial_setup(hamlib_port_t *rp)
  */
 int HAMLIB_API serial_flush(hamlib_port_t *p )
 {
+  /* drop what has already been read ahead too */
+  port_rx_discard(p);
+
   tcflush(p->fd, TCIFLUSH);
 
   return RIG_OK;
@@ -418,6 +423,8 @@ int ser_open(hamlib_port_t *p)
  */
 int ser_close(hamlib_port_t *p)
 {
+	port_rx_free(p);
+
 	return CLOSE(p->fd);
 }
 
@@ -47,6 +47,8 @@
 
 #include "hamlib/rig.h"
 #include "cal.h"
+#include "cache.h"
+#include "event.h"
 
 
 #ifndef DOC_HIDDEN
@@ -82,25 +84,29 @@ int HAMLIB_API rig_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_level == NULL || !rig_has_set_level(rig,level))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_level(rig, vfo, level, val);
+		RIG_UNLOCK_RETURN(rig, caps->set_level(rig, vfo, level, val));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_level(rig, vfo, level, val);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -136,10 +142,12 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 	if (CHECK_RIG_ARG(rig) || !val)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_level == NULL || !rig_has_get_level(rig,level))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	/*
 	 * Special case(frontend emulation): calibrated S-meter reading
@@ -153,26 +161,26 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 
 		retcode = rig_get_level(rig, vfo, RIG_LEVEL_RAWSTR, &rawstr);
 		if (retcode != RIG_OK)
-			return retcode;
+			RIG_UNLOCK_RETURN(rig, retcode);
 		val->i = (int)rig_raw2val(rawstr.i, &rig->state.str_cal);
-		return RIG_OK;
+		RIG_UNLOCK_RETURN(rig, RIG_OK);
 	}
 
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_level(rig, vfo, level, val);
+		RIG_UNLOCK_RETURN(rig, caps->get_level(rig, vfo, level, val));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_level(rig, vfo, level, val);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -196,10 +204,14 @@ int HAMLIB_API rig_set_parm(RIG *rig, setting_t parm, value_t val)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	if (rig->caps->set_parm == NULL || !rig_has_set_parm(rig,parm))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->set_parm(rig, parm, val);
+	RIG_UNLOCK_RETURN(rig, rig->caps->set_parm(rig, parm, val));
 }
 
 /**
@@ -223,10 +235,12 @@ int HAMLIB_API rig_get_parm(RIG *rig, setting_t parm, value_t *val)
 	if (CHECK_RIG_ARG(rig) || !val)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	if (rig->caps->get_parm == NULL || !rig_has_get_parm(rig,parm))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->get_parm(rig, parm, val);
+	RIG_UNLOCK_RETURN(rig, rig->caps->get_parm(rig, parm, val));
 }
 
 /**
@@ -403,25 +417,29 @@ int HAMLIB_API rig_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_func == NULL || !rig_has_set_func(rig,func))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_FUNC) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_func(rig, vfo, func, status);
+		RIG_UNLOCK_RETURN(rig, caps->set_func(rig, vfo, func, status));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_func(rig, vfo, func, status);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -452,25 +470,27 @@ int HAMLIB_API rig_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
 	if (CHECK_RIG_ARG(rig) || !func)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_func == NULL || !rig_has_get_func(rig,func))
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_FUNC) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_func(rig, vfo, func, status);
+		RIG_UNLOCK_RETURN(rig, caps->get_func(rig, vfo, func, status));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_func(rig, vfo, func, status);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -497,25 +517,29 @@ int HAMLIB_API rig_set_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t val
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_ext_level == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 		vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_ext_level(rig, vfo, token, val);
+		RIG_UNLOCK_RETURN(rig, caps->set_ext_level(rig, vfo, token, val));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_ext_level(rig, vfo, token, val);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -542,25 +566,27 @@ int HAMLIB_API rig_get_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t *va
 	if (CHECK_RIG_ARG(rig) || !val)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_ext_level == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_PURE) ||
 		vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_ext_level(rig, vfo, token, val);
+		RIG_UNLOCK_RETURN(rig, caps->get_ext_level(rig, vfo, token, val));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_ext_level(rig, vfo, token, val);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -582,10 +608,14 @@ int HAMLIB_API rig_set_ext_parm(RIG *rig, token_t token, value_t val)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	if (rig->caps->set_ext_parm == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->set_ext_parm(rig, token, val);
+	RIG_UNLOCK_RETURN(rig, rig->caps->set_ext_parm(rig, token, val));
 }
 
 /**
@@ -607,10 +637,12 @@ int HAMLIB_API rig_get_ext_parm(RIG *rig, token_t token, value_t *val)
 	if (CHECK_RIG_ARG(rig) || !val)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	if (rig->caps->get_ext_parm == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
-	return rig->caps->get_ext_parm(rig, token, val);
+	RIG_UNLOCK_RETURN(rig, rig->caps->get_ext_parm(rig, token, val));
 }
 
 
@@ -625,14 +657,22 @@ int HAMLIB_API rig_get_ext_parm(RIG *rig, token_t token, value_t *val)
  */
 int HAMLIB_API rig_setting2idx(setting_t s)
 {
-	int i;
+	/* only the bits below RIG_SETTING_MAX are settings */
+	s &= rig_idx2setting(RIG_SETTING_MAX - 1) * 2 - 1;
+	if (!s)
+		return 0;
 
-	for (i = 0; i<RIG_SETTING_MAX; i++) {
-		if (s & rig_idx2setting(i))
-			return i;
-	}
+#ifdef __GNUC__
+	return __builtin_ctzl(s);
+#else
+	{
+		int i;
 
-	return 0;
+		for (i = 0; !(s & rig_idx2setting(i)); i++)
+			;
+		return i;
+	}
+#endif
 }
 
 /*! @} */
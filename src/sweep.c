@@ -0,0 +1,285 @@
+/*
+ *  Hamlib Interface - frequency sweep
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file sweep.c
+ * \brief Frequency sweep
+ *
+ * rig_sweep() steps the rig over a frequency range and reads a level,
+ * e.g. SWR, at each point.  Rather than waiting a fixed time before
+ * each reading, the level is read until two consecutive readings
+ * agree, and the time this took becomes the wait of the next point.
+ * Each result is handed to the caller only once the next frequency is
+ * set, so that the rig settles while the caller deals with it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <hamlib/rig.h>
+
+
+#ifndef DOC_HIDDEN
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+#define SWEEP_POLL_MS 5		/* pause between two unsettled readings */
+
+/* milliseconds from an arbitrary origin, immune to clock changes */
+static unsigned long sweep_now_ms(void)
+{
+	struct timeval tv;
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+#endif
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+}
+
+static void sweep_wait_until(unsigned long deadline)
+{
+	unsigned long now = sweep_now_ms();
+
+	if ((long)(deadline - now) > 0)
+		usleep((deadline - now) * 1000);
+}
+
+static int level_settled(setting_t level, value_t a, value_t b, float settle)
+{
+	if (RIG_LEVEL_IS_FLOAT(level))
+		return a.f - b.f <= settle && b.f - a.f <= settle;
+
+	return abs(a.i - b.i) <= (int)settle;
+}
+
+/*
+ * Read the level of the point, waiting for it to settle.
+ * The frequency was set at time t0, *dwell is the expected settle
+ * time, updated with the measured one.
+ */
+static void sweep_read(RIG *rig, vfo_t vfo, const rig_sweep_t *sweep,
+		rig_sweep_point_t *point, unsigned long t0, int *dwell)
+{
+	value_t prev;
+	unsigned long stamp, settled_at;
+	int unsettled = 0;
+
+	sweep_wait_until(t0 + *dwell);
+
+	point->status = rig_get_level(rig, vfo, sweep->level, &point->val);
+	stamp = sweep_now_ms() - t0;
+
+	/* fixed dwell, nothing to measure */
+	if (sweep->dwell_max <= sweep->dwell_min || point->status != RIG_OK) {
+		point->dwell = stamp;
+		return;
+	}
+
+	for (;;) {
+		prev = point->val;
+		settled_at = stamp;
+		point->status = rig_get_level(rig, vfo, sweep->level, &point->val);
+		if (point->status != RIG_OK)
+			break;
+		stamp = sweep_now_ms() - t0;
+		if (level_settled(sweep->level, prev, point->val, sweep->settle))
+			break;
+		if (stamp >= (unsigned long)sweep->dwell_max) {
+			settled_at = stamp;
+			break;
+		}
+		unsettled++;
+		usleep(SWEEP_POLL_MS * 1000);
+	}
+
+	point->dwell = settled_at;
+
+	/*
+	 * wait longer at once when the first reading was too early,
+	 * shorter a little at a time
+	 */
+	if (unsettled)
+		*dwell = settled_at;
+	else
+		*dwell -= (*dwell - sweep->dwell_min) / 8;
+
+	if (*dwell > sweep->dwell_max)
+		*dwell = sweep->dwell_max;
+}
+
+#endif	/* !DOC_HIDDEN */
+
+
+/**
+ * \brief number of points of a sweep
+ * \param sweep	The sweep description
+ *
+ *  Gives the size of the array of results to pass to rig_sweep().
+ *
+ * \return the number of points, otherwise a negative value if the
+ * description is not valid.
+ *
+ * \sa rig_sweep()
+ */
+int HAMLIB_API rig_sweep_count(const rig_sweep_t *sweep)
+{
+	double n;
+
+	if (!sweep || sweep->step <= 0 || sweep->stop < sweep->start)
+		return -RIG_EINVAL;
+
+	/* tolerate rounding of the last step */
+	n = (sweep->stop - sweep->start) / sweep->step + 1e-6;
+	if (n >= 0x7fffffff)
+		return -RIG_EINVAL;
+
+	return (int)n + 1;
+}
+
+/**
+ * \brief sweep a frequency range, reading a level
+ * \param rig	The rig handle
+ * \param vfo	The target VFO
+ * \param sweep	The sweep description
+ * \param points	The preallocated array where to store the results
+ * \param max	The number of entries in \a points
+ * \param cb	Optional callback, called with each point
+ * \param arg	Argument passed to \a cb
+ *
+ *  Sets the frequencies from \a sweep->start to \a sweep->stop, by
+ *  \a sweep->step, and reads \a sweep->level at each one.  The reading
+ *  is taken no sooner than \a sweep->dwell_min milliseconds after the
+ *  frequency is set, then repeated until it changes by no more than
+ *  \a sweep->settle, for at most \a sweep->dwell_max milliseconds.  The
+ *  time this took is waited before the first reading of the next point.
+ *  A \a sweep->dwell_max not above \a sweep->dwell_min means a fixed
+ *  wait and a single reading.
+ *
+ *  With RIG_SWEEP_PTT, the rig transmits during the reading, and with
+ *  RIG_SWEEP_KEEP_TX too, stays in transmit while changing frequency.
+ *  Only use the latter where transmitting across the range is legal.
+ *
+ *  \a cb is called with each point once the frequency of the next one
+ *  has been set, and may abort the sweep by returning 0.
+ *
+ *  A failed reading is recorded in the status of its point, and does not
+ *  stop the sweep.
+ *
+ * \return the number of points stored, otherwise a negative value if
+ * an error occured (in which case, cause is set appropriately).
+ *
+ * \sa rig_sweep_count()
+ */
+int HAMLIB_API rig_sweep(RIG *rig, vfo_t vfo, const rig_sweep_t *sweep,
+		rig_sweep_point_t points[], int max, sweep_cb_t cb, rig_ptr_t arg)
+{
+	int ptt = sweep ? (sweep->flags & RIG_SWEEP_PTT) : 0;
+	int keep_tx = ptt && (sweep->flags & RIG_SWEEP_KEEP_TX);
+	int count, n, retval = RIG_OK;
+	int dwell;
+	unsigned long t0;
+
+	if (CHECK_RIG_ARG(rig) || !points || max <= 0)
+		return -RIG_EINVAL;
+
+	count = rig_sweep_count(sweep);
+	if (count < 0 || sweep->dwell_min < 0)
+		return -RIG_EINVAL;
+	if (count > max)
+		count = max;
+
+	if (!rig_has_get_level(rig, sweep->level))
+		return -RIG_ENAVAIL;
+
+	dwell = sweep->dwell_min;
+
+	points[0].freq = sweep->start;
+	retval = rig_set_freq(rig, vfo, points[0].freq);
+	if (retval != RIG_OK)
+		return retval;
+	t0 = sweep_now_ms();
+
+	if (keep_tx) {
+		retval = rig_set_ptt(rig, vfo, RIG_PTT_ON);
+		if (retval != RIG_OK)
+			return retval;
+	}
+
+	for (n = 0; n < count; n++) {
+		if (ptt && !keep_tx) {
+			retval = rig_set_ptt(rig, vfo, RIG_PTT_ON);
+			if (retval != RIG_OK)
+				break;
+			t0 = sweep_now_ms();
+		}
+
+		sweep_read(rig, vfo, sweep, &points[n], t0, &dwell);
+
+		if (ptt && !keep_tx) {
+			retval = rig_set_ptt(rig, vfo, RIG_PTT_OFF);
+			if (retval != RIG_OK)
+				break;
+		}
+
+		/* next frequency first, the rig settles meanwhile */
+		if (n + 1 < count) {
+			points[n + 1].freq = sweep->start + (n + 1) * sweep->step;
+			retval = rig_set_freq(rig, vfo, points[n + 1].freq);
+			if (retval != RIG_OK)
+				break;
+			t0 = sweep_now_ms();
+		}
+
+		if (cb && !cb(rig, &points[n], arg)) {
+			n++;
+			break;
+		}
+	}
+
+	if (ptt && (keep_tx || retval != RIG_OK))
+		rig_set_ptt(rig, vfo, RIG_PTT_OFF);
+
+	if (retval != RIG_OK) {
+		rig_debug(RIG_DEBUG_ERR, "%s: stopped after %d points: %s\n",
+				__func__, n, rigerror(retval));
+		return retval;
+	}
+
+	return n;
+}
+
+/** @} */
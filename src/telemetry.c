@@ -0,0 +1,253 @@
+/*
+ *  Hamlib Interface - level telemetry
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file telemetry.c
+ * \brief Level telemetry
+ *
+ * Meters like STRENGTH or SWR are often wanted at a steady rate by
+ * several consumers at once.  Instead of each of them reading the rig,
+ * one sampler calls rig_telemetry_sample() on its own schedule, and
+ * the timestamped samples are kept in a ring buffer from which any
+ * number of readers fetch them with rig_telemetry_read(), each one at
+ * its own pace.
+ *
+ * The ring buffer, the same as the event queue's, has a single
+ * producer, the sampler, and is lock free.  The oldest samples are
+ * overwritten when it is full: a reader lagging behind loses them,
+ * and sees a gap in the sample numbers.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <hamlib/rig.h>
+
+#include "ring.h"
+
+#ifndef DOC_HIDDEN
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+struct rig_tlm {
+	setting_t levels;		/* levels read by each sampling pass */
+	struct rig_ring ring;		/* of rig_telemetry_t, oldest overwritten */
+};
+
+/* time from an arbitrary origin, immune to clock changes */
+static void tlm_now(rig_telemetry_t *s)
+{
+	struct timeval tv;
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		s->ts_sec = ts.tv_sec;
+		s->ts_nsec = ts.tv_nsec;
+		return;
+	}
+#endif
+
+	gettimeofday(&tv, NULL);
+	s->ts_sec = tv.tv_sec;
+	s->ts_nsec = tv.tv_usec * 1000;
+}
+
+#endif	/* !DOC_HIDDEN */
+
+
+/**
+ * \brief set up the level telemetry
+ * \param rig	The rig handle
+ * \param levels	The levels to sample, e.g. RIG_LEVEL_STRENGTH|RIG_LEVEL_SWR,
+ * 		0 to remove the telemetry
+ * \param size	The number of samples to keep, rounded up to a power of 2
+ *
+ *  Installs the ring buffer filled by rig_telemetry_sample(), dropping
+ *  any previous one.  Only the levels the rig can read are kept.
+ *
+ *  The telemetry must be set up or removed while neither sampled nor read.
+ *
+ * \return RIG_OK if the operation has been sucessful, otherwise
+ * a negative value if an error occured (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_telemetry_sample(), rig_telemetry_read()
+ */
+int HAMLIB_API rig_telemetry_setup(RIG *rig, setting_t levels, int size)
+{
+	struct rig_tlm *q;
+
+	if (!rig || !rig->caps || size < 0)
+		return -RIG_EINVAL;
+
+	q = rig->state.telemetry;
+	if (q) {
+		rig->state.telemetry = NULL;
+		ring_free(&q->ring);
+		free(q);
+	}
+
+	if (levels == 0 || size == 0)
+		return RIG_OK;
+
+	levels &= rig->state.has_get_level;
+	if (levels == 0)
+		return -RIG_ENAVAIL;
+
+	q = calloc(1, sizeof(struct rig_tlm));
+	if (!q)
+		return -RIG_ENOMEM;
+
+	if (ring_init(&q->ring, size, sizeof(rig_telemetry_t)) != RIG_OK) {
+		free(q);
+		return -RIG_ENOMEM;
+	}
+
+	q->levels = levels;
+
+	rig->state.telemetry = q;
+
+	return RIG_OK;
+}
+
+/**
+ * \brief sample the telemetry levels
+ * \param rig	The rig handle
+ *
+ *  Reads once each level set up with rig_telemetry_setup(), and stores
+ *  the values in the ring buffer, each one stamped with a monotonic
+ *  time taken right after it has been read.
+ *
+ *  This is to be called at the wanted rate by a single sampler, in turn
+ *  with the other accesses to the rig.
+ *
+ * \return the number of samples stored, otherwise a negative value if
+ * an error occured (in which case, cause is set appropriately).
+ *
+ * \sa rig_telemetry_setup(), rig_telemetry_read()
+ */
+int HAMLIB_API rig_telemetry_sample(RIG *rig)
+{
+	struct rig_tlm *q;
+	rig_telemetry_t s;
+	int i, retval, count = 0, err = RIG_OK;
+
+	if (CHECK_RIG_ARG(rig))
+		return -RIG_EINVAL;
+
+	q = rig->state.telemetry;
+	if (!q)
+		return -RIG_EINVAL;
+
+	for (i = 0; i < RIG_SETTING_MAX; i++) {
+		s.level = rig_idx2setting(i);
+		if (!(q->levels & s.level))
+			continue;
+
+		retval = rig_get_level(rig, RIG_VFO_CURR, s.level, &s.val);
+		if (retval != RIG_OK) {
+			err = retval;
+			continue;
+		}
+
+		tlm_now(&s);
+		s.seq = q->ring.tail;	/* single producer */
+		ring_push(&q->ring, &s, 1);
+		count++;
+	}
+
+	return count > 0 ? count : err;
+}
+
+/**
+ * \brief read the telemetry samples
+ * \param rig	The rig handle
+ * \param cursor	The reader position, the number of the next sample
+ * 		to read, updated on return
+ * \param samples	The location where to store the samples
+ * \param max	The number of entries in \a samples
+ *
+ *  Reads, without blocking, the samples stored since the one numbered
+ *  \a *cursor, oldest first.  Each reader keeps its own cursor.  When
+ *  the reader lags behind, the overwritten samples are skipped, which
+ *  shows as a gap in the sample numbers.
+ *
+ *  Called with \a max equal to 0, sets \a *cursor to the next sample to
+ *  be stored, so that only the samples to come will be read.
+ *
+ *  It may be called from several threads at once, and concurrently with
+ *  rig_telemetry_sample().
+ *
+ * \return the number of samples stored in \a samples, otherwise a
+ * negative value if an error occured.
+ *
+ * \sa rig_telemetry_setup(), rig_telemetry_sample()
+ */
+int HAMLIB_API rig_telemetry_read(RIG *rig, unsigned long *cursor,
+		rig_telemetry_t samples[], int max)
+{
+	struct rig_tlm *q;
+	unsigned long head;
+	int n = 0;
+
+	if (!rig || !cursor || max < 0 || (max > 0 && !samples))
+		return -RIG_EINVAL;
+
+	q = rig->state.telemetry;
+	if (!q)
+		return -RIG_EINVAL;
+
+	head = q->ring.tail;
+	__sync_synchronize();
+
+	if (max == 0) {
+		*cursor = head;
+		return 0;
+	}
+
+	/* skip what has been overwritten already */
+	if (head - *cursor > q->ring.mask + 1)
+		*cursor = head - (q->ring.mask + 1);
+
+	while (n < max && *cursor != head) {
+		/* keep it only if not overwritten meanwhile */
+		if (ring_read(&q->ring, *cursor, &samples[n]))
+			n++;
+
+		(*cursor)++;
+	}
+
+	return n;
+}
+
+/** @} */
@@ -98,6 +98,14 @@
 #define TOK_POLL_INTERVAL	TOKEN_FRONTEND(111)
 /** \brief rig: International Telecommunications Union region no. */
 #define TOK_ITU_REGION	TOKEN_FRONTEND(120)
+/** \brief rig: validity of the cached frequency, in ms */
+#define TOK_CACHE_FREQ_TIMEOUT	TOKEN_FRONTEND(130)
+/** \brief rig: validity of the cached mode and passband, in ms */
+#define TOK_CACHE_MODE_TIMEOUT	TOKEN_FRONTEND(131)
+/** \brief rig: validity of the cached current VFO, in ms */
+#define TOK_CACHE_VFO_TIMEOUT	TOKEN_FRONTEND(132)
+/** \brief rig: validity of the cached command replies, in ms */
+#define TOK_CACHE_RESP_TIMEOUT	TOKEN_FRONTEND(133)
 /*
  * rotator specific tokens
  * (strictly, should be documented as rotator_internal)
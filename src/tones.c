@@ -38,6 +38,8 @@
 
 #include "hamlib/rig.h"
 #include "tones.h"
+#include "cache.h"
+#include "event.h"
 
 #if !defined(_WIN32) && !defined(__CYGWIN__)
 
@@ -107,25 +109,29 @@ int HAMLIB_API rig_set_ctcss_tone(RIG *rig, vfo_t vfo, tone_t tone)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_ctcss_tone == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_ctcss_tone(rig, vfo, tone);
+		RIG_UNLOCK_RETURN(rig, caps->set_ctcss_tone(rig, vfo, tone));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_ctcss_tone(rig, vfo, tone);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -156,25 +162,27 @@ int HAMLIB_API rig_get_ctcss_tone(RIG *rig, vfo_t vfo, tone_t *tone)
 	if (CHECK_RIG_ARG(rig) || !tone)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_ctcss_tone == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_ctcss_tone(rig, vfo, tone);
+		RIG_UNLOCK_RETURN(rig, caps->get_ctcss_tone(rig, vfo, tone));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_ctcss_tone(rig, vfo, tone);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -201,25 +209,29 @@ int HAMLIB_API rig_set_dcs_code(RIG *rig, vfo_t vfo, tone_t code)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_dcs_code == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_dcs_code(rig, vfo, code);
+		RIG_UNLOCK_RETURN(rig, caps->set_dcs_code(rig, vfo, code));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_dcs_code(rig, vfo, code);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -245,25 +257,27 @@ int HAMLIB_API rig_get_dcs_code(RIG *rig, vfo_t vfo, tone_t *code)
 	if (CHECK_RIG_ARG(rig) || !code)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_dcs_code == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_dcs_code(rig, vfo, code);
+		RIG_UNLOCK_RETURN(rig, caps->get_dcs_code(rig, vfo, code));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_dcs_code(rig, vfo, code);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -298,25 +312,29 @@ int HAMLIB_API rig_set_ctcss_sql(RIG *rig, vfo_t vfo, tone_t tone)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_ctcss_sql == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 				vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_ctcss_sql(rig, vfo, tone);
+		RIG_UNLOCK_RETURN(rig, caps->set_ctcss_sql(rig, vfo, tone));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_ctcss_sql(rig, vfo, tone);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -347,25 +365,27 @@ int HAMLIB_API rig_get_ctcss_sql(RIG *rig, vfo_t vfo, tone_t *tone)
 	if (CHECK_RIG_ARG(rig) || !tone)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_ctcss_sql == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_ctcss_sql(rig, vfo, tone);
+		RIG_UNLOCK_RETURN(rig, caps->get_ctcss_sql(rig, vfo, tone));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_ctcss_sql(rig, vfo, tone);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -392,25 +412,29 @@ int HAMLIB_API rig_set_dcs_sql(RIG *rig, vfo_t vfo, tone_t code)
 	if (CHECK_RIG_ARG(rig))
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
+	rig_cache_invalidate(rig);
+
 	caps = rig->caps;
 
 	if (caps->set_dcs_sql == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->set_dcs_sql(rig, vfo, code);
+		RIG_UNLOCK_RETURN(rig, caps->set_dcs_sql(rig, vfo, code));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->set_dcs_sql(rig, vfo, code);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /**
@@ -436,25 +460,27 @@ int HAMLIB_API rig_get_dcs_sql(RIG *rig, vfo_t vfo, tone_t *code)
 	if (CHECK_RIG_ARG(rig) || !code)
 		return -RIG_EINVAL;
 
+	rig_port_lock(rig);
+
 	caps = rig->caps;
 
 	if (caps->get_dcs_sql == NULL)
-		return -RIG_ENAVAIL;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENAVAIL);
 
 	if ((caps->targetable_vfo&RIG_TARGETABLE_TONE) ||
 			vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo)
-		return caps->get_dcs_sql(rig, vfo, code);
+		RIG_UNLOCK_RETURN(rig, caps->get_dcs_sql(rig, vfo, code));
 
 	if (!caps->set_vfo)
-		return -RIG_ENTARGET;
+		RIG_UNLOCK_RETURN(rig, -RIG_ENTARGET);
 	curr_vfo = rig->state.current_vfo;
 	retcode = caps->set_vfo(rig, vfo);
 	if (retcode != RIG_OK)
-		return retcode;
+		RIG_UNLOCK_RETURN(rig, retcode);
 
 	retcode = caps->get_dcs_sql(rig, vfo, code);
 	caps->set_vfo(rig, curr_vfo);
-	return retcode;
+	RIG_UNLOCK_RETURN(rig, retcode);
 }
 
 /*! @} */
@@ -0,0 +1,110 @@
+/*
+ * cmd_index.c - (C) The Hamlib Group 2026
+ *
+ * Command dispatch index shared by rigctl_parse.c and rotctl_parse.c.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_index.h"
+
+/* Hash table implementation See:  http://uthash.sourceforge.net/ */
+#include "uthash.h"
+
+struct cmd_name {
+	const char *name;
+	const void *entry;
+	UT_hash_handle hh;
+};
+
+#define CMD_ENTRY(idx, i) \
+	((const struct cmd_index_entry *)((const char *)(idx)->table + (i) * (idx)->entry_size))
+
+/*
+ * Fill idx from its table, see CMD_INDEX_DEFINE()
+ */
+void cmd_index_build(struct cmd_index *idx)
+{
+	const struct cmd_index_entry *entry;
+	struct cmd_name *found;
+	int i;
+
+	idx->names = calloc(idx->max, sizeof(struct cmd_name));
+	if (!idx->names)
+		return;
+
+	for (i = 0; i < idx->max; i++) {
+		entry = CMD_ENTRY(idx, i);
+		if (entry->cmd == 0x00)
+			break;
+
+		/* the first entry wins, as with a scan of the table */
+		if (!idx->by_cmd[entry->cmd])
+			idx->by_cmd[entry->cmd] = entry;
+
+		HASH_FIND_STR(idx->name_hash, entry->name, found);
+		if (found)
+			continue;
+		idx->names[i].name = entry->name;
+		idx->names[i].entry = entry;
+		HASH_ADD_KEYPTR(hh, idx->name_hash, idx->names[i].name,
+				strlen(idx->names[i].name), &idx->names[i]);
+	}
+}
+
+static void cmd_index_init(struct cmd_index *idx)
+{
+#ifdef HAVE_PTHREAD
+	pthread_once(&idx->once, idx->build);
+#else
+	if (!idx->built) {
+		idx->build();
+		idx->built = 1;
+	}
+#endif
+}
+
+/*
+ * Entry of command character cmd, or NULL
+ */
+const void *cmd_index_find(struct cmd_index *idx, int cmd)
+{
+	cmd_index_init(idx);
+
+	return idx->by_cmd[cmd & 0xff];
+}
+
+/*
+ * Entry of long command name, or NULL
+ */
+const void *cmd_index_lookup(struct cmd_index *idx, const char *name)
+{
+	struct cmd_name *found;
+
+	cmd_index_init(idx);
+
+	HASH_FIND_STR(idx->name_hash, name, found);
+
+	return found ? found->entry : NULL;
+}
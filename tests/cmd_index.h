@@ -0,0 +1,84 @@
+/*
+ * cmd_index.h - (C) The Hamlib Group 2026
+ *
+ * Command dispatch index shared by rigctl_parse.c and rotctl_parse.c.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CMD_INDEX_H
+#define CMD_INDEX_H
+
+#include <stddef.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/*
+ * The entries of an indexed command table must start with these fields,
+ * and the table end with a 0x00 command.
+ */
+struct cmd_index_entry {
+	unsigned char cmd;
+	const char *name;
+};
+
+struct cmd_name;
+
+/*
+ * Index of a command table, built on first use: the entries by command
+ * character, and a hash of the long names, so that dispatching does not
+ * depend on the size of the table.
+ */
+struct cmd_index {
+	const void *table;
+	size_t entry_size;
+	int max;			/* number of entries in table */
+	void (*build)(void);		/* builds this index, once */
+#ifdef HAVE_PTHREAD
+	pthread_once_t once;
+#else
+	int built;
+#endif
+	const void *by_cmd[256];
+	struct cmd_name *names;
+	struct cmd_name *name_hash;
+};
+
+#ifdef HAVE_PTHREAD
+#define CMD_INDEX_ONCE_INIT	PTHREAD_ONCE_INIT
+#else
+#define CMD_INDEX_ONCE_INIT	0
+#endif
+
+/*
+ * Define the static index var of table.  pthread_once() takes no
+ * argument, hence the build function of its own.
+ */
+#define CMD_INDEX_DEFINE(var, table) \
+	static void var##_once(void); \
+	static struct cmd_index var = { (table), sizeof((table)[0]), \
+		sizeof(table) / sizeof((table)[0]), var##_once, \
+		CMD_INDEX_ONCE_INIT }; \
+	static void var##_once(void) { cmd_index_build(&var); }
+
+void cmd_index_build(struct cmd_index *idx);
+const void *cmd_index_find(struct cmd_index *idx, int cmd);
+const void *cmd_index_lookup(struct cmd_index *idx, const char *name);
+
+#endif	/* CMD_INDEX_H */
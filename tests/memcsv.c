@@ -44,6 +44,8 @@
  */
 
 extern int all;
+extern int load_chan (RIG *rig, const channel_t *chan);
+extern int load_chan_end (RIG *rig);
 
 char csv_sep = ',';	/* CSV separator */
 
@@ -53,7 +55,6 @@ char csv_sep = ',';	/* CSV separator */
 static int dump_csv_chan(RIG *rig, channel_t **chan, int channel_num, const chan_t *chan_list, rig_ptr_t arg);
 static void dump_csv_name(const channel_cap_t *mem_caps, FILE *f);
 static int set_channel_data(RIG *rig, channel_t *chan,  char **line_key, char **line_data);
-static char* mystrtok( char *s, char delim );
 static int  tokenize_line( char *line, char **token_list, size_t siz, char delim );
 static int find_on_list( char **list, char *what );
 
@@ -107,12 +108,8 @@ int csv_load (RIG *rig, const char *infilename)
    /* First read the first line, containing the key */
    if( fgets( keys, sizeof( keys ), f ) != NULL ){
 
-      /* fgets stores '\n' in a buffer, get rid of it */
-      keys[ strlen( keys )-1 ] = '\0';
-      printf("Read the key: %s\n", keys );
-      
       /* Tokenize the key list */
-      if( !tokenize_line( keys, key_list, sizeof(key_list)/sizeof(char*), ',' ) ){
+      if( !tokenize_line( keys, key_list, sizeof(key_list)/sizeof(char*), csv_sep ) ){
          fprintf( stderr, "Invalid (possibly too long or empty) key line, cannot continue.\n" );
          fclose(f);
          return -1;
@@ -123,36 +120,43 @@ int csv_load (RIG *rig, const char *infilename)
       return -1;
    }
 
-   /* Next, read the file line by line */
+   /*
+    * Next, read the file line by line, each channel being handed over
+    * to the rig as soon as parsed
+    */
    while ( fgets ( line, sizeof line, f ) != NULL ){ 
       /* Tokenize the line */
-      if( !tokenize_line( line, value_list, sizeof(value_list)/sizeof(char*), ',' ) ){
+      if( !tokenize_line( line, value_list, sizeof(value_list)/sizeof(char*), csv_sep ) ){
          fprintf( stderr, "Invalid (possibly too long or empty) line ignored\n" );
          continue;
       }
       /* Parse a line, write channel data into chan */
-      set_channel_data( rig, &chan, key_list, value_list );
- 
-      /* Write a rig memory */
-      status=rig_set_channel(rig, &chan);
-
-      if (status != RIG_OK ) {
-            fprintf( stderr, "rig_get_channel: error = %s \n", rigerror(status));
-            fclose(f);
-            return status;
-      }
+      if( set_channel_data( rig, &chan, key_list, value_list ) < 0 )
+         continue;
 
+      status = load_chan( rig, &chan );
+      if (status != RIG_OK )
+         break;
    }
    fclose( f );
+
+   /* Write the rig memories still pending */
+   if (status == RIG_OK )
+      status = load_chan_end( rig );
+   if (status != RIG_OK )
+      fprintf( stderr, "rig_set_chan_diff: error = %s \n", rigerror(status));
+
    return status;
 }
 
-/**  Function to break a line into a list of tokens. Delimiters are 
-    replaced by end-of-string characters ('\0'), and a list of pointers
-    to thus created substrings is created.
+/**  Function to break a line into a list of tokens, in a single pass.
+    Delimiters and the end of line are replaced by end-of-string
+    characters ('\0'), and a list of pointers to thus created substrings
+    is created. Nothing is copied. Two adjacent delimiters give an empty
+    token.
     \param line (input) - a line to be tokenized, the line will be modified!
     \param token_list (output) - a resulting table containing pointers to
-         tokens, or NULLs (the table will be initially nulled )
+         tokens, ended by a NULL;
          all the pointers schould point to addresses within the line 
     \param siz (input) - size of the table
     \param delim (input) - delimiter character
@@ -160,72 +164,29 @@ int csv_load (RIG *rig, const char *infilename)
             or if line was empty.
 */
 static int  tokenize_line( char *line, char **token_list, size_t siz, char delim ){
-   size_t i;
-   char *tok;
-   
-//    printf("Starting tokenizer, line pointer %x, list pointer %x, list size = %d...", line, token_list, siz);
-   /* Erase the table */
-   for( i = 0; i < siz; i++ ){
-      token_list[i] = NULL;
-   }
-//    printf(", list emptied!\n");
-   /* Empty line passed? */
-   if( line == NULL ) return 0;
-   /* Reinitialize, find the first token */
-   i = 0;
-   tok = mystrtok( line, delim );
-   /* Line contains no delim */
-   if( tok == NULL ) return 0;
-   token_list[ i++ ] = tok;
-//    printf("First token is: %s\n", tok);
-   
-   /* Find the remaining tokens */
-   while( i < siz ){
-      tok = mystrtok( NULL, delim );
-//       printf("Next token: %s\n", tok );
-      /* If NULL, no more tokens left */
-      if( (tok == NULL)  ) break;
-      /* Add token to the list */
-      token_list[ i++ ] = tok;
-   }
-//    printf("Finished tokenizing, i = %d, siz = %d\n", i, siz);
-   /* Any tokens left? */
-   if( i == siz ){
-      return 0; 
-   }else{
-      return i;
-   }
-}
+   size_t i = 0;
+   char *p;
 
-/** Tokenizer that handles two delimiters by returning an empty string.
-    First param (input) is a string to be tokenized, second is a delimiter (input)
-    This tokenizer accepts only one delimiter! 
-    \param s - string to divide on first run, NULL on each next
-    \param delim - delimiter
-    \return pointer to token, or NULL if there are no more tokens 
-    \sa "man strtok" 
-    */
-static char* mystrtok( char *s, char delim ){
-   static size_t pos = 0, length = 0;
-   static char *str = 0;
-   if( s != NULL ){
-      str = s;
-      pos = 0;
-      length = strlen( str );
-   }else{
-   }
-   if( str[ pos+1 ] == '\0' ) return NULL;
-   size_t i,ent_pos = pos;
-   for( i = pos; i < length; ){
-      if( str[i] == delim ){
-         str[i] = '\0';
-         pos = i+1;
-         return str+ent_pos;
-      }else{
-         i++;
+   /* Empty line passed? */
+   if( line == NULL || *line == '\0' || *line == '\n' || *line == '\r' || siz < 2 )
+      return 0;
+
+   token_list[ i++ ] = line;
+
+   for( p = line; *p != '\0'; p++ ){
+      if( *p == delim ){
+         *p = '\0';
+         /* keep room for the NULL end */
+         if( i+1 >= siz ) return 0;
+         token_list[ i++ ] = p+1;
+      }else if( *p == '\n' || *p == '\r' ){
+         *p = '\0';
+         break;
       }
    }
-   return str + ent_pos;
+
+   token_list[ i ] = NULL;
+   return i;
 }
 
 static int print_parm_name(RIG *rig, const struct confparams *cfp, rig_ptr_t ptr)
@@ -518,7 +479,7 @@ int dump_csv_chan(RIG *rig, channel_t **chan_pp, int channel_num, const chan_t *
 */
 int set_channel_data(RIG *rig, channel_t *chan, char **line_key_list, char **line_data_list){
 
-   int i,j,n;
+   int i,j,n,desc_len;
    
    memset(chan,0,sizeof(channel_t));
    chan->vfo = RIG_VFO_CURR;
@@ -535,7 +496,11 @@ int set_channel_data(RIG *rig, channel_t *chan, char **line_key_list, char **lin
         if( rig->state.chan_list[j].start <= n && rig->state.chan_list[j].end >= n) 
             break;
 
-   printf("Requested channel number %d, list number %d\n",n,j);
+   rig_debug(RIG_DEBUG_TRACE, "Requested channel number %d, list number %d\n",n,j);
+   if( j == CHANLSTSIZ ){
+        fprintf(stderr,"Channel %d out of the channel list\n",n);
+        return -1;
+   }
 
    const channel_cap_t *mem_caps = &rig->state.chan_list[j].mem_caps;
 
@@ -549,8 +514,10 @@ int set_channel_data(RIG *rig, channel_t *chan, char **line_key_list, char **lin
     if (mem_caps->channel_desc) {
         i = find_on_list( line_key_list,  "channel_desc" );
         if( i >= 0 ){
-           strncpy( chan->channel_desc, line_data_list[ i ], rig->caps->chan_desc_sz-1 );
-           chan->channel_desc[ rig->caps->chan_desc_sz ] = '\0';
+           desc_len = rig->caps->chan_desc_sz > 0 && rig->caps->chan_desc_sz < MAXCHANDESC ?
+                   rig->caps->chan_desc_sz : MAXCHANDESC-1;
+           strncpy( chan->channel_desc, line_data_list[ i ], desc_len );
+           chan->channel_desc[ desc_len ] = '\0';
         }
     }
     if (mem_caps->ant) {
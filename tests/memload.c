@@ -34,62 +34,90 @@
 #ifdef HAVE_XML2
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 static int set_chan(RIG *rig, channel_t *chan ,xmlNodePtr node);
+
+extern int load_chan (RIG *rig, const channel_t *chan);
+extern int load_chan_end (RIG *rig);
 #endif
 
 
 int xml_load (RIG *my_rig, const char *infilename)
 {
 #ifdef HAVE_XML2
-	xmlDocPtr Doc;
+	xmlTextReaderPtr reader;
 	xmlNodePtr node;
+	const char *name;
+	channel_t chan;
+	int ret, depth, in_channels = 0, found = 0;
+	int status = RIG_OK;
 
-	/* load xlm Doc */
-	Doc=xmlParseFile(infilename);
-	if(Doc==NULL) {
-		fprintf(stderr,"xmlParse failed\n");
+	/*
+	 * Walk the file with a streaming reader, each channel element
+	 * being expanded and handed over to the rig on its own.
+	 */
+	reader = xmlReaderForFile(infilename, NULL, 0);
+	if (reader == NULL) {
+		fprintf(stderr,"xmlReader failed\n");
 		exit(2);
 	}
 
-	node=xmlDocGetRootElement(Doc);
-	if (node == NULL) {
-		fprintf(stderr,"get root failed\n");
-		exit(2);
-        }
-	if(strcmp((char *) node->name, "hamlib")) {
-		fprintf(stderr,"no hamlib tag found\n");
-		exit(2);
-	}
-	for(node=node->xmlChildrenNode;node!=NULL;node=node->next) {
-		if(xmlNodeIsText(node)) continue;
-		if(strcmp((char *) node->name, "channels")==0)
-			break;
-	}
-	if(node==NULL) {
-		fprintf(stderr,"no channels\n");
-		exit(2);
-	}
-	for(node=node->xmlChildrenNode;node!=NULL;node=node->next) {
-		channel_t chan;
-		int status;
+	while ((ret = xmlTextReaderRead(reader)) == 1) {
+		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
+			continue;
 
-		if(xmlNodeIsText(node)) continue;
+		name = (const char *) xmlTextReaderConstName(reader);
+		depth = xmlTextReaderDepth(reader);
 
-		set_chan(my_rig,&chan,node);
-
-		status=rig_set_channel(my_rig, &chan);
+		if (depth == 0) {
+			if (strcmp(name, "hamlib")) {
+				fprintf(stderr,"no hamlib tag found\n");
+				exit(2);
+			}
+			continue;
+		}
+		if (depth == 1) {
+			in_channels = !strcmp(name, "channels");
+			found |= in_channels;
+			continue;
+		}
+		if (depth != 2 || !in_channels)
+			continue;
 
-		if (status != RIG_OK ) {
-			printf("rig_get_channel: error = %s \n", rigerror(status));
-			return status;
+		node = xmlTextReaderExpand(reader);
+		if (node == NULL) {
+			ret = -1;
+			break;
 		}
+
+		if (set_chan(my_rig,&chan,node) < 0)
+			continue;
+
+		status = load_chan(my_rig, &chan);
+		if (status != RIG_OK)
+			break;
 	}
 
-        xmlFreeDoc(Doc);
+	xmlFreeTextReader(reader);
 	xmlCleanupParser();
 
-	return 0;
+	if (ret < 0) {
+		fprintf(stderr,"xmlParse failed\n");
+		exit(2);
+	}
+	if (status == RIG_OK && !found) {
+		fprintf(stderr,"no channels\n");
+		exit(2);
+	}
+
+	/* write the channels still pending */
+	if (status == RIG_OK)
+		status = load_chan_end(my_rig);
+	if (status != RIG_OK )
+		printf("rig_set_chan_diff: error = %s \n", rigerror(status));
+
+	return status;
 #else
 	return -RIG_ENAVAIL;
 #endif
@@ -122,7 +150,7 @@ int set_chan(RIG *rig, channel_t *chan, xmlNodePtr node)
 		if (rig->state.chan_list[i].start<=n && rig->state.chan_list[i].end>=n)
 			break;
 
-	fprintf(stderr,"node %d %d\n",n,i);
+	rig_debug(RIG_DEBUG_TRACE, "node %d %d\n",n,i);
 
 	if (rig->state.chan_list[i].mem_caps.bank_num) {
 		prop=xmlGetProp(node, (unsigned char *) "bank_num");
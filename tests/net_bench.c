@@ -0,0 +1,129 @@
+/*
+ * Hamlib net_bench program
+ * Compares the text and binary protocols of rigctld, through netrigctl.
+ *
+ * net_bench [host:port [pipeline]]
+ * A rigctld must be listening, by default on localhost:4532.  With a
+ * pipeline depth, set_freq does not wait for each reply.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+
+#define LOOP_COUNT 2000
+
+static float elapsed_s(const struct timeval *tv1, const struct timeval *tv2)
+{
+	return tv2->tv_sec - tv1->tv_sec + (tv2->tv_usec - tv1->tv_usec)/1000000.0;
+}
+
+static int bench(const char *addr, const char *binary, const char *pipeline)
+{
+	RIG *my_rig;
+	int retcode;
+	struct timeval tv1, tv2;
+	freq_t freq;
+	value_t val;
+	rig_query_t query[3];
+	int i;
+
+	my_rig = rig_init(RIG_MODEL_NETRIGCTL);
+	if (!my_rig) {
+		fprintf(stderr,"Unknown rig num: %d\n", RIG_MODEL_NETRIGCTL);
+		return 1;
+	}
+
+	strncpy(my_rig->state.rigport.pathname, addr, FILPATHLEN - 1);
+	rig_set_conf(my_rig, rig_token_lookup(my_rig, "binary"), binary);
+	rig_set_conf(my_rig, rig_token_lookup(my_rig, "pipeline"), pipeline);
+
+	gettimeofday(&tv1, NULL);
+	retcode = rig_open(my_rig);
+	gettimeofday(&tv2, NULL);
+	if (retcode != RIG_OK) {
+		printf("rig_open: error = %s\n", rigerror(retcode));
+		rig_cleanup(my_rig);
+		return 2;
+	}
+
+	printf("%s protocol, pipeline %s\n", atoi(binary) ? "Binary" : "Text",
+			pipeline);
+	printf("  open (dump_state): %.3f ms\n", elapsed_s(&tv1, &tv2) * 1000);
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < LOOP_COUNT; i++) {
+		retcode = rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+		if (retcode != RIG_OK) {
+			printf("rig_get_freq: error = %s\n", rigerror(retcode));
+			break;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	printf("  get_freq:  %8.0f ops/s\n", LOOP_COUNT / elapsed_s(&tv1, &tv2));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < LOOP_COUNT; i++) {
+		retcode = rig_set_freq(my_rig, RIG_VFO_CURR, MHz(14) + (i % 100) * kHz(1));
+		if (retcode != RIG_OK) {
+			printf("rig_set_freq: error = %s\n", rigerror(retcode));
+			break;
+		}
+	}
+	/* the last pipelined replies */
+	rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+	gettimeofday(&tv2, NULL);
+	printf("  set_freq:  %8.0f ops/s\n", LOOP_COUNT / elapsed_s(&tv1, &tv2));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < LOOP_COUNT; i++) {
+		retcode = rig_get_level(my_rig, RIG_VFO_CURR, RIG_LEVEL_AF, &val);
+		if (retcode != RIG_OK) {
+			printf("rig_get_level: error = %s\n", rigerror(retcode));
+			break;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	printf("  get_level: %8.0f ops/s\n", LOOP_COUNT / elapsed_s(&tv1, &tv2));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < LOOP_COUNT; i++) {
+		memset(query, 0, sizeof(query));
+		query[0].item = RIG_QUERY_FREQ;
+		query[1].item = RIG_QUERY_MODE;
+		query[2].item = RIG_QUERY_LEVEL;
+		query[2].level = RIG_LEVEL_AF;
+		query[0].vfo = query[1].vfo = query[2].vfo = RIG_VFO_CURR;
+		retcode = rig_get_state_batch(my_rig, query, 3);
+		if (retcode != RIG_OK) {
+			printf("rig_get_state_batch: error = %s\n", rigerror(retcode));
+			break;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	printf("  get_state: %8.0f ops/s (freq, mode and AF)\n",
+			LOOP_COUNT / elapsed_s(&tv1, &tv2));
+
+	rig_close(my_rig);
+	rig_cleanup(my_rig);
+
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	const char *addr = argc > 1 ? argv[1] : "localhost:4532";
+	const char *pipeline = argc > 2 ? argv[2] : "0";
+	int retcode;
+
+	rig_set_debug(RIG_DEBUG_ERR);
+
+	retcode = bench(addr, "0", pipeline);
+	if (retcode == 0)
+		retcode = bench(addr, "1", pipeline);
+
+	return retcode;
+}
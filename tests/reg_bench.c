@@ -0,0 +1,106 @@
+/*
+ * Hamlib reg_bench program
+ * Measures backend registration time and caps lookup cost
+ * over all the known rig and rotator models.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <sys/time.h>
+
+#define LOOP_COUNT 1000
+#define MAX_MODELS 1024
+
+static rig_model_t rig_models[MAX_MODELS];
+static int rig_count;
+static rot_model_t rot_models[MAX_MODELS];
+static int rot_count;
+
+static int collect_rig(const struct rig_caps *caps, rig_ptr_t data)
+{
+	if (rig_count < MAX_MODELS)
+		rig_models[rig_count++] = caps->rig_model;
+	return 1;
+}
+
+static int collect_rot(const struct rot_caps *caps, rig_ptr_t data)
+{
+	if (rot_count < MAX_MODELS)
+		rot_models[rot_count++] = caps->rot_model;
+	return 1;
+}
+
+static float elapsed_ms(const struct timeval *tv1, const struct timeval *tv2)
+{
+	return (tv2->tv_sec - tv1->tv_sec) * 1000.0 +
+		(tv2->tv_usec - tv1->tv_usec) / 1000.0;
+}
+
+int main (int argc, char *argv[])
+{
+	struct timeval tv1, tv2;
+	const struct rig_caps *caps;
+	const struct rot_caps *rcaps;
+	int i, j, errors = 0;
+	int loops = argc > 1 ? atoi(argv[1]) : LOOP_COUNT;
+
+	rig_set_debug(RIG_DEBUG_ERR);
+
+	gettimeofday(&tv1, NULL);
+	rig_load_all_backends();
+	gettimeofday(&tv2, NULL);
+	rig_list_foreach(collect_rig, NULL);
+	printf("rig_load_all_backends: %d models in %.3f ms\n",
+			rig_count, elapsed_ms(&tv1, &tv2));
+
+	gettimeofday(&tv1, NULL);
+	rot_load_all_backends();
+	gettimeofday(&tv2, NULL);
+	rot_list_foreach(collect_rot, NULL);
+	printf("rot_load_all_backends: %d models in %.3f ms\n",
+			rot_count, elapsed_ms(&tv1, &tv2));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < loops; i++) {
+		for (j = 0; j < rig_count; j++) {
+			caps = rig_get_caps(rig_models[j]);
+			if (!caps || caps->rig_model != rig_models[j])
+				errors++;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	printf("rig_get_caps: %.1f ns/lookup\n",
+			elapsed_ms(&tv1, &tv2) * 1e6 / ((float)loops * rig_count));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < loops; i++) {
+		for (j = 0; j < rot_count; j++) {
+			rcaps = rot_get_caps(rot_models[j]);
+			if (!rcaps || rcaps->rot_model != rot_models[j])
+				errors++;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	printf("rot_get_caps: %.1f ns/lookup\n",
+			elapsed_ms(&tv1, &tv2) * 1e6 / ((float)loops * rot_count));
+
+	/* names may be shared by several models, check only the names */
+	gettimeofday(&tv1, NULL);
+	for (j = 0; j < rig_count; j++) {
+		caps = rig_get_caps(rig_models[j]);
+		caps = rig_get_caps(rig_lookup_model(caps->mfg_name, caps->model_name));
+		if (!caps || strcmp(caps->model_name, rig_get_caps(rig_models[j])->model_name))
+			errors++;
+	}
+	gettimeofday(&tv2, NULL);
+	printf("rig_lookup_model: %.1f us/lookup\n",
+			elapsed_ms(&tv1, &tv2) * 1e3 / rig_count);
+
+	if (errors)
+		fprintf(stderr, "%d lookup errors\n", errors);
+
+	return errors ? 1 : 0;
+}
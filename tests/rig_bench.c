@@ -22,6 +22,7 @@ int main (int argc, char *argv[])
 	unsigned i;
 	struct timeval tv1, tv2;
 	float elapsed;
+	const char *port = argc > 2 ? argv[2] : SERIAL_PORT;
 
 	rig_set_debug(RIG_DEBUG_ERR);
 
@@ -60,7 +61,7 @@ int main (int argc, char *argv[])
 				my_rig->caps->version, rig_strstatus(my_rig->caps->status));
 	printf("Serial speed: %d bauds\n", my_rig->state.rigport.parm.serial.rate);
 
-	strncpy(my_rig->state.rigport.pathname,SERIAL_PORT,FILPATHLEN - 1);
+	strncpy(my_rig->state.rigport.pathname,port,FILPATHLEN - 1);
 
 	retcode = rig_open(my_rig);
 	if (retcode != RIG_OK) {
@@ -68,7 +69,7 @@ int main (int argc, char *argv[])
 		exit(2);
 	}
 
-	printf("Port %s opened ok\n", SERIAL_PORT);
+	printf("Port %s opened ok\n", port);
 	printf("Perform %d loops...\n", LOOP_COUNT);
 
 	/*
@@ -93,6 +94,33 @@ int main (int argc, char *argv[])
 	}
 	gettimeofday(&tv2, NULL);
 
+	elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec)/1000000.0;
+	printf("Elapsed: %.3fs, Avg: %f loops/s, %f s/loop\n",
+			elapsed, LOOP_COUNT/elapsed, elapsed/LOOP_COUNT
+	      );
+
+	/*
+	 * same queries, pipelined by the backend when it can
+	 */
+	printf("Perform %d batched loops...\n", LOOP_COUNT);
+
+	gettimeofday(&tv1, NULL);
+	for (i=0; i<LOOP_COUNT; i++) {
+		rig_query_t query[2];
+
+		query[0].vfo = RIG_VFO_CURR;
+		query[0].item = RIG_QUERY_FREQ;
+		query[1].vfo = RIG_VFO_CURR;
+		query[1].item = RIG_QUERY_MODE;
+
+		retcode = rig_get_state_batch(my_rig, query, 2);
+		if (retcode != RIG_OK ) {
+		  printf("rig_get_state_batch: error =  %s \n", rigerror(retcode));
+		  exit(1);
+		}
+	}
+	gettimeofday(&tv2, NULL);
+
 	elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec)/1000000.0;
 	printf("Elapsed: %.3fs, Avg: %f loops/s, %f s/loop\n",
 			elapsed, LOOP_COUNT/elapsed, elapsed/LOOP_COUNT
@@ -101,7 +129,7 @@ int main (int argc, char *argv[])
 	rig_close(my_rig); /* close port */
 	rig_cleanup(my_rig); /* if you care about memory */
 
-	printf("port %s closed ok \n",SERIAL_PORT);
+	printf("port %s closed ok \n",port);
 
 	return 0;
 }
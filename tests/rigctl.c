@@ -35,6 +35,11 @@
 #include <ctype.h>
 #include <errno.h>
 #include <getopt.h>
+#include <sys/time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #ifdef HAVE_LIBREADLINE
 #  if defined(HAVE_READLINE_READLINE_H)
@@ -87,7 +92,7 @@ void usage(void);
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:p:d:P:D:s:c:t:lC:LuovhV"
+#define SHORT_OPTIONS "m:r:p:d:P:D:s:c:t:lbC:LuovhV"
 static struct option long_options[] =
 {
 	{"model",           1, 0, 'm'},
@@ -100,6 +105,7 @@ static struct option long_options[] =
 	{"civaddr",         1, 0, 'c'},
 	{"send-cmd-term",   1, 0, 't'},
 	{"list",            0, 0, 'l'},
+	{"probe",           0, 0, 'b'},
 	{"set-conf",        1, 0, 'C'},
 	{"show-conf",       0, 0, 'L'},
 	{"dump-caps",       0, 0, 'u'},
@@ -130,6 +136,8 @@ int vfo_mode = 0;       /* vfo_mode = 0 means target VFO is 'currVFO' */
 
 char send_cmd_term = '\r';  /* send_cmd termination char */
 
+static int probe_ports(char *ports[], int count);
+
 int main (int argc, char *argv[])
 {
 	RIG *my_rig;		/* handle to rig (nstance) */
@@ -137,10 +145,12 @@ int main (int argc, char *argv[])
 
 	int retcode;		/* generic return code from functions */
 	int exitcode;
+	struct rigctl_parser_ctx parser_ctx;
 
 	int verbose = 0;
 	int show_conf = 0;
 	int dump_caps_opt = 0;
+	int probe = 0;
 #ifdef HAVE_READLINE_HISTORY
 	int rd_hist = 0;
 	int sv_hist = 0;
@@ -299,6 +309,9 @@ int main (int argc, char *argv[])
 			case 'u':
 				dump_caps_opt++;
 				break;
+			case 'b':
+				probe++;
+				break;
 			default:
 				usage();	/* unknown option? */
 				exit(1);
@@ -311,6 +324,18 @@ int main (int argc, char *argv[])
 	rig_debug(RIG_DEBUG_VERBOSE, "Report bugs to "
 			"<hamlib-developer@lists.sourceforge.net>\n\n");
 
+	/*
+	 * the ports are on the command line, in place of commands
+	 */
+	if (probe) {
+		if (optind < argc)
+			exit(probe_ports(argv + optind, argc - optind));
+		if (rig_file)
+			exit(probe_ports((char **)&rig_file, 1));
+		fprintf(stderr, "Which port to probe? See --rig-file option.\n");
+		exit(1);
+	}
+
 	/*
 	 * at least one command on command line,
 	 * disable interactive mode
@@ -412,13 +437,17 @@ int main (int argc, char *argv[])
 	}
 #endif	/* HAVE_LIBREADLINE */
 
+	rigctl_parser_ctx_init(&parser_ctx);
+
 	do {
-		retcode = rigctl_parse(my_rig, stdin, stdout, argv, argc);
+		retcode = rigctl_parse(my_rig, stdin, stdout, argv, argc, &parser_ctx);
 		if (retcode == 2)
 			exitcode = 2;
 	}
 	while (retcode == 0 || retcode == 2);
 
+	rigctl_parser_ctx_cleanup(&parser_ctx);
+
 #ifdef HAVE_LIBREADLINE
 	if (interactive && prompt && have_rl) {
 #ifdef HAVE_READLINE_HISTORY
@@ -459,6 +488,7 @@ void usage(void)
 	"  -C, --set-conf=PARM=VAL    set config parameters\n"
 	"  -L, --show-conf            list all config parameters\n"
 	"  -l, --list                 list all model numbers and exit\n"
+	"  -b, --probe [DEVICE]...    list the radios found on the devices and exit\n"
 	"  -u, --dump-caps            dump capabilities and exit\n"
 	"  -o, --vfo                  do not default to VFO_CURR, require extra vfo arg\n"
 #ifdef HAVE_READLINE_HISTORY
@@ -475,3 +505,103 @@ void usage(void)
 	printf("\nReport bugs to <hamlib-developer@lists.sourceforge.net>.\n");
 
 }
+
+
+static int probe_found(const hamlib_port_t *port, rig_model_t model, rig_ptr_t data)
+{
+	const struct rig_caps *caps = rig_get_caps(model);
+
+	printf("%s: %d %s %s\n", port->pathname, model,
+			caps ? caps->mfg_name : "", caps ? caps->model_name : "");
+	(*(int *)data)++;
+
+	return 1;	/* continue */
+}
+
+struct probe_arg {
+	hamlib_port_t port;
+	int found;
+};
+
+static void *probe_port(void *arg)
+{
+	struct probe_arg *p = arg;
+
+	rig_probe_all(&p->port, probe_found, (rig_ptr_t)&p->found);
+
+	return NULL;
+}
+
+/*
+ * Probe all the backends on each port, the ports at the same time,
+ * since each probe mostly waits for timeouts.
+ */
+static int probe_ports(char *ports[], int count)
+{
+	struct probe_arg *args;
+#ifdef HAVE_PTHREAD
+	pthread_t *threads;
+	int ret;
+#endif
+	struct timeval tv1, tv2;
+	int i, found = 0;
+
+	args = calloc(count, sizeof(struct probe_arg));
+	if (!args)
+		return 1;
+#ifdef HAVE_PTHREAD
+	threads = calloc(count, sizeof(pthread_t));
+	if (!threads) {
+		free(args);
+		return 1;
+	}
+#endif
+
+	rig_load_all_backends();
+
+	gettimeofday(&tv1, NULL);
+
+	for (i = 0; i < count; i++) {
+		args[i].port.type.rig = RIG_PORT_SERIAL;
+		args[i].port.parm.serial.rate = 9600;
+		args[i].port.parm.serial.data_bits = 8;
+		args[i].port.parm.serial.stop_bits = 1;
+		args[i].port.parm.serial.parity = RIG_PARITY_NONE;
+		args[i].port.parm.serial.handshake = RIG_HANDSHAKE_NONE;
+		strncpy(args[i].port.pathname, ports[i], FILPATHLEN - 1);
+
+#ifdef HAVE_PTHREAD
+		ret = pthread_create(&threads[i], NULL, probe_port, &args[i]);
+		if (ret != 0) {
+			/* pthread_create() returns the error, errno is not set */
+			rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(ret));
+			probe_port(&args[i]);
+			threads[i] = pthread_self();
+		}
+#else
+		probe_port(&args[i]);
+#endif
+	}
+
+	for (i = 0; i < count; i++) {
+#ifdef HAVE_PTHREAD
+		if (!pthread_equal(threads[i], pthread_self()))
+			pthread_join(threads[i], NULL);
+#endif
+		found += args[i].found;
+	}
+
+	gettimeofday(&tv2, NULL);
+
+	printf("Probed %d port%s in %.3f s, %d radio%s found\n",
+			count, count > 1 ? "s" : "",
+			tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0,
+			found, found != 1 ? "s" : "");
+
+#ifdef HAVE_PTHREAD
+	free(threads);
+#endif
+	free(args);
+
+	return found ? 0 : 2;
+}
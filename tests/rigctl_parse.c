@@ -67,6 +67,7 @@ extern int read_history ();
 #include "iofunc.h"
 #include "serial.h"
 #include "sprintflst.h"
+#include "netbin.h"
 
 /* HAVE_SSLEEP is defined when Windows Sleep is found
  * HAVE_SLEEP is defined when POSIX sleep is found
@@ -87,8 +88,7 @@ extern int read_history ();
 
 #include "rigctl_parse.h"
 
-/* Hash table implementation See:  http://uthash.sourceforge.net/ */
-#include "uthash.h"
+#include "cmd_index.h"
 
 #ifdef HAVE_PTHREAD
 #include <pthread.h>
@@ -102,6 +102,7 @@ static pthread_mutex_t rig_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define MAXNAMSIZ 32
 #define MAXNBOPT 100	/* max number of different options */
 #define MAXARGSZ 127
+#define MAX_BATCH_QUERIES 16	/* max number of items of get_state */
 
 #define ARG_IN1  0x01
 #define ARG_OUT1 0x02
@@ -117,17 +118,9 @@ static pthread_mutex_t rig_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define ARG_IN  (ARG_IN1|ARG_IN2|ARG_IN3|ARG_IN4)
 #define ARG_OUT  (ARG_OUT1|ARG_OUT2|ARG_OUT3|ARG_OUT4)
 
-/* variables for readline support */
+/* readline support, its buffers are kept in struct rigctl_parser_ctx */
 #ifdef HAVE_LIBREADLINE
-static char *input_line = (char *)NULL;
-static char *result = (char *)NULL;
-static char *parsed_input[sizeof(char) * 5];
 static const int have_rl = 1;
-
-#ifdef HAVE_READLINE_HISTORY
-static char *rp_hist_buf = (char *)NULL;
-#endif
-
 #else                               /* no readline */
 static const int have_rl = 0;
 #endif
@@ -135,8 +128,8 @@ static const int have_rl = 0;
 struct test_table {
 	unsigned char cmd;
 	const char *name;
-	int (*rig_routine)(RIG*, FILE*, FILE*, int, const struct test_table*, vfo_t,
-			const char*, const char*, const char*);
+	int (*rig_routine)(RIG*, FILE*, FILE*, int, struct rigctl_parser_ctx*,
+			const struct test_table*, vfo_t, const char*, const char*, const char*);
 	int flags;
 	const char *arg1;
 	const char *arg2;
@@ -149,8 +142,8 @@ struct test_table {
 
 #define ACTION(f) rigctl_##f
 #define declare_proto_rig(f) static int (ACTION(f))(RIG *rig, FILE *fout, FILE *fin, int interactive, \
-			const struct test_table *cmd, vfo_t vfo, const char *arg1, \
-			const char *arg2, const char *arg3)
+			struct rigctl_parser_ctx *ctx, const struct test_table *cmd, vfo_t vfo, \
+			const char *arg1, const char *arg2, const char *arg3)
 
 declare_proto_rig(set_freq);
 declare_proto_rig(get_freq);
@@ -204,6 +197,7 @@ declare_proto_rig(get_channel);
 declare_proto_rig(set_trn);
 declare_proto_rig(get_trn);
 declare_proto_rig(get_info);
+declare_proto_rig(get_state);
 declare_proto_rig(dump_caps);
 declare_proto_rig(dump_conf);
 declare_proto_rig(dump_state);
@@ -219,6 +213,9 @@ declare_proto_rig(recv_dtmf);
 declare_proto_rig(chk_vfo);
 declare_proto_rig(halt);
 declare_proto_rig(pause);
+declare_proto_rig(telemetry);
+declare_proto_rig(sweep);
+declare_proto_rig(binary);
 
 
 /*
@@ -297,102 +294,46 @@ static struct test_table test_list[] = {
 	{ 0xf0,"chk_vfo",           ACTION(chk_vfo),        ARG_NOVFO },	/* rigctld only--check for VFO mode */
 	{ 0xf1,"halt",              ACTION(halt),           ARG_NOVFO },	/* rigctld only--halt the daemon */
 	{ 0x8c, "pause",            ACTION(pause),          ARG_IN, "Seconds" },
+	{ 0x8d, "get_state",        ACTION(get_state),      ARG_IN1|ARG_IN_LINE|ARG_OUT2, "Items", "Values" },
+	{ 0x8e, "telemetry",        ACTION(telemetry),      ARG_IN|ARG_NOVFO, "Format" },	/* rigctld only--stream level telemetry */
+	{ 0x94, "sweep",            ACTION(sweep),          ARG_IN|ARG_IN_LINE, "Sweep" },
+	{ 0x95, "binary",           ACTION(binary),         ARG_NOVFO },	/* rigctld only--switch to binary frames */
 	{ 0x00, "", NULL },
 };
 
-static struct test_table *find_cmd_entry(int cmd)
-{
-	int i;
-	for (i = 0; i < MAXNBOPT && test_list[i].cmd != 0x00; i++)
-		if (test_list[i].cmd == cmd)
-			break;
-
-	if (i >= MAXNBOPT || test_list[i].cmd == 0x00)
-		return NULL;
-
-	return &test_list[i];
-}
-
-/* Structure for hash table provided by uthash.h
- *
- * Structure and hash funtions patterned after/copied from example.c
- * distributed with the uthash package. See:  http://uthash.sourceforge.net/
+/*
+ * Command index, see cmd_index.h
  */
-struct mod_lst
-{
-	int id;			/* caps->rig_model This is the hash key */
-	char mfg_name[32];	/* caps->mfg_name */
-	char model_name[32];	/* caps->model_name */
-	char version[32];	/* caps->version */
-	char status[32];	/* caps->status */
-	UT_hash_handle hh;	/* makes this structure hashable */
-};
-
-/* Hash declaration.  Must be initialized to NULL */
-struct mod_lst *models = NULL;
-
-/* Add model information to the hash */
-void hash_add_model(int id, const char *mfg_name, const char *model_name,
-                     const char *version, const char *status)
-{
-	struct mod_lst *s;
+CMD_INDEX_DEFINE(cmd_index, test_list)
 
-	s = (struct mod_lst*)malloc(sizeof(struct mod_lst));
-
-	s->id = id;
-	snprintf(s->mfg_name, sizeof(s->mfg_name), "%s", mfg_name);
-	snprintf(s->model_name, sizeof(s->model_name), "%s", model_name);
-	snprintf(s->version, sizeof(s->version), "%s", version);
-	snprintf(s->status, sizeof(s->status), "%s", status);
-
-	HASH_ADD_INT(models, id, s);	/* id: name of key field */
-}
-
-/* Hash sorting functions */
-int hash_model_id_sort(struct mod_lst *a, struct mod_lst *b)
-{
-	return (a->id - b->id);
-}
-
-void hash_sort_by_model_id()
+static struct test_table *find_cmd_entry(int cmd)
 {
-    HASH_SORT(models, hash_model_id_sort);
-}
-
-/* Delete hash */
-void hash_delete_all() {
-	struct mod_lst *current_model, *tmp;
-
-	HASH_ITER(hh, models, current_model, tmp) {
-		HASH_DEL(models, current_model);	/* delete it (models advances to next) */
-		free(current_model);			/* free it */
-	}
+	return (struct test_table *)cmd_index_find(&cmd_index, cmd);
 }
 
-
 #ifdef HAVE_LIBREADLINE
 /* Frees allocated memory and sets pointers to NULL before calling readline
  * and then parses the input into space separated tokens.
  */
-static void rp_getline(const char *s)
+static void rp_getline(struct rigctl_parser_ctx *ctx, const char *s)
 {
 	int i;
 
 	/* free allocated memory and set pointers to NULL */
-	if (input_line) {
-		free(input_line);
-		input_line = (char *)NULL;
+	if (ctx->input_line) {
+		free(ctx->input_line);
+		ctx->input_line = (char *)NULL;
 	}
 
-	if (result) {
-		result = (char *)NULL;
+	if (ctx->result) {
+		ctx->result = (char *)NULL;
 	}
 
 	for (i = 0; i < 5; i++)
-		parsed_input[i] = NULL;
+		ctx->parsed_input[i] = NULL;
 
 	/* Action!  Returns typed line with newline stripped. */
-	input_line = readline(s);
+	ctx->input_line = readline(s);
 }
 
 
@@ -404,11 +345,9 @@ static void rp_getline(const char *s)
  */
 static char parse_arg(const char *arg)
 {
-	int i;
-	for (i = 0; i < MAXNBOPT && test_list[i].cmd != 0; i++)
-		if (!strncmp(arg, test_list[i].name, MAXNAMSIZ))
-			return test_list[i].cmd;
-	return 0;
+	const struct test_table *found = cmd_index_lookup(&cmd_index, arg);
+
+	return found ? found->cmd : 0;
 }
 
 
@@ -439,23 +378,23 @@ static int scanfc(FILE *fin, const char *format, void *p)
  * returns <0 is error number
  * returns >=0 when successful
  */
-static int next_word (char *buffer, int argc, char *argv[], int newline)
+static int next_word (struct rigctl_parser_ctx *ctx, char *buffer, int argc,
+		char *argv[], int newline)
 {
   int ret;
   char c;
-  static int reading_stdin;
 
-  if (!reading_stdin)
+  if (!ctx->reading_stdin)
     {
       if (optind >= argc) return EOF;
       else if ('-' == argv[optind][0])
         {
           ++optind;
-          reading_stdin = 1;
+          ctx->reading_stdin = 1;
         }
     }
 
-  if (reading_stdin)
+  if (ctx->reading_stdin)
     {
       do
         {
@@ -467,11 +406,11 @@ static int next_word (char *buffer, int argc, char *argv[], int newline)
             }
         }
       while (!ret);
-      if (EOF == ret) reading_stdin = 0;
+      if (EOF == ret) ctx->reading_stdin = 0;
       else if (ret < 0)
         {
           rig_debug (RIG_DEBUG_ERR, "scanf: %s\n", strerror (errno));
-          reading_stdin = 0;
+          ctx->reading_stdin = 0;
         }
       else
         {
@@ -483,7 +422,7 @@ static int next_word (char *buffer, int argc, char *argv[], int newline)
         }
     }
 
-  if (!reading_stdin)
+  if (!ctx->reading_stdin)
     {
 			if (optind < argc)
         {
@@ -508,10 +447,36 @@ extern int interactive;
 extern int prompt;
 extern int vfo_mode;
 extern char send_cmd_term;
-int ext_resp = 0;
-unsigned char resp_sep = '\n';      /* Default response separator */
 
-int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
+/*
+ * Reset a parser context before its first use with rigctl_parse()
+ */
+void rigctl_parser_ctx_init(struct rigctl_parser_ctx *ctx)
+{
+	memset(ctx, 0, sizeof(struct rigctl_parser_ctx));
+
+	ctx->resp_sep = '\n';	/* Default response separator */
+	ctx->last_was_ret = 1;
+}
+
+/*
+ * Release what has been allocated in a parser context
+ */
+void rigctl_parser_ctx_cleanup(struct rigctl_parser_ctx *ctx)
+{
+	free(ctx->input_line);
+	ctx->input_line = NULL;
+	free(ctx->rp_hist_buf);
+	ctx->rp_hist_buf = NULL;
+}
+
+/*
+ * Parse and execute one command.  All the session state lives in ctx,
+ * hence different sessions may be parsed concurrently, only the calls
+ * into the rig are serialized.
+ */
+int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
+		struct rigctl_parser_ctx *ctx)
 {
 	int retcode;		/* generic return code from functions */
 	unsigned char cmd;
@@ -521,7 +486,6 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 	char arg1[MAXARGSZ+1], *p1 = NULL;
 	char arg2[MAXARGSZ+1], *p2 = NULL;
 	char arg3[MAXARGSZ+1], *p3 = NULL;
-	static int last_was_ret = 1;
 	vfo_t vfo = RIG_VFO_CURR;
 
 	/* cmd, internal, rigctld */
@@ -538,7 +502,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				 * string--rigctld only!
 				 */
 				if (cmd == '+' && !prompt) {
-					ext_resp = 1;
+					ctx->ext_resp = 1;
 					if (scanfc(fin, "%c", &cmd) < 1)
 						return -1;
 				} else if (cmd == '+' && prompt) {
@@ -546,8 +510,8 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				}
 
 				if (cmd != '\\' && cmd != '_'  && cmd != '#' && ispunct(cmd) && !prompt) {
-					ext_resp = 1;
-					resp_sep = cmd;
+					ctx->ext_resp = 1;
+					ctx->resp_sep = cmd;
 					if (scanfc(fin, "%c", &cmd) < 1)
 						return -1;
 				} else if (cmd != '\\' && cmd != '?' && cmd != '_' && cmd != '#' && ispunct(cmd) && prompt) {
@@ -572,18 +536,18 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				}
 
 				if (cmd == 0x0a || cmd == 0x0d) {
-					if (last_was_ret) {
+					if (ctx->last_was_ret) {
 						if (prompt) {
 							fprintf(fout, "? for help, q to quit.\n");
 							fprintf_flush(fout, "\nRig command: ");
 						}
 						return 0;
 					}
-					last_was_ret = 1;
+					ctx->last_was_ret = 1;
 				}
 			} while (cmd == 0x0a || cmd == 0x0d);
 
-			last_was_ret = 0;
+			ctx->last_was_ret = 0;
 
 			/* comment line */
 			if (cmd == '#') {
@@ -601,7 +565,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 			}
 		} else {
 			/* parse rest of command line */
-      retcode = next_word (command, argc, argv, 1);
+      retcode = next_word (ctx, command, argc, argv, 1);
       if (EOF == retcode) return 1;
       else if (retcode < 0) return retcode;
       else if ('\0' == command[1]) {
@@ -625,7 +589,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				vfo = rig_parse_vfo(arg1);
 			} else {
-        retcode = next_word (arg1, argc, argv, 0);
+        retcode = next_word (ctx, arg1, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -650,7 +614,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				if (nl) *nl = '\0';	/* chomp */
 				p1 = arg1[0] == ' ' ? arg1 + 1 : arg1;
 			} else {
-        retcode = next_word (arg1, argc, argv, 0);
+        retcode = next_word (ctx, arg1, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -668,7 +632,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p1 = arg1;
 			} else {
-        retcode = next_word (arg1, argc, argv, 0);
+        retcode = next_word (ctx, arg1, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -686,7 +650,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p2 = arg2;
 			} else {
-        retcode = next_word (arg2, argc, argv, 0);
+        retcode = next_word (ctx, arg2, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -704,7 +668,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p3 = arg3;
 			} else {
-        retcode = next_word (arg3, argc, argv, 0);
+        retcode = next_word (ctx, arg3, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -725,56 +689,56 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		/* Minimum space for 32+1+32+1+128+1+128+1+128+1 = 453 chars, so
 		 * allocate 512 chars cleared to zero for safety.
 		 */
-		rp_hist_buf = (char *)calloc(512, sizeof(char));
+		ctx->rp_hist_buf = (char *)calloc(512, sizeof(char));
 #endif
 
 		rl_instream = fin;
 		rl_outstream = fout;
 
-		rp_getline("\nRig command: ");
+		rp_getline(ctx, "\nRig command: ");
 
 		/* EOF (Ctl-D) received on empty input line, bail out gracefully. */
-		if (!input_line) {
+		if (!ctx->input_line) {
 			fprintf_flush(fout, "\n");
 			return 1;
 		}
 
 		/* Q or q to quit */
-		if (!(strncasecmp(input_line, "q", 1)))
+		if (!(strncasecmp(ctx->input_line, "q", 1)))
 			return 1;
 
 		/* '?' for help */
-		if (!(strncmp(input_line, "?", 1))) {
+		if (!(strncmp(ctx->input_line, "?", 1))) {
 			usage_rig(fout);
 			fflush(fout);
 			return 0;
 		}
 
 		/* '#' for comment */
-		if (!(strncmp(input_line, "#", 1)))
+		if (!(strncmp(ctx->input_line, "#", 1)))
 			return 0;
 
 		/* Blank line entered */
-		if (!(strcmp(input_line, ""))) {
+		if (!(strcmp(ctx->input_line, ""))) {
 			fprintf(fout, "? for help, q to quit.\n");
 			fflush(fout);
 			return 0;
 		}
 
-		rig_debug(RIG_DEBUG_BUG, "%s: input_line: %s\n", __func__, input_line);
+		rig_debug(RIG_DEBUG_BUG, "%s: input_line: %s\n", __func__, ctx->input_line);
 
 		/* Split input_line on any number of spaces to get the command token
 		 * Tabs are intercepted by readline for completion and a newline
 		 * causes readline to return the typed text.  If more than one
 		 * argument is given, it will be parsed out later.
 		 */
-		result = strtok(input_line, " ");
+		ctx->result = strtok(ctx->input_line, " ");
 
 		/* parsed_input stores pointers into input_line where the token strings
 		 * start.
 		 */
-		if (result) {
-			parsed_input[0] = result;
+		if (ctx->result) {
+			ctx->parsed_input[0] = ctx->result;
 		} else {
 			/* Oops!  Invoke GDB!! */
 			fprintf_flush(fout, "\n");
@@ -787,36 +751,36 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		 */
 
 		/* Single character command */
-		if ((strlen(parsed_input[0]) == 1) && (*parsed_input[0] != '\\')) {
-			cmd = *parsed_input[0];
+		if ((strlen(ctx->parsed_input[0]) == 1) && (*ctx->parsed_input[0] != '\\')) {
+			cmd = *ctx->parsed_input[0];
 
 #ifdef HAVE_READLINE_HISTORY
 			/* Store what is typed, not validated, for history. */
-			if (rp_hist_buf)
-				strncpy(rp_hist_buf, parsed_input[0], 1);
+			if (ctx->rp_hist_buf)
+				strncpy(ctx->rp_hist_buf, ctx->parsed_input[0], 1);
 #endif
 		}
 		/* Test the command token, parsed_input[0] */
-		else if ((*parsed_input[0] == '\\') && (strlen(parsed_input[0]) > 1)) {
+		else if ((*ctx->parsed_input[0] == '\\') && (strlen(ctx->parsed_input[0]) > 1)) {
 			char cmd_name[MAXNAMSIZ];
 
 			/* if there is no terminating '\0' character in the source string,
 			 * srncpy() doesn't add one even if the supplied length is less
 			 * than the destination array.  Truncate the source string here.
 			 */
-			 if (strlen(parsed_input[0] + 1) >= MAXNAMSIZ)
-				*(parsed_input[0] + MAXNAMSIZ) = '\0';
+			 if (strlen(ctx->parsed_input[0] + 1) >= MAXNAMSIZ)
+				*(ctx->parsed_input[0] + MAXNAMSIZ) = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf)
-				strncpy(rp_hist_buf, parsed_input[0], MAXNAMSIZ);
+			if (ctx->rp_hist_buf)
+				strncpy(ctx->rp_hist_buf, ctx->parsed_input[0], MAXNAMSIZ);
 #endif
 			/* The starting position of the source string is the first
 			 * character past the initial '\'.  Using MAXNAMSIZ for the
 			 * length leaves enough space for the '\0' string terminator in the
 			 * cmd_name array.
 			 */
-			strncpy(cmd_name, parsed_input[0] + 1, MAXNAMSIZ);
+			strncpy(cmd_name, ctx->parsed_input[0] + 1, MAXNAMSIZ);
 
 			/* Sanity check as valid multiple character commands consist of
 			 * alpha-numeric characters and the underscore ('_') character.
@@ -831,7 +795,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 			cmd = parse_arg(cmd_name);
 		}
 		/* Single '\' entered, prompt again */
-		 else if ((*parsed_input[0] == '\\') && (strlen(parsed_input[0]) == 1)) {
+		 else if ((*ctx->parsed_input[0] == '\\') && (strlen(ctx->parsed_input[0]) == 1)) {
 			return 0;
 		}
 		/* Multiple characters but no leading '\' */
@@ -843,7 +807,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		cmd_entry = find_cmd_entry(cmd);
 		if (!cmd_entry) {
 			if (cmd == '\0')
-				fprintf(stderr, "Command '%s' not found!\n", parsed_input[0]);
+				fprintf(stderr, "Command '%s' not found!\n", ctx->parsed_input[0]);
 			else
 				fprintf(stderr, "Command '%c' not found!\n", cmd);
 
@@ -855,24 +819,24 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		 */
 		if (!(cmd_entry->flags & ARG_NOVFO) && vfo_mode) {
 			/* Check if VFO was given with command. */
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (result) {
+			if (ctx->result) {
 				x = 1;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			}
 			/* Need to prompt if a VFO string was not given. */
 			else {
 				x = 0;
-				rp_getline("VFO: ");
+				rp_getline(ctx, "VFO: ");
 
-				if (!input_line) {
+				if (!ctx->input_line) {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 
 				/* Blank line entered */
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
@@ -881,10 +845,10 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				/* Get the first token of input, the rest, if any, will be
 				 * used later.
 				 */
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
@@ -894,28 +858,28 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 			/* VFO name tokens are presently quite short.  Truncate excessively
 			 * long strings.
 			 */
-			if (strlen(parsed_input[x]) >= MAXNAMSIZ)
-				*(parsed_input[x] + (MAXNAMSIZ - 1)) = '\0';
+			if (strlen(ctx->parsed_input[x]) >= MAXNAMSIZ)
+				*(ctx->parsed_input[x] + (MAXNAMSIZ - 1)) = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXNAMSIZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXNAMSIZ);
 			}
 #endif
 			/* Sanity check, VFO names are alpha only. */
-			for (j = 0; j < MAXNAMSIZ && parsed_input[x][j] != '\0'; j++) {
-				if (!(isalpha((int)parsed_input[x][j]))) {
-					parsed_input[x][j] = '\0';
+			for (j = 0; j < MAXNAMSIZ && ctx->parsed_input[x][j] != '\0'; j++) {
+				if (!(isalpha((int)ctx->parsed_input[x][j]))) {
+					ctx->parsed_input[x][j] = '\0';
 
 					break;
 				}
 			}
-			vfo = rig_parse_vfo(parsed_input[x]);
+			vfo = rig_parse_vfo(ctx->parsed_input[x]);
 
 			if (vfo == RIG_VFO_NONE) {
 				fprintf(stderr, "Warning:  VFO '%s' unrecognized, using 'currVFO' instead.\n",
-					parsed_input[x]);
+					ctx->parsed_input[x]);
 				vfo = RIG_VFO_CURR;
 			}
 		}
@@ -926,14 +890,14 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 			/* Check for a non-existent delimiter so as to not break up
 			 * remaining line into separate tokens (spaces OK).
 			 */
-			result = strtok(NULL, "\0");
+			ctx->result = strtok(NULL, "\0");
 
-			if (vfo_mode && result) {
+			if (vfo_mode && ctx->result) {
 				x = 2;
-				parsed_input[x] = result;
-			} else if (result) {
+				ctx->parsed_input[x] = ctx->result;
+			} else if (ctx->result) {
 				x = 1;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg1) + 3)];
@@ -941,17 +905,17 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg1);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
 				/* Blank line entered */
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				if (input_line)
-					parsed_input[x] = input_line;
+				if (ctx->input_line)
+					ctx->parsed_input[x] = ctx->input_line;
 				else {
 					fprintf_flush(fout, "\n");
 					return 1;
@@ -959,29 +923,29 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 			}
 
 			/* The arg1 array size is MAXARGSZ + 1 so truncate it to fit if larger. */
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg1, parsed_input[x]);
+			strcpy(arg1, ctx->parsed_input[x]);
 			p1 = arg1;
 		}
 
 		/* Normal argument parsing. */
 		else if ((cmd_entry->flags & ARG_IN1) && cmd_entry->arg1) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (vfo_mode && result) {
+			if (vfo_mode && ctx->result) {
 				x = 2;
-				parsed_input[x] = result;
-			} else if (result) {
+				ctx->parsed_input[x] = ctx->result;
+			} else if (ctx->result) {
 				x = 1;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg1) + 3)];
@@ -989,45 +953,45 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg1);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg1, parsed_input[x]);
+			strcpy(arg1, ctx->parsed_input[x]);
 			p1 = arg1;
 		}
 		if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN2) && cmd_entry->arg2) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (vfo_mode && result) {
+			if (vfo_mode && ctx->result) {
 				x = 3;
-				parsed_input[x] = result;
-			} else if (result) {
+				ctx->parsed_input[x] = ctx->result;
+			} else if (ctx->result) {
 				x = 2;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg2) + 3)];
@@ -1035,45 +999,45 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg2);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg2, parsed_input[x]);
+			strcpy(arg2, ctx->parsed_input[x]);
 			p2 = arg2;
 		}
 		if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN3) && cmd_entry->arg3) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (vfo_mode && result) {
+			if (vfo_mode && ctx->result) {
 				x = 4;
-				parsed_input[x] = result;
-			} else if (result) {
+				ctx->parsed_input[x] = ctx->result;
+			} else if (ctx->result) {
 				x = 3;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg3) + 3)];
@@ -1081,41 +1045,41 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg3);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg3, parsed_input[x]);
+			strcpy(arg3, ctx->parsed_input[x]);
 			p3 = arg3;
 		}
 #ifdef HAVE_READLINE_HISTORY
-		if (rp_hist_buf) {
-			add_history(rp_hist_buf);
-			free(rp_hist_buf);
-			rp_hist_buf = (char *)NULL;
+		if (ctx->rp_hist_buf) {
+			add_history(ctx->rp_hist_buf);
+			free(ctx->rp_hist_buf);
+			ctx->rp_hist_buf = (char *)NULL;
 		}
 #endif
 	}
@@ -1123,14 +1087,6 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 #endif	/* HAVE_LIBREADLINE */
 
 
-	/*
-	 * mutex locking needed because rigctld is multithreaded
-	 * and hamlib is not MT-safe
-	 */
-#ifdef HAVE_PTHREAD
-	pthread_mutex_lock(&rig_mutex);
-#endif
-
 	if (!prompt)
 		rig_debug(RIG_DEBUG_TRACE, "rigctl(d): %c '%s' '%s' '%s' '%s'\n",
 				cmd, rig_strvfo(vfo), p1?p1:"", p2?p2:"", p3?p3:"");
@@ -1139,7 +1095,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 	 * Extended Response protocol: output received command name and arguments
 	 * response.  Don't send command header on '\chk_vfo' command.
 	 */
-	if (interactive && ext_resp && !prompt && cmd != 0xf0) {
+	if (interactive && ctx->ext_resp && !prompt && cmd != 0xf0) {
 		char a1[MAXARGSZ + 1];
 		char a2[MAXARGSZ + 1];
 		char a3[MAXARGSZ + 1];
@@ -1150,10 +1106,19 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		p2 == NULL ? a2[0] = '\0' : snprintf(a2, sizeof(a2), " %s", p2);
 		p3 == NULL ? a3[0] = '\0' : snprintf(a3, sizeof(a3), " %s", p3);
 
-		fprintf(fout, "%s:%s%s%s%s%c", cmd_entry->name, vfo_str, a1, a2, a3, resp_sep);
+		fprintf(fout, "%s:%s%s%s%s%c", cmd_entry->name, vfo_str, a1, a2, a3, ctx->resp_sep);
 	}
 
-	retcode = (*cmd_entry->rig_routine)(my_rig, fout, fin, interactive,
+	/*
+	 * mutex locking needed because rigctld is multithreaded
+	 * and hamlib is not MT-safe.  Parsing above only touches
+	 * the session context, so only the rig access is serialized.
+	 */
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&rig_mutex);
+#endif
+
+	retcode = (*cmd_entry->rig_routine)(my_rig, fout, fin, interactive, ctx,
 					cmd_entry, vfo, p1, p2 ? p2 : "", p3 ? p3 : "");
 
 #ifdef HAVE_PTHREAD
@@ -1165,8 +1130,8 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		/* only for rigctld */
 		if (interactive && !prompt) {
 			fprintf(fout, NETRIGCTL_RET "%d\n", retcode);
-			ext_resp = 0;
-			resp_sep = '\n';
+			ctx->ext_resp = 0;
+			ctx->resp_sep = '\n';
 		}
 		else
 			fprintf(fout, "%s: error = %s\n", cmd_entry->name, rigerror(retcode));
@@ -1175,14 +1140,14 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc)
 		if (interactive && !prompt) {
 			/* netrigctl RIG_OK */
 			if (!(cmd_entry->flags & ARG_OUT)
-				&& !ext_resp && cmd != 0xf0)
+				&& !ctx->ext_resp && cmd != 0xf0)
 				fprintf(fout, NETRIGCTL_RET "0\n");
 
 			/* Extended Response protocol */
-			else if (ext_resp && cmd != 0xf0) {
+			else if (ctx->ext_resp && cmd != 0xf0) {
 				fprintf(fout, NETRIGCTL_RET "0\n");
-				ext_resp = 0;
-				resp_sep = '\n';
+				ctx->ext_resp = 0;
+				ctx->resp_sep = '\n';
 			}
 		}
 	}
@@ -1271,24 +1236,17 @@ int print_conf_list(const struct confparams *cfp, rig_ptr_t data)
 	return 1;  /* !=0, we want them all ! */
 }
 
-static int hash_model_list(const struct rig_caps *caps, void *data)
+/*
+ * The registry walks models in numeric order,
+ * so they can be printed as they come.
+ */
+static int print_model_list(const struct rig_caps *caps, void *data)
 {
-
-	hash_add_model(caps->rig_model, caps->mfg_name, caps->model_name,
-	               caps->version, rig_strstatus(caps->status));
+	printf("%6d  %-23s%-24s%-16s%s\n", caps->rig_model, caps->mfg_name,
+	       caps->model_name, caps->version, rig_strstatus(caps->status));
 	return 1;  /* !=0, we want them all ! */
 }
 
-void print_model_list()
-{
-	struct mod_lst *s;
-
-	for (s = models; s != NULL; s = (struct mod_lst *)(s->hh.next)) {
-		printf("%6d  %-23s%-24s%-16s%s\n", s->id, s->mfg_name,
-		       s->model_name, s->version, s->status);
-	}
-}
-
 void list_models()
 {
 	int status;
@@ -1296,15 +1254,11 @@ void list_models()
 	rig_load_all_backends();
 
 	printf(" Rig #  Mfg                    Model                   Version         Status\n");
-	status = rig_list_foreach(hash_model_list, NULL);
+	status = rig_list_foreach(print_model_list, NULL);
 	if (status != RIG_OK ) {
 		printf("rig_list_foreach: error = %s \n", rigerror(status));
 		exit(2);
 	}
-
-	hash_sort_by_model_id();
-	print_model_list();
-	hash_delete_all();
 }
 
 
@@ -1356,9 +1310,9 @@ declare_proto_rig(get_freq)
 	if (status != RIG_OK)
 		return status;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1); /* i.e. "Frequency" */
-	fprintf(fout, "%"PRIll"%c", (int64_t)freq, resp_sep);
+	fprintf(fout, "%"PRIll"%c", (int64_t)freq, ctx->resp_sep);
 
 	return status;
 }
@@ -1381,9 +1335,9 @@ declare_proto_rig(get_rit)
 	status = rig_get_rit(rig, vfo, &rit);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%ld%c", rit, resp_sep);
+	fprintf(fout, "%ld%c", rit, ctx->resp_sep);
 
 	return status;
 }
@@ -1406,9 +1360,9 @@ declare_proto_rig(get_xit)
 	status = rig_get_xit(rig, vfo, &xit);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%ld%c", xit, resp_sep);
+	fprintf(fout, "%ld%c", xit, ctx->resp_sep);
 
 	return status;
 }
@@ -1441,12 +1395,12 @@ declare_proto_rig(get_mode)
 	status = rig_get_mode(rig, vfo, &mode, &width);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", rig_strrmode(mode), resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%s%c", rig_strrmode(mode), ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%ld%c", width, resp_sep);
+	fprintf(fout, "%ld%c", width, ctx->resp_sep);
 
 	return status;
 }
@@ -1465,9 +1419,9 @@ declare_proto_rig(get_vfo)
 	status = rig_get_vfo(rig, &vfo);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", rig_strvfo(vfo), resp_sep);
+	fprintf(fout, "%s%c", rig_strvfo(vfo), ctx->resp_sep);
 
 	return status;
 }
@@ -1491,10 +1445,10 @@ declare_proto_rig(get_ptt)
 	status = rig_get_ptt(rig, vfo, &ptt);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
 	/* TODO MICDATA */
-	fprintf(fout, "%d%c", ptt, resp_sep);
+	fprintf(fout, "%d%c", ptt, ctx->resp_sep);
 
 	return status;
 }
@@ -1508,9 +1462,9 @@ declare_proto_rig(get_dcd)
 	status = rig_get_dcd(rig, vfo, &dcd);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", dcd, resp_sep);
+	fprintf(fout, "%d%c", dcd, ctx->resp_sep);
 
 	return status;
 }
@@ -1533,9 +1487,9 @@ declare_proto_rig(get_rptr_shift)
 	status = rig_get_rptr_shift(rig, vfo, &rptr_shift);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", rig_strptrshift(rptr_shift), resp_sep);
+	fprintf(fout, "%s%c", rig_strptrshift(rptr_shift), ctx->resp_sep);
 
 	return status;
 }
@@ -1558,9 +1512,9 @@ declare_proto_rig(get_rptr_offs)
 	status = rig_get_rptr_offs(rig, vfo, &rptr_offs);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%ld%c", rptr_offs, resp_sep);
+	fprintf(fout, "%ld%c", rptr_offs, ctx->resp_sep);
 
 	return status;
 }
@@ -1583,9 +1537,9 @@ declare_proto_rig(get_ctcss_tone)
 	status = rig_get_ctcss_tone(rig, vfo, &tone);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", tone, resp_sep);
+	fprintf(fout, "%d%c", tone, ctx->resp_sep);
 
 	return status;
 }
@@ -1608,9 +1562,9 @@ declare_proto_rig(get_dcs_code)
 	status = rig_get_dcs_code(rig, vfo, &code);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", code, resp_sep);
+	fprintf(fout, "%d%c", code, ctx->resp_sep);
 
 	return status;
 }
@@ -1633,9 +1587,9 @@ declare_proto_rig(get_ctcss_sql)
 	status = rig_get_ctcss_sql(rig, vfo, &tone);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", tone, resp_sep);
+	fprintf(fout, "%d%c", tone, ctx->resp_sep);
 
 	return status;
 }
@@ -1658,9 +1612,9 @@ declare_proto_rig(get_dcs_sql)
 	status = rig_get_dcs_sql(rig, vfo, &code);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", code, resp_sep);
+	fprintf(fout, "%d%c", code, ctx->resp_sep);
 
 	return status;
 }
@@ -1685,9 +1639,9 @@ declare_proto_rig(get_split_freq)
 	status = rig_get_split_freq(rig, txvfo, &txfreq);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%"PRIll"%c", (int64_t)txfreq, resp_sep);
+	fprintf(fout, "%"PRIll"%c", (int64_t)txfreq, ctx->resp_sep);
 
 	return status;
 }
@@ -1722,12 +1676,12 @@ declare_proto_rig(get_split_mode)
 	status = rig_get_split_mode(rig, txvfo, &mode, &width);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", rig_strrmode(mode), resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%s%c", rig_strrmode(mode), ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%ld%c", width, resp_sep);
+	fprintf(fout, "%ld%c", width, ctx->resp_sep);
 
 	return status;
 }
@@ -1755,12 +1709,12 @@ declare_proto_rig(get_split_vfo)
 	status = rig_get_split_vfo(rig, vfo, &split, &tx_vfo);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", split, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%d%c", split, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%s%c", rig_strvfo(tx_vfo), resp_sep);
+	fprintf(fout, "%s%c", rig_strvfo(tx_vfo), ctx->resp_sep);
 
 	return status;
 }
@@ -1783,9 +1737,9 @@ declare_proto_rig(get_ts)
 	status = rig_get_ts(rig, vfo, &ts);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%ld%c", ts, resp_sep);
+	fprintf(fout, "%ld%c", ts, ctx->resp_sep);
 
 	return status;
 }
@@ -1806,9 +1760,9 @@ declare_proto_rig(power2mW)
 	status = rig_power2mW(rig, &mwp, power, freq, mode);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%i%c", mwp, resp_sep);
+	fprintf(fout, "%i%c", mwp, ctx->resp_sep);
 
 	return status;
 }
@@ -1829,9 +1783,9 @@ declare_proto_rig(mW2power)
 	status = rig_mW2power(rig, &power, mwp, freq, mode);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%f%c", power, resp_sep);
+	fprintf(fout, "%f%c", power, ctx->resp_sep);
 
 	return status;
 }
@@ -2153,9 +2107,9 @@ declare_proto_rig(get_mem)
 	status = rig_get_mem(rig, vfo, &ch);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", ch, resp_sep);
+	fprintf(fout, "%d%c", ch, ctx->resp_sep);
 
 	return status;
 }
@@ -2230,95 +2184,95 @@ declare_proto_rig(set_channel)
 		return -RIG_ECONF;
 
 	if (mem_caps->bank_num) {
-	    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	    if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		    fprintf_flush(fout, "Bank Num: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.bank_num));
 	}
 #if 0
 	if (mem_caps->vfo) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "vfo (VFOA,MEM,etc...): ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		chan.vfo = rig_parse_vfo(s);
 	}
 #endif
 	if (mem_caps->ant) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "ant: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.ant));
 	}
 	if (mem_caps->freq) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "Frequency: ");
 		CHKSCN1ARG(scanfc(fin, "%"SCNfreq, &chan.freq));
 	}
 	if (mem_caps->mode) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "mode (FM,LSB,etc...): ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		chan.mode = rig_parse_mode(s);
 	}
 	if (mem_caps->width) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "width: ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.width));
 	}
 	if (mem_caps->tx_freq) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "tx freq: ");
 		CHKSCN1ARG(scanfc(fin, "%"SCNfreq, &chan.tx_freq));
 	}
 	if (mem_caps->tx_mode) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "tx mode (FM,LSB,etc...): ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		chan.tx_mode = rig_parse_mode(s);
 	}
 	if (mem_caps->tx_width) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "tx width: ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.tx_width));
 	}
 	if (mem_caps->split) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "split (0,1): ");
 		CHKSCN1ARG(scanfc(fin, "%d", &status));
 		chan.split = status;
 	}
 	if (mem_caps->tx_vfo) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "tx vfo (VFOA,MEM,etc...): ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		chan.tx_vfo = rig_parse_vfo(s);
 	}
 	if (mem_caps->rptr_shift) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "rptr shift (+-0): ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		chan.rptr_shift = rig_parse_rptr_shift(s);
 	}
 	if (mem_caps->rptr_offs) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "rptr offset: ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.rptr_offs));
 	}
 	if (mem_caps->tuning_step) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "tuning step: ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.tuning_step));
 	}
 	if (mem_caps->rit) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "rit (Hz,0=off): ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.rit));
 	}
 	if (mem_caps->xit) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "xit (Hz,0=off): ");
 		CHKSCN1ARG(scanfc(fin, "%ld", &chan.xit));
 	}
 	if (mem_caps->funcs) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "funcs: ");
 		CHKSCN1ARG(scanfc(fin, "%lx", &chan.funcs));
 	}
@@ -2328,37 +2282,37 @@ declare_proto_rig(set_channel)
 		sscanf(arg1, "%d", &chan.levels);
 #endif
 	if (mem_caps->ctcss_tone) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "ctcss tone freq in tenth of Hz (0=off): ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.ctcss_tone));
 	}
 	if (mem_caps->ctcss_sql) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "ctcss sql freq in tenth of Hz (0=off): ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.ctcss_sql));
 	}
 	if (mem_caps->dcs_code) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "dcs code: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.dcs_code));
 	}
 	if (mem_caps->dcs_sql) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "dcs sql: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.dcs_sql));
 	}
 	if (mem_caps->scan_group) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "scan group: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.scan_group));
 	}
 	if (mem_caps->flags) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "flags: ");
 		CHKSCN1ARG(scanfc(fin, "%d", &chan.flags));
 	}
 	if (mem_caps->channel_desc) {
-		if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
             fprintf_flush(fout, "channel desc: ");
 		CHKSCN1ARG(scanfc(fin, "%s", s));
 		strcpy(chan.channel_desc, s);
@@ -2433,6 +2387,31 @@ static int mydcd_event(RIG *rig, vfo_t vfo, dcd_t dcd, rig_ptr_t arg)
 	return 0;
 }
 
+static int mysplit_event(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo, rig_ptr_t arg)
+{
+	printf("Event: split changed to %i, TX on %s\n", split, rig_strvfo(tx_vfo));
+	return 0;
+}
+
+static int mylevel_event(RIG *rig, vfo_t vfo, setting_t level, value_t val, rig_ptr_t arg)
+{
+	if (RIG_LEVEL_IS_FLOAT(level))
+		printf("Event: %s changed to %f on %s\n", rig_strlevel(level), val.f,
+				rig_strvfo(vfo));
+	else
+		printf("Event: %s changed to %d on %s\n", rig_strlevel(level), val.i,
+				rig_strvfo(vfo));
+	return 0;
+}
+
+static int myspectrum_event(RIG *rig, const rig_spectrum_line_t *line, rig_ptr_t arg)
+{
+	printf("Event: spectrum sweep of %d points from %"PRIll"Hz to %"PRIll"Hz\n",
+			line->data_length, (int64_t)line->low_edge_freq,
+			(int64_t)line->high_edge_freq);
+	return 0;
+}
+
 /* 'A' */
 declare_proto_rig(set_trn)
 {
@@ -2457,6 +2436,9 @@ declare_proto_rig(set_trn)
 		rig_set_vfo_callback (rig, myvfo_event, NULL);
 		rig_set_ptt_callback (rig, myptt_event, NULL);
 		rig_set_dcd_callback (rig, mydcd_event, NULL);
+		rig_set_split_callback (rig, mysplit_event, NULL);
+		rig_set_level_callback (rig, mylevel_event, NULL);
+		rig_set_spectrum_callback (rig, myspectrum_event, NULL);
 	}
 
 	return rig_set_trn(rig, trn);
@@ -2475,10 +2457,10 @@ declare_proto_rig(get_trn)
 	status = rig_get_trn(rig, &trn);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
 	if (trn>=0 && trn<=2)
-		fprintf(fout, "%s%c", trn_txt[trn], resp_sep);
+		fprintf(fout, "%s%c", trn_txt[trn], ctx->resp_sep);
 
 	return status;
 }
@@ -2489,13 +2471,195 @@ declare_proto_rig(get_info)
 	const char *s;
 
 	s = rig_get_info(rig);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", s ? s : "None", resp_sep);
+	fprintf(fout, "%s%c", s ? s : "None", ctx->resp_sep);
 
 	return RIG_OK;
 }
 
+/*
+ * '0x8d'
+ *
+ * Read several items in one go, e.g. "FREQ MODE PTT STRENGTH",
+ * through rig_get_state_batch().  Items are FREQ, MODE, VFO, PTT
+ * or a level name, and each one is reported as its own get_ command.
+ */
+declare_proto_rig(get_state)
+{
+	rig_query_t query[MAX_BATCH_QUERIES];
+	char items[MAXARGSZ + 1];
+	char *item[MAX_BATCH_QUERIES];
+	char *tok, *saveptr = NULL;
+	int i, n, status;
+
+	strncpy(items, arg1, MAXARGSZ);
+	items[MAXARGSZ] = '\0';
+
+	for (n = 0, tok = strtok_r(items, " ,", &saveptr);
+			tok && n < MAX_BATCH_QUERIES;
+			n++, tok = strtok_r(NULL, " ,", &saveptr)) {
+		item[n] = tok;
+		query[n].vfo = vfo;
+		if (!strcmp(tok, "FREQ"))
+			query[n].item = RIG_QUERY_FREQ;
+		else if (!strcmp(tok, "MODE"))
+			query[n].item = RIG_QUERY_MODE;
+		else if (!strcmp(tok, "VFO"))
+			query[n].item = RIG_QUERY_VFO;
+		else if (!strcmp(tok, "PTT"))
+			query[n].item = RIG_QUERY_PTT;
+		else {
+			query[n].item = RIG_QUERY_LEVEL;
+			query[n].level = rig_parse_level(tok);
+			if (!rig_has_get_level(rig, query[n].level))
+				return -RIG_EINVAL;
+		}
+	}
+	if (n == 0 || tok)
+		return -RIG_EINVAL;
+
+	status = rig_get_state_batch(rig, query, n);
+	if (status != RIG_OK)
+		return status;
+
+	for (i = 0; i < n; i++) {
+		if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
+			fprintf(fout, "%s: ", item[i]);
+
+		switch (query[i].item) {
+		case RIG_QUERY_FREQ:
+			fprintf(fout, "%"PRIll"%c", (int64_t)query[i].u.freq, ctx->resp_sep);
+			break;
+		case RIG_QUERY_MODE:
+			fprintf(fout, "%s%c", rig_strrmode(query[i].u.mode.mode), ctx->resp_sep);
+			if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
+				fprintf(fout, "%s: ", "Passband");
+			fprintf(fout, "%ld%c", query[i].u.mode.width, ctx->resp_sep);
+			break;
+		case RIG_QUERY_VFO:
+			fprintf(fout, "%s%c", rig_strvfo(query[i].u.vfo), ctx->resp_sep);
+			break;
+		case RIG_QUERY_PTT:
+			fprintf(fout, "%d%c", query[i].u.ptt, ctx->resp_sep);
+			break;
+		case RIG_QUERY_LEVEL:
+			if (RIG_LEVEL_IS_FLOAT(query[i].level))
+				fprintf(fout, "%f%c", query[i].u.level.f, ctx->resp_sep);
+			else
+				fprintf(fout, "%d%c", query[i].u.level.i, ctx->resp_sep);
+			break;
+		}
+	}
+
+	return status;
+}
+
+#define SWEEP_DWELL_MIN 50	/* ms */
+#define SWEEP_DWELL_MAX 500	/* ms */
+#define SWEEP_MAX_POINTS 100000
+
+struct sweep_out {
+	FILE *fout;
+	const struct rigctl_parser_ctx *ctx;
+	setting_t level;
+};
+
+static int sweep_print(RIG *rig, const rig_sweep_point_t *point, rig_ptr_t arg)
+{
+	struct sweep_out *out = (struct sweep_out *)arg;
+
+	fprintf(out->fout, "%"PRIll" ", (int64_t)point->freq);
+	if (point->status != RIG_OK)
+		fprintf(out->fout, "?%c", out->ctx->resp_sep);
+	else if (RIG_LEVEL_IS_FLOAT(out->level))
+		fprintf(out->fout, "%f%c", point->val.f, out->ctx->resp_sep);
+	else
+		fprintf(out->fout, "%d%c", point->val.i, out->ctx->resp_sep);
+
+	/* let the client see the progress */
+	fflush(out->fout);
+
+	return !ferror(out->fout);
+}
+
+/*
+ * '0x94'
+ *
+ * "Level Start Stop Step [PTT|KEEP_TX] [DWELL=Min[,Max]]"
+ *
+ * Sweep the frequency range with rig_sweep(), and report the
+ * level read at each point as "Freq Value".
+ */
+declare_proto_rig(sweep)
+{
+	rig_sweep_t sw;
+	rig_sweep_point_t *points;
+	struct sweep_out out;
+	char items[MAXARGSZ + 1];
+	char *tok, *saveptr = NULL;
+	int i, count, status;
+
+	memset(&sw, 0, sizeof(sw));
+	sw.dwell_min = SWEEP_DWELL_MIN;
+	sw.dwell_max = SWEEP_DWELL_MAX;
+
+	strncpy(items, arg1, MAXARGSZ);
+	items[MAXARGSZ] = '\0';
+
+	for (i = 0, tok = strtok_r(items, " ", &saveptr); tok;
+			i++, tok = strtok_r(NULL, " ", &saveptr)) {
+		switch (i) {
+		case 0:
+			sw.level = rig_parse_level(tok);
+			break;
+		case 1:
+			CHKSCN1ARG(sscanf(tok, "%"SCNfreq, &sw.start));
+			break;
+		case 2:
+			CHKSCN1ARG(sscanf(tok, "%"SCNfreq, &sw.stop));
+			break;
+		case 3:
+			CHKSCN1ARG(sscanf(tok, "%"SCNfreq, &sw.step));
+			break;
+		default:
+			if (!strcmp(tok, "PTT"))
+				sw.flags |= RIG_SWEEP_PTT;
+			else if (!strcmp(tok, "KEEP_TX"))
+				sw.flags |= RIG_SWEEP_PTT | RIG_SWEEP_KEEP_TX;
+			else if (!strncmp(tok, "DWELL=", 6)) {
+				sw.dwell_min = sw.dwell_max = atoi(tok + 6);
+				if (strchr(tok, ','))
+					sw.dwell_max = atoi(strchr(tok, ',') + 1);
+			} else
+				return -RIG_EINVAL;
+		}
+	}
+	if (i < 4 || !rig_has_get_level(rig, sw.level))
+		return -RIG_EINVAL;
+
+	/* settled within a few % of a float level, or 1 unit */
+	sw.settle = RIG_LEVEL_IS_FLOAT(sw.level) ? 0.05 : 1;
+
+	count = rig_sweep_count(&sw);
+	if (count < 0 || count > SWEEP_MAX_POINTS)
+		return -RIG_EINVAL;
+
+	points = calloc(count, sizeof(rig_sweep_point_t));
+	if (!points)
+		return -RIG_ENOMEM;
+
+	out.fout = fout;
+	out.ctx = ctx;
+	out.level = sw.level;
+
+	status = rig_sweep(rig, vfo, &sw, points, count, sweep_print, &out);
+
+	free(points);
+
+	return status < 0 ? status : RIG_OK;
+}
+
 int dump_chan(FILE *fout, RIG *rig, channel_t *chan)
 {
 	int idx, firstloop=1;
@@ -2709,9 +2873,9 @@ declare_proto_rig(get_ant)
 	status = rig_get_ant(rig, vfo, &ant);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%d%c", rig_setting2idx(ant), resp_sep);
+	fprintf(fout, "%d%c", rig_setting2idx(ant), ctx->resp_sep);
 
 	return status;
 }
@@ -2771,7 +2935,7 @@ declare_proto_rig(get_powerstat)
 	status = rig_get_powerstat(rig, &stat);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
 	fprintf(fout, "%d\n", stat);
 
@@ -2888,3 +3052,408 @@ declare_proto_rig(pause)
   sleep (seconds);
 	return RIG_OK;
 }
+
+/*
+ * '0x8e'--turn the connection into a stream of the level telemetry
+ * samples, "text" or "binary".  rigctld only, and the telemetry has
+ * to be enabled.
+ */
+declare_proto_rig(telemetry)
+{
+	/* a stream cannot be interleaved with the frames */
+	if (!rig->state.telemetry || ctx->binary == RIGCTL_BIN_ON)
+		return -RIG_ENAVAIL;
+
+	if (!strcmp(arg1, "text"))
+		ctx->telemetry = RIGCTL_TLM_TEXT;
+	else if (!strcmp(arg1, "binary"))
+		ctx->telemetry = RIGCTL_TLM_BINARY;
+	else
+		return -RIG_EINVAL;
+
+	return RIG_OK;
+}
+
+/*
+ * Sample the telemetry levels, in turn with the commands
+ */
+int rigctl_telemetry_sample(RIG *my_rig)
+{
+	int retcode;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&rig_mutex);
+#endif
+
+	retcode = rig_telemetry_sample(my_rig);
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&rig_mutex);
+#endif
+
+	return retcode;
+}
+
+static void put_be32(unsigned char *p, unsigned long v)
+{
+	p[0] = (v >> 24) & 0xff;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+/*
+ * Format a telemetry sample into buf, at least RIGCTL_TLM_MAXLEN long.
+ *
+ * text: "seq sec.nsec LEVEL value\n"
+ * binary: big endian seq(32) sec(32) nsec(32), level index(8),
+ * 	1 if float(8), 0(16), value(32) as int or IEEE float
+ *
+ * Returns the number of bytes.
+ */
+int rigctl_telemetry_format(const rig_telemetry_t *sample, int format, char *buf)
+{
+	unsigned char *p = (unsigned char *)buf;
+	int is_float = RIG_LEVEL_IS_FLOAT(sample->level) ? 1 : 0;
+	unsigned long bits;
+	float f;
+
+	if (format == RIGCTL_TLM_TEXT) {
+		if (is_float)
+			return snprintf(buf, RIGCTL_TLM_MAXLEN, "%lu %ld.%09ld %s %g\n",
+					sample->seq, sample->ts_sec, sample->ts_nsec,
+					rig_strlevel(sample->level), sample->val.f);
+		return snprintf(buf, RIGCTL_TLM_MAXLEN, "%lu %ld.%09ld %s %d\n",
+				sample->seq, sample->ts_sec, sample->ts_nsec,
+				rig_strlevel(sample->level), sample->val.i);
+	}
+
+	if (is_float) {
+		f = sample->val.f;
+		memcpy(&bits, &f, sizeof(f));
+		bits &= 0xffffffffUL;
+	} else {
+		bits = (unsigned long)sample->val.i & 0xffffffffUL;
+	}
+
+	put_be32(p, sample->seq);
+	put_be32(p + 4, sample->ts_sec);
+	put_be32(p + 8, sample->ts_nsec);
+	p[12] = rig_setting2idx(sample->level);
+	p[13] = is_float;
+	p[14] = p[15] = 0;
+	put_be32(p + 16, bits);
+
+	return RIGCTL_TLM_BINARY_LEN;
+}
+
+/*
+ * '\binary' -- rigctld only
+ *
+ * Switch the session to the binary frames of netbin.h, right after
+ * the "RPRT 0" of this command.
+ */
+declare_proto_rig(binary)
+{
+	if (ctx->binary == RIGCTL_BIN_NONE)
+		return -RIG_ENAVAIL;
+
+	ctx->binary = RIGCTL_BIN_ON;
+
+	return RIG_OK;
+}
+
+/*
+ * Run a text command line carried by a TEXT frame, its whole
+ * reply going into res, at most max long.
+ * Returns the status of the frame, 1 if the line was 'q'.
+ */
+static int binary_text(RIG *my_rig, struct rigctl_parser_ctx *ctx,
+		const unsigned char *line, size_t len, unsigned char *res,
+		size_t max, size_t *reslen)
+{
+#if defined(HAVE_FMEMOPEN) && defined(HAVE_OPEN_MEMSTREAM)
+	FILE *fin, *fout;
+	char *text = NULL;
+	size_t text_len = 0;
+	int retcode;
+
+	*reslen = 0;
+	if (len == 0)
+		return RIG_OK;
+
+	fin = fmemopen((void *)line, len, "rb");
+	if (!fin)
+		return -RIG_ENOMEM;
+	fout = open_memstream(&text, &text_len);
+	if (!fout) {
+		fclose(fin);
+		return -RIG_ENOMEM;
+	}
+
+	do {
+		retcode = rigctl_parse(my_rig, fin, fout, NULL, 0, ctx);
+	}
+	while (retcode == 0 || retcode == 2);
+
+	fclose(fin);
+	fclose(fout);
+
+	if (text_len > max) {
+		text_len = max;
+		retcode = -RIG_ETRUNC;
+	} else if (retcode != 1) {
+		retcode = RIG_OK;
+	}
+
+	memcpy(res, text, text_len);
+	*reslen = text_len;
+	free(text);
+
+	return retcode;
+#else
+	*reslen = 0;
+	return -RIG_ENIMPL;
+#endif
+}
+
+static unsigned char *binary_ranges(unsigned char *p, const freq_range_t *list)
+{
+	unsigned char *count = p++;
+	int i;
+
+	for (i = 0; i < FRQRANGESIZ && !RIG_IS_FRNG_END(list[i]); i++) {
+		netbin_put_double(p, list[i].start);
+		netbin_put_double(p + 8, list[i].end);
+		netbin_put32(p + 16, list[i].modes);
+		netbin_put32(p + 20, list[i].low_power);
+		netbin_put32(p + 24, list[i].high_power);
+		netbin_put32(p + 28, list[i].vfo);
+		netbin_put32(p + 32, list[i].ant);
+		p += NETBIN_RANGE_LEN;
+	}
+	*count = i;
+
+	return p;
+}
+
+/*
+ * The DUMP_STATE results, see netbin.h.
+ * Returns the length stored in buf, or -RIG_ENOMEM if it is too small.
+ */
+static int binary_dump_state(RIG *rig, unsigned char *buf, size_t size)
+{
+	const struct rig_state *rs = &rig->state;
+	unsigned char *p = buf, *count;
+	int i;
+
+	/* worst case, so that the loops need no check */
+	if (size < 12 + 2 * (1 + FRQRANGESIZ * NETBIN_RANGE_LEN) +
+			(1 + TSLSTSIZ * 8) + (1 + FLTLSTSIZ * 8) + 16 +
+			2 * (1 + MAXDBLSTSIZ * 4) + 6 * 8)
+		return -RIG_ENOMEM;
+
+	netbin_put32(p, NETBIN_PROT_VER);
+	netbin_put32(p + 4, rig->caps->rig_model);
+	netbin_put32(p + 8, rs->itu_region);
+	p += 12;
+
+	p = binary_ranges(p, rs->rx_range_list);
+	p = binary_ranges(p, rs->tx_range_list);
+
+	count = p++;
+	for (i = 0; i < TSLSTSIZ && !RIG_IS_TS_END(rs->tuning_steps[i]); i++) {
+		netbin_put32(p, rs->tuning_steps[i].modes);
+		netbin_put32(p + 4, rs->tuning_steps[i].ts);
+		p += 8;
+	}
+	*count = i;
+
+	count = p++;
+	for (i = 0; i < FLTLSTSIZ && !RIG_IS_FLT_END(rs->filters[i]); i++) {
+		netbin_put32(p, rs->filters[i].modes);
+		netbin_put32(p + 4, rs->filters[i].width);
+		p += 8;
+	}
+	*count = i;
+
+	netbin_put32(p, rs->max_rit);
+	netbin_put32(p + 4, rs->max_xit);
+	netbin_put32(p + 8, rs->max_ifshift);
+	netbin_put32(p + 12, rs->announces);
+	p += 16;
+
+	count = p++;
+	for (i = 0; i < MAXDBLSTSIZ - 1 && rs->preamp[i] != RIG_DBLST_END; i++, p += 4)
+		netbin_put32(p, rs->preamp[i]);
+	*count = i;
+
+	count = p++;
+	for (i = 0; i < MAXDBLSTSIZ - 1 && rs->attenuator[i] != RIG_DBLST_END; i++, p += 4)
+		netbin_put32(p, rs->attenuator[i]);
+	*count = i;
+
+	netbin_put64(p, rs->has_get_func);
+	netbin_put64(p + 8, rs->has_set_func);
+	netbin_put64(p + 16, rs->has_get_level);
+	netbin_put64(p + 24, rs->has_set_level);
+	netbin_put64(p + 32, rs->has_get_parm);
+	netbin_put64(p + 40, rs->has_set_parm);
+	p += 48;
+
+	return p - buf;
+}
+
+/*
+ * Run a binary request frame, len bytes long with its length field,
+ * and store the reply frame in reply, NETBIN_MAX_FRAME long.
+ *
+ * Returns the length of the reply, 0 when the connection is to be
+ * closed.
+ */
+int rigctl_binary_exec(RIG *my_rig, struct rigctl_parser_ctx *ctx,
+		const unsigned char *req, size_t len, unsigned char *reply)
+{
+	const unsigned char *arg = req + NETBIN_REQ_HDR;
+	unsigned char *res = reply + NETBIN_REP_HDR;
+	size_t arglen, reslen = 0;
+	unsigned int id = 0;
+	int op = -1, retcode;
+	vfo_t vfo = RIG_VFO_CURR;
+	freq_t freq;
+	rmode_t mode;
+	pbwidth_t width;
+	ptt_t ptt;
+	setting_t level;
+	value_t val;
+
+	if (len < NETBIN_REQ_HDR) {
+		retcode = -RIG_EPROTO;
+		goto frame_reply;
+	}
+
+	id = netbin_get16(req + 2);
+	op = req[4];
+	vfo = netbin_get32(req + 5);
+	arglen = len - NETBIN_REQ_HDR;
+
+	rig_debug(RIG_DEBUG_TRACE, "%s: id %u op %d vfo %s, %d bytes\n",
+			__func__, id, op, rig_strvfo(vfo), (int)arglen);
+
+	if (op == NETBIN_OP_QUIT)
+		return 0;
+
+	if (op == NETBIN_OP_TEXT) {
+		retcode = binary_text(my_rig, ctx, arg, arglen, res,
+				NETBIN_MAX_FRAME - NETBIN_REP_HDR, &reslen);
+		if (retcode == 1)
+			return 0;
+		goto frame_reply;
+	}
+
+	/* fixed size arguments */
+	switch (op) {
+	case NETBIN_OP_SET_FREQ:
+	case NETBIN_OP_SET_MODE:
+		retcode = arglen < 8 ? -RIG_EINVAL : RIG_OK;
+		break;
+	case NETBIN_OP_SET_PTT:
+		retcode = arglen < 4 ? -RIG_EINVAL : RIG_OK;
+		break;
+	case NETBIN_OP_SET_LEVEL:
+		retcode = arglen < 5 ? -RIG_EINVAL : RIG_OK;
+		break;
+	case NETBIN_OP_GET_LEVEL:
+		retcode = arglen < 1 ? -RIG_EINVAL : RIG_OK;
+		break;
+	default:
+		retcode = RIG_OK;
+		break;
+	}
+	if (retcode != RIG_OK)
+		goto frame_reply;
+
+	freq = 0;
+	mode = RIG_MODE_NONE;
+	width = 0;
+	ptt = RIG_PTT_OFF;
+	val.i = 0;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&rig_mutex);
+#endif
+
+	switch (op) {
+	case NETBIN_OP_DUMP_STATE:
+		retcode = binary_dump_state(my_rig, res, NETBIN_MAX_FRAME - NETBIN_REP_HDR);
+		if (retcode >= 0) {
+			reslen = retcode;
+			retcode = RIG_OK;
+		}
+		break;
+	case NETBIN_OP_SET_FREQ:
+		retcode = rig_set_freq(my_rig, vfo, netbin_get_double(arg));
+		break;
+	case NETBIN_OP_GET_FREQ:
+		retcode = rig_get_freq(my_rig, vfo, &freq);
+		netbin_put_double(res, freq);
+		reslen = 8;
+		break;
+	case NETBIN_OP_SET_MODE:
+		retcode = rig_set_mode(my_rig, vfo, netbin_get32(arg),
+				(int)netbin_get32(arg + 4));
+		break;
+	case NETBIN_OP_GET_MODE:
+		retcode = rig_get_mode(my_rig, vfo, &mode, &width);
+		netbin_put32(res, mode);
+		netbin_put32(res + 4, width);
+		reslen = 8;
+		break;
+	case NETBIN_OP_SET_VFO:
+		retcode = rig_set_vfo(my_rig, vfo);
+		break;
+	case NETBIN_OP_GET_VFO:
+		retcode = rig_get_vfo(my_rig, &vfo);
+		netbin_put32(res, vfo);
+		reslen = 4;
+		break;
+	case NETBIN_OP_SET_PTT:
+		retcode = rig_set_ptt(my_rig, vfo, netbin_get32(arg));
+		break;
+	case NETBIN_OP_GET_PTT:
+		retcode = rig_get_ptt(my_rig, vfo, &ptt);
+		netbin_put32(res, ptt);
+		reslen = 4;
+		break;
+	case NETBIN_OP_SET_LEVEL:
+		level = rig_idx2setting(arg[0]);
+		netbin_get_level(arg + 1, level, &val);
+		retcode = rig_set_level(my_rig, vfo, level, val);
+		break;
+	case NETBIN_OP_GET_LEVEL:
+		level = rig_idx2setting(arg[0]);
+		retcode = rig_get_level(my_rig, vfo, level, &val);
+		netbin_put_level(res, level, val);
+		reslen = 4;
+		break;
+	default:
+		retcode = -RIG_ENIMPL;
+		break;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&rig_mutex);
+#endif
+
+	/* no results with an error */
+	if (retcode != RIG_OK)
+		reslen = 0;
+
+frame_reply:
+	netbin_put16(reply, NETBIN_REP_HDR - 2 + reslen);
+	netbin_put16(reply + 2, id);
+	reply[4] = op;
+	reply[5] = (signed char)retcode;
+
+	return NETBIN_REP_HDR + reslen;
+}
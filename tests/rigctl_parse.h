@@ -28,6 +28,38 @@
 #include <stdio.h>
 #include <hamlib/rig.h>
 
+/*
+ * Per session parser state, so that several sessions (e.g. rigctld
+ * clients) can be parsed concurrently.
+ */
+struct rigctl_parser_ctx {
+	int ext_resp;		/* Extended response protocol requested */
+	unsigned char resp_sep;	/* Response separator */
+	int last_was_ret;	/* Previous char read was an end of line */
+	int reading_stdin;	/* Reading further commands from stdin */
+	int telemetry;		/* Telemetry stream requested, RIGCTL_TLM_* */
+	int binary;		/* Binary frames, RIGCTL_BIN_* */
+
+	/* readline support */
+	char *input_line;
+	char *result;
+	char *parsed_input[5];
+	char *rp_hist_buf;
+};
+
+/* telemetry stream formats, see \telemetry */
+#define RIGCTL_TLM_NONE		0
+#define RIGCTL_TLM_TEXT		1
+#define RIGCTL_TLM_BINARY	2
+
+#define RIGCTL_TLM_BINARY_LEN	20	/* bytes per binary sample */
+#define RIGCTL_TLM_MAXLEN	64	/* max bytes per formatted sample */
+
+/* binary frames, see \binary and netbin.h */
+#define RIGCTL_BIN_NONE		0	/* not offered, e.g. by rigctl */
+#define RIGCTL_BIN_AVAIL	1	/* offered, text until \binary */
+#define RIGCTL_BIN_ON		2	/* binary frames from now on */
+
 /*
  * external prototype
  */
@@ -45,6 +77,15 @@ int dump_chan(FILE *, RIG*, channel_t*);
 int print_conf_list(const struct confparams *cfp, rig_ptr_t data);
 int set_conf(RIG *my_rig, char *conf_parms);
 
-int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc);
+void rigctl_parser_ctx_init(struct rigctl_parser_ctx *ctx);
+void rigctl_parser_ctx_cleanup(struct rigctl_parser_ctx *ctx);
+int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
+		struct rigctl_parser_ctx *ctx);
+
+int rigctl_telemetry_sample(RIG *my_rig);
+int rigctl_telemetry_format(const rig_telemetry_t *sample, int format, char *buf);
+
+int rigctl_binary_exec(RIG *my_rig, struct rigctl_parser_ctx *ctx,
+		const unsigned char *req, size_t len, unsigned char *reply);
 
 #endif	/* RIGCTL_PARSE_H */
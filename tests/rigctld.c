@@ -41,6 +41,9 @@
 #ifdef HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
@@ -61,11 +64,24 @@
 #include <pthread.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <fcntl.h>
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#endif
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
 #include <hamlib/rig.h>
 #include "misc.h"
 #include "iofunc.h"
 #include "serial.h"
 #include "sprintflst.h"
+#include "netbin.h"
 
 #include "rigctl_parse.h"
 
@@ -75,7 +91,7 @@
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:p:d:P:D:s:c:T:t:C:lLuovhV"
+#define SHORT_OPTIONS "m:r:p:d:P:D:s:c:T:t:C:S:lLuoevhV"
 static struct option long_options[] =
 {
 	{"model",       1, 0, 'm'},
@@ -93,6 +109,8 @@ static struct option long_options[] =
 	{"show-conf",   0, 0, 'L'},
 	{"dump-caps",   0, 0, 'u'},
 	{"vfo",         0, 0, 'o'},
+	{"event-loop",  0, 0, 'e'},
+	{"telemetry",   1, 0, 'S'},
 	{"verbose",     0, 0, 'v'},
 	{"help",        0, 0, 'h'},
 	{"version",     0, 0, 'V'},
@@ -107,8 +125,26 @@ struct handle_data {
 };
 
 void * handle_socket(void * arg);
+static void set_nodelay(int sock);
+static void binary_serve(RIG *rig, FILE *fin, FILE *fout,
+		struct rigctl_parser_ctx *ctx);
+#ifdef HAVE_SYS_EPOLL_H
+static int event_loop(RIG *rig, int sock_listen);
+#endif
 void usage(void);
 
+/* levels sampled when -S gives none */
+#define TLM_DEFAULT_LEVELS (RIG_LEVEL_STRENGTH|RIG_LEVEL_RAWSTR|RIG_LEVEL_SWR|\
+		RIG_LEVEL_ALC|RIG_LEVEL_RFPOWER)
+#define TLM_MIN_SIZE 256	/* samples kept in the telemetry ring buffer */
+#define TLM_READ_MAX 64		/* samples fetched per rig_telemetry_read() */
+
+static int tlm_parse(const char *arg);
+#ifdef HAVE_PTHREAD
+static void * tlm_sampler(void *arg);
+static void tlm_stream(RIG *rig, FILE *fout, int format);
+#endif
+
 int interactive = 1;    /* no cmd because of daemon */
 int prompt = 0;         /* Daemon mode for rigparse return string */
 int vfo_mode = 0;       /* vfo_mode=0 means target VFO is current VFO */
@@ -120,6 +156,9 @@ const char *src_addr = NULL; /* INADDR_ANY */
 
 #define MAXCONFLEN 128
 
+int tlm_rate = 0;	/* telemetry sampling rate in Hz, 0 when off */
+setting_t tlm_levels = TLM_DEFAULT_LEVELS;
+
 int main (int argc, char *argv[])
 {
 	RIG *my_rig;		/* handle to rig (instance) */
@@ -140,6 +179,7 @@ int main (int argc, char *argv[])
 	struct addrinfo hints, *result;
 	int sock_listen;
 	int reuseaddr = 1;
+	int use_event_loop = 0;
 
 	while(1) {
 		int c;
@@ -265,6 +305,15 @@ int main (int argc, char *argv[])
 			case 'o':
 				vfo_mode++;
 				break;
+			case 'S':
+				if (!optarg || tlm_parse(optarg) < 0) {
+						usage();	/* wrong arg count */
+						exit(1);
+				}
+				break;
+			case 'e':
+				use_event_loop++;
+				break;
 			case 'v':
 				verbose++;
 				break;
@@ -353,6 +402,22 @@ int main (int argc, char *argv[])
 	rig_debug(RIG_DEBUG_VERBOSE, "Backend version: %s, Status: %s\n",
 			my_rig->caps->version, rig_strstatus(my_rig->caps->status));
 
+	if (tlm_rate > 0) {
+		int size = tlm_rate * 4 * 8;	/* 4 seconds of up to 8 levels */
+
+		retcode = rig_telemetry_setup(my_rig, tlm_levels,
+				size < TLM_MIN_SIZE ? TLM_MIN_SIZE : size);
+		if (retcode != RIG_OK) {
+			fprintf(stderr,"rig_telemetry_setup: error = %s \n",
+					rigerror(retcode));
+			exit(2);
+		}
+#ifdef SIGPIPE
+		/* streaming clients go away without notice */
+		signal(SIGPIPE, SIG_IGN);
+#endif
+	}
+
 #ifdef __MINGW32__
 # ifndef SO_OPENTYPE
 #  define SO_OPENTYPE     0x7008
@@ -413,6 +478,40 @@ int main (int argc, char *argv[])
 		exit (1);
 	}
 
+	if (use_event_loop) {
+#ifdef HAVE_SYS_EPOLL_H
+		retcode = event_loop(my_rig, sock_listen);
+
+		rig_close(my_rig); /* close port */
+		rig_cleanup(my_rig); /* if you care about memory */
+
+		return retcode == 0 ? 0 : 1;
+#else
+		rig_debug(RIG_DEBUG_WARN, "event loop not supported on this "
+				"platform, using a thread per connection\n");
+#endif
+	}
+
+	if (tlm_rate > 0) {
+#ifdef HAVE_PTHREAD
+		pthread_t thread;
+		pthread_attr_t attr;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+		retcode = pthread_create(&thread, &attr, tlm_sampler, my_rig);
+		if (retcode != 0) {
+			rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(retcode));
+			exit(1);
+		}
+#else
+		rig_debug(RIG_DEBUG_WARN, "telemetry not supported on this "
+				"platform\n");
+		rig_telemetry_setup(my_rig, 0, 0);
+#endif
+	}
+
 	/*
 	 * main loop accepting connections
 	 */
@@ -442,6 +541,8 @@ int main (int argc, char *argv[])
 				inet_ntoa(arg->cli_addr.sin_addr),
 				ntohs(arg->cli_addr.sin_port));
 
+		set_nodelay(arg->sock);
+
 #ifdef HAVE_PTHREAD
 		pthread_attr_init(&attr);
 		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
@@ -468,6 +569,21 @@ int main (int argc, char *argv[])
 }
 
 
+/*
+ * Send the replies right away: with the Nagle algorithm, the second
+ * reply to a batch of queries waits for the delayed ACK of the first.
+ */
+static void set_nodelay(int sock)
+{
+#ifdef TCP_NODELAY
+	int nodelay = 1;
+
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+				(char *)&nodelay, sizeof(nodelay)) < 0)
+		rig_debug(RIG_DEBUG_WARN, "setsockopt TCP_NODELAY: %s\n", strerror(errno));
+#endif
+}
+
 /*
  * This is the function run by the threads
  */
@@ -476,6 +592,7 @@ void * handle_socket(void *arg)
 	struct handle_data *handle_data_arg = (struct handle_data *)arg;
 	FILE *fsockin;
 	FILE *fsockout;
+	struct rigctl_parser_ctx parser_ctx;
 	int retcode;
 
 #ifdef __MINGW32__
@@ -506,12 +623,29 @@ void * handle_socket(void *arg)
 		goto handle_exit;
 	}
 
+	rigctl_parser_ctx_init(&parser_ctx);
+	parser_ctx.binary = RIGCTL_BIN_AVAIL;
+
 	do {
-		retcode = rigctl_parse(handle_data_arg->rig, fsockin, fsockout, NULL, 0);
+		retcode = rigctl_parse(handle_data_arg->rig, fsockin, fsockout, NULL, 0,
+				&parser_ctx);
 		if (ferror(fsockin) || ferror(fsockout))
 			retcode = 1;
 	}
-	while (retcode == 0 || retcode == 2);
+	while ((retcode == 0 || retcode == 2) && !parser_ctx.telemetry &&
+			parser_ctx.binary != RIGCTL_BIN_ON);
+
+	/* \binary: frames from now on */
+	if (parser_ctx.binary == RIGCTL_BIN_ON && retcode != 1)
+		binary_serve(handle_data_arg->rig, fsockin, fsockout, &parser_ctx);
+
+#ifdef HAVE_PTHREAD
+	/* \telemetry: no more commands, only samples from now on */
+	if (parser_ctx.telemetry)
+		tlm_stream(handle_data_arg->rig, fsockout, parser_ctx.telemetry);
+#endif
+
+	rigctl_parser_ctx_cleanup(&parser_ctx);
 
 	rig_debug(RIG_DEBUG_VERBOSE, "Connection closed from %s:%d\n",
 				inet_ntoa(handle_data_arg->cli_addr.sin_addr),
@@ -534,6 +668,672 @@ handle_exit:
 	return NULL;
 }
 
+/*
+ * Parse the -S argument, "HZ[,LEVEL...]"
+ */
+static int tlm_parse(const char *arg)
+{
+	char buf[MAXCONFLEN];
+	char *p, *next;
+	setting_t level;
+
+	strncpy(buf, arg, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+
+	next = strchr(buf, ',');
+	if (next)
+		*next++ = '\0';
+
+	tlm_rate = atoi(buf);
+	if (tlm_rate <= 0 || tlm_rate > 1000)
+		return -1;
+
+	if (!next)
+		return 0;
+
+	tlm_levels = 0;
+	for (p = next; p; p = next) {
+		next = strchr(p, ',');
+		if (next)
+			*next++ = '\0';
+		level = rig_parse_level(p);
+		if (level == RIG_LEVEL_NONE) {
+			fprintf(stderr, "Unknown telemetry level '%s'\n", p);
+			return -1;
+		}
+		tlm_levels |= level;
+	}
+
+	return 0;
+}
+
+#ifdef HAVE_PTHREAD
+
+static pthread_mutex_t tlm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tlm_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long tlm_passes;	/* sampling passes done so far */
+
+/*
+ * Thread sampling the telemetry levels at tlm_rate, in turn with
+ * the commands of the clients, and waking up the streams.
+ */
+/* the sampler's clock, immune to clock changes where available */
+static void tlm_now(struct timespec *ts)
+{
+	struct timeval tv;
+
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	if (clock_gettime(CLOCK_MONOTONIC, ts) == 0)
+		return;
+#endif
+
+	gettimeofday(&tv, NULL);
+	ts->tv_sec = tv.tv_sec;
+	ts->tv_nsec = tv.tv_usec * 1000;
+}
+
+static void * tlm_sampler(void *arg)
+{
+	RIG *rig = (RIG *)arg;
+	long period = 1000000000L / tlm_rate;
+	struct timespec next, now, delay;
+
+	tlm_now(&next);
+
+	for (;;) {
+		rigctl_telemetry_sample(rig);
+
+		pthread_mutex_lock(&tlm_mutex);
+		tlm_passes++;
+		pthread_cond_broadcast(&tlm_cond);
+		pthread_mutex_unlock(&tlm_mutex);
+
+		/* fixed schedule, unless the rig cannot keep up */
+		next.tv_nsec += period;
+		if (next.tv_nsec >= 1000000000L) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+
+		tlm_now(&now);
+		delay.tv_sec = next.tv_sec - now.tv_sec;
+		delay.tv_nsec = next.tv_nsec - now.tv_nsec;
+		if (delay.tv_nsec < 0) {
+			delay.tv_sec--;
+			delay.tv_nsec += 1000000000L;
+		}
+		if (delay.tv_sec < 0) {
+			next = now;
+			continue;
+		}
+
+		while (nanosleep(&delay, &delay) < 0 && errno == EINTR)
+			;
+	}
+
+	return NULL;
+}
+
+/*
+ * Stream the telemetry samples to a client until it goes away
+ */
+static void tlm_stream(RIG *rig, FILE *fout, int format)
+{
+	rig_telemetry_t samples[TLM_READ_MAX];
+	char buf[RIGCTL_TLM_MAXLEN];
+	unsigned long cursor, passes;
+	int i, n, len;
+
+	fflush(fout);
+
+	pthread_mutex_lock(&tlm_mutex);
+	passes = tlm_passes;
+	pthread_mutex_unlock(&tlm_mutex);
+
+	rig_telemetry_read(rig, &cursor, NULL, 0);
+
+	while (!ferror(fout)) {
+		pthread_mutex_lock(&tlm_mutex);
+		while (tlm_passes == passes)
+			pthread_cond_wait(&tlm_cond, &tlm_mutex);
+		passes = tlm_passes;
+		pthread_mutex_unlock(&tlm_mutex);
+
+		while ((n = rig_telemetry_read(rig, &cursor, samples,
+						TLM_READ_MAX)) > 0) {
+			for (i = 0; i < n; i++) {
+				len = rigctl_telemetry_format(&samples[i], format, buf);
+				fwrite(buf, 1, len, fout);
+			}
+		}
+		fflush(fout);
+	}
+}
+
+#endif /* HAVE_PTHREAD */
+
+/*
+ * Answer the binary request frames of a client, one at a time,
+ * until it quits or goes away.
+ */
+static void binary_serve(RIG *rig, FILE *fin, FILE *fout,
+		struct rigctl_parser_ctx *ctx)
+{
+	unsigned char *req, *reply;
+	size_t len;
+
+	req = malloc(NETBIN_MAX_FRAME);
+	reply = malloc(NETBIN_MAX_FRAME);
+	if (!req || !reply) {
+		rig_debug(RIG_DEBUG_ERR, "%s: out of memory\n", __func__);
+		free(req);
+		free(reply);
+		return;
+	}
+
+	for (;;) {
+		if (fread(req, 2, 1, fin) != 1)
+			break;
+		len = netbin_get16(req);
+		if (len > 0 && fread(req + 2, len, 1, fin) != 1)
+			break;
+
+		len = rigctl_binary_exec(rig, ctx, req, len + 2, reply);
+		if (len == 0)
+			break;
+
+		if (fwrite(reply, len, 1, fout) != 1 || fflush(fout) != 0)
+			break;
+	}
+
+	free(req);
+	free(reply);
+}
+
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/*
+ * Event loop mode: all the client sockets are non blocking and
+ * multiplexed with epoll in the main thread.  Each connection buffers
+ * its input until a full '\n' terminated command line is received,
+ * and its output until the socket accepts it.  Connections holding
+ * complete lines make up the command queue in front of the rig, which
+ * is serviced one command per connection per pass so that a chatty
+ * client cannot starve the others.
+ */
+
+#define EVLOOP_MAXEVENTS 64
+#define EVLOOP_INBUFSZ 1024
+#define EVLOOP_TLM_BACKLOG 65536	/* unsent telemetry before dropping samples */
+
+struct conn_data {
+	int sock;
+	struct sockaddr_in cli_addr;
+	int closing;		/* peer has shut down its side */
+	struct rigctl_parser_ctx parser_ctx;
+	char *inbuf;		/* received, not parsed yet */
+	size_t inlen;
+	size_t insize;		/* EVLOOP_INBUFSZ, a whole frame once binary */
+	size_t stalled;		/* lines holding a command short of arguments */
+	char *outbuf;		/* replies, not sent yet */
+	size_t outlen;
+	size_t outsize;
+	size_t outpos;
+	int tlm;		/* telemetry stream format, 0 when none */
+	unsigned long tlm_cursor;	/* next telemetry sample to send */
+	struct conn_data *next;
+};
+
+static int set_nonblock(int sock)
+{
+	int flags;
+
+	flags = fcntl(sock, F_GETFL, 0);
+	if (flags < 0)
+		return -1;
+	return fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+}
+
+/*
+ * A full command line, or a full frame in binary mode,
+ * is waiting in the input buffer
+ */
+static int conn_has_line(const struct conn_data *conn)
+{
+	if (conn->parser_ctx.binary == RIGCTL_BIN_ON)
+		return conn->inlen >= 2 &&
+			conn->inlen >= 2 + netbin_get16((unsigned char *)conn->inbuf);
+
+	return memchr(conn->inbuf + conn->stalled, '\n',
+			conn->inlen - conn->stalled) != NULL;
+}
+
+/*
+ * Drain the socket into the input buffer.
+ * Returns -1 when the connection must be dropped.
+ */
+static int conn_read(struct conn_data *conn)
+{
+	size_t size = conn->parser_ctx.binary == RIGCTL_BIN_ON ?
+			NETBIN_MAX_FRAME : EVLOOP_INBUFSZ;
+	ssize_t ret;
+
+	if (conn->insize < size) {
+		char *newbuf = realloc(conn->inbuf, size);
+
+		if (!newbuf) {
+			rig_debug(RIG_DEBUG_ERR, "realloc: %s\n", strerror(errno));
+			return -1;
+		}
+		conn->inbuf = newbuf;
+		conn->insize = size;
+	}
+
+	while (!conn->closing && conn->inlen < conn->insize) {
+		ret = recv(conn->sock, conn->inbuf + conn->inlen,
+				conn->insize - conn->inlen, 0);
+		if (ret > 0) {
+			conn->inlen += ret;
+			/* a telemetry stream takes no more commands */
+			if (conn->tlm)
+				conn->inlen = 0;
+			continue;
+		}
+		if (ret == 0) {
+			conn->closing = 1;
+			break;
+		}
+		if (errno == EINTR)
+			continue;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		rig_debug(RIG_DEBUG_ERR, "recv: %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (conn->inlen == conn->insize && !conn_has_line(conn)) {
+		rig_debug(RIG_DEBUG_ERR, "%s: command line too long\n", __func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Send as much of the output buffer as the socket accepts,
+ * and only watch for writability while something is left.
+ * Returns -1 when the connection must be dropped.
+ */
+static int conn_flush(int epfd, struct conn_data *conn)
+{
+	struct epoll_event ev;
+	ssize_t ret;
+
+	while (conn->outpos < conn->outlen) {
+		ret = send(conn->sock, conn->outbuf + conn->outpos,
+				conn->outlen - conn->outpos, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			rig_debug(RIG_DEBUG_ERR, "send: %s\n", strerror(errno));
+			return -1;
+		}
+		conn->outpos += ret;
+	}
+
+	if (conn->outpos == conn->outlen)
+		conn->outpos = conn->outlen = 0;
+
+	ev.events = conn->closing ? 0 : EPOLLIN;
+	if (conn->outlen)
+		ev.events |= EPOLLOUT;
+	ev.data.ptr = conn;
+	if (epoll_ctl(epfd, EPOLL_CTL_MOD, conn->sock, &ev) < 0) {
+		rig_debug(RIG_DEBUG_ERR, "epoll_ctl: %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int conn_append(struct conn_data *conn, const char *buf, size_t len)
+{
+	if (conn->outlen + len > conn->outsize) {
+		size_t newsize = conn->outsize ? conn->outsize : 256;
+		char *newbuf;
+
+		while (newsize < conn->outlen + len)
+			newsize *= 2;
+		newbuf = realloc(conn->outbuf, newsize);
+		if (!newbuf)
+			return -1;
+		conn->outbuf = newbuf;
+		conn->outsize = newsize;
+	}
+	memcpy(conn->outbuf + conn->outlen, buf, len);
+	conn->outlen += len;
+
+	return 0;
+}
+
+/*
+ * Run the first command of the connection through rigctl_parse(),
+ * or its first frame through rigctl_binary_exec(), and queue its reply.
+ * A command may take its arguments from the following lines, as with
+ * the threads, so it is parsed from all the complete lines received.
+ * Returns -1 when the connection must be dropped.
+ */
+static int conn_exec(RIG *rig, struct conn_data *conn)
+{
+	static unsigned char frame[NETBIN_MAX_FRAME];
+	FILE *fin, *fout;
+	char *reply = NULL;
+	size_t reply_len = 0;
+	size_t linelen;
+	int retcode;
+
+	if (conn->parser_ctx.binary == RIGCTL_BIN_ON) {
+		if (!conn_has_line(conn))
+			return 0;
+		linelen = 2 + netbin_get16((unsigned char *)conn->inbuf);
+
+		reply_len = rigctl_binary_exec(rig, &conn->parser_ctx,
+				(unsigned char *)conn->inbuf, linelen, frame);
+
+		conn->inlen -= linelen;
+		memmove(conn->inbuf, conn->inbuf + linelen, conn->inlen);
+
+		if (reply_len == 0 || conn_append(conn, (char *)frame, reply_len) < 0)
+			return -1;
+		return 0;
+	}
+
+	/* whole lines only, not to cut an argument */
+	for (linelen = conn->inlen; linelen > 0; linelen--)
+		if (conn->inbuf[linelen - 1] == '\n')
+			break;
+	if (linelen <= conn->stalled)
+		return 0;
+
+	fin = fmemopen(conn->inbuf, linelen, "rb");
+	if (!fin) {
+		rig_debug(RIG_DEBUG_ERR, "fmemopen: %s\n", strerror(errno));
+		return -1;
+	}
+	fout = open_memstream(&reply, &reply_len);
+	if (!fout) {
+		rig_debug(RIG_DEBUG_ERR, "open_memstream: %s\n", strerror(errno));
+		fclose(fin);
+		return -1;
+	}
+
+	retcode = rigctl_parse(rig, fin, fout, NULL, 0, &conn->parser_ctx);
+
+	/* out of input before its arguments, nothing run: wait for them */
+	if (retcode == -1 && feof(fin) && !conn->closing) {
+		fclose(fin);
+		fclose(fout);
+		free(reply);
+		conn->stalled = linelen;
+		return 0;
+	}
+	if (retcode != -1)
+		linelen = ftell(fin);
+	conn->stalled = 0;
+
+	fclose(fin);
+	fclose(fout);
+
+	conn->inlen -= linelen;
+	memmove(conn->inbuf, conn->inbuf + linelen, conn->inlen);
+
+	if (conn_append(conn, reply, reply_len) < 0)
+		retcode = 1;
+	free(reply);
+
+	/* \telemetry: only samples to come from now on */
+	if (conn->parser_ctx.telemetry && !conn->tlm) {
+		conn->tlm = conn->parser_ctx.telemetry;
+		conn->inlen = 0;
+		rig_telemetry_read(rig, &conn->tlm_cursor, NULL, 0);
+	}
+
+	/* 'q' or 'Q' asks for the connection to be closed */
+	return retcode == 1 ? -1 : 0;
+}
+
+static void conn_close(int epfd, struct conn_data *conn)
+{
+	rig_debug(RIG_DEBUG_VERBOSE, "Connection closed from %s:%d\n",
+				inet_ntoa(conn->cli_addr.sin_addr),
+				ntohs(conn->cli_addr.sin_port));
+
+	epoll_ctl(epfd, EPOLL_CTL_DEL, conn->sock, NULL);
+	close(conn->sock);
+	rigctl_parser_ctx_cleanup(&conn->parser_ctx);
+	free(conn->inbuf);
+	free(conn->outbuf);
+	free(conn);
+}
+
+static void accept_conns(int epfd, int sock_listen, struct conn_data **conns)
+{
+	struct epoll_event ev;
+	struct conn_data *conn;
+	socklen_t clilen;
+
+	for (;;) {
+		conn = calloc(1, sizeof(struct conn_data));
+		if (!conn) {
+			rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+			return;
+		}
+
+		clilen = sizeof(conn->cli_addr);
+		conn->sock = accept(sock_listen, (struct sockaddr *)&conn->cli_addr,
+				&clilen);
+		if (conn->sock < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				rig_debug(RIG_DEBUG_ERR, "accept: %s\n", strerror(errno));
+			free(conn);
+			return;
+		}
+
+		ev.events = EPOLLIN;
+		ev.data.ptr = conn;
+		if (set_nonblock(conn->sock) < 0 ||
+				epoll_ctl(epfd, EPOLL_CTL_ADD, conn->sock, &ev) < 0) {
+			rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+			close(conn->sock);
+			free(conn);
+			continue;
+		}
+
+		rig_debug(RIG_DEBUG_VERBOSE, "Connection opened from %s:%d\n",
+				inet_ntoa(conn->cli_addr.sin_addr),
+				ntohs(conn->cli_addr.sin_port));
+
+		set_nodelay(conn->sock);
+
+		rigctl_parser_ctx_init(&conn->parser_ctx);
+		conn->parser_ctx.binary = RIGCTL_BIN_AVAIL;
+
+		conn->next = *conns;
+		*conns = conn;
+	}
+}
+
+#ifdef HAVE_SYS_TIMERFD_H
+/*
+ * Telemetry timer expiry: sample, and queue the new samples
+ * to the streams which are not too far behind.
+ */
+static void tlm_tick(RIG *rig, int epfd, int tfd, struct conn_data *conns)
+{
+	rig_telemetry_t samples[TLM_READ_MAX];
+	char buf[RIGCTL_TLM_MAXLEN];
+	struct conn_data *conn;
+	uint64_t expirations;
+	int i, n, len;
+
+	if (read(tfd, &expirations, sizeof(expirations)) < 0)
+		return;
+
+	rigctl_telemetry_sample(rig);
+
+	for (conn = conns; conn; conn = conn->next) {
+		if (!conn->tlm || conn->closing == 2)
+			continue;
+
+		while (conn->outlen < EVLOOP_TLM_BACKLOG &&
+				(n = rig_telemetry_read(rig, &conn->tlm_cursor,
+						samples, TLM_READ_MAX)) > 0) {
+			for (i = 0; i < n; i++) {
+				len = rigctl_telemetry_format(&samples[i], conn->tlm, buf);
+				if (conn_append(conn, buf, len) < 0)
+					conn->closing = 2;
+			}
+		}
+
+		if (conn->closing < 2 && conn_flush(epfd, conn) < 0)
+			conn->closing = 2;
+	}
+}
+#endif
+
+/*
+ * Single threaded replacement for the accept loop/thread per client.
+ * Only returns on fatal error.
+ */
+static int event_loop(RIG *rig, int sock_listen)
+{
+	struct epoll_event ev, events[EVLOOP_MAXEVENTS];
+	struct conn_data *conns = NULL, *conn, **pconn;
+	int epfd, nfds, i;
+	int pending = 0;
+	int tfd = -1;
+	static char tlm_timer;	/* epoll data of the telemetry timer */
+
+	epfd = epoll_create(EVLOOP_MAXEVENTS);
+	if (epfd < 0) {
+		rig_debug(RIG_DEBUG_ERR, "epoll_create: %s\n", strerror(errno));
+		return -1;
+	}
+
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;	/* the listening socket */
+	if (set_nonblock(sock_listen) < 0 ||
+			epoll_ctl(epfd, EPOLL_CTL_ADD, sock_listen, &ev) < 0) {
+		rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+		close(epfd);
+		return -1;
+	}
+
+	if (rig->state.telemetry) {
+#ifdef HAVE_SYS_TIMERFD_H
+		struct itimerspec its;
+
+		/* tv_nsec must stay below one second, e.g. with -S 1 */
+		its.it_interval.tv_sec = 1 / tlm_rate;
+		its.it_interval.tv_nsec = (1000000000L / tlm_rate) % 1000000000L;
+		its.it_value = its.it_interval;
+
+		ev.events = EPOLLIN;
+		ev.data.ptr = &tlm_timer;
+		tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+		if (tfd < 0 || timerfd_settime(tfd, 0, &its, NULL) < 0 ||
+				epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &ev) < 0) {
+			rig_debug(RIG_DEBUG_ERR, "telemetry timer: %s\n", strerror(errno));
+			if (tfd >= 0)
+				close(tfd);
+			close(epfd);
+			return -1;
+		}
+#else
+		rig_debug(RIG_DEBUG_WARN, "telemetry not supported by the event "
+				"loop on this platform\n");
+		rig_telemetry_setup(rig, 0, 0);
+#endif
+	}
+
+	for (;;) {
+		/* don't block while commands are waiting in the queue */
+		nfds = epoll_wait(epfd, events, EVLOOP_MAXEVENTS, pending ? 0 : -1);
+		if (nfds < 0) {
+			if (errno == EINTR)
+				continue;
+			rig_debug(RIG_DEBUG_ERR, "epoll_wait: %s\n", strerror(errno));
+			break;
+		}
+
+		for (i = 0; i < nfds; i++) {
+			conn = events[i].data.ptr;
+			if (!conn) {
+				accept_conns(epfd, sock_listen, &conns);
+				continue;
+			}
+#ifdef HAVE_SYS_TIMERFD_H
+			if (events[i].data.ptr == &tlm_timer) {
+				tlm_tick(rig, epfd, tfd, conns);
+				continue;
+			}
+#endif
+			if (events[i].events & (EPOLLIN|EPOLLHUP|EPOLLERR)) {
+				if (conn_read(conn) < 0)
+					conn->closing = 2;
+				/* stop watching input once the peer is done */
+				else if (conn->closing && conn_flush(epfd, conn) < 0)
+					conn->closing = 2;
+			}
+			if (events[i].events & EPOLLOUT) {
+				if (conn_flush(epfd, conn) < 0)
+					conn->closing = 2;
+			}
+		}
+
+		/*
+		 * command queue: one command per connection and per pass
+		 */
+		pending = 0;
+		pconn = &conns;
+		while ((conn = *pconn) != NULL) {
+			if (conn->closing < 2 && conn_has_line(conn)) {
+				if (conn_exec(rig, conn) < 0 || conn_flush(epfd, conn) < 0)
+					conn->closing = 2;
+				else if (conn_has_line(conn))
+					pending = 1;
+			}
+
+			/* closed by peer, and nothing left to answer */
+			if (conn->closing == 1 && !conn_has_line(conn) &&
+					conn->outlen == 0)
+				conn->closing = 2;
+
+			if (conn->closing == 2) {
+				*pconn = conn->next;
+				conn_close(epfd, conn);
+			} else
+				pconn = &conn->next;
+		}
+	}
+
+	while (conns) {
+		conn = conns;
+		conns = conn->next;
+		conn_close(epfd, conn);
+	}
+	if (tfd >= 0)
+		close(tfd);
+	close(epfd);
+
+	return -1;
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
+
 void usage(void)
 {
 	printf("Usage: rigctld [OPTION]...\n"
@@ -556,6 +1356,8 @@ void usage(void)
 	"  -l, --list                 list all model numbers and exit\n"
 	"  -u, --dump-caps            dump capabilities and exit\n"
 	"  -o, --vfo                  do not default to VFO_CURR, require extra vfo arg\n"
+	"  -e, --event-loop           serve all connections from a single event loop\n"
+	"  -S, --telemetry=HZ[,LEVEL...] sample LEVELs at HZ for \\telemetry streams\n"
 	"  -v, --verbose              set verbose mode, cumulative\n"
 	"  -h, --help                 display this help and exit\n"
 	"  -V, --version              output version information and exit\n\n",
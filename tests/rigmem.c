@@ -57,6 +57,9 @@ extern int csv_load (RIG *rig, const char *infilename);
 extern int csv_parm_save (RIG *rig, const char *outfilename);
 extern int csv_parm_load (RIG *rig, const char *infilename);
 
+extern int load_chan (RIG *rig, const channel_t *chan);
+extern int load_chan_end (RIG *rig);
+
 /*
  * Prototypes
  */
@@ -71,7 +74,7 @@ int clear_chans (RIG *rig, const char *infilename);
  * 		keep up to date SHORT_OPTIONS, usage()'s output and man page. thanks.
  * NB: do NOT use -W since it's reserved by POSIX.
  */
-#define SHORT_OPTIONS "m:r:s:c:C:p:axvhV"
+#define SHORT_OPTIONS "m:r:s:c:C:p:andxvhV"
 static struct option long_options[] =
 {
 	{"model",    1, 0, 'm'},
@@ -81,6 +84,8 @@ static struct option long_options[] =
 	{"set-conf", 1, 0, 'C'},
 	{"set-separator", 1, 0, 'p'},
 	{"all",  0, 0, 'a'},
+	{"dry-run",  0, 0, 'n'},
+	{"delete",  0, 0, 'd'},
 #ifdef HAVE_XML2
 	{"xml",  0, 0, 'x'},
 #endif
@@ -93,6 +98,18 @@ static struct option long_options[] =
 #define MAXCONFLEN 128
 
 int all;
+int diff_flags;
+int diff_count[RIG_CHAN_DELETED+1];
+
+/*
+ * Channels parsed but not yet compared with the rig memory
+ */
+#define LOAD_BATCH 32
+
+static channel_t load_batch[LOAD_BATCH];
+static int load_batch_len;
+static unsigned char *load_listed;	/* channel seen in the file */
+static int load_deleting;
 
 int main (int argc, char *argv[])
 {
@@ -171,6 +188,12 @@ int main (int argc, char *argv[])
 			case 'a':
 					all++;
 					break;
+			case 'n':
+					diff_flags |= RIG_CHAN_DIFF_DRYRUN;
+					break;
+			case 'd':
+					diff_flags |= RIG_CHAN_DIFF_DELETE;
+					break;
 #ifdef HAVE_XML2
 			case 'x':
 					xml++;
@@ -262,6 +285,11 @@ int main (int argc, char *argv[])
 			retcode = xml_load(rig, argv[optind+1]);
 		else
 			retcode = csv_load(rig, argv[optind+1]);
+		if (retcode == RIG_OK)
+			printf("%s%d channels unchanged, %d changed, %d new, %d deleted\n",
+					diff_flags & RIG_CHAN_DIFF_DRYRUN ? "Dry run: " : "",
+					diff_count[RIG_CHAN_SAME], diff_count[RIG_CHAN_CHANGED],
+					diff_count[RIG_CHAN_NEW], diff_count[RIG_CHAN_DELETED]);
 	} else
 	if (!strcmp(argv[optind], "save_parm")) {
 		if (xml)
@@ -315,6 +343,8 @@ void usage()
 	"  -C, --set-conf=PARM=VAL    set config parameters\n"
 	"  -p, --set-separator=SEP    set character separator instead of the CSV comma\n"
 	"  -a, --all                  bypass mem_caps, apply to all fields of channel_t\n"
+	"  -n, --dry-run              load: only report the channels to be written\n"
+	"  -d, --delete               load: delete the channels missing from FILE\n"
 #ifdef HAVE_XML2
 	"  -x, --xml                  use XML format instead of CSV\n"
 #endif
@@ -360,6 +390,119 @@ int set_conf(RIG *rig, char *conf_parms)
 }
 
 
+static const char *diff_str[] = { "unchanged", "changed", "new", "deleted" };
+
+static int report_diff (RIG *rig, const channel_t *chan, chan_diff_t diff, rig_ptr_t arg)
+{
+	/* channels already empty when deleting the ones not in the file */
+	if (load_deleting && diff == RIG_CHAN_SAME)
+		return RIG_OK;
+
+	diff_count[diff]++;
+
+	if (diff != RIG_CHAN_SAME)
+		printf("Channel %d: %s\n", chan->channel_num, diff_str[diff]);
+
+	return RIG_OK;
+}
+
+static int load_flush (RIG *rig)
+{
+	int n = load_batch_len;
+
+	load_batch_len = 0;
+
+	return rig_set_chan_diff(rig, load_batch, n,
+			diff_flags & ~RIG_CHAN_DIFF_DELETE, report_diff, NULL);
+}
+
+/*
+ * Queue a channel parsed from the file being loaded.  Channels are
+ * written by batches, as soon as parsed, skipping the memories already
+ * holding the same data, so the file never has to be held in memory.
+ */
+int load_chan (RIG *rig, const channel_t *chan)
+{
+	int idx = 0, i, ret;
+	const chan_t *chan_list = rig->state.chan_list;
+
+	if (!load_listed) {
+		load_listed = calloc(rig_mem_count(rig) + 1, 1);
+		if (!load_listed)
+			return -RIG_ENOMEM;
+	}
+
+	for (i=0; i < CHANLSTSIZ && chan_list[i].type; i++) {
+		if (chan->channel_num >= chan_list[i].start &&
+				chan->channel_num <= chan_list[i].end) {
+			load_listed[idx + chan->channel_num - chan_list[i].start] = 1;
+			break;
+		}
+		idx += chan_list[i].end - chan_list[i].start + 1;
+	}
+
+	memcpy(&load_batch[load_batch_len++], chan, sizeof(channel_t));
+
+	if (load_batch_len < LOAD_BATCH)
+		return RIG_OK;
+
+	ret = load_flush(rig);
+	if (ret != RIG_OK) {
+		/* the load stops there, load_chan_end() won't be called */
+		free(load_listed);
+		load_listed = NULL;
+	}
+
+	return ret;
+}
+
+/*
+ * Write the channels still queued, then delete the memories
+ * missing from the file if asked to.
+ */
+int load_chan_end (RIG *rig)
+{
+	int i, j, idx = 0, ret;
+	const chan_t *chan_list = rig->state.chan_list;
+	channel_t *chan;
+
+	ret = load_flush(rig);
+
+	if (ret != RIG_OK || !(diff_flags & RIG_CHAN_DIFF_DELETE) || !load_listed)
+		goto out;
+
+	load_deleting = 1;
+
+	for (i=0; i < CHANLSTSIZ && chan_list[i].type; i++) {
+		for (j = chan_list[i].start; j <= chan_list[i].end; j++, idx++) {
+			if (load_listed[idx])
+				continue;
+
+			chan = &load_batch[load_batch_len++];
+			memset(chan, 0, sizeof(channel_t));
+			chan->freq = RIG_FREQ_NONE;
+			chan->tx_freq = RIG_FREQ_NONE;
+			chan->vfo = RIG_VFO_MEM;
+			chan->channel_num = j;
+
+			if (load_batch_len == LOAD_BATCH) {
+				ret = load_flush(rig);
+				if (ret != RIG_OK)
+					goto out;
+			}
+		}
+	}
+
+	ret = load_flush(rig);
+
+out:
+	load_deleting = 0;
+	free(load_listed);
+	load_listed = NULL;
+
+	return ret;
+}
+
 /*
  * Pretty nasty, clears everything you have in rig memory
  */
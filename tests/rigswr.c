@@ -44,13 +44,14 @@
 static void usage();
 static void version();
 static int set_conf(RIG *rig, char *conf_parms);
+static int print_point(RIG *rig, const rig_sweep_point_t *point, rig_ptr_t arg);
 
 /*
  * Reminder: when adding long options,
  *  keep up to date SHORT_OPTIONS, usage()'s output and man page. thanks.
  * NB: do NOT use -W since it's reserved by POSIX.
  */
-#define SHORT_OPTIONS "m:r:s:c:C:p:P:vhV"
+#define SHORT_OPTIONS "m:r:s:c:C:p:P:d:kvhV"
 static struct option long_options[] =
 {
 	{"model",    1, 0, 'm'},
@@ -60,6 +61,8 @@ static struct option long_options[] =
 	{"set-conf", 1, 0, 'C'},
 	{"ptt-file", 1, 0, 'p'},
 	{"ptt-type", 1, 0, 'P'},
+	{"dwell",    1, 0, 'd'},
+	{"keep-tx",  0, 0, 'k'},
 	{"verbose",  0, 0, 'v'},
 	{"help",     0, 0, 'h'},
 	{"version",  0, 0, 'V'},
@@ -68,6 +71,10 @@ static struct option long_options[] =
 
 #define MAXCONFLEN 128
 
+#define DWELL_MIN 50	/* ms before the first SWR reading */
+#define DWELL_MAX 500	/* ms at most for the SWR to settle */
+#define SWR_SETTLE 0.05
+
 
 int main (int argc, char *argv[])
 {
@@ -85,6 +92,11 @@ int main (int argc, char *argv[])
 	freq_t freq,freqstop;
 	freq_t step=kHz(100);
 	value_t pwr;
+	rig_sweep_t sweep;
+	rig_sweep_point_t *points;
+	int count;
+	int dwell_min = DWELL_MIN, dwell_max = DWELL_MAX;
+	int keep_tx = 0;
 
 	while(1) {
 		int c;
@@ -164,6 +176,18 @@ int main (int argc, char *argv[])
 			else
 				ptt_type = atoi(optarg);
 			break;
+		case 'd':
+			if (!optarg) {
+				usage();	/* wrong arg count */
+				exit(1);
+			}
+			dwell_min = dwell_max = atoi(optarg);
+			if (strchr(optarg, ','))
+				dwell_max = atoi(strchr(optarg, ',') + 1);
+			break;
+		case 'k':
+			keep_tx = 1;
+			break;
 		case 'v':
 			verbose++;
 			break;
@@ -237,28 +261,59 @@ int main (int argc, char *argv[])
 	if (optind < argc)
 		step=atof(argv[optind]);
 
+	memset(&sweep, 0, sizeof(sweep));
+	sweep.start = freq;
+	sweep.stop = freqstop;
+	sweep.step = step;
+	sweep.level = RIG_LEVEL_SWR;
+	sweep.flags = RIG_SWEEP_PTT | (keep_tx ? RIG_SWEEP_KEEP_TX : 0);
+	sweep.dwell_min = dwell_min;
+	sweep.dwell_max = dwell_max;
+	sweep.settle = SWR_SETTLE;
+
+	count = rig_sweep_count(&sweep);
+	if (count < 0) {
+		fprintf(stderr, "Invalid frequency range\n");
+		exit(1);
+	}
+	points = calloc(count, sizeof(rig_sweep_point_t));
+	if (!points) {
+		fprintf(stderr, "Out of memory\n");
+		exit(2);
+	}
+
 	rig_set_freq(rig,RIG_VFO_CURR,freq);
 	rig_set_mode(rig,RIG_VFO_CURR,RIG_MODE_CW,RIG_PASSBAND_NORMAL);
 
 	pwr.f = 0.25;	/* 25% of RF POWER */
 	rig_set_level(rig,RIG_VFO_CURR,RIG_LEVEL_RFPOWER,pwr);
 
-	while(freq<=freqstop) {
-		value_t swr;
+	retcode = rig_sweep(rig, RIG_VFO_CURR, &sweep, points, count,
+			print_point, NULL);
+	if (retcode < 0)
+		fprintf(stderr, "rig_sweep: error = %s\n", rigerror(retcode));
 
-		rig_set_ptt(rig,RIG_VFO_CURR,RIG_PTT_ON);
-		usleep(500000);
-		rig_get_level(rig,RIG_VFO_CURR,RIG_LEVEL_SWR,&swr);
-		rig_set_ptt(rig,RIG_VFO_CURR,RIG_PTT_OFF);
+	free(points);
+	rig_close(rig);
 
-		printf("%10.0f %4.2f\n",freq,swr.f);
-		freq+=step;
-		rig_set_freq(rig,RIG_VFO_CURR,freq);
-	}
+	return retcode < 0 ? 2 : 0;
+}
 
-	rig_close(rig);
+/*
+ * called once the next frequency is set, while the rig settles
+ */
+int print_point(RIG *rig, const rig_sweep_point_t *point, rig_ptr_t arg)
+{
+	if (point->status != RIG_OK)
+		printf("%10.0f ?\n", point->freq);
+	else
+		printf("%10.0f %4.2f\n", point->freq, point->val.f);
+
+	rig_debug(RIG_DEBUG_VERBOSE, "%.0f Hz settled in %d ms\n",
+			point->freq, point->dwell);
+
+	return 1;
 
-	return 0;
 }
 
 
@@ -283,6 +338,8 @@ void usage()
 	"  -C, --set-conf=PARM=VAL    set config parameters\n"
 	"  -p, --ptt-file=DEVICE      set device of the PTT device to operate on\n"
 	"  -P, --ptt-type=TYPE        set type of the PTT device to operate on\n"
+	"  -d, --dwell=MIN[,MAX]      wait MIN ms, up to MAX for the SWR to settle\n"
+	"  -k, --keep-tx              keep transmitting while changing frequency\n"
 	"  -v, --verbose              set verbose mode, cumulative\n"
 	"  -h, --help                 display this help and exit\n"
 	"  -V, --version              output version information and exit\n\n"
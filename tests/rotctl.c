@@ -125,6 +125,7 @@ int main (int argc, char *argv[])
 
 	int retcode;		/* generic return code from functions */
 	int exitcode;
+	struct rotctl_parser_ctx parser_ctx;
 
 	int verbose = 0;
 	int show_conf = 0;
@@ -319,13 +320,17 @@ int main (int argc, char *argv[])
 	}
 #endif	/* HAVE_LIBREADLINE */
 
+	rotctl_parser_ctx_init(&parser_ctx);
+
 	do {
-		retcode = rotctl_parse(my_rot, stdin, stdout, argv, argc);
+		retcode = rotctl_parse(my_rot, stdin, stdout, argv, argc, &parser_ctx);
 		if (retcode == 2)
 			exitcode = 2;
 	}
 	while (retcode == 0 || retcode == 2);
 
+	rotctl_parser_ctx_cleanup(&parser_ctx);
+
 #ifdef HAVE_LIBREADLINE
 	if (interactive && prompt && have_rl) {
 #ifdef HAVE_READLINE_HISTORY
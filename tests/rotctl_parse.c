@@ -84,8 +84,7 @@ extern int read_history ();
 
 #include "rotctl_parse.h"
 
-/* Hash table implementation See:  http://uthash.sourceforge.net/ */
-#include "uthash.h"
+#include "cmd_index.h"
 
 #ifdef HAVE_PTHREAD
 #include <pthread.h>
@@ -114,17 +113,9 @@ static pthread_mutex_t rot_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define ARG_IN  (ARG_IN1|ARG_IN2|ARG_IN3|ARG_IN4)
 #define ARG_OUT  (ARG_OUT1|ARG_OUT2|ARG_OUT3|ARG_OUT4)
 
-/* variables for readline support */
+/* readline support, its buffers are kept in struct rotctl_parser_ctx */
 #ifdef HAVE_LIBREADLINE
-static char *input_line = (char *)NULL;
-static char *result = (char *)NULL;
-static char *parsed_input[sizeof(char) * 7];
 static const int have_rl = 1;
-
-#ifdef HAVE_READLINE_HISTORY
-static char *rp_hist_buf = (char *)NULL;
-#endif
-
 #else                               /* no readline */
 static const int have_rl = 0;
 #endif
@@ -132,8 +123,9 @@ static const int have_rl = 0;
 struct test_table {
 	unsigned char cmd;
 	const char *name;
-    	int (*rot_routine)(ROT*, FILE*, int, const struct test_table*, const char*,
-					const char*, const char*, const char*, const char*, const char*);
+    	int (*rot_routine)(ROT*, FILE*, int, struct rotctl_parser_ctx*,
+					const struct test_table*, const char*, const char*,
+					const char*, const char*, const char*, const char*);
 	int flags;
 	const char *arg1;
 	const char *arg2;
@@ -147,7 +139,8 @@ struct test_table {
 
 #define ACTION(f) rigctl_##f
 #define declare_proto_rot(f) static int (ACTION(f))(ROT *rot, FILE *fout, int interactive, \
-			const struct test_table *cmd, const char *arg1, const char *arg2, \
+			struct rotctl_parser_ctx *ctx, const struct test_table *cmd, \
+			const char *arg1, const char *arg2, \
 			const char *arg3, const char *arg4, const char *arg5, const char *arg6)
 
 declare_proto_rot(set_position);
@@ -204,102 +197,42 @@ struct test_table test_list[] = {
 
 };
 
-struct test_table *find_cmd_entry(int cmd)
-{
-	int i;
-	for (i = 0; i < MAXNBOPT && test_list[i].cmd != 0x00; i++)
-		if (test_list[i].cmd == cmd)
-			break;
-
-	if (i >= MAXNBOPT || test_list[i].cmd == 0x00)
-		return NULL;
-
-	return &test_list[i];
-}
-
-/* Structure for hash table provided by uthash.h
- *
- * Structure and hash funtions patterned after/copied from example.c
- * distributed with the uthash package. See:  http://uthash.sourceforge.net/
+/*
+ * Command index, see cmd_index.h
  */
-struct mod_lst
-{
-	int id;			/* caps->rot_model This is the hash key */
-	char mfg_name[32];	/* caps->mfg_name */
-	char model_name[32];	/* caps->model_name */
-	char version[32];	/* caps->version */
-	char status[32];	/* caps->status */
-	UT_hash_handle hh;	/* makes this structure hashable */
-};
-
-/* Hash declaration.  Must be initialized to NULL */
-struct mod_lst *models = NULL;
-
-/* Add model information to the hash */
-void hash_add_model(int id, const char *mfg_name, const char *model_name,
-                     const char *version, const char *status)
-{
-	struct mod_lst *s;
-
-	s = (struct mod_lst*)malloc(sizeof(struct mod_lst));
-
-	s->id = id;
-	snprintf(s->mfg_name, sizeof(s->mfg_name), "%s", mfg_name);
-	snprintf(s->model_name, sizeof(s->model_name), "%s", model_name);
-	snprintf(s->version, sizeof(s->version), "%s", version);
-	snprintf(s->status, sizeof(s->status), "%s", status);
+CMD_INDEX_DEFINE(cmd_index, test_list)
 
-	HASH_ADD_INT(models, id, s);	/* id: name of key field */
-}
-
-/* Hash sorting functions */
-int hash_model_id_sort(struct mod_lst *a, struct mod_lst *b)
-{
-	return (a->id - b->id);
-}
-
-void hash_sort_by_model_id()
+struct test_table *find_cmd_entry(int cmd)
 {
-    HASH_SORT(models, hash_model_id_sort);
-}
-
-/* Delete hash */
-void hash_delete_all() {
-	struct mod_lst *current_model, *tmp;
-
-	HASH_ITER(hh, models, current_model, tmp) {
-		HASH_DEL(models, current_model);	/* delete it (models advances to next) */
-		free(current_model);			/* free it */
-	}
+	return (struct test_table *)cmd_index_find(&cmd_index, cmd);
 }
 
-
 #ifdef HAVE_LIBREADLINE
 /* Frees allocated memory and sets pointers to NULL before calling readline
  * and then parses the input into space separated tokens.
  */
-static void rp_getline(const char *s)
+static void rp_getline(struct rotctl_parser_ctx *ctx, const char *s)
 {
 	int i;
 
 	/* free allocated memory and set pointers to NULL */
-	if (input_line) {
-		free(input_line);
-		input_line = (char *)NULL;
+	if (ctx->input_line) {
+		free(ctx->input_line);
+		ctx->input_line = (char *)NULL;
 	}
 
-	if (result) {
-		result = (char *)NULL;
+	if (ctx->result) {
+		ctx->result = (char *)NULL;
 	}
 
 	/* cmd, arg1, arg2, arg3, arg4, arg5, arg6
 	 * arg5 and arg 6 are currently unused.
 	 */
 	for (i = 0; i < 7; i++)
-		parsed_input[i] = NULL;
+		ctx->parsed_input[i] = NULL;
 
 	/* Action!  Returns typed line with newline stripped. */
-	input_line = readline(s);
+	ctx->input_line = readline(s);
 }
 
 
@@ -311,11 +244,9 @@ static void rp_getline(const char *s)
  */
 char parse_arg(const char *arg)
 {
-		int i;
-		for (i = 0; i < MAXNBOPT && test_list[i].cmd != 0; i++)
-				if (!strncmp(arg, test_list[i].name, MAXNAMSIZ))
-						return test_list[i].cmd;
-		return 0;
+	const struct test_table *found = cmd_index_lookup(&cmd_index, arg);
+
+	return found ? found->cmd : 0;
 }
 
 /*
@@ -345,23 +276,23 @@ static int scanfc(FILE *fin, const char *format, void *p)
  * returns <0 is error number
  * returns >=0 when successful
  */
-static int next_word (char *buffer, int argc, char *argv[], int newline)
+static int next_word (struct rotctl_parser_ctx *ctx, char *buffer, int argc,
+		char *argv[], int newline)
 {
   int ret;
   char c;
-  static int reading_stdin;
 
-  if (!reading_stdin)
+  if (!ctx->reading_stdin)
     {
       if (optind >= argc) return EOF;
       else if ('-' == argv[optind][0])
         {
           ++optind;
-          reading_stdin = 1;
+          ctx->reading_stdin = 1;
         }
     }
 
-  if (reading_stdin)
+  if (ctx->reading_stdin)
     {
       do
         {
@@ -373,11 +304,11 @@ static int next_word (char *buffer, int argc, char *argv[], int newline)
             }
         }
       while (!ret);
-      if (EOF == ret) reading_stdin = 0;
+      if (EOF == ret) ctx->reading_stdin = 0;
       else if (ret < 0)
         {
           rig_debug (RIG_DEBUG_ERR, "scanf: %s\n", strerror (errno));
-          reading_stdin = 0;
+          ctx->reading_stdin = 0;
         }
       else
         {
@@ -389,7 +320,7 @@ static int next_word (char *buffer, int argc, char *argv[], int newline)
         }
     }
 
-  if (!reading_stdin)
+  if (!ctx->reading_stdin)
     {
 			if (optind < argc)
         {
@@ -414,10 +345,36 @@ static int next_word (char *buffer, int argc, char *argv[], int newline)
 extern int interactive;
 extern int prompt;
 extern char send_cmd_term;
-int ext_resp = 0;
-unsigned char resp_sep = '\n';      /* Default response separator */
 
-int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
+/*
+ * Reset a parser context before its first use with rotctl_parse()
+ */
+void rotctl_parser_ctx_init(struct rotctl_parser_ctx *ctx)
+{
+	memset(ctx, 0, sizeof(struct rotctl_parser_ctx));
+
+	ctx->resp_sep = '\n';	/* Default response separator */
+	ctx->last_was_ret = 1;
+}
+
+/*
+ * Release what has been allocated in a parser context
+ */
+void rotctl_parser_ctx_cleanup(struct rotctl_parser_ctx *ctx)
+{
+	free(ctx->input_line);
+	ctx->input_line = NULL;
+	free(ctx->rp_hist_buf);
+	ctx->rp_hist_buf = NULL;
+}
+
+/*
+ * Parse and execute one command.  All the session state lives in ctx,
+ * hence different sessions may be parsed concurrently, only the calls
+ * into the rotator are serialized.
+ */
+int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc,
+		struct rotctl_parser_ctx *ctx)
 {
 	int retcode;            /* generic return code from functions */
 	unsigned char cmd;
@@ -430,7 +387,6 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 	char arg4[MAXARGSZ + 1], *p4 = NULL;
 	char *p5 = NULL;
 	char *p6 = NULL;
-	static int last_was_ret = 1;
 
 	/* cmd, internal, rotctld */
 	if (!(interactive && prompt && have_rl)) {
@@ -446,7 +402,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				 * string--rotctld only!
 				 */
 				if (cmd == '+' && !prompt) {
-					ext_resp = 1;
+					ctx->ext_resp = 1;
 					if (scanfc(fin, "%c", &cmd) < 1)
 						return -1;
 				} else if (cmd == '+' && prompt) {
@@ -454,8 +410,8 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				}
 
 				if (cmd != '\\' && cmd != '_' && cmd != '#' && ispunct(cmd) && !prompt) {
-					ext_resp = 1;
-					resp_sep = cmd;
+					ctx->ext_resp = 1;
+					ctx->resp_sep = cmd;
 					if (scanfc(fin, "%c", &cmd) < 1)
 						return -1;
 				} else if (cmd != '\\' && cmd != '?' && cmd != '_' && cmd != '#' && ispunct(cmd) && prompt) {
@@ -480,17 +436,17 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				}
 
 				if (cmd == 0x0a || cmd == 0x0d) {
-					if (last_was_ret) {
+					if (ctx->last_was_ret) {
 						if (prompt) {
 							fprintf_flush(fout, "? for help, q to quit.\n");
 						}
 						return 0;
 					}
-					last_was_ret = 1;
+					ctx->last_was_ret = 1;
 				}
 			} while (cmd == 0x0a || cmd == 0x0d);
 
-			last_was_ret = 0;
+			ctx->last_was_ret = 0;
 
 			/* comment line */
 			if (cmd == '#') {
@@ -508,7 +464,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 			}
 		} else {
 			/* parse rest of command line */
-      retcode = next_word (command, argc, argv, 1);
+      retcode = next_word (ctx, command, argc, argv, 1);
       if (EOF == retcode) return 1;
       else if (retcode < 0) return retcode;
       else if ('\0' == command[1]) {
@@ -539,7 +495,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				if (nl) *nl = '\0';	/* chomp */
 				p1 = arg1[0]==' '?arg1+1:arg1;
 			} else {
-        retcode = next_word (arg1, argc, argv, 0);
+        retcode = next_word (ctx, arg1, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -556,7 +512,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p1 = arg1;
 			} else {
-        retcode = next_word (arg1, argc, argv, 0);
+        retcode = next_word (ctx, arg1, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -574,7 +530,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p2 = arg2;
 			} else {
-        retcode = next_word (arg2, argc, argv, 0);
+        retcode = next_word (ctx, arg2, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -592,7 +548,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p3 = arg3;
 			} else {
-        retcode = next_word (arg3, argc, argv, 0);
+        retcode = next_word (ctx, arg3, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -611,7 +567,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 					return -1;
 				p4 = arg4;
 			} else {
-        retcode = next_word (arg4, argc, argv, 0);
+        retcode = next_word (ctx, arg4, argc, argv, 0);
         if (EOF == retcode) {
 					fprintf(stderr, "Invalid arg for command '%s'\n",
                   cmd_entry->name);
@@ -632,56 +588,56 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 		/* Minimum space for 32+1+128+1+128+1+128+1+128+1+128+1+128+1 = 807
 		 * chars, so allocate 896 chars cleared to zero for safety.
 		 */
-		rp_hist_buf = (char *)calloc(896, sizeof(char));
+		ctx->rp_hist_buf = (char *)calloc(896, sizeof(char));
 #endif
 
 		rl_instream = fin;
 		rl_outstream = fout;
 
-		rp_getline("\nRotator command: ");
+		rp_getline(ctx, "\nRotator command: ");
 
 		/* EOF (Ctl-D) received on empty input line, bail out gracefully. */
-		if (!input_line) {
+		if (!ctx->input_line) {
 			fprintf_flush(fout, "\n");
 			return 1;
 		}
 
 		/* Q or q to quit */
-		if (!(strncasecmp(input_line, "q", 1)))
+		if (!(strncasecmp(ctx->input_line, "q", 1)))
 			return 1;
 
 		/* '?' for help */
-		if (!(strncmp(input_line, "?", 1))) {
+		if (!(strncmp(ctx->input_line, "?", 1))) {
 			usage_rot(fout);
 			fflush(fout);
 			return 0;
 		}
 
 		/* '#' for comment */
-		if (!(strncmp(input_line, "#", 1)))
+		if (!(strncmp(ctx->input_line, "#", 1)))
 			return 0;
 
 		/* Blank line entered */
-		if (!(strcmp(input_line, ""))) {
+		if (!(strcmp(ctx->input_line, ""))) {
 			fprintf(fout, "? for help, q to quit.\n");
 			fflush(fout);
 			return 0;
 		}
 
-		rig_debug(RIG_DEBUG_BUG, "%s: input_line: %s\n", __func__, input_line);
+		rig_debug(RIG_DEBUG_BUG, "%s: input_line: %s\n", __func__, ctx->input_line);
 
 		/* Split input_line on any number of spaces to get the command token
 		 * Tabs are intercepted by readline for completion and a newline
 		 * causes readline to return the typed text.  If more than one
 		 * argument is given, it will be parsed out later.
 		 */
-		result = strtok(input_line, " ");
+		ctx->result = strtok(ctx->input_line, " ");
 
 		/* parsed_input stores pointers into input_line where the token strings
 		 * start.
 		 */
-		if (result) {
-			parsed_input[0] = result;
+		if (ctx->result) {
+			ctx->parsed_input[0] = ctx->result;
 		} else {
 			/* Oops!  Invoke GDB!! */
 			fprintf_flush(fout, "\n");
@@ -694,36 +650,36 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 		 */
 
 		/* Single character command */
-		if ((strlen(parsed_input[0]) == 1) && (*parsed_input[0] != '\\')) {
-			cmd = *parsed_input[0];
+		if ((strlen(ctx->parsed_input[0]) == 1) && (*ctx->parsed_input[0] != '\\')) {
+			cmd = *ctx->parsed_input[0];
 
 #ifdef HAVE_READLINE_HISTORY
 			/* Store what is typed, not validated, for history. */
-			if (rp_hist_buf)
-				strncpy(rp_hist_buf, parsed_input[0], 1);
+			if (ctx->rp_hist_buf)
+				strncpy(ctx->rp_hist_buf, ctx->parsed_input[0], 1);
 #endif
 		}
 		/* Test the command token, parsed_input[0] */
-		else if ((*parsed_input[0] == '\\') && (strlen(parsed_input[0]) > 1)) {
+		else if ((*ctx->parsed_input[0] == '\\') && (strlen(ctx->parsed_input[0]) > 1)) {
 			char cmd_name[MAXNAMSIZ];
 
 			/* if there is no terminating '\0' character in the source string,
 			 * srncpy() doesn't add one even if the supplied length is less
 			 * than the destination array.  Truncate the source string here.
 			 */
-			 if (strlen(parsed_input[0] + 1) >= MAXNAMSIZ)
-				*(parsed_input[0] + MAXNAMSIZ) = '\0';
+			 if (strlen(ctx->parsed_input[0] + 1) >= MAXNAMSIZ)
+				*(ctx->parsed_input[0] + MAXNAMSIZ) = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf)
-				strncpy(rp_hist_buf, parsed_input[0], MAXNAMSIZ);
+			if (ctx->rp_hist_buf)
+				strncpy(ctx->rp_hist_buf, ctx->parsed_input[0], MAXNAMSIZ);
 #endif
 			/* The starting position of the source string is the first
 			 * character past the initial '\'.  Using MAXNAMSIZ for the
 			 * length leaves enough space for the '\0' string terminator in the
 			 * cmd_name array.
 			 */
-			strncpy(cmd_name, parsed_input[0] + 1, MAXNAMSIZ);
+			strncpy(cmd_name, ctx->parsed_input[0] + 1, MAXNAMSIZ);
 
 			/* Sanity check as valid multiple character commands consist of
 			 * alpha-numeric characters and the underscore ('_') character.
@@ -738,7 +694,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 			cmd = parse_arg(cmd_name);
 		}
 		/* Single '\' entered, prompt again */
-		 else if ((*parsed_input[0] == '\\') && (strlen(parsed_input[0]) == 1)) {
+		 else if ((*ctx->parsed_input[0] == '\\') && (strlen(ctx->parsed_input[0]) == 1)) {
 			return 0;
 		}
 		/* Multiple characters but no leading '\' */
@@ -750,7 +706,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 		cmd_entry = find_cmd_entry(cmd);
 		if (!cmd_entry) {
 			if (cmd == '\0')
-				fprintf(stderr, "Command '%s' not found!\n", parsed_input[0]);
+				fprintf(stderr, "Command '%s' not found!\n", ctx->parsed_input[0]);
 			else
 				fprintf(stderr, "Command '%c' not found!\n", cmd);
 
@@ -763,11 +719,11 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 			/* Check for a non-existent delimiter so as to not break up
 			 * remaining line into separate tokens (spaces OK).
 			 */
-			result = strtok(NULL, "\0");
+			ctx->result = strtok(NULL, "\0");
 
-			if (result) {
+			if (ctx->result) {
 				x = 1;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg1) + 3)];
@@ -775,17 +731,17 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg1);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
 				/* Blank line entered */
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				if (input_line)
-					parsed_input[x] = input_line;
+				if (ctx->input_line)
+					ctx->parsed_input[x] = ctx->input_line;
 				else {
 					fprintf_flush(fout, "\n");
 					return 1;
@@ -793,26 +749,26 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 			}
 
 			/* The arg1 array size is MAXARGSZ + 1 so truncate it to fit if larger. */
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg1, parsed_input[x]);
+			strcpy(arg1, ctx->parsed_input[x]);
 			p1 = arg1;
 		}
 
 		/* Normal argument parsing. */
 		else if ((cmd_entry->flags & ARG_IN1) && cmd_entry->arg1) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (result) {
+			if (ctx->result) {
 				x = 1;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg1) + 3)];
@@ -820,42 +776,42 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg1);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg1, parsed_input[x]);
+			strcpy(arg1, ctx->parsed_input[x]);
 			p1 = arg1;
 		}
 		if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN2) && cmd_entry->arg2) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (result) {
+			if (ctx->result) {
 				x = 2;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg2) + 3)];
@@ -863,42 +819,42 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg2);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg2, parsed_input[x]);
+			strcpy(arg2, ctx->parsed_input[x]);
 			p2 = arg2;
 		}
 		if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN3) && cmd_entry->arg3) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (result) {
+			if (ctx->result) {
 				x = 3;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg3) + 3)];
@@ -906,42 +862,42 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg3);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg3, parsed_input[x]);
+			strcpy(arg3, ctx->parsed_input[x]);
 			p3 = arg3;
 		}
 		if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN4) && cmd_entry->arg4) {
-			result = strtok(NULL, " ");
+			ctx->result = strtok(NULL, " ");
 
-			if (result) {
+			if (ctx->result) {
 				x = 4;
-				parsed_input[x] = result;
+				ctx->parsed_input[x] = ctx->result;
 			} else {
 				x = 0;
 				char pmptstr[(strlen(cmd_entry->arg4) + 3)];
@@ -949,41 +905,41 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 				strcpy(pmptstr, cmd_entry->arg4);
 				strcat(pmptstr, ": ");
 
-				rp_getline(pmptstr);
+				rp_getline(ctx, pmptstr);
 
-				if (!(strcmp(input_line, ""))) {
+				if (!(strcmp(ctx->input_line, ""))) {
 					fprintf(fout, "? for help, q to quit.\n");
 					fflush(fout);
 					return 0;
 				}
 
-				result = strtok(input_line, " ");
+				ctx->result = strtok(ctx->input_line, " ");
 
-				if (result) {
-					parsed_input[x] = result;
+				if (ctx->result) {
+					ctx->parsed_input[x] = ctx->result;
 				} else {
 					fprintf_flush(fout, "\n");
 					return 1;
 				}
 			}
 
-			if (strlen(parsed_input[x]) > MAXARGSZ)
-				parsed_input[x][MAXARGSZ] = '\0';
+			if (strlen(ctx->parsed_input[x]) > MAXARGSZ)
+				ctx->parsed_input[x][MAXARGSZ] = '\0';
 
 #ifdef HAVE_READLINE_HISTORY
-			if (rp_hist_buf) {
-				strncat(rp_hist_buf, " ", 1);
-				strncat(rp_hist_buf, parsed_input[x], MAXARGSZ);
+			if (ctx->rp_hist_buf) {
+				strncat(ctx->rp_hist_buf, " ", 1);
+				strncat(ctx->rp_hist_buf, ctx->parsed_input[x], MAXARGSZ);
 			}
 #endif
-			strcpy(arg4, parsed_input[x]);
+			strcpy(arg4, ctx->parsed_input[x]);
 			p4 = arg4;
 		}
 #ifdef HAVE_READLINE_HISTORY
-		if (rp_hist_buf) {
-			add_history(rp_hist_buf);
-			free(rp_hist_buf);
-			rp_hist_buf = (char *)NULL;
+		if (ctx->rp_hist_buf) {
+			add_history(ctx->rp_hist_buf);
+			free(ctx->rp_hist_buf);
+			ctx->rp_hist_buf = (char *)NULL;
 		}
 #endif
 	}
@@ -1007,7 +963,7 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
      * Extended Response protocol: output received command name and arguments
      * response.
      */
-    if (interactive && ext_resp && !prompt) {
+    if (interactive && ctx->ext_resp && !prompt) {
         char a1[MAXARGSZ + 1];
         char a2[MAXARGSZ + 1];
         char a3[MAXARGSZ + 1];
@@ -1018,10 +974,10 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
         p3 == NULL ? a3[0] = '\0' : snprintf(a3, sizeof(a3), " %s", p3);
         p4 == NULL ? a4[0] = '\0' : snprintf(a4, sizeof(a4), " %s", p4);
 
-        fprintf(fout, "%s:%s%s%s%s%c", cmd_entry->name, a1, a2, a3, a4, resp_sep);
+        fprintf(fout, "%s:%s%s%s%s%c", cmd_entry->name, a1, a2, a3, a4, ctx->resp_sep);
     }
 
-	retcode = (*cmd_entry->rot_routine)(my_rot, fout, interactive,
+	retcode = (*cmd_entry->rot_routine)(my_rot, fout, interactive, ctx,
 					cmd_entry, p1, p2 ? p2 : "", p3 ? p3 : "",
                     p4 ? p4 : "", p5 ? p5 : "", p6 ? p6 : "");
 
@@ -1033,8 +989,8 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 		/* only for rotctld */
 		if (interactive && !prompt) {
 			fprintf(fout, NETROTCTL_RET "%d\n", retcode);
-			ext_resp = 0;
-			resp_sep = '\n';
+			ctx->ext_resp = 0;
+			ctx->resp_sep = '\n';
 		}
 		else
 			fprintf(fout, "%s: error = %s\n", cmd_entry->name, rigerror(retcode));
@@ -1042,14 +998,14 @@ int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc)
 		/* only for rotctld */
 		if (interactive && !prompt) {
 			/* netrotctl RIG_OK */
-			if (!(cmd_entry->flags & ARG_OUT) && !ext_resp)
+			if (!(cmd_entry->flags & ARG_OUT) && !ctx->ext_resp)
 				fprintf(fout, NETROTCTL_RET "0\n");
 
 			/* Extended Response protocol */
-			else if (ext_resp && cmd != 0xf0) {
+			else if (ctx->ext_resp && cmd != 0xf0) {
 				fprintf(fout, NETROTCTL_RET "0\n");
-				ext_resp = 0;
-				resp_sep = '\n';
+				ctx->ext_resp = 0;
+				ctx->resp_sep = '\n';
 			}
 		}
 	}
@@ -1129,24 +1085,17 @@ int print_conf_list(const struct confparams *cfp, rig_ptr_t data)
 	return 1;  /* != 0, we want them all ! */
 }
 
-static int hash_model_list(const struct rot_caps *caps, void *data)
+/*
+ * The registry walks models in numeric order,
+ * so they can be printed as they come.
+ */
+static int print_model_list(const struct rot_caps *caps, void *data)
 {
-
-	hash_add_model(caps->rot_model, caps->mfg_name, caps->model_name,
-	               caps->version, rig_strstatus(caps->status));
+	printf("%6d  %-23s%-24s%-16s%s\n", caps->rot_model, caps->mfg_name,
+	       caps->model_name, caps->version, rig_strstatus(caps->status));
 	return 1;  /* !=0, we want them all ! */
 }
 
-void print_model_list()
-{
-	struct mod_lst *s;
-
-	for (s = models; s != NULL; s = (struct mod_lst *)(s->hh.next)) {
-		printf("%6d  %-23s%-24s%-16s%s\n", s->id, s->mfg_name,
-		       s->model_name, s->version, s->status);
-	}
-}
-
 void list_models()
 {
 	int status;
@@ -1154,15 +1103,11 @@ void list_models()
 	rot_load_all_backends();
 
 	printf(" Rig #  Mfg                    Model                   Version         Status\n");
-	status = rot_list_foreach(hash_model_list, NULL);
+	status = rot_list_foreach(print_model_list, NULL);
 	if (status != RIG_OK ) {
 		printf("rot_list_foreach: error = %s \n", rigerror(status));
 		exit(2);
 	}
-
-	hash_sort_by_model_id();
-	print_model_list();
-	hash_delete_all();
 }
 
 
@@ -1215,12 +1160,12 @@ declare_proto_rot(get_position)
 	status = rot_get_position(rot, &az, &el);
 	if (status != RIG_OK)
 		return status;
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%f%c", az, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%f%c", az, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%f%c", el, resp_sep);
+	fprintf(fout, "%f%c", el, ctx->resp_sep);
 
 	return status;
 }
@@ -1252,9 +1197,9 @@ declare_proto_rot(get_info)
 	const char *s;
 
 	s = rot_get_info(rot);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg1);
-	fprintf(fout, "%s%c", s ? s : "None", resp_sep);
+	fprintf(fout, "%s%c", s ? s : "None", ctx->resp_sep);
 
 	return RIG_OK;
 }
@@ -1315,29 +1260,29 @@ declare_proto_rot(dump_state)
 	 * - Protocol version
 	 */
 #define ROTCTLD_PROT_VER 0
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "rotctld Protocol Ver: ");
-	fprintf(fout, "%d%c", ROTCTLD_PROT_VER, resp_sep);
+	fprintf(fout, "%d%c", ROTCTLD_PROT_VER, ctx->resp_sep);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "Rotor Model: ");
-	fprintf(fout, "%d%c", rot->caps->rot_model, resp_sep);
+	fprintf(fout, "%d%c", rot->caps->rot_model, ctx->resp_sep);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "Minimum Azimuth: ");
-	fprintf(fout, "%lf%c", rs->min_az, resp_sep);
+	fprintf(fout, "%lf%c", rs->min_az, ctx->resp_sep);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "Maximum Azimuth: ");
-	fprintf(fout, "%lf%c", rs->max_az, resp_sep);
+	fprintf(fout, "%lf%c", rs->max_az, ctx->resp_sep);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "Minimum Elevation: ");
-	fprintf(fout, "%lf%c", rs->min_el, resp_sep);
+	fprintf(fout, "%lf%c", rs->min_el, ctx->resp_sep);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "Maximum Elevation: ");
-	fprintf(fout, "%lf%c", rs->max_el, resp_sep);
+	fprintf(fout, "%lf%c", rs->max_el, ctx->resp_sep);
 
 	return RIG_OK;
 }
@@ -1444,9 +1389,9 @@ declare_proto_rot(lonlat2loc)
 	if (err != RIG_OK)
 		return err;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%s%c", loc, resp_sep);
+	fprintf(fout, "%s%c", loc, ctx->resp_sep);
 
 	return err;
 }
@@ -1465,12 +1410,12 @@ declare_proto_rot(loc2lonlat)
 	if (status != RIG_OK)
 		return status;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%f%c", lon, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%f%c", lon, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg3);
-	fprintf(fout, "%f%c", lat, resp_sep);
+	fprintf(fout, "%f%c", lat, ctx->resp_sep);
 
 	return status;
 }
@@ -1488,9 +1433,9 @@ declare_proto_rot(d_m_s2dec)
 
 	dec_deg = dms2dec(deg, min, sec, sw);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg5);
-	fprintf(fout, "%lf%c", dec_deg, resp_sep);
+	fprintf(fout, "%lf%c", dec_deg, ctx->resp_sep);
 
 	return RIG_OK;
 }
@@ -1508,18 +1453,18 @@ declare_proto_rot(dec2d_m_s)
 	if (err != RIG_OK)
 		return err;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%d%c", deg, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%d%c", deg, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg3);
-	fprintf(fout, "%d%c", min, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%d%c", min, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%lf%c", sec, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%lf%c", sec, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg5);
-	fprintf(fout, "%d%c", sw, resp_sep);
+	fprintf(fout, "%d%c", sw, ctx->resp_sep);
 
 	return err;
 }
@@ -1536,9 +1481,9 @@ declare_proto_rot(d_mm2dec)
 
 	dec_deg = dmmm2dec(deg, min, sw);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%lf%c", dec_deg, resp_sep);
+	fprintf(fout, "%lf%c", dec_deg, ctx->resp_sep);
 
 	return RIG_OK;
 }
@@ -1556,15 +1501,15 @@ declare_proto_rot(dec2d_mm)
 	if (err != RIG_OK)
 		return err;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%d%c", deg, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%d%c", deg, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg3);
-	fprintf(fout, "%lf%c", min, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%lf%c", min, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg4);
-	fprintf(fout, "%d%c", sw, resp_sep);
+	fprintf(fout, "%d%c", sw, ctx->resp_sep);
 
 	return err;
 }
@@ -1585,12 +1530,12 @@ declare_proto_rot(coord2qrb)
 	if (err != RIG_OK)
 		return err;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg5);
-	fprintf(fout, "%lf%c", dist, resp_sep);
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	fprintf(fout, "%lf%c", dist, ctx->resp_sep);
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg6);
-	fprintf(fout, "%lf%c", az, resp_sep);
+	fprintf(fout, "%lf%c", az, ctx->resp_sep);
 
 	return err;
 }
@@ -1607,9 +1552,9 @@ declare_proto_rot(az_sp2az_lp)
 	if (az_lp < 0)
 		return -RIG_EINVAL;
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%lf%c", az_lp, resp_sep);
+	fprintf(fout, "%lf%c", az_lp, ctx->resp_sep);
 
 	return RIG_OK;
 }
@@ -1623,9 +1568,9 @@ declare_proto_rot(dist_sp2dist_lp)
 
 	dist_lp = distance_long_path(dist_sp);
 
-	if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+	if ((interactive && prompt) || (interactive && !prompt && ctx->ext_resp))
 		fprintf(fout, "%s: ", cmd->arg2);
-	fprintf(fout, "%lf%c", dist_lp, resp_sep);
+	fprintf(fout, "%lf%c", dist_lp, ctx->resp_sep);
 
 	return RIG_OK;
 }
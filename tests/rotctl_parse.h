@@ -28,6 +28,23 @@
 #include <stdio.h>
 #include <hamlib/rotator.h>
 
+/*
+ * Per session parser state, so that several sessions (e.g. rotctld
+ * clients) can be parsed concurrently.
+ */
+struct rotctl_parser_ctx {
+	int ext_resp;		/* Extended response protocol requested */
+	unsigned char resp_sep;	/* Response separator */
+	int last_was_ret;	/* Previous char read was an end of line */
+	int reading_stdin;	/* Reading further commands from stdin */
+
+	/* readline support */
+	char *input_line;
+	char *result;
+	char *parsed_input[7];
+	char *rp_hist_buf;
+};
+
 /*
  * external prototype
  */
@@ -44,6 +61,9 @@ void list_models();
 int print_conf_list(const struct confparams *cfp, rig_ptr_t data);
 int set_conf(ROT *my_rot, char *conf_parms);
 
-int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc);
+void rotctl_parser_ctx_init(struct rotctl_parser_ctx *ctx);
+void rotctl_parser_ctx_cleanup(struct rotctl_parser_ctx *ctx);
+int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc,
+		struct rotctl_parser_ctx *ctx);
 
 #endif	/* ROTCTL_PARSE_H */
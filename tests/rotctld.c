@@ -389,6 +389,7 @@ void * handle_socket(void *arg)
 	FILE *fsockin;
 	FILE *fsockout;
 	int retcode;
+	struct rotctl_parser_ctx parser_ctx;
 
 #ifdef __MINGW32__
 	int sock_osfhandle = _open_osfhandle(handle_data_arg->sock, _O_RDONLY);
@@ -417,13 +418,18 @@ void * handle_socket(void *arg)
 	    goto handle_exit;
 	}
 
+	rotctl_parser_ctx_init(&parser_ctx);
+
 	do {
-		retcode = rotctl_parse(handle_data_arg->rot, fsockin, fsockout, NULL, 0);
+		retcode = rotctl_parse(handle_data_arg->rot, fsockin, fsockout, NULL, 0,
+				&parser_ctx);
 		if (ferror(fsockin) || ferror(fsockout))
 			retcode = 1;
 	}
 	while (retcode == 0 || retcode == 2);
 
+	rotctl_parser_ctx_cleanup(&parser_ctx);
+
 	rig_debug(RIG_DEBUG_VERBOSE, "Connection closed from %s:%d\n",
 				inet_ntoa(handle_data_arg->cli_addr.sin_addr),
 				ntohs(handle_data_arg->cli_addr.sin_port));
@@ -0,0 +1,135 @@
+/*
+ * Hamlib str_bench program
+ * Measures the rig_parse_*() and rig_str*() conversions, against
+ * a plain scan of the same names, and checks they round trip.
+ *
+ * str_bench [loops]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+
+#define LOOP_COUNT 100000
+#define MAX_NAMES 64
+
+struct conv {
+	const char *name;
+	unsigned long (*parse)(const char *);
+	const char *(*str)(unsigned long);
+	int bits;
+};
+
+static unsigned long parse_mode(const char *s) { return rig_parse_mode(s); }
+static const char *str_mode(unsigned long v) { return rig_strrmode(v); }
+static unsigned long parse_func(const char *s) { return rig_parse_func(s); }
+static const char *str_func(unsigned long v) { return rig_strfunc(v); }
+static unsigned long parse_level(const char *s) { return rig_parse_level(s); }
+static const char *str_level(unsigned long v) { return rig_strlevel(v); }
+static unsigned long parse_parm(const char *s) { return rig_parse_parm(s); }
+static const char *str_parm(unsigned long v) { return rig_strparm(v); }
+static unsigned long parse_vfo_op(const char *s) { return rig_parse_vfo_op(s); }
+static const char *str_vfo_op(unsigned long v) { return rig_strvfop(v); }
+
+static const struct conv convs[] = {
+	{ "mode", parse_mode, str_mode, 32 },
+	{ "func", parse_func, str_func, RIG_SETTING_MAX },
+	{ "level", parse_level, str_level, RIG_SETTING_MAX },
+	{ "parm", parse_parm, str_parm, RIG_SETTING_MAX },
+	{ "vfo_op", parse_vfo_op, str_vfo_op, 32 },
+};
+
+static float elapsed_ms(const struct timeval *tv1, const struct timeval *tv2)
+{
+	return (tv2->tv_sec - tv1->tv_sec) * 1000.0 +
+		(tv2->tv_usec - tv1->tv_usec) / 1000.0;
+}
+
+/* what the conversions did before, for comparison */
+static unsigned long scan_names(const char *names[], const unsigned long vals[],
+		int n, const char *s)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!strcmp(s, names[i]))
+			return vals[i];
+	return 0;
+}
+
+static int bench(const struct conv *c, int loops)
+{
+	const char *names[MAX_NAMES];
+	unsigned long vals[MAX_NAMES];
+	volatile unsigned long sink = 0;
+	struct timeval tv1, tv2;
+	int i, j, n = 0, errors = 0;
+
+	for (i = 0; i < c->bits && n < MAX_NAMES; i++) {
+		if (c->str(1UL << i)[0] == '\0')
+			continue;
+		vals[n] = 1UL << i;
+		names[n++] = c->str(1UL << i);
+	}
+
+	for (j = 0; j < n; j++) {
+		if (c->parse(names[j]) != vals[j])
+			errors++;
+	}
+	if (c->parse("NOT_A_NAME") != 0)
+		errors++;
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < loops; i++)
+		for (j = 0; j < n; j++)
+			sink += scan_names(names, vals, n, names[j]);
+	gettimeofday(&tv2, NULL);
+	printf("%-7s %2d names, scan:  %6.1f ns/lookup\n", c->name, n,
+			elapsed_ms(&tv1, &tv2) * 1e6 / ((float)loops * n));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < loops; i++)
+		for (j = 0; j < n; j++)
+			sink += c->parse(names[j]);
+	gettimeofday(&tv2, NULL);
+	printf("%-7s %2d names, parse: %6.1f ns/lookup\n", c->name, n,
+			elapsed_ms(&tv1, &tv2) * 1e6 / ((float)loops * n));
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < loops; i++)
+		for (j = 0; j < n; j++)
+			sink += c->str(vals[j])[0];
+	gettimeofday(&tv2, NULL);
+	printf("%-7s %2d names, str:   %6.1f ns/lookup\n", c->name, n,
+			elapsed_ms(&tv1, &tv2) * 1e6 / ((float)loops * n));
+
+	return errors;
+}
+
+int main (int argc, char *argv[])
+{
+	int loops = argc > 1 ? atoi(argv[1]) : LOOP_COUNT;
+	int i, errors = 0;
+
+	rig_set_debug(RIG_DEBUG_ERR);
+
+	for (i = 0; i < sizeof(convs)/sizeof(convs[0]); i++)
+		errors += bench(&convs[i], loops);
+
+	/* not single bits, nor in every table */
+	if (rig_parse_vfo("currVFO") != RIG_VFO_CURR ||
+			strcmp(rig_strvfo(RIG_VFO_TX), "TX") ||
+			rig_parse_mtype("PRIO") != RIG_MTYPE_PRIO ||
+			strcmp(rig_strmtype(RIG_MTYPE_SAT), "SAT") ||
+			rig_parse_scan("STOP") != RIG_SCAN_STOP ||
+			rig_setting2idx(RIG_LEVEL_STRENGTH) != 30 ||
+			rig_setting2idx(0) != 0)
+		errors++;
+
+	if (errors)
+		fprintf(stderr, "%d conversion errors\n", errors);
+
+	return errors ? 1 : 0;
+}
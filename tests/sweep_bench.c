@@ -0,0 +1,118 @@
+/*
+ * Hamlib sweep_bench program
+ * Compares rig_sweep() with the fixed delay loop rigswr used to run.
+ *
+ * sweep_bench [model [port [level]]]
+ * The level defaults to STRENGTH.  With SWR, the rig transmits
+ * during each reading, like rigswr does.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+
+#define SERIAL_PORT "/dev/ttyS0"
+
+#define START_FREQ MHz(14)
+#define STEP_FREQ kHz(10)
+#define POINT_COUNT 20
+#define LEGACY_DWELL 500	/* ms, what rigswr used to wait */
+
+static float elapsed_s(const struct timeval *tv1, const struct timeval *tv2)
+{
+	return tv2->tv_sec - tv1->tv_sec + (tv2->tv_usec - tv1->tv_usec)/1000000.0;
+}
+
+int main (int argc, char *argv[])
+{
+	RIG *my_rig;
+	int retcode;
+	rig_model_t myrig_model = argc > 1 ? atoi(argv[1]) : RIG_MODEL_DUMMY;
+	const char *port = argc > 2 ? argv[2] : SERIAL_PORT;
+	setting_t level = argc > 3 ? rig_parse_level(argv[3]) : RIG_LEVEL_STRENGTH;
+	int ptt = level == RIG_LEVEL_SWR;
+	rig_sweep_t sweep;
+	rig_sweep_point_t points[POINT_COUNT];
+	struct timeval tv1, tv2;
+	float elapsed;
+	freq_t freq;
+	value_t val;
+	int i;
+
+	rig_set_debug(RIG_DEBUG_ERR);
+
+	my_rig = rig_init(myrig_model);
+	if (!my_rig) {
+		fprintf(stderr,"Unknown rig num: %d\n", myrig_model);
+		exit(1);
+	}
+
+	strncpy(my_rig->state.rigport.pathname, port, FILPATHLEN - 1);
+
+	retcode = rig_open(my_rig);
+	if (retcode != RIG_OK) {
+		printf("rig_open: error = %s\n", rigerror(retcode));
+		exit(2);
+	}
+
+	if (!rig_has_get_level(my_rig, level)) {
+		printf("rig cannot read level %s\n", rig_strlevel(level));
+		exit(2);
+	}
+
+	printf("Sweep of %d points, reading %s\n", POINT_COUNT, rig_strlevel(level));
+
+	/*
+	 * the former rigswr loop: set, key, wait, read, unkey
+	 */
+	gettimeofday(&tv1, NULL);
+	for (i = 0, freq = START_FREQ; i < POINT_COUNT; i++, freq += STEP_FREQ) {
+		rig_set_freq(my_rig, RIG_VFO_CURR, freq);
+		if (ptt)
+			rig_set_ptt(my_rig, RIG_VFO_CURR, RIG_PTT_ON);
+		usleep(LEGACY_DWELL * 1000);
+		rig_get_level(my_rig, RIG_VFO_CURR, level, &val);
+		if (ptt)
+			rig_set_ptt(my_rig, RIG_VFO_CURR, RIG_PTT_OFF);
+	}
+	gettimeofday(&tv2, NULL);
+
+	elapsed = elapsed_s(&tv1, &tv2);
+	printf("Fixed %d ms dwell: %.3fs, %f s/point\n",
+			LEGACY_DWELL, elapsed, elapsed/POINT_COUNT);
+
+	/*
+	 * rig_sweep(), settle time measured and next frequency pipelined
+	 */
+	memset(&sweep, 0, sizeof(sweep));
+	sweep.start = START_FREQ;
+	sweep.stop = START_FREQ + (POINT_COUNT - 1) * STEP_FREQ;
+	sweep.step = STEP_FREQ;
+	sweep.level = level;
+	sweep.flags = ptt ? RIG_SWEEP_PTT : 0;
+	sweep.dwell_min = 20;
+	sweep.dwell_max = LEGACY_DWELL;
+	sweep.settle = RIG_LEVEL_IS_FLOAT(level) ? 0.05 : 1;
+
+	gettimeofday(&tv1, NULL);
+	retcode = rig_sweep(my_rig, RIG_VFO_CURR, &sweep, points, POINT_COUNT,
+			NULL, NULL);
+	gettimeofday(&tv2, NULL);
+
+	if (retcode < 0) {
+		printf("rig_sweep: error = %s\n", rigerror(retcode));
+		exit(1);
+	}
+
+	elapsed = elapsed_s(&tv1, &tv2);
+	printf("rig_sweep: %.3fs, %f s/point, last dwell %d ms\n",
+			elapsed, elapsed/retcode, points[retcode - 1].dwell);
+
+	rig_close(my_rig);
+	rig_cleanup(my_rig);
+
+	return 0;
+}
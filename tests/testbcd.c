@@ -2,6 +2,9 @@
 /*
  * Very simple test program to check BCD convertion against some other --SF
  * This is mainly to test freq2bcd and bcd2freq functions.
+ *
+ * testbcd -c [loops] checks the conversions against a digit by digit
+ * reference, exhaustively up to 6 digits, and times them.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -10,10 +13,185 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
 #include <hamlib/rig.h>
 #include "misc.h"
 
 #define MAXDIGITS 32
+#define LOOP_COUNT 1000000
+
+/* the former conversions, one digit at a time */
+static void ref_to_bcd(unsigned char b[], unsigned long long f, unsigned len)
+{
+	int i;
+
+	for (i=0; i < len/2; i++) {
+		b[i] = f%10;
+		f /= 10;
+		b[i] |= (f%10)<<4;
+		f /= 10;
+	}
+	if (len&1)
+		b[i] = (b[i] & 0xf0) | f%10;
+}
+
+static void ref_to_bcd_be(unsigned char b[], unsigned long long f, unsigned len)
+{
+	int i;
+
+	if (len&1) {
+		b[len/2] = (b[len/2] & 0x0f) | (f%10)<<4;
+		f /= 10;
+	}
+	for (i=(len/2)-1; i >= 0; i--) {
+		b[i] = f%10;
+		f /= 10;
+		b[i] |= (f%10)<<4;
+		f /= 10;
+	}
+}
+
+static unsigned long long ref_from_bcd(const unsigned char b[], unsigned len)
+{
+	unsigned long long f = 0;
+	int i;
+
+	if (len&1)
+		f = b[len/2] & 0x0f;
+	for (i=(len/2)-1; i >= 0; i--)
+		f = (f*10 + (b[i]>>4))*10 + (b[i] & 0x0f);
+
+	return f;
+}
+
+static unsigned long long ref_from_bcd_be(const unsigned char b[], unsigned len)
+{
+	unsigned long long f = 0;
+	int i;
+
+	for (i=0; i < len/2; i++)
+		f = (f*10 + (b[i]>>4))*10 + (b[i] & 0x0f);
+	if (len&1)
+		f = f*10 + (b[len/2]>>4);
+
+	return f;
+}
+
+static int check_one(unsigned long long f, unsigned len)
+{
+	unsigned char b[10], r[10];
+	int errors = 0;
+
+	/* the nibble beyond an odd length must be kept */
+	memset(b, 0xa5, sizeof(b));
+	memset(r, 0xa5, sizeof(r));
+	to_bcd(b, f, len);
+	ref_to_bcd(r, f, len);
+	if (memcmp(b, r, sizeof(b)) || from_bcd(b, len) != ref_from_bcd(r, len))
+		errors++;
+
+	memset(b, 0x5a, sizeof(b));
+	memset(r, 0x5a, sizeof(r));
+	to_bcd_be(b, f, len);
+	ref_to_bcd_be(r, f, len);
+	if (memcmp(b, r, sizeof(b)) || from_bcd_be(b, len) != ref_from_bcd_be(r, len))
+		errors++;
+
+	if (errors)
+		fprintf(stderr, "mismatch for %llu on %u digits\n", f, len);
+
+	return errors;
+}
+
+/* every octet, invalid nibbles included, at every place */
+static int check_octets(unsigned len)
+{
+	unsigned char b[10];
+	int i, c, errors = 0;
+
+	for (i = 0; i < (len+1)/2; i++)
+		for (c = 0; c < 256; c++) {
+			memset(b, 0x99, sizeof(b));
+			b[i] = c;
+			if (from_bcd(b, len) != ref_from_bcd(b, len) ||
+					from_bcd_be(b, len) != ref_from_bcd_be(b, len)) {
+				fprintf(stderr, "mismatch decoding %02x at %d on %u digits\n",
+						c, i, len);
+				errors++;
+			}
+		}
+
+	return errors;
+}
+
+static float elapsed_ns(const struct timeval *tv1, const struct timeval *tv2, int loops)
+{
+	return ((tv2->tv_sec - tv1->tv_sec) * 1e9 +
+		(tv2->tv_usec - tv1->tv_usec) * 1e3) / loops;
+}
+
+static int check(int loops)
+{
+	static const unsigned lens[] = { 6, 8, 9, 10 };
+	unsigned char b[10];
+	volatile unsigned long long sink = 0;
+	unsigned long long f, p;
+	struct timeval tv1, tv2;
+	unsigned len;
+	int i, j, errors = 0;
+
+	for (len = 1, p = 10; len <= 6; len++, p *= 10)
+		for (f = 0; f < p * 10; f++)
+			errors += check_one(f, len);
+
+	srand(1);
+	for (len = 7; len <= 19; len++)
+		for (i = 0; i < 100000; i++) {
+			f = ((unsigned long long)rand() << 42) ^
+				((unsigned long long)rand() << 21) ^ rand();
+			errors += check_one(f, len);
+		}
+	errors += check_one(~0ULL, 19);
+	for (len = 1; len <= 19; len++)
+		errors += check_octets(len);
+
+	for (j = 0; j < sizeof(lens)/sizeof(lens[0]); j++) {
+		len = lens[j];
+
+		gettimeofday(&tv1, NULL);
+		for (i = 0; i < loops; i++) {
+			ref_to_bcd(b, 146520000 + i, len);
+			sink += ref_from_bcd(b, len);
+		}
+		gettimeofday(&tv2, NULL);
+		printf("%2u digits, reference: %6.1f ns/round trip\n", len,
+				elapsed_ns(&tv1, &tv2, loops));
+
+		gettimeofday(&tv1, NULL);
+		for (i = 0; i < loops; i++) {
+			to_bcd(b, 146520000 + i, len);
+			sink += from_bcd(b, len);
+		}
+		gettimeofday(&tv2, NULL);
+		printf("%2u digits, to/from_bcd: %6.1f ns/round trip\n", len,
+				elapsed_ns(&tv1, &tv2, loops));
+
+		gettimeofday(&tv1, NULL);
+		for (i = 0; i < loops; i++) {
+			to_bcd_be(b, 146520000 + i, len);
+			sink += from_bcd_be(b, len);
+		}
+		gettimeofday(&tv2, NULL);
+		printf("%2u digits, *_bcd_be:    %6.1f ns/round trip\n", len,
+				elapsed_ns(&tv1, &tv2, loops));
+	}
+
+	if (errors)
+		fprintf(stderr, "%d conversion errors\n", errors);
+
+	return errors ? 1 : 0;
+}
 
 int main (int argc, char *argv[])
 {
@@ -22,6 +200,9 @@ int main (int argc, char *argv[])
 	int digits = 10;
 	int i;
 
+	if (argc > 1 && !strcmp(argv[1], "-c"))
+		return check(argc > 2 ? atoi(argv[2]) : LOOP_COUNT);
+
 	if (argc != 2 && argc != 3) {
 			fprintf(stderr,"Usage: %s <freq> [digits]\n",argv[0]);
 			exit(1);
@@ -0,0 +1,258 @@
+/*
+ * Hamlib sample program to test the Icom spectrum scope stream
+ *
+ * Replays a recorded CI-V stream of 0x27 scope sweeps, IC-7300 like
+ * (11 divisions, 475 points), at 115200 bauds through a pty, with
+ * frequency reads interleaved, and checks each sweep handed to the
+ * spectrum callback.
+ *
+ * testscope [-v]
+ */
+
+#define _XOPEN_SOURCE 600	/* posix_openpt() */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <hamlib/rig.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(HAVE_PTHREAD) && !defined(_WIN32)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+
+#define CIV_ADDR	0x94	/* IC-7100 */
+#define SWEEP_COUNT	20
+#define SWEEP_POINTS	475
+#define SWEEP_DIVS	11
+#define DIV_POINTS	50
+#define CENTER_FREQ	14100000
+#define SPAN_FREQ	50000
+#define RIG_FREQ	14074000
+#define BYTE_US		(1000000 / 11520)	/* 115200 bauds */
+
+static unsigned char rec[SWEEP_COUNT * (SWEEP_DIVS + 1) * 64];
+static int rec_len;
+
+static int master;
+static volatile int streaming, played, stopping;
+static int scope_sts, scope_dop;
+
+static int sweeps, bad;
+
+static unsigned char *put_bcd(unsigned char *p, long f, int n)
+{
+	for (; n > 0; n--, f /= 100)
+		*p++ = (f % 10) | (f / 10 % 10) << 4;
+	return p;
+}
+
+/* what the rig sent once scope_data was on: the recording */
+static void record(void)
+{
+	unsigned char *p = rec;
+	int sw, d, i, n;
+
+	for (sw = 0; sw < SWEEP_COUNT; sw++) {
+		for (d = 1; d <= SWEEP_DIVS; d++) {
+			*p++ = 0xfe; *p++ = 0xfe; *p++ = 0x00; *p++ = CIV_ADDR;
+			*p++ = 0x27; *p++ = 0x00; *p++ = 0x00;
+			p = put_bcd(p, d, 1);
+			p = put_bcd(p, SWEEP_DIVS, 1);
+			if (d == 1) {
+				/* centered, center and span, in range */
+				*p++ = 0x00;
+				p = put_bcd(p, CENTER_FREQ, 5);
+				p = put_bcd(p, SPAN_FREQ, 5);
+				*p++ = 0x00;
+			} else {
+				n = SWEEP_POINTS - (d - 2) * DIV_POINTS;
+				if (n > DIV_POINTS)
+					n = DIV_POINTS;
+				for (i = 0; i < n; i++)
+					*p++ = (sw + (d - 2) * DIV_POINTS + i) % 161;
+			}
+			*p++ = 0xfd;
+		}
+		/* and a transceive frequency change now and then */
+		if (sw % 10 == 5) {
+			*p++ = 0xfe; *p++ = 0xfe; *p++ = 0x00; *p++ = CIV_ADDR;
+			*p++ = 0x00;
+			p = put_bcd(p, RIG_FREQ + sw, 5);
+			*p++ = 0xfd;
+		}
+	}
+	rec_len = p - rec;
+}
+
+/* echo the commands, like the bus does, and answer them */
+static void answer(unsigned char *buf, int *len)
+{
+	static const unsigned char ack[] = { 0xfe, 0xfe, 0xe0, CIV_ADDR, 0xfb, 0xfd };
+	static const unsigned char freq[] = { 0xfe, 0xfe, 0xe0, CIV_ADDR, 0x03,
+		0x00, 0x40, 0x07, 0x14, 0x00, 0xfd };
+	unsigned char *end;
+	int n, ret;
+
+	n = read(master, buf + *len, 256 - *len);
+	if (n <= 0)
+		return;
+	ret = write(master, buf + *len, n);
+	*len += n;
+
+	while ((end = memchr(buf, 0xfd, *len)) != NULL) {
+		n = end - buf + 1;
+		if (n >= 6 && buf[4] == 0x03)
+			ret = write(master, freq, sizeof(freq));
+		else if (n >= 8 && buf[4] == 0x27) {
+			if (buf[5] == 0x10)
+				scope_sts = buf[6];
+			else if (buf[5] == 0x11)
+				scope_dop = buf[6];
+			ret = write(master, ack, sizeof(ack));
+		}
+		*len -= n;
+		memmove(buf, end + 1, *len);
+	}
+	(void)ret;
+}
+
+/* the rig: whole frames at the line rate, like on a bus */
+static void *play(void *arg)
+{
+	unsigned char buf[256];
+	struct pollfd pfd;
+	int pos = 0, len = 0, n, ret;
+
+	pfd.fd = master;
+	pfd.events = POLLIN;
+
+	while (!stopping) {
+		if (poll(&pfd, 1, streaming && pos < rec_len ? 0 : 10) > 0)
+			answer(buf, &len);
+
+		if (!streaming || pos >= rec_len) {
+			played = pos >= rec_len;
+			continue;
+		}
+
+		n = (unsigned char *)memchr(rec + pos, 0xfd, rec_len - pos) - (rec + pos) + 1;
+		ret = write(master, rec + pos, n);
+		(void)ret;
+		pos += n;
+		usleep(n * BYTE_US);
+	}
+
+	return NULL;
+}
+
+static int spectrum_event(RIG *rig, const rig_spectrum_line_t *line, rig_ptr_t arg)
+{
+	int i, first = line->data[0];
+
+	if (line->data_length != SWEEP_POINTS || !line->centered ||
+			line->low_edge_freq != CENTER_FREQ - SPAN_FREQ ||
+			line->high_edge_freq != CENTER_FREQ + SPAN_FREQ) {
+		printf("sweep %d: %d points, %"PRIfreq" to %"PRIfreq" Hz\n", sweeps,
+				line->data_length, line->low_edge_freq, line->high_edge_freq);
+		bad++;
+	}
+	for (i = 0; i < line->data_length; i++) {
+		if (line->data[i] != (first + i) % 161) {
+			printf("sweep %d: bad point %d\n", sweeps, i);
+			bad++;
+			break;
+		}
+	}
+	sweeps++;
+
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	RIG *my_rig;
+	pthread_t player;
+	freq_t freq;
+	int retcode, i, failed = 0;
+
+	rig_set_debug(argc > 1 ? RIG_DEBUG_TRACE : RIG_DEBUG_NONE);
+
+	record();
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+		perror("posix_openpt");
+		return 77;
+	}
+
+	my_rig = rig_init(RIG_MODEL_IC7100);
+	if (!my_rig) {
+		fprintf(stderr, "Unknown rig num: %d\n", RIG_MODEL_IC7100);
+		return 1;
+	}
+	strncpy(my_rig->state.rigport.pathname, ptsname(master), FILPATHLEN - 1);
+	my_rig->state.rigport.parm.serial.rate = 115200;
+	rig_set_conf(my_rig, rig_token_lookup(my_rig, "civaddr"), "0x94");
+	/* applied by rig_open() */
+	rig_set_conf(my_rig, rig_token_lookup(my_rig, "scope_data"), "1");
+
+	pthread_create(&player, NULL, play, NULL);
+
+	retcode = rig_open(my_rig);
+	if (retcode != RIG_OK) {
+		printf("rig_open: error = %s\n", rigerror(retcode));
+		stopping = 1;
+		pthread_join(player, NULL);
+		return 1;
+	}
+	if (!scope_sts || !scope_dop) {
+		printf("scope_data not applied at open\n");
+		failed++;
+	}
+
+	rig_set_spectrum_callback(my_rig, spectrum_event, NULL);
+	rig_set_trn(my_rig, RIG_TRN_RIG);
+	streaming = 1;
+
+	/* the replies must be told apart from the sweeps */
+	for (i = 0; !played; i++) {
+		usleep(100000);
+		retcode = rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+		if (retcode != RIG_OK || freq != RIG_FREQ) {
+			printf("rig_get_freq %d: %s, %"PRIfreq" Hz\n", i, rigerror(retcode), freq);
+			failed++;
+		}
+	}
+	sleep(1);
+
+	printf("%d sweeps, %d bad, %d frequency reads, %d failed\n",
+			sweeps, bad, i, failed);
+
+	rig_set_trn(my_rig, RIG_TRN_OFF);
+	rig_close(my_rig);
+	rig_cleanup(my_rig);
+
+	stopping = 1;
+	pthread_join(player, NULL);
+	close(master);
+
+	return sweeps == SWEEP_COUNT && !bad && !failed ? 0 : 1;
+}
+
+#else
+
+int main (int argc, char *argv[])
+{
+	printf("testscope: needs a pty and threads, skipped\n");
+	return 77;
+}
+
+#endif
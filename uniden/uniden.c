@@ -646,7 +646,7 @@ DECLARE_PROBERIG_BACKEND(uniden)
 
 		retval = write_block(port, "SI"EOM, 3);
 		id_len = read_string(port, idbuf, IDBUFSZ, EOM, 1);
-		close(port->fd);
+		ser_close(port);
 
 		if (retval != RIG_OK || id_len < 0)
 			continue;
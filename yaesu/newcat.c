@@ -41,6 +41,8 @@
 
 #include "hamlib/rig.h"
 #include "iofunc.h"
+#include "cache.h"
+#include "event.h"
 #include "newcat.h"
 
 /* global variables */
@@ -235,6 +237,7 @@ static int newcat_get_faststep(RIG * rig, ncboolean * fast_step);
 static int newcat_get_rigid(RIG * rig);
 static int newcat_get_vfo_mode(RIG * rig, vfo_t * vfo_mode);
 static int newcat_get_cmd(RIG * rig);
+static int newcat_set_cmd(RIG * rig);
 static int newcat_vfomem_toggle(RIG * rig);
 static ncboolean newcat_valid_command(RIG *rig, char *command);
 
@@ -358,7 +361,6 @@ int newcat_close(RIG *rig) {
 int newcat_set_freq(RIG *rig, vfo_t vfo, freq_t freq) {
     const struct rig_caps *caps;
     struct newcat_priv_data *priv;
-    struct rig_state *state;
     char c;
     int err;
 
@@ -369,7 +371,6 @@ int newcat_set_freq(RIG *rig, vfo_t vfo, freq_t freq) {
 
     priv = (struct newcat_priv_data *)rig->state.priv;
     caps = rig->caps;
-    state = &rig->state;
 //    vfo_t tvfo;
 
 //    tvfo = (vfo == RIG_VFO_CURR || vfo == RIG_VFO_VFO) ? state->current_vfo : vfo;
@@ -415,7 +416,7 @@ int newcat_set_freq(RIG *rig, vfo_t vfo, freq_t freq) {
     snprintf(priv->cmd_str, sizeof(priv->cmd_str), "F%c%08d%c", c, (int)freq, cat_term);
 
     rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %s\n", __func__, priv->cmd_str);
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -484,11 +485,9 @@ int newcat_get_freq(RIG *rig, vfo_t vfo, freq_t *freq) {
 int newcat_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 {
     struct newcat_priv_data *priv;
-    struct rig_state *state;
     int err;
 
     priv = (struct newcat_priv_data *)rig->state.priv;
-    state = &rig->state;
 
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -554,7 +553,7 @@ int newcat_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
             return -RIG_EINVAL;
     }
 
-    err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    err = newcat_set_cmd(rig);
     if (err != RIG_OK)
         return err;
 
@@ -752,7 +751,7 @@ int newcat_set_vfo(RIG *rig, vfo_t vfo) {
 
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
-    err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    err = newcat_set_cmd(rig);
     if (err != RIG_OK)
         return err;
 
@@ -834,8 +833,7 @@ int newcat_get_vfo(RIG *rig, vfo_t *vfo) {
 
 int newcat_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 {
-    struct rig_state *state = &rig->state;
-    int err;
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     char txon[] = "TX1;";
     char txoff[] = "TX0;";
 
@@ -844,15 +842,15 @@ int newcat_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 
     switch(ptt) {
         case RIG_PTT_ON:
-            err = write_block(&state->rigport, txon, strlen(txon));
+            strcpy(priv->cmd_str, txon);
             break;
         case RIG_PTT_OFF:
-            err = write_block(&state->rigport, txoff, strlen(txoff));
+            strcpy(priv->cmd_str, txoff);
             break;
         default:
             return -RIG_EINVAL;
     }
-    return err;
+    return newcat_set_cmd(rig);
 }
 
 
@@ -903,7 +901,6 @@ int newcat_get_dcd(RIG * rig, vfo_t vfo, dcd_t * dcd)
 
 int newcat_set_rptr_shift(RIG * rig, vfo_t vfo, rptr_shift_t rptr_shift)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char c;
@@ -939,7 +936,7 @@ int newcat_set_rptr_shift(RIG * rig, vfo_t vfo, rptr_shift_t rptr_shift)
     }
 
     snprintf(priv->cmd_str, sizeof(priv->cmd_str), "%s%c%c%c", command, main_sub_vfo, c, cat_term);
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -1113,7 +1110,6 @@ int newcat_get_split_vfo(RIG * rig, vfo_t vfo, split_t * split, vfo_t *tx_vfo)
 
 int newcat_set_rit(RIG * rig, vfo_t vfo, shortfreq_t rit)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
 
     if (!newcat_valid_command(rig, "RT"))
@@ -1131,7 +1127,7 @@ int newcat_set_rit(RIG * rig, vfo_t vfo, shortfreq_t rit)
     else
         snprintf(priv->cmd_str, sizeof(priv->cmd_str), "RC%cRU%04d%cRT1%c", cat_term, abs(rit), cat_term, cat_term);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -1174,7 +1170,6 @@ int newcat_get_rit(RIG * rig, vfo_t vfo, shortfreq_t * rit)
 
 int newcat_set_xit(RIG * rig, vfo_t vfo, shortfreq_t xit)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
 
     if (!newcat_valid_command(rig, "XT"))
@@ -1192,7 +1187,7 @@ int newcat_set_xit(RIG * rig, vfo_t vfo, shortfreq_t xit)
     else
         snprintf(priv->cmd_str, sizeof(priv->cmd_str), "RC%cRU%04d%cXT1%c", cat_term, abs(xit), cat_term, cat_term);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -1342,7 +1337,6 @@ int newcat_get_tone(RIG * rig, vfo_t vfo, tone_t * tone)
 
 int newcat_set_ctcss_tone(RIG * rig, vfo_t vfo, tone_t tone)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     int i;
@@ -1383,7 +1377,7 @@ int newcat_set_ctcss_tone(RIG * rig, vfo_t vfo, tone_t tone)
         snprintf(priv->cmd_str, sizeof(priv->cmd_str), "CN%c%02d%cCT%c2%c", main_sub_vfo, i, cat_term, main_sub_vfo, cat_term);
     }
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -1622,7 +1616,6 @@ int newcat_mW2power(RIG * rig, float *power, unsigned int mwpower, freq_t freq,
 
 int newcat_set_powerstat(RIG * rig, powerstat_t status)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char ps;
@@ -1645,14 +1638,14 @@ int newcat_set_powerstat(RIG * rig, powerstat_t status)
     }
 
     snprintf(priv->cmd_str, sizeof(priv->cmd_str), "PS%c%c", ps, cat_term);
-    if (RIG_OK != (err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str))))
+    if (RIG_OK != (err = newcat_set_cmd(rig)))
       {
         return err;
       }
 
     // delay 1.5 seconds
     usleep(1500000);
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -1706,7 +1699,6 @@ int newcat_reset(RIG * rig, reset_t reset)
 
 int newcat_set_ant(RIG * rig, vfo_t vfo, ant_t ant)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char which_ant;
@@ -1752,7 +1744,7 @@ int newcat_set_ant(RIG * rig, vfo_t vfo, ant_t ant)
     }
 
     snprintf(priv->cmd_str, sizeof(priv->cmd_str), "%s%c%c%c", command, main_sub_vfo, which_ant, cat_term);
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -2078,7 +2070,7 @@ int newcat_set_level(RIG * rig, vfo_t vfo, setting_t level, value_t val)
             return -RIG_EINVAL;
     }
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -2346,7 +2338,6 @@ int newcat_get_level(RIG * rig, vfo_t vfo, setting_t level, value_t * val)
 
 int newcat_set_func(RIG * rig, vfo_t vfo, setting_t func, int status)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char main_sub_vfo = '0';
@@ -2434,7 +2425,7 @@ int newcat_set_func(RIG * rig, vfo_t vfo, setting_t func, int status)
             return -RIG_EINVAL;
     }
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -2658,7 +2649,6 @@ int newcat_set_bank(RIG * rig, vfo_t vfo, int bank)
 
 int newcat_set_mem(RIG * rig, vfo_t vfo, int ch)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err, i;
     ncboolean restore_vfo;
@@ -2722,7 +2712,7 @@ int newcat_set_mem(RIG * rig, vfo_t vfo, int ch)
 
     rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %s\n", __func__, priv->cmd_str);
 
-    err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    err = newcat_set_cmd(rig);
     if (err != RIG_OK)
       return err;
 
@@ -2764,7 +2754,6 @@ int newcat_get_mem(RIG * rig, vfo_t vfo, int *ch)
 
 int newcat_vfo_op(RIG * rig, vfo_t vfo, vfo_op_t op)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char main_sub_vfo = '0';
@@ -2828,7 +2817,7 @@ int newcat_vfo_op(RIG * rig, vfo_t vfo, vfo_op_t op)
             return -RIG_EINVAL;
     }
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -2843,7 +2832,6 @@ int newcat_scan(RIG * rig, vfo_t vfo, scan_t scan, int ch)
 int newcat_set_trn(RIG * rig, int trn)
 {
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
-    struct rig_state *state = &rig->state;
     char c;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -2860,7 +2848,7 @@ int newcat_set_trn(RIG * rig, int trn)
 
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -3021,7 +3009,7 @@ int newcat_set_channel(RIG * rig, const channel_t * chan)
     rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %s\n", __func__, priv->cmd_str);
 
     /* Set Memory Channel */
-    err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    err = newcat_set_cmd(rig);
     if (err != RIG_OK)
         return err;
 
@@ -3305,7 +3293,6 @@ ncboolean newcat_is_rig(RIG * rig, rig_model_t model) {
  * newcat_set_tx_vfo does not set priv->curr_vfo
  */
 int newcat_set_tx_vfo(RIG * rig, vfo_t tx_vfo) {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char p1;
@@ -3350,7 +3337,7 @@ int newcat_set_tx_vfo(RIG * rig, vfo_t tx_vfo) {
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
     /* Set TX VFO */
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -3459,7 +3446,6 @@ int newcat_scale_float(int scale, float fval) {
 
 int newcat_set_narrow(RIG * rig, vfo_t vfo, ncboolean narrow)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char c;
@@ -3488,7 +3474,7 @@ int newcat_set_narrow(RIG * rig, vfo_t vfo, ncboolean narrow)
 
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -3533,7 +3519,6 @@ int newcat_get_narrow(RIG * rig, vfo_t vfo, ncboolean * narrow)
 
 int newcat_set_rx_bandwidth(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int err;
     char width_str[6];        /* extra larger buffer */
@@ -3660,7 +3645,7 @@ int newcat_set_rx_bandwidth(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
     /* Set RX Bandwidth */
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -3797,7 +3782,6 @@ int newcat_get_rx_bandwidth(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t *width)
 
 int newcat_set_faststep(RIG * rig, ncboolean fast_step)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     char c;
 
@@ -3815,7 +3799,7 @@ int newcat_set_faststep(RIG * rig, ncboolean fast_step)
 
     rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 
@@ -3923,7 +3907,6 @@ int newcat_get_vfo_mode(RIG * rig, vfo_t * vfo_mode)
 
 int newcat_vfomem_toggle(RIG * rig)
 {
-    struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     char command[] = "VM";
 
@@ -3937,13 +3920,16 @@ int newcat_vfomem_toggle(RIG * rig)
 
     rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %s\n", __func__, priv->cmd_str);
 
-    return write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+    return newcat_set_cmd(rig);
 }
 
 /*
  * Writes a null terminated command string in priv->cmd_str to the CAT
  * port and returns a response from the rig in priv->ret_data which is
  * also null terminated.
+ *
+ * Replies may come from the response cache when "cache_resp_timeout"
+ * is set.  It is flushed by the frontend before any rig_set_* call.
  */
 int newcat_get_cmd (RIG *rig)
 {
@@ -3952,6 +3938,15 @@ int newcat_get_cmd (RIG *rig)
   int retry_count = 0;
   int rc = -RIG_EPROTO;
   int bytes_read;
+  size_t len = sizeof(priv->ret_data);
+
+  rig_port_lock(rig);
+
+  if (rig_resp_cache_get(rig, priv->cmd_str, strlen(priv->cmd_str), priv->ret_data, &len))
+    {
+      rig_port_unlock(rig);
+      return RIG_OK;
+    }
 
   while (rc != RIG_OK && retry_count++ <= state->rigport.retry)
     {
@@ -3959,6 +3954,7 @@ int newcat_get_cmd (RIG *rig)
       rig_debug(RIG_DEBUG_TRACE, "cmd_str = %s\n", priv->cmd_str);
       if (RIG_OK != (rc = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str))))
         {
+          rig_port_unlock(rig);
           return rc;
         }
 
@@ -3992,6 +3988,7 @@ int newcat_get_cmd (RIG *rig)
             case 'N':
               /* Command recognised by rig but invalid data entered. */
               rig_debug(RIG_DEBUG_VERBOSE, "%s: NegAck for '%s'\n", __func__, priv->cmd_str);
+              rig_port_unlock(rig);
               return -RIG_ENAVAIL;
 
             case 'O':
@@ -4028,5 +4025,34 @@ int newcat_get_cmd (RIG *rig)
         }
     }
 
+  if (RIG_OK == rc)
+    {
+      rig_resp_cache_put(rig, priv->cmd_str, strlen(priv->cmd_str),
+                         priv->ret_data, strlen(priv->ret_data) + 1);
+    }
+
+  rig_port_unlock(rig);
+
   return rc;
 }
+
+
+/*
+ * newcat_set_cmd
+ *
+ * Send priv->cmd_str, a command without reply, under the port lock.
+ * The rig state may change, so the cached replies are dropped.
+ */
+int newcat_set_cmd (RIG *rig)
+{
+  struct rig_state *state = &rig->state;
+  struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+  int err;
+
+  rig_port_lock(rig);
+  rig_resp_cache_invalidate(rig, NULL, 0);
+  err = write_block(&state->rigport, priv->cmd_str, strlen(priv->cmd_str));
+  rig_port_unlock(rig);
+
+  return err;
+}
@@ -149,7 +149,7 @@ DECLARE_PROBERIG_BACKEND(yaesu)
 		retval = write_block(port, (char *) cmd, YAESU_CMD_LENGTH);
 		id_len = read_block(port, (char *) idbuf, YAESU_CMD_LENGTH);
 
-		close(port->fd);
+		ser_close(port);
 
 		if (retval != RIG_OK || id_len < 0)
 			continue;